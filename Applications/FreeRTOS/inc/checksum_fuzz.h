@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2016-2024, devolo solutions GmbH, Aachen, Germany.
+ * All rights reserved.
+ *
+ * This Software is part of the devolo GreenPHY-SDK.
+ *
+ * Usage in source form and redistribution in binary form, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Usage in source form is subject to a current end user license agreement
+ *    with the devolo solutions GmbH.
+ * 2. Neither the name of the devolo solutions GmbH nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 3. Redistribution in binary form is limited to the usage on the GreenPHY
+ *    module of the devolo solutions GmbH.
+ * 4. Redistribution in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CHECKSUM_FUZZ_H
+#define CHECKSUM_FUZZ_H
+
+/*
+ * Compare the checksum routines that the drivers use on the receive path
+ * with the ones of the IP-task, over ulIterations random and damaged frames:
+ * usGenerateChecksumCopy() against memcpy() and usGenerateChecksum(), and the
+ * verdict of vNetworkBufferSetRxChecksum() against usGenerateProtocolChecksum().
+ * Prints a summary and returns pdPASS when no difference was found.
+ */
+BaseType_t xChecksumFuzz( uint32_t ulIterations, uint32_t ulSeed );
+
+#endif /* CHECKSUM_FUZZ_H */
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2016-2024, devolo solutions GmbH, Aachen, Germany.
+ * All rights reserved.
+ *
+ * This Software is part of the devolo GreenPHY-SDK.
+ *
+ * Usage in source form and redistribution in binary form, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Usage in source form is subject to a current end user license agreement
+ *    with the devolo solutions GmbH.
+ * 2. Neither the name of the devolo solutions GmbH nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 3. Redistribution in binary form is limited to the usage on the GreenPHY
+ *    module of the devolo solutions GmbH.
+ * 4. Redistribution in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Benchmark of the packet copy and checksum routines of FreeRTOS+TCP.
+ *
+ * Every routine is run over single frame sizes and over two mixes: "imix",
+ * 7:4:1 frames of 60, 590 and 1514 bytes as seen on a busy LAN, and "bulk",
+ * two full TCP segments per ACK as sent by the web server.  The result is
+ * the cost per byte, times 100, of:
+ *   memcpy      memcpy() from the C library
+ *   copy        pvCopyPacketData()
+ *   csum        usGenerateChecksum()
+ *   csum+copy   usGenerateChecksumCopy()
+ *   memcpy+csum memcpy() followed by usGenerateChecksum(), the two pass way
+ *
+ * Both buffers start at ipBUFFER_PADDING, like the Ethernet data of a network
+ * buffer.  On the target each call is timed with the DWT cycle counter with
+ * interrupts masked, so the figures are cycles per byte.  Build with
+ * ipconfigUSE_CM3_ASM_KERNELS set to 0 to get the figures of the C loops.
+ *
+ * The same file builds natively to compare the C loops on a PC, with the
+ * firmware include paths and:
+ *   gcc -O2 -DCHECKSUM_BENCHMARK_HOST -ffunction-sections -Wl,--gc-sections
+ *       checksum_benchmark.c FreeRTOS_IP.c -o checksum_benchmark
+ * The figures are then nanoseconds per byte.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include "task.h"
+
+/* FreeRTOS +TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+
+/* GreenPHY SDK includes. */
+#include "GreenPhySDKConfig.h"
+#include "checksum_benchmark.h"
+
+#if( ( includeCHECKSUM_BENCHMARK != 0 ) || defined( CHECKSUM_BENCHMARK_HOST ) )
+
+#if defined( CHECKSUM_BENCHMARK_HOST )
+	#include <stdio.h>
+	#include <time.h>
+
+	#define benchUNIT              "ns"
+	#define benchPRINTF            printf
+	#define benchENTER()
+	#define benchEXIT()
+	#define benchTIMER_INIT()
+	#define benchTIME_NOW()        prvHostTimeNow()
+
+	static uint32_t prvHostTimeNow( void )
+	{
+	struct timespec xNow;
+
+		( void ) clock_gettime( CLOCK_MONOTONIC, &xNow );
+		return ( uint32_t ) ( ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec );
+	}
+#else
+	/* LPCOpen includes. */
+	#include "board.h"
+
+	#define benchUNIT              "cycles"
+	#define benchPRINTF            DEBUGOUT
+	#define benchENTER()           taskENTER_CRITICAL()
+	#define benchEXIT()            taskEXIT_CRITICAL()
+	#define benchTIMER_INIT()      do { CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while( 0 )
+	#define benchTIME_NOW()        ( DWT->CYCCNT )
+#endif
+
+/* The largest frame that is measured. */
+#define benchMAX_FRAME_SIZE     1514U
+
+/* Number of times each mix is run, the results are summed. */
+#define benchREPEAT             16U
+
+/* The routines that are measured.  benchNONE measures the timing overhead. */
+typedef enum
+{
+	benchNONE = 0,
+	benchMEMCPY,
+	benchCOPY,
+	benchCHECKSUM,
+	benchCHECKSUM_COPY,
+	benchMEMCPY_CHECKSUM,
+	benchCASE_COUNT
+} BenchCase_t;
+
+typedef struct
+{
+	const char *pcName;
+	const uint16_t *pusSizes;
+	size_t uxCount;
+} BenchMix_t;
+
+static const uint16_t usSize60[] = { 60 };
+static const uint16_t usSize128[] = { 128 };
+static const uint16_t usSize256[] = { 256 };
+static const uint16_t usSize590[] = { 590 };
+static const uint16_t usSize1024[] = { 1024 };
+static const uint16_t usSize1514[] = { 1514 };
+static const uint16_t usSizeIMIX[] = { 60, 590, 60, 60, 590, 60, 1514, 60, 590, 60, 590, 60 };
+static const uint16_t usSizeBulk[] = { 1514, 1514, 60 };
+
+#define benchMIX( NAME, SIZES )    { NAME, SIZES, sizeof( SIZES ) / sizeof( SIZES[ 0 ] ) }
+
+static const BenchMix_t xMixes[] =
+{
+	benchMIX( "60", usSize60 ),
+	benchMIX( "128", usSize128 ),
+	benchMIX( "256", usSize256 ),
+	benchMIX( "590", usSize590 ),
+	benchMIX( "1024", usSize1024 ),
+	benchMIX( "1514", usSize1514 ),
+	benchMIX( "imix", usSizeIMIX ),
+	benchMIX( "bulk", usSizeBulk )
+};
+
+static uint8_t ucSource[ ipBUFFER_PADDING + benchMAX_FRAME_SIZE ] __attribute__ ( ( aligned( 4 ) ) );
+static uint8_t ucTarget[ ipBUFFER_PADDING + benchMAX_FRAME_SIZE ] __attribute__ ( ( aligned( 4 ) ) );
+
+/* Keeps the compiler from dropping the checksums. */
+static volatile uint16_t usSink;
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRunOnce( BenchCase_t xCase, size_t uxSize )
+{
+uint8_t *pucSource = &( ucSource[ ipBUFFER_PADDING ] );
+uint8_t *pucTarget = &( ucTarget[ ipBUFFER_PADDING ] );
+uint32_t ulStart, ulEnd;
+
+	benchENTER();
+	ulStart = benchTIME_NOW();
+
+	switch( xCase )
+	{
+		case benchMEMCPY:
+			( void ) memcpy( pucTarget, pucSource, uxSize );
+			break;
+		case benchCOPY:
+			( void ) pvCopyPacketData( pucTarget, pucSource, uxSize );
+			break;
+		case benchCHECKSUM:
+			usSink = usGenerateChecksum( 0U, pucSource, uxSize );
+			break;
+		case benchCHECKSUM_COPY:
+			usSink = usGenerateChecksumCopy( 0U, pucTarget, pucSource, uxSize );
+			break;
+		case benchMEMCPY_CHECKSUM:
+			( void ) memcpy( pucTarget, pucSource, uxSize );
+			usSink = usGenerateChecksum( 0U, pucTarget, uxSize );
+			break;
+		default:
+			break;
+	}
+
+	ulEnd = benchTIME_NOW();
+	benchEXIT();
+
+	return ulEnd - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+/* Returns the cost per byte times 100 of one routine over a mix. */
+static uint32_t prvRunMix( BenchCase_t xCase, const BenchMix_t *pxMix, uint32_t ulOverhead )
+{
+uint64_t ullTime = 0U;
+uint64_t ullBytes = 0U;
+uint32_t ulTime;
+size_t uxRepeat, uxIndex;
+
+	for( uxRepeat = 0U; uxRepeat < benchREPEAT; uxRepeat++ )
+	{
+		for( uxIndex = 0U; uxIndex < pxMix->uxCount; uxIndex++ )
+		{
+			ulTime = prvRunOnce( xCase, pxMix->pusSizes[ uxIndex ] );
+			ullTime += ( ulTime > ulOverhead ) ? ( ulTime - ulOverhead ) : 0U;
+			ullBytes += pxMix->pusSizes[ uxIndex ];
+		}
+	}
+
+	return ( uint32_t ) ( ( ullTime * 100U ) / ullBytes );
+}
+/*-----------------------------------------------------------*/
+
+void vChecksumBenchmark( void )
+{
+uint32_t ulOverhead = UINT32_MAX;
+uint32_t ulTime;
+size_t uxIndex;
+
+	benchTIMER_INIT();
+
+	for( uxIndex = 0U; uxIndex < sizeof( ucSource ); uxIndex++ )
+	{
+		ucSource[ uxIndex ] = ( uint8_t ) ( ( uxIndex * 131U ) + 7U );
+	}
+
+	/* The cheapest empty measurement is the overhead of the timing itself. */
+	for( uxIndex = 0U; uxIndex < 32U; uxIndex++ )
+	{
+		ulTime = prvRunOnce( benchNONE, 0U );
+		if( ulTime < ulOverhead )
+		{
+			ulOverhead = ulTime;
+		}
+	}
+
+	benchPRINTF( "Checksum benchmark, %s per byte x100, %s kernels, overhead %lu\r\n",
+		benchUNIT, ( ipUSE_CM3_ASM_KERNELS != 0 ) ? "Thumb-2" : "C", ( unsigned long ) ulOverhead );
+	benchPRINTF( "frame   memcpy   copy   csum csum+copy memcpy+csum\r\n" );
+
+	for( uxIndex = 0U; uxIndex < sizeof( xMixes ) / sizeof( xMixes[ 0 ] ); uxIndex++ )
+	{
+		benchPRINTF( "%-6s %7lu %6lu %6lu %9lu %11lu\r\n",
+			xMixes[ uxIndex ].pcName,
+			( unsigned long ) prvRunMix( benchMEMCPY, &( xMixes[ uxIndex ] ), ulOverhead ),
+			( unsigned long ) prvRunMix( benchCOPY, &( xMixes[ uxIndex ] ), ulOverhead ),
+			( unsigned long ) prvRunMix( benchCHECKSUM, &( xMixes[ uxIndex ] ), ulOverhead ),
+			( unsigned long ) prvRunMix( benchCHECKSUM_COPY, &( xMixes[ uxIndex ] ), ulOverhead ),
+			( unsigned long ) prvRunMix( benchMEMCPY_CHECKSUM, &( xMixes[ uxIndex ] ), ulOverhead ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+#if defined( CHECKSUM_BENCHMARK_HOST )
+	int main( void )
+	{
+		vChecksumBenchmark();
+		return 0;
+	}
+#endif
+
+#endif /* ( includeCHECKSUM_BENCHMARK != 0 ) || defined( CHECKSUM_BENCHMARK_HOST ) */
@@ -0,0 +1,596 @@
+/*
+ * Copyright (c) 2016-2024, devolo solutions GmbH, Aachen, Germany.
+ * All rights reserved.
+ *
+ * This Software is part of the devolo GreenPHY-SDK.
+ *
+ * Usage in source form and redistribution in binary form, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Usage in source form is subject to a current end user license agreement
+ *    with the devolo solutions GmbH.
+ * 2. Neither the name of the devolo solutions GmbH nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 3. Redistribution in binary form is limited to the usage on the GreenPHY
+ *    module of the devolo solutions GmbH.
+ * 4. Redistribution in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Fuzz test of the checksum routines of the receive path.
+ *
+ * With ipconfigDRIVER_VERIFIES_RX_CHECKSUM the QCA7000 driver sums a frame
+ * while it copies it out of the staging buffer, with usGenerateChecksumCopy()
+ * and usChecksumAddBlock(), and vNetworkBufferSetRxChecksum() turns that sum
+ * into a verdict.  When the verdict is ipRX_CHECKSUM_GOOD, prvAllowIPPacketIPv4()
+ * skips usGenerateProtocolChecksum(), and with it the length checks that it
+ * does.  So a frame may only be found good when the IP-task would accept it,
+ * and it may only be found bad when the IP-task would drop it.
+ *
+ * Every iteration builds a random IPv4 frame: TCP, UDP, ICMP, IGMP or another
+ * protocol, sometimes with IP options, with correct checksums and Ethernet
+ * padding.  Then it is damaged in some of the ways that matter here: a flipped
+ * bit anywhere, a wrong or short IP length, a cut off frame, another header
+ * length, frame type or protocol, or a UDP packet without a checksum.  For
+ * each frame it checks that:
+ *   - usGenerateChecksumCopy() copies the frame and returns the same sum as
+ *     usGenerateChecksum(), for all four alignments of the source and the
+ *     target, and without writing beyond the target;
+ *   - the sum of the frame built from random pieces with usChecksumAddBlock()
+ *     equals the sum of the whole frame;
+ *   - ipRX_CHECKSUM_GOOD is only given when the IP header checksum is correct
+ *     and usGenerateProtocolChecksum() returns ipCORRECT_CRC, and
+ *     ipRX_CHECKSUM_BAD only when one of the two fails.
+ * ipRX_CHECKSUM_UNKNOWN leaves the frame to the IP-task, it is always right.
+ *
+ * The same file builds natively, with the firmware include paths and:
+ *   gcc -O2 -DCHECKSUM_FUZZ_HOST -ffunction-sections -Wl,--gc-sections
+ *       -Wl,--wrap=printf checksum_fuzz.c FreeRTOS_IP.c -o checksum_fuzz
+ *   ./checksum_fuzz [ iterations [ seed ] ]
+ * The wrapper drops the messages that usGenerateProtocolChecksum() prints
+ * about the damaged frames.  On the target they are printed as usual.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include "task.h"
+
+/* FreeRTOS +TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+
+/* GreenPHY SDK includes. */
+#include "GreenPhySDKConfig.h"
+#include "checksum_fuzz.h"
+
+#if( ( includeCHECKSUM_FUZZ != 0 ) || defined( CHECKSUM_FUZZ_HOST ) )
+
+#if( ipconfigDRIVER_VERIFIES_RX_CHECKSUM == 0 )
+	#error The checksum fuzz needs ipconfigDRIVER_VERIFIES_RX_CHECKSUM
+#endif
+
+#if defined( CHECKSUM_FUZZ_HOST )
+	#include <stdio.h>
+	#include <stdlib.h>
+	#include <stdarg.h>
+
+	#define fuzzPRINTF             prvHostPrintf
+
+	static void prvHostPrintf( const char *pcFormat, ... )
+	{
+	va_list xArgs;
+
+		va_start( xArgs, pcFormat );
+		( void ) vprintf( pcFormat, xArgs );
+		va_end( xArgs );
+	}
+#else
+	/* LPCOpen includes. */
+	#include "board.h"
+
+	#define fuzzPRINTF             DEBUGOUT
+#endif
+
+/* The value of usGenerateProtocolChecksum() for a packet that is accepted,
+see FreeRTOS_IP.c. */
+#define fuzzCORRECT_CRC         0xffffU
+
+/* The largest frame, and room behind the copy to see if it writes too far. */
+#define fuzzMAX_FRAME_SIZE      ( ipSIZE_OF_ETH_HEADER + ipconfigNETWORK_MTU )
+#define fuzzGUARD_SIZE          8U
+
+/* Only the first few differences are printed. */
+#define fuzzMAX_REPORTS         8U
+
+typedef enum
+{
+	fuzzRX_UNKNOWN = 0,
+	fuzzRX_GOOD,
+	fuzzRX_BAD,
+	fuzzRX_COUNT
+} FuzzVerdict_t;
+
+typedef struct
+{
+	uint32_t ulVerdicts[ fuzzRX_COUNT ];	/* Frames per verdict of vNetworkBufferSetRxChecksum(). */
+	uint32_t ulAccepted;					/* Frames the IP-task would accept. */
+	uint32_t ulDamaged;						/* Frames that were damaged. */
+	uint32_t ulErrors;
+} FuzzStats_t;
+
+static uint8_t ucFrame[ ipBUFFER_PADDING + fuzzMAX_FRAME_SIZE ] __attribute__ ( ( aligned( 4 ) ) );
+static uint8_t ucCopy[ ipBUFFER_PADDING + fuzzMAX_FRAME_SIZE + 3U + fuzzGUARD_SIZE ] __attribute__ ( ( aligned( 4 ) ) );
+
+static uint32_t ulRandomState;
+static FuzzStats_t xStats;
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( void )
+{
+	/* xorshift32 */
+	ulRandomState ^= ulRandomState << 13;
+	ulRandomState ^= ulRandomState >> 17;
+	ulRandomState ^= ulRandomState << 5;
+
+	return ulRandomState;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandomBelow( uint32_t ulLimit )
+{
+	return ( ulLimit != 0U ) ? ( prvRandom() % ulLimit ) : 0U;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutShort( uint8_t *pucData, uint16_t usValue )
+{
+	pucData[ 0 ] = ( uint8_t ) ( usValue >> 8 );
+	pucData[ 1 ] = ( uint8_t ) usValue;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetIPChecksum( uint8_t *pucIP, size_t uxHeaderLength )
+{
+	prvPutShort( &( pucIP[ 10 ] ), 0U );
+	prvPutShort( &( pucIP[ 10 ] ), ( uint16_t ) ~usGenerateChecksum( 0U, pucIP, uxHeaderLength ) );
+}
+/*-----------------------------------------------------------*/
+
+/* Builds a frame with correct checksums and returns its length. */
+static size_t prvMakeFrame( uint8_t *pucFrame )
+{
+static const uint8_t ucProtocols[] = { ipPROTOCOL_TCP, ipPROTOCOL_TCP, ipPROTOCOL_UDP, ipPROTOCOL_UDP, ipPROTOCOL_ICMP, ipPROTOCOL_IGMP, 47U };
+uint8_t *pucIP = &( pucFrame[ ipSIZE_OF_ETH_HEADER ] );
+uint8_t *pucProtocol;
+uint8_t ucProtocol = ucProtocols[ prvRandomBelow( sizeof( ucProtocols ) ) ];
+size_t uxHeaderLength = ipSIZE_OF_IPv4_HEADER;
+size_t uxProtocolLength, uxFrameLength, uxIndex;
+size_t uxChecksumOffset = 0U;
+uint32_t ulSum;
+
+	/* Mostly small packets, where the length checks matter. */
+	if( prvRandomBelow( 4U ) == 0U )
+	{
+		uxHeaderLength += 4U * ( 1U + prvRandomBelow( 10U ) );
+	}
+
+	if( prvRandomBelow( 2U ) == 0U )
+	{
+		uxProtocolLength = prvRandomBelow( 64U );
+	}
+	else
+	{
+		uxProtocolLength = prvRandomBelow( ipconfigNETWORK_MTU - uxHeaderLength + 1U );
+	}
+
+	for( uxIndex = 0U; uxIndex < fuzzMAX_FRAME_SIZE; uxIndex++ )
+	{
+		pucFrame[ uxIndex ] = ( uint8_t ) prvRandom();
+	}
+
+	/* Ethernet header. */
+	prvPutShort( &( pucFrame[ 12 ] ), 0x0800U );
+
+	/* IP header, the options are random bytes. */
+	pucIP[ 0 ] = ( uint8_t ) ( 0x40U | ( uxHeaderLength / 4U ) );
+	pucIP[ 1 ] = 0U;
+	prvPutShort( &( pucIP[ 2 ] ), ( uint16_t ) ( uxHeaderLength + uxProtocolLength ) );
+	prvPutShort( &( pucIP[ 6 ] ), 0x4000U );
+	pucIP[ 8 ] = 64U;
+	pucIP[ 9 ] = ucProtocol;
+
+	pucProtocol = &( pucIP[ uxHeaderLength ] );
+
+	switch( ucProtocol )
+	{
+		case ipPROTOCOL_TCP:
+			uxChecksumOffset = 16U;
+			if( uxProtocolLength >= ipSIZE_OF_TCP_HEADER )
+			{
+				pucProtocol[ 12 ] = 0x50U;
+			}
+			break;
+		case ipPROTOCOL_UDP:
+			uxChecksumOffset = 6U;
+			if( uxProtocolLength >= ipSIZE_OF_UDP_HEADER )
+			{
+				prvPutShort( &( pucProtocol[ 4 ] ), ( uint16_t ) uxProtocolLength );
+			}
+			break;
+		case ipPROTOCOL_ICMP:
+		case ipPROTOCOL_IGMP:
+			uxChecksumOffset = 2U;
+			break;
+		default:
+			break;
+	}
+
+	if( ( uxChecksumOffset != 0U ) && ( uxProtocolLength >= ( uxChecksumOffset + 2U ) ) )
+	{
+		prvPutShort( &( pucProtocol[ uxChecksumOffset ] ), 0U );
+		ulSum = usGenerateChecksum( 0U, pucProtocol, uxProtocolLength );
+
+		if( ( ucProtocol == ipPROTOCOL_TCP ) || ( ucProtocol == ipPROTOCOL_UDP ) )
+		{
+			/* The pseudo header. */
+			ulSum += usGenerateChecksum( 0U, &( pucIP[ 12 ] ), 8U );
+			ulSum += ( uint32_t ) ucProtocol + ( uint32_t ) uxProtocolLength;
+			ulSum = ( ulSum & 0xffffU ) + ( ulSum >> 16 );
+			ulSum = ( ulSum & 0xffffU ) + ( ulSum >> 16 );
+		}
+
+		ulSum = ( uint16_t ) ~ulSum;
+		if( ( ulSum == 0U ) && ( ucProtocol == ipPROTOCOL_UDP ) )
+		{
+			/* Zero means that UDP has no checksum. */
+			ulSum = 0xffffU;
+		}
+		prvPutShort( &( pucProtocol[ uxChecksumOffset ] ), ( uint16_t ) ulSum );
+	}
+
+	prvSetIPChecksum( pucIP, uxHeaderLength );
+
+	/* Padding up to the minimum frame size, or a few random bytes more. */
+	uxFrameLength = ipSIZE_OF_ETH_HEADER + uxHeaderLength + uxProtocolLength;
+	if( uxFrameLength < 60U )
+	{
+		uxFrameLength = 60U;
+	}
+	else if( prvRandomBelow( 8U ) == 0U )
+	{
+		uxFrameLength += prvRandomBelow( 5U );
+	}
+	if( uxFrameLength > fuzzMAX_FRAME_SIZE )
+	{
+		uxFrameLength = fuzzMAX_FRAME_SIZE;
+	}
+
+	return uxFrameLength;
+}
+/*-----------------------------------------------------------*/
+
+/* Damages the frame in one of the ways that the verdict depends on. */
+static size_t prvDamageFrame( uint8_t *pucFrame, size_t uxFrameLength )
+{
+uint8_t *pucIP = &( pucFrame[ ipSIZE_OF_ETH_HEADER ] );
+size_t uxHeaderLength = 4U * ( pucIP[ 0 ] & 0x0FU );
+uint16_t usLength = ( uint16_t ) ( ( pucIP[ 2 ] << 8 ) | pucIP[ 3 ] );
+
+	switch( prvRandomBelow( 10U ) )
+	{
+		case 0:
+		case 1:
+			/* A flipped bit, in the headers or in the data. */
+			pucFrame[ prvRandomBelow( uxFrameLength ) ] ^= ( uint8_t ) ( 1U << prvRandomBelow( 8U ) );
+			break;
+		case 2:
+			/* Another IP length, with a correct header checksum. */
+			usLength = ( uint16_t ) ( usLength + prvRandomBelow( 9U ) - 4U );
+			if( prvRandomBelow( 4U ) == 0U )
+			{
+				usLength = ( uint16_t ) prvRandomBelow( 48U );
+			}
+			prvPutShort( &( pucIP[ 2 ] ), usLength );
+			prvSetIPChecksum( pucIP, uxHeaderLength );
+			break;
+		case 3:
+			/* The frame is cut off. */
+			uxFrameLength = ipSIZE_OF_ETH_HEADER + prvRandomBelow( uxFrameLength - ipSIZE_OF_ETH_HEADER );
+			break;
+		case 4:
+			/* Another header length, with a correct header checksum. */
+			pucIP[ 0 ] = ( uint8_t ) ( 0x40U | prvRandomBelow( 16U ) );
+			if( ( 4U * ( pucIP[ 0 ] & 0x0FU ) ) >= ipSIZE_OF_IPv4_HEADER )
+			{
+				uxHeaderLength = 4U * ( pucIP[ 0 ] & 0x0FU );
+				if( uxFrameLength >= ( ipSIZE_OF_ETH_HEADER + uxHeaderLength ) )
+				{
+					prvSetIPChecksum( pucIP, uxHeaderLength );
+				}
+			}
+			break;
+		case 5:
+			/* Another protocol, with a correct header checksum. */
+			pucIP[ 9 ] = ( uint8_t ) prvRandom();
+			prvSetIPChecksum( pucIP, uxHeaderLength );
+			break;
+		case 6:
+			/* Another frame type or IP version. */
+			if( prvRandomBelow( 2U ) == 0U )
+			{
+				prvPutShort( &( pucFrame[ 12 ] ), ( uint16_t ) prvRandom() );
+			}
+			else
+			{
+				pucIP[ 0 ] = ( uint8_t ) ( ( pucIP[ 0 ] & 0x0FU ) | 0x60U );
+				prvSetIPChecksum( pucIP, uxHeaderLength );
+			}
+			break;
+		case 7:
+			/* A UDP packet without a checksum. */
+			if( ( pucIP[ 9 ] == ipPROTOCOL_UDP ) && ( uxFrameLength >= ( ipSIZE_OF_ETH_HEADER + uxHeaderLength + ipSIZE_OF_UDP_HEADER ) ) )
+			{
+				prvPutShort( &( pucIP[ uxHeaderLength + 6U ] ), 0U );
+			}
+			break;
+		case 8:
+			/* Two bits flipped in the same column, the sum may not notice. */
+			if( uxFrameLength > ( ipSIZE_OF_ETH_HEADER + 1U ) )
+			{
+			size_t uxOffset = ipSIZE_OF_ETH_HEADER + prvRandomBelow( uxFrameLength - ipSIZE_OF_ETH_HEADER - 1U );
+			size_t uxOther = uxOffset + 2U * ( 1U + prvRandomBelow( 4U ) );
+			uint8_t ucBit = ( uint8_t ) ( 1U << prvRandomBelow( 8U ) );
+
+				if( ( uxOther < uxFrameLength ) && ( ( ( pucFrame[ uxOffset ] ^ pucFrame[ uxOther ] ) & ucBit ) != 0U ) )
+				{
+					pucFrame[ uxOffset ] ^= ucBit;
+					pucFrame[ uxOther ] ^= ucBit;
+				}
+			}
+			break;
+		default:
+			/* Random bytes behind the IP packet. */
+			uxFrameLength += prvRandomBelow( fuzzMAX_FRAME_SIZE - uxFrameLength + 1U );
+			break;
+	}
+
+	return uxFrameLength;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReport( const char *pcWhat, uint32_t ulIteration, const uint8_t *pucFrame, size_t uxLength )
+{
+	xStats.ulErrors++;
+
+	if( xStats.ulErrors <= fuzzMAX_REPORTS )
+	{
+		fuzzPRINTF( "Checksum fuzz %lu: %s, length %u, IP %02x %02x%02x proto %u\r\n",
+			( unsigned long ) ulIteration, pcWhat, ( unsigned ) uxLength,
+			pucFrame[ 14 ], pucFrame[ 16 ], pucFrame[ 17 ], pucFrame[ 23 ] );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Copies the frame with usGenerateChecksumCopy() to all alignments, and
+compares the result with usGenerateChecksum().  Returns the sum. */
+static uint16_t prvCheckCopy( uint32_t ulIteration, const uint8_t *pucFrame, size_t uxLength )
+{
+uint16_t usSum = usGenerateChecksum( 0U, pucFrame, uxLength );
+uint16_t usStart = ( uint16_t ) prvRandom();
+size_t uxShift, uxIndex;
+uint8_t *pucTarget;
+
+	for( uxShift = 0U; uxShift < 4U; uxShift++ )
+	{
+		pucTarget = &( ucCopy[ ipBUFFER_PADDING + uxShift ] );
+		memset( ucCopy, 0xA5, sizeof( ucCopy ) );
+
+		if( usGenerateChecksumCopy( 0U, pucTarget, pucFrame, uxLength ) != usSum )
+		{
+			prvReport( "usGenerateChecksumCopy() sum differs", ulIteration, pucFrame, uxLength );
+		}
+		if( memcmp( pucTarget, pucFrame, uxLength ) != 0 )
+		{
+			prvReport( "usGenerateChecksumCopy() copy differs", ulIteration, pucFrame, uxLength );
+		}
+		for( uxIndex = ipBUFFER_PADDING + uxShift + uxLength; uxIndex < sizeof( ucCopy ); uxIndex++ )
+		{
+			if( ucCopy[ uxIndex ] != 0xA5U )
+			{
+				prvReport( "usGenerateChecksumCopy() writes too far", ulIteration, pucFrame, uxLength );
+				break;
+			}
+		}
+
+		/* A running sum. */
+		if( usGenerateChecksumCopy( usStart, pucTarget, pucFrame, uxLength ) != usGenerateChecksum( usStart, pucTarget, uxLength ) )
+		{
+			prvReport( "usGenerateChecksumCopy() with a start value differs", ulIteration, pucFrame, uxLength );
+		}
+	}
+
+	return usSum;
+}
+/*-----------------------------------------------------------*/
+
+/* Sums the frame in random pieces, as the driver does when a frame arrives
+in several SPI transfers. */
+static uint16_t prvSumInPieces( const uint8_t *pucFrame, size_t uxLength )
+{
+uint16_t usSum = 0U;
+size_t uxOffset = 0U;
+size_t uxPiece;
+
+	do
+	{
+		uxPiece = 1U + prvRandomBelow( 600U );
+		if( uxPiece > ( uxLength - uxOffset ) )
+		{
+			uxPiece = uxLength - uxOffset;
+		}
+		usSum = usChecksumAddBlock( ( uxOffset == 0U ) ? 0U : usSum,
+									usGenerateChecksumCopy( 0U, &( ucCopy[ ipBUFFER_PADDING + uxOffset ] ), &( pucFrame[ uxOffset ] ), uxPiece ),
+									uxOffset );
+		uxOffset += uxPiece;
+	} while( uxOffset < uxLength );
+
+	return usSum;
+}
+/*-----------------------------------------------------------*/
+
+/* Whether the IP-task would accept the frame: the IP header checksum is
+correct, and usGenerateProtocolChecksum() accepts the lengths and the sum. */
+static BaseType_t prvIPTaskAccepts( const uint8_t *pucFrame, size_t uxLength )
+{
+size_t uxHeaderLength = 4U * ( pucFrame[ ipSIZE_OF_ETH_HEADER ] & 0x0FU );
+BaseType_t xReturn = pdFALSE;
+
+	if( ( uxLength >= sizeof( IPPacket_t ) ) &&
+		( pucFrame[ 12 ] == 0x08U ) && ( pucFrame[ 13 ] == 0x00U ) &&
+		( ( pucFrame[ ipSIZE_OF_ETH_HEADER ] & 0xF0U ) == 0x40U ) &&
+		( uxHeaderLength >= ipSIZE_OF_IPv4_HEADER ) &&
+		( uxLength >= ( ipSIZE_OF_ETH_HEADER + uxHeaderLength ) ) &&
+		( usGenerateChecksum( 0U, &( pucFrame[ ipSIZE_OF_ETH_HEADER ] ), uxHeaderLength ) == fuzzCORRECT_CRC ) &&
+		( usGenerateProtocolChecksum( pucFrame, uxLength, pdFALSE ) == fuzzCORRECT_CRC ) )
+	{
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xChecksumFuzz( uint32_t ulIterations, uint32_t ulSeed )
+{
+NetworkBufferDescriptor_t xDescriptor;
+uint8_t *pucFrame = &( ucFrame[ ipBUFFER_PADDING ] );
+uint32_t ulIteration;
+uint16_t usSum;
+size_t uxLength;
+BaseType_t xAccepted;
+uint32_t ulDamage;
+
+	memset( &xStats, 0, sizeof( xStats ) );
+	ulRandomState = ( ulSeed != 0U ) ? ulSeed : 1U;
+
+	for( ulIteration = 0U; ulIteration < ulIterations; ulIteration++ )
+	{
+		uxLength = prvMakeFrame( pucFrame );
+
+		/* One in four frames is left intact. */
+		ulDamage = prvRandomBelow( 4U );
+		if( ulDamage != 0U )
+		{
+			xStats.ulDamaged++;
+			while( ulDamage-- != 0U )
+			{
+				uxLength = prvDamageFrame( pucFrame, uxLength );
+				if( prvRandomBelow( 2U ) == 0U )
+				{
+					break;
+				}
+			}
+		}
+
+		usSum = prvCheckCopy( ulIteration, pucFrame, uxLength );
+
+		if( ( uxLength != 0U ) && ( prvSumInPieces( pucFrame, uxLength ) != usSum ) )
+		{
+			prvReport( "sum in pieces differs", ulIteration, pucFrame, uxLength );
+		}
+
+		memset( &xDescriptor, 0, sizeof( xDescriptor ) );
+		xDescriptor.pucEthernetBuffer = pucFrame;
+		xDescriptor.xDataLength = uxLength;
+		vNetworkBufferSetRxChecksum( &xDescriptor, usSum );
+
+		xAccepted = prvIPTaskAccepts( pucFrame, uxLength );
+		if( xAccepted != pdFALSE )
+		{
+			xStats.ulAccepted++;
+		}
+
+		switch( xDescriptor.ucRxChecksum )
+		{
+			case ipRX_CHECKSUM_GOOD:
+				xStats.ulVerdicts[ fuzzRX_GOOD ]++;
+				if( xAccepted == pdFALSE )
+				{
+					prvReport( "found good, the IP-task would drop it", ulIteration, pucFrame, uxLength );
+				}
+				break;
+			case ipRX_CHECKSUM_BAD:
+				xStats.ulVerdicts[ fuzzRX_BAD ]++;
+				if( xAccepted != pdFALSE )
+				{
+					prvReport( "found bad, the IP-task would accept it", ulIteration, pucFrame, uxLength );
+				}
+				break;
+			case ipRX_CHECKSUM_UNKNOWN:
+				xStats.ulVerdicts[ fuzzRX_UNKNOWN ]++;
+				break;
+			default:
+				prvReport( "unknown verdict", ulIteration, pucFrame, uxLength );
+				break;
+		}
+	}
+
+	fuzzPRINTF( "Checksum fuzz, %lu frames, seed %lu, %lu damaged, %lu accepted by the IP-task\r\n",
+		( unsigned long ) ulIterations, ( unsigned long ) ulSeed,
+		( unsigned long ) xStats.ulDamaged, ( unsigned long ) xStats.ulAccepted );
+	fuzzPRINTF( "good %lu  bad %lu  unknown %lu  errors %lu\r\n",
+		( unsigned long ) xStats.ulVerdicts[ fuzzRX_GOOD ], ( unsigned long ) xStats.ulVerdicts[ fuzzRX_BAD ],
+		( unsigned long ) xStats.ulVerdicts[ fuzzRX_UNKNOWN ], ( unsigned long ) xStats.ulErrors );
+
+	return ( xStats.ulErrors == 0U ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+#if defined( CHECKSUM_FUZZ_HOST )
+	/* The messages of the IP-stack about the damaged frames. */
+	int __wrap_printf( const char *pcFormat, ... )
+	{
+		( void ) pcFormat;
+		return 0;
+	}
+
+	int main( int argc, char **argv )
+	{
+	uint32_t ulIterations = 1000000U;
+	uint32_t ulSeed = 1U;
+
+		if( argc > 1 )
+		{
+			ulIterations = ( uint32_t ) strtoul( argv[ 1 ], NULL, 0 );
+		}
+		if( argc > 2 )
+		{
+			ulSeed = ( uint32_t ) strtoul( argv[ 2 ], NULL, 0 );
+		}
+
+		return ( xChecksumFuzz( ulIterations, ulSeed ) == pdPASS ) ? 0 : 1;
+	}
+#endif
+
+#endif /* ( includeCHECKSUM_FUZZ != 0 ) || defined( CHECKSUM_FUZZ_HOST ) */
@@ -107,8 +107,8 @@
 	mainCREATE_FTP_SERVER settings at the top of this file. */
 	static const struct xSERVER_CONFIG xServerConfiguration =
 
-		/* Server type,		port number,	backlog, 	root dir. */
-		{ eSERVER_HTTP,		80, 			2, 		"" }
+		/* Server type,		port number,	backlog, 						root dir. */
+		{ eSERVER_HTTP,		80, 			ipconfigTCP_SERVER_CLIENTS, 	"" }
 	;
 
 		/* Remove compiler warning about unused parameter. */
@@ -240,6 +240,7 @@ void vNetworkInit( void )
 		#if( netconfigUSE_BRIDGE != 0)
 		{
 			xPlcInterface.bits.bIsBridged = 1;
+			xPlcInterface.bits.bMulticastDropList = 1;
 		}
 		#endif
 		FreeRTOS_AddNetworkInterface(&xPlcInterface);
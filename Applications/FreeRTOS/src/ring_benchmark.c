@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2016-2024, devolo solutions GmbH, Aachen, Germany.
+ * All rights reserved.
+ *
+ * This Software is part of the devolo GreenPHY-SDK.
+ *
+ * Usage in source form and redistribution in binary form, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Usage in source form is subject to a current end user license agreement
+ *    with the devolo solutions GmbH.
+ * 2. Neither the name of the devolo solutions GmbH nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 3. Redistribution in binary form is limited to the usage on the GreenPHY
+ *    module of the devolo solutions GmbH.
+ * 4. Redistribution in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Benchmark of the NetworkBufferRing_t that the drivers use instead of a
+ * FreeRTOS queue to pass descriptors to their task.
+ *
+ * A descriptor is passed through a queue of pointers, with xQueueSend() and
+ * xQueueReceive() and no block time, and through a ring with
+ * xNetworkBufferRingPush() and pxNetworkBufferRingPop().  Both have
+ * benchLENGTH slots.  Every call is timed on its own with the DWT cycle
+ * counter, with interrupts masked.  Two patterns are run:
+ *   1   one descriptor is sent and received at a time, the queue or ring is
+ *       empty before every send, as with a lightly loaded link
+ *   8   benchLENGTH descriptors are sent and then all received, as with a
+ *       burst of frames
+ * The result is the average number of cycles per send and per receive.  The
+ * contention of several producers is tested on the host by
+ * tools/net_ring_stress.c.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include "task.h"
+#include "queue.h"
+
+/* FreeRTOS +TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "NetworkBufferRing.h"
+
+/* GreenPHY SDK includes. */
+#include "GreenPhySDKConfig.h"
+#include "ring_benchmark.h"
+
+#if( includeRING_BENCHMARK != 0 )
+
+/* LPCOpen includes. */
+#include "board.h"
+
+#define benchENTER()           taskENTER_CRITICAL()
+#define benchEXIT()            taskEXIT_CRITICAL()
+#define benchTIMER_INIT()      do { CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while( 0 )
+#define benchTIME_NOW()        ( DWT->CYCCNT )
+
+/* Number of slots in the queue and the ring, like configEMAC_TX_RING_LENGTH. */
+#define benchLENGTH            8U
+
+/* Number of times each pattern is run, the results are summed. */
+#define benchREPEAT            64U
+
+typedef enum
+{
+	benchQUEUE = 0,
+	benchRING
+} BenchKind_t;
+
+typedef struct
+{
+	uint32_t ulSend;
+	uint32_t ulReceive;
+} BenchResult_t;
+
+static QueueHandle_t xQueue;
+static NetworkBufferRing_t xRing;
+static NetworkBufferDescriptor_t *pxRingStorage[ benchLENGTH ];
+
+/* Only the addresses are passed around. */
+static NetworkBufferDescriptor_t xDescriptors[ benchLENGTH ];
+
+/* The cost of reading the cycle counter twice. */
+static uint32_t ulOverhead;
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvTimeSend( BenchKind_t xKind, NetworkBufferDescriptor_t *pxDescriptor )
+{
+uint32_t ulStart, ulEnd;
+BaseType_t xResult;
+
+	benchENTER();
+	ulStart = benchTIME_NOW();
+
+	if( xKind == benchQUEUE )
+	{
+		xResult = xQueueSend( xQueue, &pxDescriptor, ( TickType_t ) 0 );
+	}
+	else
+	{
+		xResult = xNetworkBufferRingPush( &xRing, pxDescriptor, NULL );
+	}
+
+	ulEnd = benchTIME_NOW();
+	benchEXIT();
+
+	configASSERT( xResult == pdPASS );
+
+	return ulEnd - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvTimeReceive( BenchKind_t xKind )
+{
+NetworkBufferDescriptor_t *pxDescriptor = NULL;
+uint32_t ulStart, ulEnd;
+
+	benchENTER();
+	ulStart = benchTIME_NOW();
+
+	if( xKind == benchQUEUE )
+	{
+		( void ) xQueueReceive( xQueue, &pxDescriptor, ( TickType_t ) 0 );
+	}
+	else
+	{
+		pxDescriptor = pxNetworkBufferRingPop( &xRing );
+	}
+
+	ulEnd = benchTIME_NOW();
+	benchEXIT();
+
+	configASSERT( pxDescriptor != NULL );
+
+	return ulEnd - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+/* Sends and receives 'uxBurst' descriptors at a time, returns the average
+cycles per call. */
+static BenchResult_t prvRunPattern( BenchKind_t xKind, size_t uxBurst )
+{
+BenchResult_t xResult;
+uint64_t ullSend = 0U, ullReceive = 0U;
+uint32_t ulTime;
+size_t uxRepeat, uxIndex;
+
+	for( uxRepeat = 0U; uxRepeat < benchREPEAT; uxRepeat++ )
+	{
+		for( uxIndex = 0U; uxIndex < uxBurst; uxIndex++ )
+		{
+			ulTime = prvTimeSend( xKind, &( xDescriptors[ uxIndex ] ) );
+			ullSend += ( ulTime > ulOverhead ) ? ( ulTime - ulOverhead ) : 0U;
+		}
+
+		for( uxIndex = 0U; uxIndex < uxBurst; uxIndex++ )
+		{
+			ulTime = prvTimeReceive( xKind );
+			ullReceive += ( ulTime > ulOverhead ) ? ( ulTime - ulOverhead ) : 0U;
+		}
+	}
+
+	xResult.ulSend = ( uint32_t ) ( ullSend / ( benchREPEAT * uxBurst ) );
+	xResult.ulReceive = ( uint32_t ) ( ullReceive / ( benchREPEAT * uxBurst ) );
+
+	return xResult;
+}
+/*-----------------------------------------------------------*/
+
+void vRingBenchmark( void )
+{
+static const size_t uxBursts[] = { 1U, benchLENGTH };
+BenchResult_t xQueueResult, xRingResult;
+uint32_t ulStart, ulTime;
+size_t uxIndex;
+
+	benchTIMER_INIT();
+
+	xQueue = xQueueCreate( benchLENGTH, sizeof( NetworkBufferDescriptor_t * ) );
+	configASSERT( xQueue != NULL );
+	xNetworkBufferRingInit( &xRing, pxRingStorage, benchLENGTH );
+
+	/* The cheapest empty measurement is the overhead of the timing itself. */
+	ulOverhead = UINT32_MAX;
+	for( uxIndex = 0U; uxIndex < 32U; uxIndex++ )
+	{
+		benchENTER();
+		ulStart = benchTIME_NOW();
+		ulTime = benchTIME_NOW() - ulStart;
+		benchEXIT();
+
+		if( ulTime < ulOverhead )
+		{
+			ulOverhead = ulTime;
+		}
+	}
+
+	DEBUGOUT( "Ring benchmark, cycles per descriptor, overhead %lu\r\n", ( unsigned long ) ulOverhead );
+	DEBUGOUT( "burst  queue send  receive   ring push  pop\r\n" );
+
+	for( uxIndex = 0U; uxIndex < sizeof( uxBursts ) / sizeof( uxBursts[ 0 ] ); uxIndex++ )
+	{
+		xQueueResult = prvRunPattern( benchQUEUE, uxBursts[ uxIndex ] );
+		xRingResult = prvRunPattern( benchRING, uxBursts[ uxIndex ] );
+
+		DEBUGOUT( "%5lu %11lu %8lu %11lu %4lu\r\n",
+			( unsigned long ) uxBursts[ uxIndex ],
+			( unsigned long ) xQueueResult.ulSend, ( unsigned long ) xQueueResult.ulReceive,
+			( unsigned long ) xRingResult.ulSend, ( unsigned long ) xRingResult.ulReceive );
+	}
+
+	vQueueDelete( xQueue );
+}
+/*-----------------------------------------------------------*/
+
+#endif /* includeRING_BENCHMARK != 0 */
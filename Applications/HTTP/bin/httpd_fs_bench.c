@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2016-2024, devolo solutions GmbH, Aachen, Germany.
+ * All rights reserved.
+ *
+ * This Software is part of the devolo GreenPHY-SDK.
+ *
+ * Usage in source form and redistribution in binary form, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Usage in source form is subject to a current end user license agreement
+ *    with the devolo solutions GmbH.
+ * 2. Neither the name of the devolo solutions GmbH nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 3. Redistribution in binary form is limited to the usage on the GreenPHY
+ *    module of the devolo solutions GmbH.
+ * 4. Redistribution in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/*
+ * httpd_fs_bench.c
+ * Host benchmark of httpd_fs_open(): compares the perfect hash lookup with the
+ * linked list walk that it replaced, for a synthetic site written by
+ * "makefsdata.py --bench N".  See httpd_fs_bench.md for further description.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* The code under test, and the generated file system. */
+#include "httpd-fs.c"
+
+#ifndef HTTPD_FS_BENCH_DATA
+	#define HTTPD_FS_BENCH_DATA		"httpd-fsdata-bench.c"
+#endif
+#include HTTPD_FS_BENCH_DATA
+
+/* The number of lookups of one measurement, the names are looked up in turn. */
+#define BENCH_LOOKUPS		2000000u
+
+/* The lookup as it was: walk fs_root and compare every name until it ends. */
+static int prvListOpen( const char *pcName, struct httpd_fs_file *pxFile )
+{
+const struct fsdata_file *pxEntry;
+const char *pcFileName;
+size_t uxIndex;
+
+	for( pxEntry = fs_root; pxEntry != NULL; pxEntry = pxEntry->next )
+	{
+		pcFileName = ( const char * ) pxEntry->name;
+
+		for( uxIndex = 0u; ; uxIndex++ )
+		{
+			if( ( pcFileName[ uxIndex ] == 0 ) || ( pcName[ uxIndex ] == '\r' ) || ( pcName[ uxIndex ] == '\n' ) )
+			{
+				pxFile->data = ( char * ) pxEntry->data;
+				pxFile->len = pxEntry->len;
+				return 1;
+			}
+
+			if( pcName[ uxIndex ] != pcFileName[ uxIndex ] )
+			{
+				break;
+			}
+		}
+	}
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static double prvNow( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( double ) xNow.tv_sec * 1e9 + ( double ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+/* Look up all names, plus the same number of names that do not exist, and
+return the average time of a lookup in ns. */
+static double prvMeasure( int ( *pxOpen )( const char *, struct httpd_fs_file * ), const char **ppcNames, size_t uxCount, unsigned *puxFound )
+{
+struct httpd_fs_file xFile;
+double dStart;
+size_t uxRound, uxRounds, uxIndex;
+unsigned uxFound = 0u;
+
+	uxRounds = ( BENCH_LOOKUPS + uxCount - 1u ) / uxCount;
+	dStart = prvNow();
+
+	for( uxRound = 0u; uxRound < uxRounds; uxRound++ )
+	{
+		for( uxIndex = 0u; uxIndex < uxCount; uxIndex++ )
+		{
+			uxFound += ( unsigned ) pxOpen( ppcNames[ uxIndex ], &xFile );
+		}
+	}
+
+	*puxFound = uxFound / ( unsigned ) uxRounds;
+	return ( prvNow() - dStart ) / ( ( double ) uxRounds * ( double ) uxCount );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+const struct fsdata_file *pxEntry;
+const char **ppcNames;
+char *pcMissing;
+size_t uxIndex = 0u, uxLength;
+unsigned uxListFound, uxHashFound;
+double dList, dHash;
+
+	/* Every file name, and a name that is one character longer which must
+	not be found. */
+	ppcNames = calloc( 2u * fs_numfiles, sizeof( *ppcNames ) );
+
+	for( pxEntry = fs_root; pxEntry != NULL; pxEntry = pxEntry->next )
+	{
+		uxLength = strlen( ( const char * ) pxEntry->name );
+		pcMissing = malloc( uxLength + 2u );
+		memcpy( pcMissing, pxEntry->name, uxLength );
+		strcpy( pcMissing + uxLength, "x" );
+		ppcNames[ uxIndex ] = ( const char * ) pxEntry->name;
+		ppcNames[ fs_numfiles + uxIndex ] = pcMissing;
+		uxIndex++;
+	}
+
+	dList = prvMeasure( prvListOpen, ppcNames, 2u * fs_numfiles, &uxListFound );
+	dHash = prvMeasure( httpd_fs_open, ppcNames, 2u * fs_numfiles, &uxHashFound );
+
+	/* The list walk also matches a name that is longer than a file name. */
+	printf( "%5u files  list %8.1f ns  hash %6.1f ns  found %u / %u of %u\n",
+		( unsigned ) fs_numfiles, dList, dHash, uxListFound, uxHashFound, 2u * fs_numfiles );
+
+	return ( uxHashFound == fs_numfiles ) ? 0 : 1;
+}
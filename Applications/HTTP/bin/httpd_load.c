@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2016-2024, devolo solutions GmbH, Aachen, Germany.
+ * All rights reserved.
+ *
+ * This Software is part of the devolo GreenPHY-SDK.
+ *
+ * Usage in source form and redistribution in binary form, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Usage in source form is subject to a current end user license agreement
+ *    with the devolo solutions GmbH.
+ * 2. Neither the name of the devolo solutions GmbH nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 3. Redistribution in binary form is limited to the usage on the GreenPHY
+ *    module of the devolo solutions GmbH.
+ * 4. Redistribution in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/*
+ * httpd_load.c
+ * Host load generator for the HTTP server of the firmware: a number of
+ * keep-alive connections request a list of URLs in turn, as a dashboard that
+ * polls several JSON files does.  It prints the requests per second and the
+ * latency of the requests.  See httpd_load.md for further description.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+/* Requests are sent until the time is up, at most this many per connection. */
+#define LOAD_MAX_REQUESTS		100000u
+
+/* The space for a reply header. */
+#define LOAD_HEADER_SIZE		2048u
+
+typedef struct xLOAD_CONNECTION
+{
+	pthread_t xThread;
+	unsigned uxIndex;
+	unsigned uxRequests;
+	unsigned uxErrors;
+	unsigned uxConnects;
+	double *pdLatency;			/* The time of each request in ms. */
+} LoadConnection_t;
+
+static const char *pcHost = "192.168.0.10";
+static const char *pcPort = "80";
+static char **ppcPaths;
+static unsigned uxPathCount;
+static double dDuration = 10.0;
+static double dStopTime;
+
+static double prvNow( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( double ) xNow.tv_sec * 1e3 + ( double ) xNow.tv_nsec / 1e6;
+}
+/*-----------------------------------------------------------*/
+
+static int prvConnect( void )
+{
+struct addrinfo xHints, *pxResult;
+int iSocket = -1, iOne = 1;
+
+	memset( &xHints, 0, sizeof( xHints ) );
+	xHints.ai_family = AF_INET;
+	xHints.ai_socktype = SOCK_STREAM;
+
+	if( getaddrinfo( pcHost, pcPort, &xHints, &pxResult ) == 0 )
+	{
+		iSocket = socket( pxResult->ai_family, pxResult->ai_socktype, pxResult->ai_protocol );
+		if( ( iSocket >= 0 ) && ( connect( iSocket, pxResult->ai_addr, pxResult->ai_addrlen ) != 0 ) )
+		{
+			close( iSocket );
+			iSocket = -1;
+		}
+		freeaddrinfo( pxResult );
+	}
+
+	if( iSocket >= 0 )
+	{
+		setsockopt( iSocket, IPPROTO_TCP, TCP_NODELAY, &iOne, sizeof( iOne ) );
+	}
+
+	return iSocket;
+}
+/*-----------------------------------------------------------*/
+
+/* A reader of the reply that keeps what follows a header or a chunk size line. */
+typedef struct xLOAD_READER
+{
+	int iSocket;
+	char pcBuffer[ LOAD_HEADER_SIZE ];
+	size_t uxHead;
+	size_t uxTail;
+} LoadReader_t;
+
+static int prvFill( LoadReader_t *pxReader )
+{
+ssize_t xCount;
+
+	if( pxReader->uxTail > 0u )
+	{
+		memmove( pxReader->pcBuffer, pxReader->pcBuffer + pxReader->uxTail, pxReader->uxHead - pxReader->uxTail );
+		pxReader->uxHead -= pxReader->uxTail;
+		pxReader->uxTail = 0u;
+	}
+	if( pxReader->uxHead >= sizeof( pxReader->pcBuffer ) - 1u )
+	{
+		return -1;
+	}
+
+	xCount = recv( pxReader->iSocket, pxReader->pcBuffer + pxReader->uxHead, sizeof( pxReader->pcBuffer ) - 1u - pxReader->uxHead, 0 );
+	if( xCount <= 0 )
+	{
+		return -1;
+	}
+	pxReader->uxHead += ( size_t ) xCount;
+	pxReader->pcBuffer[ pxReader->uxHead ] = '\0';
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+/* Return a line that ends with '\n', or NULL when the connection broke. */
+static char *prvReadLine( LoadReader_t *pxReader )
+{
+char *pcLine, *pcEnd;
+
+	for( ;; )
+	{
+		pcLine = pxReader->pcBuffer + pxReader->uxTail;
+		pcEnd = memchr( pcLine, '\n', pxReader->uxHead - pxReader->uxTail );
+		if( pcEnd != NULL )
+		{
+			*pcEnd = '\0';
+			pxReader->uxTail = ( size_t ) ( pcEnd + 1 - pxReader->pcBuffer );
+			return pcLine;
+		}
+		if( prvFill( pxReader ) != 0 )
+		{
+			return NULL;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static int prvSkip( LoadReader_t *pxReader, size_t uxLength )
+{
+size_t uxCount;
+
+	while( uxLength > 0u )
+	{
+		if( pxReader->uxHead == pxReader->uxTail )
+		{
+			pxReader->uxHead = pxReader->uxTail = 0u;
+			if( prvFill( pxReader ) != 0 )
+			{
+				return -1;
+			}
+		}
+		uxCount = pxReader->uxHead - pxReader->uxTail;
+		if( uxCount > uxLength )
+		{
+			uxCount = uxLength;
+		}
+		pxReader->uxTail += uxCount;
+		uxLength -= uxCount;
+	}
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+/* Read one reply: the header, and a body of Content-Length bytes or in chunks. */
+static int prvReadReply( LoadReader_t *pxReader )
+{
+char *pcLine;
+size_t uxLength = 0u;
+int iStatus = 0, iChunked = 0;
+
+	pcLine = prvReadLine( pxReader );
+	if( ( pcLine == NULL ) || ( sscanf( pcLine, "HTTP/1.%*d %d", &iStatus ) != 1 ) )
+	{
+		return -1;
+	}
+
+	while( ( pcLine = prvReadLine( pxReader ) ) != NULL )
+	{
+		if( ( pcLine[ 0 ] == '\r' ) || ( pcLine[ 0 ] == '\0' ) )
+		{
+			break;
+		}
+		if( strncasecmp( pcLine, "Content-Length:", 15 ) == 0 )
+		{
+			uxLength = strtoul( pcLine + 15, NULL, 10 );
+		}
+		else if( strncasecmp( pcLine, "Transfer-Encoding: chunked", 26 ) == 0 )
+		{
+			iChunked = 1;
+		}
+	}
+	if( pcLine == NULL )
+	{
+		return -1;
+	}
+
+	if( ( iStatus == 304 ) || ( ( iStatus >= 100 ) && ( iStatus < 200 ) ) )
+	{
+		uxLength = 0u;
+	}
+	else if( iChunked != 0 )
+	{
+		/* The chunk size wins over a Content-Length. */
+		do
+		{
+			pcLine = prvReadLine( pxReader );
+			if( pcLine == NULL )
+			{
+				return -1;
+			}
+			uxLength = strtoul( pcLine, NULL, 16 );
+			/* The chunk and its CRLF, the last chunk has an empty line. */
+			if( prvSkip( pxReader, uxLength ) != 0 || prvReadLine( pxReader ) == NULL )
+			{
+				return -1;
+			}
+		} while( uxLength > 0u );
+	}
+
+	if( prvSkip( pxReader, uxLength ) != 0 )
+	{
+		return -1;
+	}
+
+	return iStatus;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvConnectionTask( void *pvParameters )
+{
+LoadConnection_t *pxConnection = ( LoadConnection_t * ) pvParameters;
+LoadReader_t xReader;
+char pcRequest[ 512 ];
+unsigned uxPath = pxConnection->uxIndex;
+int iLength, iStatus;
+double dStart;
+
+	xReader.iSocket = -1;
+
+	while( ( prvNow() < dStopTime ) && ( pxConnection->uxRequests < LOAD_MAX_REQUESTS ) )
+	{
+		if( xReader.iSocket < 0 )
+		{
+			xReader.iSocket = prvConnect();
+			xReader.uxHead = xReader.uxTail = 0u;
+			pxConnection->uxConnects++;
+			if( xReader.iSocket < 0 )
+			{
+				pxConnection->uxErrors++;
+				usleep( 100000 );
+				continue;
+			}
+		}
+
+		/* Every connection starts at another path, as parallel requests of a page do. */
+		iLength = snprintf( pcRequest, sizeof( pcRequest ),
+			"GET %s HTTP/1.1\r\n"
+			"Host: %s\r\n"
+			"Connection: keep-alive\r\n"
+			"\r\n", ppcPaths[ uxPath % uxPathCount ], pcHost );
+		uxPath++;
+
+		dStart = prvNow();
+		if( send( xReader.iSocket, pcRequest, ( size_t ) iLength, 0 ) != iLength )
+		{
+			iStatus = -1;
+		}
+		else
+		{
+			iStatus = prvReadReply( &xReader );
+		}
+
+		if( ( iStatus < 200 ) || ( iStatus >= 400 ) )
+		{
+			/* Start again with a new connection. */
+			pxConnection->uxErrors++;
+			close( xReader.iSocket );
+			xReader.iSocket = -1;
+		}
+		else
+		{
+			pxConnection->pdLatency[ pxConnection->uxRequests++ ] = prvNow() - dStart;
+		}
+	}
+
+	if( xReader.iSocket >= 0 )
+	{
+		close( xReader.iSocket );
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static int prvCompare( const void *pvLeft, const void *pvRight )
+{
+double dLeft = *( const double * ) pvLeft, dRight = *( const double * ) pvRight;
+
+	return ( dLeft > dRight ) - ( dLeft < dRight );
+}
+/*-----------------------------------------------------------*/
+
+static double prvPercentile( const double *pdSorted, unsigned uxCount, double dPercent )
+{
+unsigned uxIndex;
+
+	if( uxCount == 0u )
+	{
+		return 0.0;
+	}
+	uxIndex = ( unsigned ) ( dPercent / 100.0 * ( double ) ( uxCount - 1u ) + 0.5 );
+
+	return pdSorted[ uxIndex ];
+}
+/*-----------------------------------------------------------*/
+
+static void prvUsage( const char *pcName )
+{
+	fprintf( stderr, "usage: %s [-c connections] [-d seconds] [-p port] host [path ...]\n", pcName );
+	exit( 2 );
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+static char *ppcDefaultPaths[] = { "/status.json?", "/thermo3.json?", "/config.json?" };
+LoadConnection_t *pxConnections;
+double *pdAll;
+unsigned uxConnectionCount = 3u, uxIndex, uxTotal = 0u, uxErrors = 0u, uxConnects = 0u;
+double dStart, dElapsed;
+int iOption;
+
+	while( ( iOption = getopt( argc, argv, "c:d:p:" ) ) != -1 )
+	{
+		switch( iOption )
+		{
+			case 'c': uxConnectionCount = ( unsigned ) atoi( optarg ); break;
+			case 'd': dDuration = atof( optarg ); break;
+			case 'p': pcPort = optarg; break;
+			default: prvUsage( argv[ 0 ] );
+		}
+	}
+	if( ( optind >= argc ) || ( uxConnectionCount == 0u ) )
+	{
+		prvUsage( argv[ 0 ] );
+	}
+	pcHost = argv[ optind++ ];
+
+	if( optind < argc )
+	{
+		ppcPaths = argv + optind;
+		uxPathCount = ( unsigned ) ( argc - optind );
+	}
+	else
+	{
+		ppcPaths = ppcDefaultPaths;
+		uxPathCount = sizeof( ppcDefaultPaths ) / sizeof( ppcDefaultPaths[ 0 ] );
+	}
+
+	pxConnections = calloc( uxConnectionCount, sizeof( *pxConnections ) );
+
+	dStart = prvNow();
+	dStopTime = dStart + dDuration * 1e3;
+
+	for( uxIndex = 0u; uxIndex < uxConnectionCount; uxIndex++ )
+	{
+		pxConnections[ uxIndex ].uxIndex = uxIndex;
+		pxConnections[ uxIndex ].pdLatency = malloc( LOAD_MAX_REQUESTS * sizeof( double ) );
+		pthread_create( &pxConnections[ uxIndex ].xThread, NULL, prvConnectionTask, &pxConnections[ uxIndex ] );
+	}
+
+	for( uxIndex = 0u; uxIndex < uxConnectionCount; uxIndex++ )
+	{
+		pthread_join( pxConnections[ uxIndex ].xThread, NULL );
+		uxTotal += pxConnections[ uxIndex ].uxRequests;
+		uxErrors += pxConnections[ uxIndex ].uxErrors;
+		uxConnects += pxConnections[ uxIndex ].uxConnects;
+	}
+	dElapsed = ( prvNow() - dStart ) / 1e3;
+
+	/* Put the latency of all requests together and sort them. */
+	pdAll = malloc( ( uxTotal + 1u ) * sizeof( double ) );
+	uxTotal = 0u;
+	for( uxIndex = 0u; uxIndex < uxConnectionCount; uxIndex++ )
+	{
+		memcpy( pdAll + uxTotal, pxConnections[ uxIndex ].pdLatency, pxConnections[ uxIndex ].uxRequests * sizeof( double ) );
+		uxTotal += pxConnections[ uxIndex ].uxRequests;
+	}
+	qsort( pdAll, uxTotal, sizeof( double ), prvCompare );
+
+	printf( "%u connections  %u requests in %.1f s  %.1f req/s  errors %u  connects %u\n",
+		uxConnectionCount, uxTotal, dElapsed, ( double ) uxTotal / dElapsed, uxErrors, uxConnects );
+	printf( "latency ms  p50 %.2f  p90 %.2f  p99 %.2f  max %.2f\n",
+		prvPercentile( pdAll, uxTotal, 50.0 ), prvPercentile( pdAll, uxTotal, 90.0 ),
+		prvPercentile( pdAll, uxTotal, 99.0 ), prvPercentile( pdAll, uxTotal, 100.0 ) );
+
+	return ( uxErrors == 0u ) ? 0 : 1;
+}
@@ -1,37 +1,202 @@
 #/usr/bin/env python
 
 from pathlib import Path
+import argparse
 import binascii
+import hashlib
 import textwrap
-from css_html_js_minify import html_minify, js_minify, css_minify
 import zlib
-import bs4
 
 fsdir = Path('../httpd-fs/')
 outfile = Path('../src/httpd-fsdata.c')
-outfile.touch(exist_ok=True)
 extensions = ['.html', '.css', '.js', '.svg', '.shtml', '.json', '.png', '.gif', '.jpg']
 unify = True
 minify = True
 gzip_extensions = ['.html', '.css', '.js', '.svg']
+# Pages are revalidated with their ETag on every load, other files are cached
+# for max_age seconds.  A firmware update may change any of them.
+revalidate_extensions = ['.html', '.shtml', '.json']
+max_age = 86400
+
+# Must match pxTypeCouples[] in FreeRTOS_HTTP_server.c
+content_types = {
+  '.html': 'text/html',
+  '.shtml': 'text/html',
+  '.css': 'text/css',
+  '.js': 'text/javascript',
+  '.json': 'application/json',
+  '.svg': 'image/svg+xml',
+  '.png': 'image/png',
+  '.jpg': 'image/jpeg',
+  '.gif': 'image/gif',
+  '.txt': 'text/plain',
+}
+
+# Must match httpd_fs_hash() and httpd_fs_open() in httpd-fs.c
+FNV_OFFSET = 0x811c9dc5
+FNV_PRIME = 0x01000193
+HASH_MIX = 0x9e3779b1
 
 def gzip_encode(content):
     gzip_compress = zlib.compressobj(9, zlib.DEFLATED, zlib.MAX_WBITS | 16)
     data = gzip_compress.compress(content) + gzip_compress.flush()
     return data
 
+def fnv1a(name):
+  h = FNV_OFFSET
+  for c in name.encode():
+    h = ((h ^ c) * FNV_PRIME) & 0xffffffff
+  return h
+
+def hash_slot(h, d, bits):
+  return (((h ^ d) * HASH_MIX) & 0xffffffff) >> (32 - bits)
+
+def perfect_hash(names):
+  # Hash and displace: the FNV-1a hash of a name selects a bucket, the
+  # displacement of that bucket is mixed into the same hash to find the slot.
+  # Both tables have a power of two size of at least the number of files.
+  bits = max(1, (len(names) - 1).bit_length())
+  size = 1 << bits
+  hashes = [fnv1a(name) for name in names]
+  buckets = [[] for _ in range(size)]
+  for index, h in enumerate(hashes):
+    buckets[h & (size - 1)].append(index)
+  displace = [0] * size
+  table = [None] * size
+  for bucket in sorted(range(size), key=lambda b: -len(buckets[b])):
+    if not buckets[bucket]:
+      break
+    for d in range(0x10000):
+      slots = [hash_slot(hashes[i], d, bits) for i in buckets[bucket]]
+      if len(set(slots)) == len(slots) and all(table[s] is None for s in slots):
+        break
+    else:
+      raise RuntimeError('no perfect hash found for bucket {}'.format(bucket))
+    displace[bucket] = d
+    for i, s in zip(buckets[bucket], slots):
+      table[s] = i
+  return bits, displace, table
+
+def etag(data):
+  return '"{}"'.format(hashlib.sha1(data).hexdigest()[:16])
+
+def cache_control(name):
+  if Path(name).suffix in revalidate_extensions:
+    return 'no-cache'
+  return 'max-age={}'.format(max_age)
+
+def http_header(name, data, gzip):
+  # The complete reply header of a file, which FreeRTOS_HTTP_server.c sends as
+  # is.  A '304 Not Modified' reply repeats the lines from the ETag onwards.
+  lines = ['HTTP/1.1 200 OK',
+           'Content-Type: ' + content_types.get(Path(name).suffix, 'text/html')]
+  if gzip:
+    lines.append('Content-Encoding: gzip')
+  lines += ['Content-Length: {}'.format(len(data)),
+            'ETag: ' + etag(data),
+            'Cache-Control: ' + cache_control(name),
+            'Connection: keep-alive']
+  return [line + '\r\n' for line in lines] + ['\r\n']
+
+def header_304_offset(header):
+  offset = 0
+  for line in header:
+    if line.startswith('ETag: '):
+      return offset
+    offset += len(line)
+
+def c_string(text):
+  return '"{}"'.format(text.replace('\\', '\\\\').replace('"', '\\"').replace('\r', '\\r').replace('\n', '\\n'))
+
+def write_tables(fout, entries):
+  # entries: list of (file name, encoded name, data, gzip) in data array order
+  last_file = ''
+  for name, filename_enc, data, gzip in entries:
+    filename_slash = '/' + name
+    name_len = len(filename_slash) + (4 - (len(filename_slash) % 4))
+    fout.write('static const char header__{}[] =\n'.format(filename_enc))
+    header = http_header(name, data, gzip)
+    fout.write('\n'.join(c_string(line) for line in header))
+    fout.write(';\n\n')
+    fout.write('const struct fsdata_file file__{}[] = {{ {{\n'.format(filename_enc))
+    if last_file == '': fout.write('file_NULL,\n')
+    else:               fout.write('file__{},\n'.format(last_file))
+    fout.write('data__{},\n'.format(filename_enc))
+    fout.write('data__{} + {},\n'.format(filename_enc, name_len))
+    fout.write('sizeof(data__{}) - {},\n'.format(filename_enc, name_len))
+    fout.write('"{}",\n'.format(content_types.get(Path(name).suffix, 'text/html')))
+    fout.write('{},\n'.format(c_string(etag(data))))
+    fout.write('{},\n'.format(1 if gzip else 0))
+    fout.write('header__{},\n'.format(filename_enc))
+    fout.write('sizeof(header__{}) - 1,\n'.format(filename_enc))
+    fout.write('{},\n'.format(header_304_offset(header)))
+    fout.write('#ifdef HTTPD_FS_STATISTICS\n')
+    fout.write('#if HTTPD_FS_STATISTICS == 1\n')
+    fout.write('0,\n')
+    fout.write('#endif /* HTTPD_FS_STATISTICS */\n')
+    fout.write('#endif /* HTTPD_FS_STATISTICS */\n')
+    fout.write('} };\n')
+    fout.write('\n\n')
+    last_file = filename_enc
+
+  fout.write('const struct fsdata_file *fs_root = file__{};\n'.format(last_file))
+  fout.write('const uint16_t fs_numfiles = {};\n\n'.format(len(entries)))
+
+  bits, displace, table = perfect_hash(['/' + e[0] for e in entries])
+  fout.write('/* Perfect hash of the file names, see httpd_fs_open(). */\n')
+  fout.write('const uint8_t fs_hash_bits = {};\n'.format(bits))
+  fout.write('const uint16_t fs_hash_displace[{}] = {{\n'.format(len(displace)))
+  fout.write(',\n'.join(','.join(str(d) for d in displace[i:i + 16]) for i in range(0, len(displace), 16)))
+  fout.write('\n};\n')
+  fout.write('const struct fsdata_file * const fs_hash_table[{}] = {{\n'.format(len(table)))
+  fout.write(',\n'.join('file_NULL' if i is None else 'file__' + entries[i][1] for i in table))
+  fout.write('\n};\n\n')
+
+  fout.write('#ifdef HTTPD_FS_STATISTICS\n')
+  fout.write('#if HTTPD_FS_STATISTICS == 1\n')
+  fout.write('uint16_t fs_count[{}];\n'.format(len(entries)))
+  fout.write('#endif /* HTTPD_FS_STATISTICS */\n')
+  fout.write('#endif /* HTTPD_FS_STATISTICS */\n')
+
+def write_file(fout, name, data, filecount):
+  filename_enc = name.translate(str.maketrans('.-/', '___'))
+  filename_slash = '/' + name
+  fout.write('static const unsigned int dummy_align__{} = {};\n'.format(filename_enc, filecount))
+  fout.write('static const unsigned char data__{}[] = {{\n'.format(filename_enc))
+  fout.write('\n\n')
+
+  fout.write('/* /{} ({} chars) */\n'.format(name, len(filename_slash) + 1))
+  filename_hex = ",".join("0x{:02x}".format(c) for c in filename_slash.encode()) + ','
+  filename_hex += '0x00,' * (4 - (len(filename_slash) % 4))
+  fout.write('\n'.join(textwrap.wrap(filename_hex, 80)))
+  fout.write('\n\n')
+
+  data_hex = ",".join("0x{:02x}".format(c) for c in data)
+  fout.write('/* raw file data ({} bytes) */\n'.format(len(data)))
+  fout.write('\n'.join(textwrap.wrap(data_hex, 80)))
+  fout.write(',\n};\n')
+  fout.write('\n\n')
+  return filename_enc
+
+def write_header(fout):
+  fout.write('#include "stddef.h"\n')
+  fout.write('#include "httpd-fsdata.h"\n\n')
+  fout.write('#define file_NULL (struct fsdata_file *) NULL\n')
+
 def generate_fs():
+  from css_html_js_minify import html_minify, js_minify, css_minify
+  import bs4
+
+  outfile.touch(exist_ok=True)
   files = [p for p in sorted(fsdir.iterdir()) if p.is_file() and p.suffix in extensions]
   if all(file.stat().st_mtime < outfile.stat().st_mtime for file in files):
     print('generated file up to date')
     #return
 
   with outfile.open('w') as fout:
-    fout.write('#include "stddef.h"\n')
-    fout.write('#include "httpd-fsdata.h"\n\n')
-    fout.write('#define file_NULL (struct fsdata_file *) NULL\n')
+    write_header(fout)
 
-    filecount = 0
+    entries = []
 
     for file in files:
       if(unify):
@@ -94,56 +259,37 @@ def generate_fs():
 
       print(file.name)
 
-      filename_enc = file.name.translate(str.maketrans('.-', '__'))
-      filename_slash = '/' + file.name
-      fout.write('static const unsigned int dummy_align__{} = {};\n'.format(filename_enc, filecount))
-      fout.write('static const unsigned char data__{}[] = {{\n'.format(filename_enc))
-      fout.write('\n\n')
-
-      fout.write('/* /{} ({} chars) */\n'.format(file.name, len(filename_slash) + 1))
-      filename_hex = ",".join("0x{:02x}".format(c) for c in filename_slash.encode()) + ','
-      filename_hex += '0x00,' * (4 - (len(filename_slash) % 4))
-      fout.write('\n'.join(textwrap.wrap(filename_hex, 80)))
-      fout.write('\n\n')
-
       data = data.encode()
-      if(file.suffix in gzip_extensions):
+      gzip = file.suffix in gzip_extensions
+      if(gzip):
           data = gzip_encode(data)
-      data_hex = ",".join("0x{:02x}".format(c) for c in data)
-      fout.write('/* raw file data ({} bytes) */\n'.format(len(data)))
-      fout.write('\n'.join(textwrap.wrap(data_hex, 80)))
-      fout.write(',\n};\n')
-      fout.write('\n\n')
-
-      filecount += 1
-        
-    last_file = ''
-    for file in files:
-      if(unify):
-        if(file.suffix not in ['.htm', '.html']):
-          continue
-      filename_enc = file.name.translate(str.maketrans('.-', '__'))
-      filename_slash = '/' + file.name
-      fout.write('const struct fsdata_file file__{}[] = {{ {{\n'.format(filename_enc))
-      if last_file == '': fout.write('file_NULL,\n')
-      else:               fout.write('file__{},\n'.format(last_file))
-      fout.write('data__{},\n'.format(filename_enc))
-      fout.write('data__{} + {},\n'.format(filename_enc, len(filename_slash) + (4 - (len(filename_slash) % 4))))
-      fout.write('sizeof(data__{}) - {},\n'.format(filename_enc, len(filename_slash) + (4 - (len(filename_slash) % 4))))
-      fout.write('#ifdef HTTPD_FS_STATISTICS\n')
-      fout.write('#if HTTPD_FS_STATISTICS == 1\n')
-      fout.write('0,\n')
-      fout.write('#endif /* HTTPD_FS_STATISTICS */\n')
-      fout.write('#endif /* HTTPD_FS_STATISTICS */\n')
-      fout.write('} };\n')
-      fout.write('\n\n')
-      last_file = filename_enc
-
-    fout.write('const struct fsdata_file *fs_root = file__{};\n'.format(last_file))
-    fout.write('#ifdef HTTPD_FS_STATISTICS\n')
-    fout.write('#if HTTPD_FS_STATISTICS == 1\n')
-    fout.write('uint16_t fs_count[{}];\n'.format(filecount))
-    fout.write('#endif /* HTTPD_FS_STATISTICS */\n')
-    fout.write('#endif /* HTTPD_FS_STATISTICS */\n')
+      filename_enc = write_file(fout, file.name, data, len(entries))
+      entries.append((file.name, filename_enc, data, gzip))
+
+    write_tables(fout, entries)
+
+def generate_bench(count):
+  # A synthetic site of 'count' small assets, without minifying, for the
+  # host benchmark httpd_fs_bench.c
+  with outfile.open('w') as fout:
+    write_header(fout)
+    entries = []
+    for index in range(count):
+      suffix = extensions[index % len(extensions)]
+      name = 'assets/item{:04d}{}'.format(index, suffix)
+      data = '{} {}\n'.format(name, index).encode()
+      filename_enc = write_file(fout, name, data, index)
+      entries.append((name, filename_enc, data, suffix in gzip_extensions))
+    write_tables(fout, entries)
 
-generate_fs()
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser(description='Convert the web pages in httpd-fs to httpd-fsdata.c')
+  parser.add_argument('-o', '--output', help='output file, default ' + str(outfile))
+  parser.add_argument('--bench', type=int, metavar='N', help='write a synthetic site of N files instead')
+  args = parser.parse_args()
+  if args.output:
+    outfile = Path(args.output)
+  if args.bench:
+    generate_bench(args.bench)
+  else:
+    generate_fs()
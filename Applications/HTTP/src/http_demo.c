@@ -46,6 +46,7 @@
 #include "FreeRTOS_IP.h"
 #include "FreeRTOS_Sockets.h"
 #include "FreeRTOS_Routing.h"
+#include "NetworkBufferManagement.h"
 
 /* GreenPHY SDK includes. */
 #include "GreenPhySDKConfig.h"
@@ -53,6 +54,26 @@
 /* Project includes. */
 #include "http_query_parser.h"
 
+/* Room that the status keeps for the address fields and the closing brace, so
+that optional fields never push them out of the buffer. */
+#define httpSTATUS_TAIL_LENGTH		160
+
+/* Returns the length after an snprintf(), which reports the length it wanted to
+write rather than what fitted.  The result never points past the terminator. */
+static BaseType_t prvClampCount( BaseType_t xCount, size_t uxBufferLength )
+{
+	if( xCount < 0 )
+	{
+		xCount = 0;
+	}
+	else if( ( size_t ) xCount >= uxBufferLength )
+	{
+		xCount = ( BaseType_t ) uxBufferLength - 1;
+	}
+
+	return xCount;
+}
+
 BaseType_t xRequestHandler_Status( char *pcBuffer, size_t uxBufferLength, QueryParam_t *pxParams, BaseType_t xParamCount )
 {
 BaseType_t xCount = 0;
@@ -60,6 +81,15 @@ QueryParam_t *pxParam;
 NetworkEndPoint_t *pxEndPoint;
 uint32_t ulIPAddress, ulNetMask, ulGatewayAddress, ulDNSServerAddress;
 int8_t cBuffer[ 16 ];
+#if( ipconfigNETWORK_BUFFER_STATS != 0 )
+	static const char cHexDigits[] = "0123456789abcdef";
+	uint8_t ucStats[ 128 ];
+	size_t uxStatsLength, uxIndex;
+#endif
+#if( ipconfigEVENT_RESIDENCY_STATS != 0 )
+	const IPEventResidency_t *pxResidency;
+	BaseType_t xEventType;
+#endif
 
 	pxParam = pxFindKeyInQueryParams( "reset", pxParams, xParamCount );
 	if( pxParam != NULL )
@@ -99,6 +129,55 @@ int8_t cBuffer[ 16 ];
 			BUILD_STRING,
 			pcApplicationHostnameHook()
 	);
+	xCount = prvClampCount( xCount, uxBufferLength );
+
+#if( ipconfigNETWORK_BUFFER_STATS != 0 )
+	/* The binary record of uxNetworkBufferStatsSnapshot(), hex encoded. */
+	pxParam = pxFindKeyInQueryParams( "buffers", pxParams, xParamCount );
+	if( pxParam != NULL )
+	{
+		uxStatsLength = uxNetworkBufferStatsSnapshot( ucStats, sizeof( ucStats ) );
+		if( ( size_t ) xCount + ( 2 * uxStatsLength ) + 16 + httpSTATUS_TAIL_LENGTH < uxBufferLength )
+		{
+			xCount += snprintf( pcBuffer + xCount, uxBufferLength - xCount, "\"buffers\":\"" );
+			for( uxIndex = 0; uxIndex < uxStatsLength; uxIndex++ )
+			{
+				pcBuffer[ xCount++ ] = cHexDigits[ ucStats[ uxIndex ] >> 4 ];
+				pcBuffer[ xCount++ ] = cHexDigits[ ucStats[ uxIndex ] & 0x0F ];
+			}
+			xCount += snprintf( pcBuffer + xCount, uxBufferLength - xCount, "\"," );
+		}
+	}
+#endif
+
+#if( ipconfigEVENT_RESIDENCY_STATS != 0 )
+	/* Per IP-task event type: count, total and longest time in the queue. */
+	pxParam = pxFindKeyInQueryParams( "events", pxParams, xParamCount );
+	if( pxParam != NULL )
+	{
+		/* An entry takes at most 35 bytes: three 10-digit numbers, the commas
+		and the brackets.  Entries that do not fit are left out. */
+		if( ( size_t ) xCount + 16 + httpSTATUS_TAIL_LENGTH < uxBufferLength )
+		{
+			xCount += snprintf( pcBuffer + xCount, uxBufferLength - xCount, "\"events\":[" );
+			for( xEventType = 0; ( pxResidency = pxGetIPEventResidency( xEventType ) ) != NULL; xEventType++ )
+			{
+				if( ( size_t ) xCount + 35 + 2 + httpSTATUS_TAIL_LENGTH >= uxBufferLength )
+				{
+					break;
+				}
+				xCount += snprintf( pcBuffer + xCount, uxBufferLength - xCount, "%s[%u,%u,%u]",
+						( xEventType != 0 ) ? "," : "",
+						( unsigned ) pxResidency->ulCount,
+						( unsigned ) pxResidency->ulTotal,
+						( unsigned ) pxResidency->ulMaximum );
+				xCount = prvClampCount( xCount, uxBufferLength );
+			}
+			xCount += snprintf( pcBuffer + xCount, uxBufferLength - xCount, "]," );
+			xCount = prvClampCount( xCount, uxBufferLength );
+		}
+	}
+#endif
 
 	pxEndPoint = FreeRTOS_FirstEndPoint( NULL );
 	if( pxEndPoint != NULL )
@@ -112,6 +191,7 @@ int8_t cBuffer[ 16 ];
 				pxEndPoint->xMACAddress.ucBytes[4],
 				pxEndPoint->xMACAddress.ucBytes[5]
 		);
+		xCount = prvClampCount( xCount, uxBufferLength );
 
 		FreeRTOS_GetEndPointConfiguration( &ulIPAddress,
 										   &ulNetMask,
@@ -121,15 +201,20 @@ int8_t cBuffer[ 16 ];
 
 		FreeRTOS_inet_ntoa( ulIPAddress, cBuffer );
 		xCount += snprintf( pcBuffer + xCount, uxBufferLength - xCount, "\"ip\":\"%s\",", cBuffer);
+		xCount = prvClampCount( xCount, uxBufferLength );
 		FreeRTOS_inet_ntoa( ulNetMask, cBuffer );
 		xCount += snprintf( pcBuffer + xCount, uxBufferLength - xCount, "\"netmask\":\"%s\",", cBuffer);
+		xCount = prvClampCount( xCount, uxBufferLength );
 		FreeRTOS_inet_ntoa( ulGatewayAddress, cBuffer );
 		xCount += snprintf( pcBuffer + xCount, uxBufferLength - xCount, "\"gateway\":\"%s\",", cBuffer);
+		xCount = prvClampCount( xCount, uxBufferLength );
 		FreeRTOS_inet_ntoa( ulDNSServerAddress, cBuffer );
 		xCount += snprintf( pcBuffer + xCount, uxBufferLength - xCount, "\"dns\":\"%s\"", cBuffer);
+		xCount = prvClampCount( xCount, uxBufferLength );
 	}
 
 	xCount += snprintf( pcBuffer + xCount, uxBufferLength - xCount, "}" );
+	xCount = prvClampCount( xCount, uxBufferLength );
 
 
 	return xCount;
@@ -3292,11 +3292,27 @@ static const unsigned char data__index_html[] = {
 };
 
 
+static const char header__index_html[] =
+"HTTP/1.1 200 OK\r\n"
+"Content-Type: text/html\r\n"
+"Content-Encoding: gzip\r\n"
+"Content-Length: 52460\r\n"
+"ETag: \"cfe59ae40d8441aa\"\r\n"
+"Cache-Control: no-cache\r\n"
+"Connection: keep-alive\r\n"
+"\r\n";
+
 const struct fsdata_file file__index_html[] = { {
 file_NULL,
 data__index_html,
 data__index_html + 12,
 sizeof(data__index_html) - 12,
+"text/html",
+"\"cfe59ae40d8441aa\"",
+1,
+header__index_html,
+sizeof(header__index_html) - 1,
+89,
 #ifdef HTTPD_FS_STATISTICS
 #if HTTPD_FS_STATISTICS == 1
 0,
@@ -3306,6 +3322,18 @@ sizeof(data__index_html) - 12,
 
 
 const struct fsdata_file *fs_root = file__index_html;
+const uint16_t fs_numfiles = 1;
+
+/* Perfect hash of the file names, see httpd_fs_open(). */
+const uint8_t fs_hash_bits = 1;
+const uint16_t fs_hash_displace[2] = {
+0,0
+};
+const struct fsdata_file * const fs_hash_table[2] = {
+file_NULL,
+file__index_html
+};
+
 #ifdef HTTPD_FS_STATISTICS
 #if HTTPD_FS_STATISTICS == 1
 uint16_t fs_count[1];
@@ -94,6 +94,17 @@ then set ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM to 1 to prevent the software
 stack repeating the checksum calculations. */
 #define ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM   1
 
+/* The PLC driver calculates the checksum of a received frame while it copies
+the frame out of the SPI staging buffer, and checks the IP and protocol
+checksums with it.  The IP task then only walks packets that the driver could
+not check. */
+#define ipconfigDRIVER_VERIFIES_RX_CHECKSUM      1
+
+/* Use the Thumb-2 checksum and copy kernels for the Cortex-M3.  Set to 0 to
+fall back to the portable C loops, e.g. to compare them with the checksum
+benchmark. */
+#define ipconfigUSE_CM3_ASM_KERNELS              1
+
 /* Several API's will block until the result is known, or the action has been
 performed, for example FreeRTOS_send() and FreeRTOS_recv().  The timeouts can be
 set per socket, using setsockopt().  If not set, the times below will be
@@ -224,7 +235,23 @@ not set to 1 then only FreeRTOS_indet_addr_quick() is available. */
 are available to the IP stack.  The total number of network buffers is limited
 to ensure the total amount of RAM that can be consumed by the IP stack is capped
 to a pre-determinable value. */
-#define ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS   20
+#define ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS   36
+
+/* The buffers live in the 32 KB AHB SRAM, which used to hold 20 full sized
+buffers.  Most frames that the stack sends are ARP packets, TCP ACKs and MMEs,
+so part of that RAM is split into 16 small buffers of 128 bytes and 2 medium
+buffers of 576 bytes.  Both drivers receive into full sized buffers only, so
+18 of those are kept: 16 * 144 + 2 * 592 + 18 * 1536 = 31136 bytes, including
+the padding in front of every buffer. */
+#define ipconfigNETWORK_BUFFER_SMALL_COUNT       16
+#define ipconfigNETWORK_BUFFER_SMALL_SIZE        128
+#define ipconfigNETWORK_BUFFER_MEDIUM_COUNT      2
+#define ipconfigNETWORK_BUFFER_MEDIUM_SIZE       576
+
+/* Keep track of who holds the network buffers, how long tasks wait for them
+and how often none was available.  The figures are reported by the HTTP status
+handler when asked for "status.json?buffers". */
+#define ipconfigNETWORK_BUFFER_STATS             1
 
 #define ipconfigZERO_COPY_TX_DRIVER              1
 #define ipconfigZERO_COPY_RX_DRIVER              1
@@ -232,9 +259,21 @@ to a pre-determinable value. */
 /* A FreeRTOS queue is used to send events from application tasks to the IP
 stack.  ipconfigEVENT_QUEUE_LENGTH sets the maximum number of events that can
 be queued for processing at any one time.  The event queue must be a minimum of
-5 greater than the total number of network buffers. */
+5 greater than the total number of network buffers.  The small buffers count as
+well: packets that tasks send, e.g. UDP packets, reach the IP-task through the
+queue in buffers of any size.  36 + 5 = 41 events take 8 bytes of heap each. */
 #define ipconfigEVENT_QUEUE_LENGTH               ( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 5 )
 
+/* Socket, timer and other control events get a queue of their own, which the
+IP-task serves before the queue with received and outgoing packets.  Up to
+ipconfigEVENT_BATCH_SIZE events are handled before the IP timers are checked
+again.  The time events spend in the queues is measured with the run time
+counter, in units of 100 us. */
+#define ipconfigEVENT_PRIORITY_QUEUE_LENGTH      16
+#define ipconfigEVENT_BATCH_SIZE                 8
+#define ipconfigEVENT_RESIDENCY_STATS            1
+#define ipconfigEVENT_TIMESTAMP()                portGET_RUN_TIME_COUNTER_VALUE()
+
 /* The address of a socket is the combination of its IP address and its port
 number.  FreeRTOS_bind() is used to manually allocate a port number to a socket
 (to 'bind' the socket to a port), but manual binding is not normally necessary
@@ -256,8 +295,10 @@ aborted. */
 /* USE_TCP: Use TCP and all its features */
 #define ipconfigUSE_TCP                          ( 1 )
 
-/* USE_WIN: Let TCP use windowing mechanism. */
-#define ipconfigUSE_TCP_WIN                      ( 0 )
+/* USE_WIN: Let TCP use windowing mechanism.  The PLC link has a round trip
+time of several milliseconds, a connection that can only have one segment
+outstanding would spend most of its time waiting for ACKs. */
+#define ipconfigUSE_TCP_WIN                      ( 1 )
 
 
 /* Set ipconfigUSE_DNS to 1 to include a basic DNS client/resolver.  DNS is used
@@ -289,7 +330,7 @@ perform the filtering instead (it is much less efficient for the stack to do it
 because the packet will already have been passed into the stack).  If the
 Ethernet driver does all the necessary filtering in hardware then software
 filtering can be removed by using a value other than 1 or 0. */
-#define ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES 0 // TODO: fix this in the driver
+#define ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES 1
 
 /* Advanced only: in order to access 32-bit fields in the IP packets with
 32-bit memory instructions, all packets will be stored 32-bit-aligned, plus 16-bits.
@@ -301,7 +342,12 @@ This has to do with the contents of the IP-packets: all 32-bit fields are
 TCP socket will use up to 2 x 6 descriptors, meaning that it can have 2 x 6
 outstanding packets (for Rx and Tx).  When using up to 10 TP sockets
 simultaneously, one could define TCP_WIN_SEG_COUNT as 120. */
-#define ipconfigTCP_WIN_SEG_COUNT                12
+#define ipconfigTCP_WIN_SEG_COUNT                16
+
+/* Each connection reserves one descriptor per MSS of its windows out of the
+pool above.  When the pool runs low, new connections get smaller windows
+instead of running out of descriptors halfway a transfer. */
+#define ipconfigTCP_WIN_BUDGET                   1
 
 /* When using call-back handlers, the driver may check if the handler points to
 real program memory (RAM or flash) or just has a random non-zero value. */
@@ -350,18 +396,40 @@ FTP and HTTP servers both execute in the standard server task. */
 #define ipconfigFTP_TX_WINSIZE                   ( 1 )
 #define ipconfigFTP_RX_BUFSIZE                   ( 1 * ipconfigTCP_MSS )
 #define ipconfigFTP_RX_WINSIZE                   ( 1 )
-#define ipconfigHTTP_TX_BUFSIZE                  ( 1 * ipconfigTCP_MSS )
-#define ipconfigHTTP_TX_WINSIZE                  ( 1 )
+#define ipconfigHTTP_TX_BUFSIZE                  ( 2 * ipconfigTCP_MSS )
+#define ipconfigHTTP_TX_WINSIZE                  ( 2 )
 #define ipconfigHTTP_RX_BUFSIZE                  ( 1 * ipconfigTCP_MSS )
 #define ipconfigHTTP_RX_WINSIZE                  ( 1 )
 
 #define ipconfigTCP_COMMAND_BUFFER_SIZE          512
 #define ipconfigTCP_FILE_BUFFER_SIZE             512
 
+/* The HTTP server serves this many connections at the same time, e.g. a page
+that polls several JSON files in parallel.  The clients are static, but each
+connection takes about 4.8 KB of heap for its socket and stream buffers. */
+#define ipconfigTCP_SERVER_CLIENTS               3
+
 #define NETWORK_IRQHandler                       ETH_IRQHandler
-#define ipconfigNUM_RX_DESCRIPTORS                 4
+/* Each RX DMA descriptor holds a full sized network buffer, the EMAC driver
+keeps configEMAC_RX_RESERVE ( 2 ) more in reserve and the PLC driver one for
+the frame it is reading.  That pins 8 + 2 + 1 = 11 of the 18 full sized
+buffers, the other 7 are left for TCP segments and frames forwarded by the
+bridge.  8 descriptors absorb about 1 ms of full sized frames at 100 Mbit
+while the EMAC task waits for the CPU. */
+#define ipconfigNUM_RX_DESCRIPTORS                 8
 #define ipconfigNUM_TX_DESCRIPTORS                 4
 
+/* A frame may carry one fragment, e.g. a file body sent from flash behind the
+headers in the network buffer.  The EMAC sends a fragment in AHB SRAM with a
+second descriptor, its DMA can not read the flash, so such a frame is copied
+into one network buffer first. */
+#define ipconfigMAX_TX_FRAGMENTS                   1
+
+/* The HTTP server sends the header and the body of a file from flash with
+FREERTOS_MSG_CONST.  txStream reserves their space but does not copy them, the
+last part of each segment goes out as the fragment. */
+#define ipconfigTCP_TX_CONST_REGIONS               4
+
 #define ipconfigREAD_MAC_FROM_GREENPHY             1
 
 /* If ipconfigUSE_BRIDGE is set to 1 multiple interfaces can be bridged.
@@ -378,9 +446,10 @@ like a hub. */
 
 /* The forwarding table maps to MAC addresses to interfaces. When a frame
 arrives the forwarding table is updated with the source MAC and the receiving
-interface. ipconfigFORWARDING_TABLE_ENTRIES defines the maximum number of
-entries that can exist in the forwarding table at any one time. */
-#define ipconfigFORWARDING_TABLE_ENTRIES         32
+interface. The table is a hash table, ipconfigFORWARDING_TABLE_ENTRIES defines
+its number of slots and must be a power of 2. At most three quarters of the
+slots are used at any one time, older entries are replaced when it is full. */
+#define ipconfigFORWARDING_TABLE_ENTRIES         64
 
 /* ipconfigMAX_FORWARDING_TABLE_AGE defines the maximum time between an entry
 in the forwarding table being created or refreshed and the entry being removed
@@ -388,6 +457,29 @@ because it is stale. ipconfigUSE_FORWARDING_TABLE is specified in tens of
 seconds, so a value of 30 is equal to 300 seconds (or 5 minutes). */
 #define ipconfigMAX_FORWARDING_TABLE_AGE         30
 
+/* If ipconfigUSE_NETWORK_BUFFER_REFCOUNT is set to 1 the bridge hands a
+flooded frame to all egress interfaces without copying it. The network buffer
+is reference counted and released when the last driver has sent it. */
+#define ipconfigUSE_NETWORK_BUFFER_REFCOUNT      1
+
+/* If ipconfigBRIDGE_LATENCY_STATS is set to 1 each bridged interface keeps a
+histogram of the time frames from the other bridged interfaces take until they
+are handed to its hardware, see xBridgeLatency in NetworkInterface_t. */
+#define ipconfigBRIDGE_LATENCY_STATS             1
+
+/* If ipconfigUSE_MULTICAST_SNOOPING is set to 1 the bridge listens to IGMPv2
+and MLDv1 messages and forwards multicast frames only to interfaces with group
+members or a querier. Unknown groups are flooded as long as no querier is seen.
+ipconfigMULTICAST_GROUP_ENTRIES is the number of groups that can be known. */
+#define ipconfigUSE_MULTICAST_SNOOPING           1
+#define ipconfigMULTICAST_GROUP_ENTRIES          16
+
+/* Multicast groups listed in ipconfigMULTICAST_DROP_LIST are never forwarded to
+bridged interfaces with bits.bMulticastDropList set, e.g. to keep link-local
+name resolution off the powerline:
+#define ipconfigMULTICAST_DROP_LIST	{ { { 0x01, 0x00, 0x5E, 0x00, 0x00, 0xFB } }, { { 0x01, 0x00, 0x5E, 0x00, 0x00, 0xFC } } }
+*/
+
 #define ipconfigMULTI_INTERFACE                   1
 
 /* Defines how often the forwarding table timer callback function is executed.  The time is
@@ -40,6 +40,16 @@
 /* Includes. */
 #define includeHTTP_DEMO       1
 
+/* Print the cost of the packet copy and checksum routines at start-up. */
+#define includeCHECKSUM_BENCHMARK 0
+
+/* Print the cycles of a FreeRTOS queue and of the driver rings at start-up. */
+#define includeRING_BENCHMARK  0
+
+/* Compare the receive checksum routines of the driver with those of the
+IP-task over random frames at start-up. */
+#define includeCHECKSUM_FUZZ   0
+
 /* Clickboard defines. */
 #define includeCOLOR2_CLICK    1
 #define includeTHERMO3_CLICK   1
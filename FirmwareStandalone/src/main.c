@@ -49,6 +49,9 @@
 #include "network.h"
 #include "save_config.h"
 #include "clickboard_config.h"
+#include "checksum_benchmark.h"
+#include "ring_benchmark.h"
+#include "checksum_fuzz.h"
 
 /*-----------------------------------------------------------*/
 static void prvTestTask( void *pvParameters )
@@ -56,6 +59,18 @@ static void prvTestTask( void *pvParameters )
 
 	DEBUGOUT( "Test task running.\r\n" );
 
+#if( includeCHECKSUM_BENCHMARK != 0 )
+	vChecksumBenchmark();
+#endif
+
+#if( includeRING_BENCHMARK != 0 )
+	vRingBenchmark();
+#endif
+
+#if( includeCHECKSUM_FUZZ != 0 )
+	( void ) xChecksumFuzz( 20000U, 1U );
+#endif
+
 	/* Add endless loop here to prevent task deletion. */
 
 	vTaskDelete( NULL );
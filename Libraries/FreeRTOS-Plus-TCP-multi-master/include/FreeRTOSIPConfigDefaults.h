@@ -150,6 +150,15 @@
         #define ipconfigTCP_WIN_SEG_COUNT    ( 256 )
     #endif
 
+    #ifndef ipconfigTCP_WIN_BUDGET
+
+/* When non-zero, the window sizes of a new connection are fitted in the pool
+ * of ipconfigTCP_WIN_SEG_COUNT segment descriptors.  Each connection reserves
+ * one descriptor per MSS of its windows, so a few busy connections can not
+ * starve the others of descriptors.  Only used when ipconfigUSE_TCP_WIN is 1. */
+        #define ipconfigTCP_WIN_BUDGET    ( 0 )
+    #endif
+
     #ifndef ipconfigIGNORE_UNKNOWN_PACKETS
 
 /* When non-zero, TCP will not send RST packets in reply to
@@ -310,6 +319,38 @@
     #define ipconfigEVENT_QUEUE_LENGTH    ( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 5 )
 #endif
 
+#ifndef ipconfigEVENT_PRIORITY_QUEUE_LENGTH
+
+/* When non-zero, only received frames and packets to be sent pass through
+ * the queue of ipconfigEVENT_QUEUE_LENGTH events.  All other events, such as
+ * socket and timer events, get a queue of this length, which the IP-task
+ * always serves first.  They then no longer wait behind a burst of frames. */
+    #define ipconfigEVENT_PRIORITY_QUEUE_LENGTH    0
+#endif
+
+#ifndef ipconfigEVENT_BATCH_SIZE
+
+/* The number of events the IP-task handles in a row before it checks its
+ * timers again, as long as events are waiting. */
+    #define ipconfigEVENT_BATCH_SIZE    1
+#endif
+
+#ifndef ipconfigEVENT_RESIDENCY_STATS
+
+/* When non-zero, events are time stamped when they are queued and the IP-task
+ * keeps the number of events, the total and the longest time they waited in
+ * the queue per event type, see pxGetIPEventResidency(). */
+    #define ipconfigEVENT_RESIDENCY_STATS    0
+#endif
+
+#ifndef ipconfigEVENT_TIMESTAMP
+
+/* The clock used for ipconfigEVENT_RESIDENCY_STATS, it must be readable from
+ * interrupts too.  A free running counter gives a better resolution than the
+ * tick count. */
+    #define ipconfigEVENT_TIMESTAMP()    ( ( uint32_t ) xTaskGetTickCount() )
+#endif
+
 #ifndef ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND
     #define ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND    1
 #endif
@@ -501,6 +542,24 @@
     #define ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM    ( 0 )
 #endif
 
+#ifndef ipconfigDRIVER_VERIFIES_RX_CHECKSUM
+
+/* When non-zero, a driver that copies a received frame with
+ * usGenerateChecksumCopy() can pass the sum to vNetworkBufferSetRxChecksum().
+ * The IP-task then trusts the result stored in the network buffer and does
+ * not walk the packet a second time to check the IP and protocol checksums. */
+    #define ipconfigDRIVER_VERIFIES_RX_CHECKSUM    0
+#endif
+
+#ifndef ipconfigUSE_CM3_ASM_KERNELS
+
+/* When non-zero, usGenerateChecksum(), usGenerateChecksumCopy() and
+ * pvCopyPacketData() hand their word aligned bulk to the Thumb-2 kernels in
+ * portable/Compiler/GCC/FreeRTOS_Checksum_ARM_CM3.S.  Only for Cortex-M3/M4
+ * targets built with GCC. */
+    #define ipconfigUSE_CM3_ASM_KERNELS    0
+#endif
+
 #ifndef ipconfigETHERNET_DRIVER_FILTERS_PACKETS
     #define ipconfigETHERNET_DRIVER_FILTERS_PACKETS    ( 0 )
 #endif
@@ -630,6 +689,104 @@
     #define ipconfigUSE_LINKED_RX_MESSAGES    0
 #endif
 
+#ifndef ipconfigUSE_NETWORK_BUFFER_REFCOUNT
+
+/* When non-zero, a network buffer can be shared between several network
+ * interfaces, e.g. when the bridge floods a frame.  Every user calls
+ * vReleaseNetworkBufferAndDescriptor() and the buffer is only returned to the
+ * free list when the last reference is dropped.  The users may not modify a
+ * shared buffer.  Only supported by BufferAllocation_1.c. */
+    #define ipconfigUSE_NETWORK_BUFFER_REFCOUNT    0
+#endif
+
+#ifndef ipconfigNETWORK_BUFFER_SMALL_COUNT
+
+/* BufferAllocation_1.c can split the ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS
+ * network buffers into three size classes: small, medium and the rest with
+ * room for a full Ethernet frame.  A request is served from the smallest class
+ * that fits, or from a larger one when that class is exhausted.  ARP packets,
+ * TCP ACKs and other control frames then no longer occupy a full sized
+ * buffer.  With both counts left at zero all buffers are full sized. */
+    #define ipconfigNETWORK_BUFFER_SMALL_COUNT    0
+#endif
+
+#ifndef ipconfigNETWORK_BUFFER_SMALL_SIZE
+    #define ipconfigNETWORK_BUFFER_SMALL_SIZE    128
+#endif
+
+#ifndef ipconfigNETWORK_BUFFER_MEDIUM_COUNT
+    #define ipconfigNETWORK_BUFFER_MEDIUM_COUNT    0
+#endif
+
+#ifndef ipconfigNETWORK_BUFFER_MEDIUM_SIZE
+    #define ipconfigNETWORK_BUFFER_MEDIUM_SIZE    576
+#endif
+
+#ifndef ipconfigNETWORK_BUFFER_STATS
+
+/* When non-zero, BufferAllocation_1.c keeps track of who holds the network
+ * buffers, the lowest number of free buffers per size class, the time tasks
+ * spent waiting for a buffer and how often a buffer could not be obtained.
+ * uxNetworkBufferStatsSnapshot() returns the figures as a compact binary
+ * record. */
+    #define ipconfigNETWORK_BUFFER_STATS    0
+#endif
+
+#ifndef ipconfigMAX_TX_FRAGMENTS
+
+/* The number of fragments that may follow the data in a network buffer when a
+ * frame is sent.  A fragment points to memory outside the network buffer, e.g.
+ * a constant file body in flash, so only the headers have to be built in RAM.
+ * Drivers which set 'bits.bTxFragments' map the fragments onto their DMA
+ * descriptors, for all other drivers the frame is flattened first.  Zero
+ * disables fragments. */
+    #define ipconfigMAX_TX_FRAGMENTS    0
+#endif
+
+#ifndef ipconfigTCP_TX_CONST_REGIONS
+
+/* The number of ranges in the txStream of a TCP socket that may refer to
+ * constant memory.  FreeRTOS_send() with FREERTOS_MSG_CONST only reserves
+ * space in txStream for such data, the bytes are read from their own memory
+ * when a segment is built.  When all ranges are in use, the data is copied.
+ * Zero disables it, FREERTOS_MSG_CONST is then ignored. */
+    #define ipconfigTCP_TX_CONST_REGIONS    0
+#endif
+
+#ifndef ipconfigUSE_MULTICAST_SNOOPING
+
+/* When non-zero, the bridge learns multicast group members from IGMPv2 and
+ * MLDv1 reports and only forwards multicast frames to interfaces behind which
+ * members or a querier were seen. */
+    #define ipconfigUSE_MULTICAST_SNOOPING    0
+#endif
+
+#ifndef ipconfigMULTICAST_GROUP_ENTRIES
+    #define ipconfigMULTICAST_GROUP_ENTRIES    16
+#endif
+
+#ifndef ipconfigMULTICAST_GROUP_PORTS
+
+/* The maximum number of bridged interfaces for which group membership is
+ * kept. */
+    #define ipconfigMULTICAST_GROUP_PORTS    4
+#endif
+
+#ifndef ipconfigMAX_MULTICAST_GROUP_AGE
+
+/* In units of ipFORWARDING_TABLE_TIMER_PERIOD_MS, 26 equals the default
+ * IGMP group membership interval of 260 seconds. */
+    #define ipconfigMAX_MULTICAST_GROUP_AGE    26
+#endif
+
+#ifndef ipconfigBRIDGE_LATENCY_STATS
+
+/* When non-zero, the network drivers time stamp received frames and every
+ * bridged interface keeps a histogram of the time it took to forward frames
+ * from another bridged interface.  Requires driver support. */
+    #define ipconfigBRIDGE_LATENCY_STATS    0
+#endif
+
 #ifndef ipconfigBUFFER_PADDING
 
 /* Expert option: define a value for 'ipBUFFER_PADDING'.
@@ -67,6 +67,33 @@ extern "C" {
 /* Age value for forwarding table entries that do not expire. */
 #define INFINITE_FORWARDING_TABLE_AGE ( 255 )
 
+/* Usage counters of the forwarding table. */
+typedef struct xFORWARDING_TABLE_STATS
+{
+	uint32_t ulLookupHits;		/* Destination MACs found in the table. */
+	uint32_t ulLookupMisses;	/* Destination MACs not found, the frame was flooded. */
+	uint32_t ulEvictions;		/* Entries removed to make room for a new MAC. */
+	UBaseType_t uxEntries;		/* The number of entries currently in use. */
+} ForwardingTableStats_t;
+
+/* Counters of the multicast snooping. */
+typedef struct xMULTICAST_SNOOPING_STATS
+{
+	uint32_t ulFlooded;			/* Multicast frames sent to all bridged interfaces. */
+	uint32_t ulFiltered;		/* Multicast frames withheld from interfaces without group members. */
+	uint32_t ulDropped;			/* Multicast frames withheld because of the drop list. */
+	uint32_t ulReports;			/* IGMP and MLD membership reports seen. */
+	uint32_t ulLeaves;			/* IGMP leave and MLD done messages seen. */
+	uint32_t ulQueries;			/* IGMP and MLD queries seen. */
+	UBaseType_t uxGroups;		/* The number of groups currently known. */
+} MulticastSnoopingStats_t;
+
+/*
+ * Look up the interface through which a MAC address can be reached. Returns
+ * NULL if the MAC is not in the forwarding table.
+ */
+NetworkInterface_t *pxFindInterfaceOnMAC( const MACAddress_t *pxMACAddress );
+
 /*
  *
  */
@@ -78,6 +105,17 @@ void vRefreshForwardingTableEntry( const MACAddress_t *pxMACAddress, NetworkInte
  */
 void vAgeForwardingTable( void );
 
+/*
+ * Copy the usage counters of the forwarding table.
+ */
+void vGetForwardingTableStats( ForwardingTableStats_t *pxStats );
+
+/*
+ * Read the forwarding table slot uxIndex, which ranges from 0 to
+ * ipconfigFORWARDING_TABLE_ENTRIES - 1. Returns pdFALSE if the slot is free.
+ */
+BaseType_t xGetForwardingTableEntry( UBaseType_t uxIndex, MACAddress_t *pxMACAddress, NetworkInterface_t **ppxInterface, uint8_t *pucAge, uint32_t *pulHits );
+
 /*
  * Get the first bridged interface.
  */
@@ -96,6 +134,23 @@ NetworkInterface_t *FreeRTOS_NextNetworkInterfaceInBridge( NetworkInterface_t *p
  */
 BaseType_t xBridge_Process( NetworkBufferDescriptor_t * const pxNetworkBuffer );
 
+#if( ipconfigUSE_MULTICAST_SNOOPING != 0 )
+	/*
+	 * Copy the counters of the multicast snooping.
+	 */
+	void vGetMulticastSnoopingStats( MulticastSnoopingStats_t *pxStats );
+#endif
+
+#if( ipconfigBRIDGE_LATENCY_STATS != 0 )
+	/*
+	 * Called by a driver when it hands a frame to the hardware. If the frame was
+	 * received on another bridged interface, the time since its reception is
+	 * added to the latency histogram of pxInterface. ulNow and the receive time
+	 * stamp are CPU cycle counts.
+	 */
+	void vBridgeLatencySample( NetworkInterface_t *pxInterface, const NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulNow );
+#endif
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
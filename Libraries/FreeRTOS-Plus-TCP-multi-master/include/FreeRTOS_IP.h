@@ -163,6 +163,17 @@
     struct xNetworkEndPoint;
     struct xNetworkInterface;
 
+    #if ( ipconfigMAX_TX_FRAGMENTS != 0 )
+
+/* A piece of a frame that is sent straight from memory outside the network
+ * buffer.  The memory must not change until the frame has been sent. */
+        typedef struct xNETWORK_FRAGMENT
+        {
+            const uint8_t * pucData; /* Start of the fragment. */
+            size_t xLength;          /* Number of bytes in the fragment. */
+        } NetworkFragment_t;
+    #endif
+
 /* The structure used to store buffers and pass them around the network stack.
  * Buffers can be in use by the stack, in use by the network interface hardware
  * driver, or free (not in use). */
@@ -179,6 +190,22 @@
         #if ( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
             struct xNETWORK_BUFFER * pxNextBuffer; /* Possible optimisation for expert users - requires network driver support. */
         #endif
+        #if ( ipconfigUSE_NETWORK_BUFFER_REFCOUNT != 0 )
+            uint8_t ucRefCount;                    /* The number of users sharing the buffer, it is freed when this drops to zero. */
+        #endif
+        #if ( ipconfigNETWORK_BUFFER_STATS != 0 )
+            uint8_t ucOwner;                       /* The NetworkBufferOwner_t which holds the buffer at the moment. */
+        #endif
+        #if ( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+            uint8_t ucRxChecksum;                  /* ipRX_CHECKSUM_UNKNOWN, _GOOD or _BAD, as found by the driver. */
+        #endif
+        #if ( ipconfigBRIDGE_LATENCY_STATS != 0 )
+            uint32_t ulRxTimestamp;                /* CPU cycle counter at the time the frame was received. */
+        #endif
+        #if ( ipconfigMAX_TX_FRAGMENTS != 0 )
+            UBaseType_t uxFragmentCount;           /* Number of fragments sent after the first xDataLength bytes. */
+            NetworkFragment_t xFragments[ ipconfigMAX_TX_FRAGMENTS ]; /* Data sent straight from its own memory. */
+        #endif
         #if ( ipconfigUSE_IPv6 != 0 )
             IPv6_Address_t xIPv6_Address;
         #endif
@@ -449,6 +476,19 @@
         UBaseType_t uxGetMinimumIPQueueSpace( void );
     #endif
 
+    #if ( ipconfigEVENT_RESIDENCY_STATS != 0 )
+        typedef struct xIP_EVENT_RESIDENCY
+        {
+            uint32_t ulCount;   /* The number of events of this type taken from the queue. */
+            uint32_t ulTotal;   /* The sum of the times they waited, in ipconfigEVENT_TIMESTAMP() units. */
+            uint32_t ulMaximum; /* The longest time an event waited. */
+        } IPEventResidency_t;
+
+/* Get the queue residency of the events of type xEventType, an eIPEvent_t.
+ * Returns NULL for an unknown type. */
+        const IPEventResidency_t * pxGetIPEventResidency( BaseType_t xEventType );
+    #endif
+
     #if ( ipconfigHAS_PRINTF != 0 )
         extern void vPrintResourceStats( void );
     #else
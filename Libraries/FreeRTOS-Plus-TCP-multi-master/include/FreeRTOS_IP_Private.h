@@ -557,8 +557,14 @@
     {
         eIPEvent_t eEventType; /**< The event-type enum */
         void * pvData;         /**< The data in the event */
+        #if ( ipconfigEVENT_RESIDENCY_STATS != 0 )
+            uint32_t ulQueueTime; /**< ipconfigEVENT_TIMESTAMP() when the event was queued. */
+        #endif
     } IPStackEvent_t;
 
+/* The number of event types, eNoEvent not included. */
+    #define ipEVENT_TYPE_COUNT    ( ( BaseType_t ) eSocketSignalEvent + 1 )
+
     #define ipBROADCAST_IP_ADDRESS    0xffffffffUL
 
 
@@ -768,6 +774,75 @@
                                  const uint8_t * pucNextData,
                                  size_t uxByteCount );
 
+/*
+ * Copy uxByteCount bytes and return the same checksum as usGenerateChecksum()
+ * would over the destination, in a single pass.
+ */
+    uint16_t usGenerateChecksumCopy( uint16_t usSum,
+                                     uint8_t * pucDestination,
+                                     const uint8_t * pucSource,
+                                     size_t uxByteCount );
+
+/*
+ * Add the checksum usPart of a block that starts at uxOffset within a frame
+ * to usSum, the checksum of the frame so far.
+ */
+    uint16_t usChecksumAddBlock( uint16_t usSum,
+                                 uint16_t usPart,
+                                 size_t uxOffset );
+
+/*
+ * memcpy() for packet data.  When both pointers have the same alignment, the
+ * bulk is moved a word at a time.
+ */
+    void * pvCopyPacketData( void * pvDestination,
+                             const void * pvSource,
+                             size_t uxByteCount );
+
+/* The assembly kernels are only used when the target can run them, a host
+ * build of the same configuration falls back to the C loops. */
+    #if ( ipconfigUSE_CM3_ASM_KERNELS != 0 ) && defined( __GNUC__ ) && ( defined( __ARM_ARCH_7M__ ) || defined( __ARM_ARCH_7EM__ ) )
+        #define ipUSE_CM3_ASM_KERNELS    1
+    #else
+        #define ipUSE_CM3_ASM_KERNELS    0
+    #endif
+
+    #if ( ipUSE_CM3_ASM_KERNELS != 0 )
+
+/*
+ * The Thumb-2 kernels in portable/Compiler/GCC/FreeRTOS_Checksum_ARM_CM3.S.
+ * All pointers must be word aligned.  The sums are 32-bit one's complement
+ * sums that still have to be folded to 16 bits.
+ */
+        uint32_t ulChecksumWordsCM3( const uint32_t * pulData,
+                                     size_t uxWords,
+                                     uint32_t ulSum );
+
+        uint32_t ulChecksumCopyWordsCM3( uint32_t * pulDestination,
+                                         const uint32_t * pulSource,
+                                         size_t uxWords,
+                                         uint32_t ulSum );
+
+        void vCopyWordsCM3( uint32_t * pulDestination,
+                            const uint32_t * pulSource,
+                            size_t uxWords );
+    #endif /* ipUSE_CM3_ASM_KERNELS != 0 */
+
+    #if ( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+
+/* The result of the checksum verification done by the driver. */
+        #define ipRX_CHECKSUM_UNKNOWN    0U /* Not verified, the IP-task checks the packet. */
+        #define ipRX_CHECKSUM_GOOD       1U /* The IP header and protocol checksums are correct. */
+        #define ipRX_CHECKSUM_BAD        2U /* A checksum is wrong, the packet will be dropped. */
+
+/*
+ * Verify the IPv4 header and TCP/UDP/ICMP/IGMP checksums of a received frame,
+ * given usFrameSum, the checksum over all xDataLength bytes of the frame.
+ */
+        void vNetworkBufferSetRxChecksum( NetworkBufferDescriptor_t * pxNetworkBuffer,
+                                          uint16_t usFrameSum );
+    #endif
+
 /* Socket related private functions. */
 
 /*
@@ -834,6 +909,20 @@
             } u; /**< The structure to give an alignment of 8 + 2 */
         } LastTCPPacket_t;
 
+        #if ( ipconfigTCP_TX_CONST_REGIONS != 0 )
+
+/**
+ * A range of txStream of which the bytes are not stored in txStream itself,
+ * but in constant memory.  See FREERTOS_MSG_CONST.
+ */
+            typedef struct xTCP_CONST_REGION
+            {
+                const uint8_t * pucData; /**< The first byte that has not been acknowledged yet. */
+                size_t uxStart;          /**< The position of that byte in txStream. */
+                size_t uxLength;         /**< The number of bytes left, zero for a free entry. */
+            } TCPConstRegion_t;
+        #endif /* ipconfigTCP_TX_CONST_REGIONS */
+
 /**
  * Note that the values of all short and long integers in these structs
  * are being stored in the native-endian way
@@ -902,6 +991,9 @@
             size_t uxTxStreamSize;                        /**< The transmit stream size */
             StreamBuffer_t * rxStream;                    /**< The pointer to the receive stream buffer. */
             StreamBuffer_t * txStream;                    /**< The pointer to the transmit stream buffer. */
+            #if ( ipconfigTCP_TX_CONST_REGIONS != 0 )
+                TCPConstRegion_t xConstRegions[ ipconfigTCP_TX_CONST_REGIONS ]; /**< Parts of txStream that are read from constant memory. */
+            #endif
             #if ( ipconfigUSE_TCP_WIN == 1 )
                 NetworkBufferDescriptor_t * pxAckMessage; /**< The pointer to the ACK message */
             #endif /* ipconfigUSE_TCP_WIN */
@@ -1148,6 +1240,12 @@
     BaseType_t xSendEventStructToIPTask( const IPStackEvent_t * pxEvent,
                                          TickType_t uxTimeout );
 
+/*
+ * The same as above, for use from an interrupt.
+ */
+    BaseType_t xSendEventStructToIPTaskFromISR( const IPStackEvent_t * pxEvent,
+                                                BaseType_t * pxHigherPriorityTaskWoken );
+
 /*
  * Returns a pointer to the original NetworkBuffer from a pointer to a UDP
  * payload buffer.
@@ -54,6 +54,21 @@
 /* Return true as long as the LinkStatus on the PHY is present. */
     typedef BaseType_t ( * GetPhyLinkStatusFunction_t ) ( struct xNetworkInterface * /* pxDescriptor */ );
 
+    #if ( ipconfigUSE_BRIDGE != 0 ) && ( ipconfigBRIDGE_LATENCY_STATS != 0 )
+
+/* Number of buckets of the bridge latency histogram. Bucket 0 counts frames
+ * forwarded in less than 8 us, every next bucket doubles the limit, the last
+ * bucket counts everything above. */
+        #define ipBRIDGE_LATENCY_BUCKETS    10
+
+        typedef struct xBRIDGE_LATENCY
+        {
+            uint32_t ulFrames;                                /* Number of frames that were forwarded to this interface. */
+            uint32_t ulMaxMicroSeconds;                       /* The longest forwarding time seen. */
+            uint32_t ulBuckets[ ipBRIDGE_LATENCY_BUCKETS ];
+        } BridgeLatency_t;
+    #endif
+
 /* These NetworkInterface access functions are collected in a struct: */
 
     typedef struct xNetworkInterface
@@ -69,14 +84,19 @@
 			#if( ipconfigUSE_BRIDGE )
 				bIsBridged : 1,
 				bForwardingTableKnown : 1,
+				bMulticastDropList : 1,
 				bInterfaceInitialised : 1,
 			#endif
                 bInterfaceUp : 1,
-                bCallDownEvent : 1;
+                bCallDownEvent : 1,
+                bTxFragments : 1; /* The driver sends the fragments of a network buffer itself. */
         } bits;
 
         struct xNetworkEndPoint * pxEndPoint;
         struct xNetworkInterface * pxNext;
+        #if ( ipconfigUSE_BRIDGE != 0 ) && ( ipconfigBRIDGE_LATENCY_STATS != 0 )
+            BridgeLatency_t xBridgeLatency; /* Time between reception on another bridged interface and transmission on this one. */
+        #endif
     } NetworkInterface_t;
 
 /*
@@ -122,7 +122,7 @@
     #define FREERTOS_SO_REUSE_LISTEN_SOCKET       ( 11 ) /* When a listening socket gets connected, do not create a new one but re-use it */
     #define FREERTOS_SO_CLOSE_AFTER_SEND          ( 12 ) /* As soon as the last byte has been transmitted, finalise the connection */
     #define FREERTOS_SO_WIN_PROPERTIES            ( 13 ) /* Set all buffer and window properties in one call, parameter is pointer to WinProperties_t */
-    #define FREERTOS_SO_SET_FULL_SIZE             ( 14 ) /* Refuse to send packets smaller than MSS  */
+    #define FREERTOS_SO_SET_FULL_SIZE             ( 14 ) /* Refuse to send packets smaller than MSS, like TCP_CORK: clearing it sends the rest at once. Set it after connecting. */
 
     #define FREERTOS_SO_STOP_RX                   ( 15 ) /* Temporarily hold up reception, used by streaming client */
 
@@ -149,6 +149,7 @@
     #define FREERTOS_MSG_PEEK                         ( 4 )   /* peek at incoming message */
     #define FREERTOS_MSG_DONTROUTE                    ( 8 )   /* send without using routing tables */
     #define FREERTOS_MSG_DONTWAIT                     ( 16 )  /* Can be used with recvfrom(), sendto(), recv(), and send(). */
+    #define FREERTOS_MSG_CONST                        ( 32 )  /* send(): refer to constant data, e.g. in flash, instead of copying it. */
 
     #define FREERTOS_INADDR_ANY                       ( 0UL ) /* The 0.0.0.0 IPv4 address. */
 
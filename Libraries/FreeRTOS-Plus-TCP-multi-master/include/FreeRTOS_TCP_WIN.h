@@ -97,8 +97,10 @@
                 uint32_t
                     bHasInit : 1,      /* The window structure has been initialised */
                     bSendFullSize : 1, /* May only send packets with a size equal to MSS (for optimisation) */
-                    bTimeStamps : 1;   /* Socket is supposed to use TCP time-stamps. This depends on the */
-            } bits;                    /* party which opens the connection */
+                    bTimeStamps : 1,   /* Socket is supposed to use TCP time-stamps. This depends on the */
+                                       /* party which opens the connection */
+                    bFastRecovery : 1; /* NewReno: a lost segment was retransmitted after duplicate ACKs */
+            } bits;
             uint32_t ulFlags;
         } u;
         TCPWinSize_t xSize;
@@ -125,6 +127,11 @@
             uint32_t ulOptionsData[ ipSIZE_TCP_OPTIONS / sizeof( uint32_t ) ]; /* Contains the options we send out */
             List_t xTxSegments;                                                /* A linked list of all transmission segments, sorted on sequence number */
             List_t xRxSegments;                                                /* A linked list of reception segments, order depends on sequence of arrival */
+            uint32_t ulRecoverSequenceNumber;                                  /* NewReno: tx.ulHighestSequenceNumber when fast recovery started */
+            uint8_t ucDupAckCount;                                             /* The number of duplicate ACKs for tx.ulCurrentSequenceNumber */
+            #if ( ipconfigTCP_WIN_BUDGET != 0 )
+                UBaseType_t uxBudget;                                          /* The number of segment descriptors reserved by vTCPWindowBudget() */
+            #endif
         #else
             /* For tiny TCP, there is only 1 outstanding TX segment */
             TCPSegment_t xTxSegment; /* Priority queue */
@@ -152,7 +159,19 @@
 
 /* Destroy a window (always returns NULL)
  * It will free some resources: a collection of segments */
-    void vTCPWindowDestroy( TCPWindow_t const * pxWindow );
+    void vTCPWindowDestroy( TCPWindow_t * pxWindow );
+
+    #if ( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_WIN_BUDGET != 0 )
+
+/* Fit the window sizes (in units of MSS) of a new connection in the pool of
+ * segment descriptors, and reserve them. */
+        void vTCPWindowBudget( TCPWindow_t * pxWindow,
+                               size_t * puxRxWinSize,
+                               size_t * puxTxWinSize );
+
+/* The number of segment descriptors reserved by all connections. */
+        UBaseType_t uxTCPWindowBudgetReserved( void );
+    #endif
 
 /* Initialize a window */
     void vTCPWindowInit( TCPWindow_t * pxWindow,
@@ -217,6 +236,14 @@
                                 uint32_t ulFirst,
                                 uint32_t ulLast );
 
+    #if ( ipconfigUSE_TCP_WIN == 1 )
+
+/* Receive an ACK without data or window change, which does not advance
+ * tx.ulCurrentSequenceNumber */
+        void vTCPWindowTxDuplicateAck( TCPWindow_t * pxWindow,
+                                       uint32_t ulSequenceNumber );
+    #endif
+
 
     #ifdef __cplusplus
         } /* extern "C" */
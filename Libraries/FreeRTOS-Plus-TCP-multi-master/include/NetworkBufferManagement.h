@@ -40,9 +40,18 @@
     uint8_t * pucGetNetworkBuffer( size_t * pxRequestedSizeBytes );
     void vReleaseNetworkBuffer( uint8_t * pucEthernetBuffer );
 
+/* The network buffer descriptors are ordered by size class: first the small,
+ * then the medium and last the full sized buffers. */
+    #define ipNETWORK_BUFFER_FULL_COUNT \
+    ( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - ipconfigNETWORK_BUFFER_SMALL_COUNT - ipconfigNETWORK_BUFFER_MEDIUM_COUNT )
+
 /* Get the current number of free network buffers. */
     UBaseType_t uxGetNumberOfFreeNetworkBuffers( void );
 
+/* Get the current number of free network buffers that can hold
+ * xRequestedSizeBytes, i.e. those of the matching and the larger size classes. */
+    UBaseType_t uxGetNumberOfFreeNetworkBuffersOfSize( size_t xRequestedSizeBytes );
+
 /* Get the lowest number of free network buffers. */
     UBaseType_t uxGetMinimumFreeNetworkBuffers( void );
 
@@ -55,6 +64,64 @@
     NetworkBufferDescriptor_t * pxResizeNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * pxDescriptor,
                                                                      size_t xByteCount );
 
+    #if ( ipconfigUSE_NETWORK_BUFFER_REFCOUNT != 0 )
+
+/* Share a Network Buffer with one more user.  Every user must release it, the
+ * buffer is freed when the last reference is released. */
+        NetworkBufferDescriptor_t * pxNetworkBufferAddReference( NetworkBufferDescriptor_t * const pxNetworkBuffer );
+    #endif
+
+    #if ( ipconfigMAX_TX_FRAGMENTS != 0 )
+
+/* Append a fragment to a frame that is about to be sent.  Returns pdFAIL when
+ * all fragment slots are in use. */
+        BaseType_t xNetworkBufferAddFragment( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                              const uint8_t * pucData,
+                                              size_t xLength );
+
+/* Copy the fragments behind the data in the buffer itself, for interfaces that
+ * can only send a contiguous frame.  Returns pdFAIL when they do not fit. */
+        BaseType_t xNetworkBufferFlattenFragments( NetworkBufferDescriptor_t * const pxNetworkBuffer );
+    #endif
+
+    #if ( ipconfigNETWORK_BUFFER_STATS != 0 )
+
+/* The parties that can hold a network buffer, see vNetworkBufferSetOwner(). */
+        typedef enum eNETWORK_BUFFER_OWNER
+        {
+            eNetworkBufferOwnerApplication = 0, /* Obtained outside the IP-task, not handed over yet. */
+            eNetworkBufferOwnerIPTask,          /* Being processed by the IP-task. */
+            eNetworkBufferOwnerPLC,             /* Held by the PLC driver, for reception or in a TX queue. */
+            eNetworkBufferOwnerEthernet,        /* Held by the Ethernet driver, for reception or in a TX queue. */
+            eNetworkBufferOwnerBridge,          /* Being forwarded by the bridge. */
+            eNetworkBufferOwnerSocket,          /* Waiting in a UDP socket or read by its user. */
+            eNetworkBufferOwnerCount
+        } NetworkBufferOwner_t;
+
+/* Record that a network buffer was handed over to another party. */
+        void vNetworkBufferSetOwner( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                     NetworkBufferOwner_t eOwner );
+
+/* Count a frame that was dropped, or a buffer that was not taken, because too
+ * few network buffers were free. */
+        void vNetworkBufferStarved( NetworkBufferOwner_t eOwner );
+
+/* Write the statistics as a binary record, all fields little endian:
+ *   uint8_t  version (1), number of size classes, number of owners, 0
+ *   per size class: uint16_t size, count, free, lowest free
+ *   per owner: uint16_t buffers held, most buffers held; uint32_t starved
+ *   uint32_t allocation failures, blocking waits, ticks waited, longest wait
+ * Returns the number of bytes written, or 0 when pucBuffer is too small. */
+        size_t uxNetworkBufferStatsSnapshot( uint8_t * pucBuffer,
+                                             size_t uxBufferLength );
+
+        #define ipNETWORK_BUFFER_SET_OWNER( pxNetworkBuffer, eOwner )    vNetworkBufferSetOwner( ( pxNetworkBuffer ), ( eOwner ) )
+        #define ipNETWORK_BUFFER_STARVED( eOwner )                       vNetworkBufferStarved( eOwner )
+    #else
+        #define ipNETWORK_BUFFER_SET_OWNER( pxNetworkBuffer, eOwner )
+        #define ipNETWORK_BUFFER_STARVED( eOwner )
+    #endif /* ipconfigNETWORK_BUFFER_STATS */
+
     #if ipconfigTCP_IP_SANITY
 
 /*
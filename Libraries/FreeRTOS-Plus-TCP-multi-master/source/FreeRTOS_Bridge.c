@@ -77,113 +77,700 @@
 /* Exclude the entire file if bridge support is not enabled. */
 #if( ipconfigUSE_BRIDGE != 0 )
 
+#if( ipconfigUSE_MULTICAST_SNOOPING != 0 )
+
+#if( ipconfigUSE_FORWARDING_TABLE == 0 )
+	#error ipconfigUSE_MULTICAST_SNOOPING requires ipconfigUSE_FORWARDING_TABLE
+#endif
+
+/* Offsets and values used to recognise IGMP and MLD messages. */
+#define bridgeIGMP_PROTOCOL				( 2U )
+#define bridgeIGMP_QUERY				( 0x11U )
+#define bridgeIGMPv1_REPORT				( 0x12U )
+#define bridgeIGMPv2_REPORT				( 0x16U )
+#define bridgeIGMPv2_LEAVE				( 0x17U )
+#define bridgeIGMPv3_REPORT				( 0x22U )
+#define bridgeIPv6_HOP_BY_HOP			( 0U )
+#define bridgeIPv6_ICMP					( 58U )
+#define bridgeMLD_QUERY					( 130U )
+#define bridgeMLDv1_REPORT				( 131U )
+#define bridgeMLDv1_DONE				( 132U )
+#define bridgeMLDv2_REPORT				( 143U )
+#define bridgeIPv6_HEADER_LENGTH		( 40U )
+
+typedef struct xMULTICAST_GROUP_ROW
+{
+	MACAddress_t xGroupMAC;									/* The multicast MAC address of the group. */
+	uint8_t ucAge[ ipconfigMULTICAST_GROUP_PORTS ];		/* Per bridged interface, 0 if it has no members of the group. */
+} MulticastGroupRow_t;
+
+static MulticastGroupRow_t xMulticastGroups[ ipconfigMULTICAST_GROUP_ENTRIES ];
+
+/* Interfaces on which a querier was seen get all multicast traffic. */
+static uint8_t ucRouterPortAge[ ipconfigMULTICAST_GROUP_PORTS ];
+
+static MulticastSnoopingStats_t xMulticastStats;
+
+#ifdef ipconfigMULTICAST_DROP_LIST
+	/* Multicast groups that are never forwarded to interfaces that have
+	bMulticastDropList set. */
+	static const MACAddress_t xMulticastDropList[] = ipconfigMULTICAST_DROP_LIST;
+#endif
+
+/* The index of a bridged interface, used for the per interface ages. */
+static BaseType_t prvPortIndex( const NetworkInterface_t *pxInterface )
+{
+NetworkInterface_t *pxPort;
+BaseType_t xIndex = 0;
+
+	for( pxPort = FreeRTOS_FirstNetworkInterfaceInBridge();
+		 ( pxPort != NULL ) && ( xIndex < ipconfigMULTICAST_GROUP_PORTS );
+		 pxPort = FreeRTOS_NextNetworkInterfaceInBridge( pxPort ) )
+	{
+		if( pxPort == pxInterface )
+		{
+			return xIndex;
+		}
+		xIndex++;
+	}
+
+	return -1;
+}
+/*-----------------------------------------------------------*/
+
+/* Groups in the IPv4 local network control block 224.0.0.x, the well known
+IPv6 groups and the IPv6 solicited-node groups are always flooded, as are
+non-IP multicasts. */
+static BaseType_t prvIsSnoopedGroup( const MACAddress_t *pxGroupMAC )
+{
+BaseType_t xReturn = pdFALSE;
+
+	if( ( pxGroupMAC->ucBytes[ 0 ] == 0x01U ) && ( pxGroupMAC->ucBytes[ 1 ] == 0x00U ) && ( pxGroupMAC->ucBytes[ 2 ] == 0x5EU ) )
+	{
+		if( ( pxGroupMAC->ucBytes[ 3 ] != 0x00U ) || ( pxGroupMAC->ucBytes[ 4 ] != 0x00U ) )
+		{
+			xReturn = pdTRUE;
+		}
+	}
+	else if( ( pxGroupMAC->ucBytes[ 0 ] == 0x33U ) && ( pxGroupMAC->ucBytes[ 1 ] == 0x33U ) )
+	{
+		if( ( pxGroupMAC->ucBytes[ 2 ] != 0xFFU ) && ( ( pxGroupMAC->ucBytes[ 2 ] != 0x00U ) || ( pxGroupMAC->ucBytes[ 3 ] != 0x00U ) ) )
+		{
+			xReturn = pdTRUE;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+/* Call with the table locked. */
+static MulticastGroupRow_t *prvFindGroup( const MACAddress_t *pxGroupMAC )
+{
+BaseType_t x, xPort;
+
+	for( x = 0; x < ipconfigMULTICAST_GROUP_ENTRIES; x++ )
+	{
+		for( xPort = 0; xPort < ipconfigMULTICAST_GROUP_PORTS; xPort++ )
+		{
+			if( xMulticastGroups[ x ].ucAge[ xPort ] != 0U )
+			{
+				break;
+			}
+		}
+
+		if( ( xPort < ipconfigMULTICAST_GROUP_PORTS ) &&
+			( memcmp( xMulticastGroups[ x ].xGroupMAC.ucBytes, pxGroupMAC->ucBytes, ipMAC_ADDRESS_LENGTH_BYTES ) == 0 ) )
+		{
+			return &( xMulticastGroups[ x ] );
+		}
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvUpdateGroup( const MACAddress_t *pxGroupMAC, BaseType_t xPort, uint8_t ucAge )
+{
+MulticastGroupRow_t *pxGroup;
+BaseType_t x, xIndex, xUsed;
+
+	if( prvIsSnoopedGroup( pxGroupMAC ) == pdFALSE )
+	{
+		return;
+	}
+
+	taskENTER_CRITICAL();
+	{
+		pxGroup = prvFindGroup( pxGroupMAC );
+
+		if( ( pxGroup == NULL ) && ( ucAge != 1U ) )
+		{
+			/* A new group, look for a free row. */
+			for( x = 0; ( x < ipconfigMULTICAST_GROUP_ENTRIES ) && ( pxGroup == NULL ); x++ )
+			{
+				xUsed = pdFALSE;
+				for( xIndex = 0; xIndex < ipconfigMULTICAST_GROUP_PORTS; xIndex++ )
+				{
+					if( xMulticastGroups[ x ].ucAge[ xIndex ] != 0U )
+					{
+						xUsed = pdTRUE;
+					}
+				}
+
+				if( xUsed == pdFALSE )
+				{
+					pxGroup = &( xMulticastGroups[ x ] );
+					memcpy( pxGroup->xGroupMAC.ucBytes, pxGroupMAC->ucBytes, ipMAC_ADDRESS_LENGTH_BYTES );
+					xMulticastStats.uxGroups++;
+				}
+			}
+
+			if( pxGroup == NULL )
+			{
+				/* The table is full. The interface gets all multicast traffic,
+				so the new member does not miss its group. */
+				ucRouterPortAge[ xPort ] = ucAge;
+			}
+		}
+
+		if( pxGroup != NULL )
+		{
+			pxGroup->ucAge[ xPort ] = ucAge;
+		}
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+/* Learn group memberships and queriers from IGMP and MLD messages. */
+static void prvSnoopMulticast( const NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+const uint8_t *pucFrame = pxNetworkBuffer->pucEthernetBuffer;
+const EthernetHeader_t *pxEthernetHeader = ( const EthernetHeader_t * ) pucFrame;
+size_t uxOffset = sizeof( EthernetHeader_t );
+size_t uxLength = pxNetworkBuffer->xDataLength;
+BaseType_t xPort;
+MACAddress_t xGroupMAC;
+uint8_t ucType;
+uint8_t ucNextHeader;
+
+	xPort = prvPortIndex( pxNetworkBuffer->pxInterface );
+	if( xPort < 0 )
+	{
+		return;
+	}
+
+	if( pxEthernetHeader->usFrameType == ipIPv4_FRAME_TYPE )
+	{
+		if( ( uxLength < uxOffset + ipSIZE_OF_IPv4_HEADER ) || ( pucFrame[ uxOffset + 9U ] != bridgeIGMP_PROTOCOL ) )
+		{
+			return;
+		}
+		uxOffset += ( size_t ) ( pucFrame[ uxOffset ] & 0x0FU ) * 4U;
+		if( uxLength < uxOffset + 8U )
+		{
+			return;
+		}
+
+		ucType = pucFrame[ uxOffset ];
+		xGroupMAC.ucBytes[ 0 ] = 0x01U;
+		xGroupMAC.ucBytes[ 1 ] = 0x00U;
+		xGroupMAC.ucBytes[ 2 ] = 0x5EU;
+		xGroupMAC.ucBytes[ 3 ] = pucFrame[ uxOffset + 5U ] & 0x7FU;
+		xGroupMAC.ucBytes[ 4 ] = pucFrame[ uxOffset + 6U ];
+		xGroupMAC.ucBytes[ 5 ] = pucFrame[ uxOffset + 7U ];
+
+		switch( ucType )
+		{
+			case bridgeIGMPv1_REPORT:
+			case bridgeIGMPv2_REPORT:
+				xMulticastStats.ulReports++;
+				prvUpdateGroup( &xGroupMAC, xPort, ipconfigMAX_MULTICAST_GROUP_AGE );
+				break;
+			case bridgeIGMPv2_LEAVE:
+				/* Other members may remain behind the interface. They answer the
+				query that follows a leave, otherwise the group times out at the
+				next ageing period. */
+				xMulticastStats.ulLeaves++;
+				prvUpdateGroup( &xGroupMAC, xPort, 1U );
+				break;
+			case bridgeIGMPv3_REPORT:
+				/* Version 3 reports are not parsed, the interface gets all
+				multicast traffic like a querier. */
+				xMulticastStats.ulReports++;
+				ucRouterPortAge[ xPort ] = ipconfigMAX_MULTICAST_GROUP_AGE;
+				break;
+			case bridgeIGMP_QUERY:
+				xMulticastStats.ulQueries++;
+				ucRouterPortAge[ xPort ] = ipconfigMAX_MULTICAST_GROUP_AGE;
+				break;
+			default:
+				break;
+		}
+	}
+	else if( pxEthernetHeader->usFrameType == ipIPv6_FRAME_TYPE )
+	{
+		if( uxLength < uxOffset + bridgeIPv6_HEADER_LENGTH + 8U )
+		{
+			return;
+		}
+		ucNextHeader = pucFrame[ uxOffset + 6U ];
+		uxOffset += bridgeIPv6_HEADER_LENGTH;
+
+		/* MLD messages carry a router alert in a hop-by-hop header. */
+		if( ucNextHeader == bridgeIPv6_HOP_BY_HOP )
+		{
+			ucNextHeader = pucFrame[ uxOffset ];
+			uxOffset += ( ( size_t ) pucFrame[ uxOffset + 1U ] + 1U ) * 8U;
+		}
+		if( ( ucNextHeader != bridgeIPv6_ICMP ) || ( uxLength < uxOffset + 24U ) )
+		{
+			return;
+		}
+
+		ucType = pucFrame[ uxOffset ];
+		xGroupMAC.ucBytes[ 0 ] = 0x33U;
+		xGroupMAC.ucBytes[ 1 ] = 0x33U;
+		memcpy( &( xGroupMAC.ucBytes[ 2 ] ), &( pucFrame[ uxOffset + 20U ] ), 4U );
+
+		switch( ucType )
+		{
+			case bridgeMLDv1_REPORT:
+				xMulticastStats.ulReports++;
+				prvUpdateGroup( &xGroupMAC, xPort, ipconfigMAX_MULTICAST_GROUP_AGE );
+				break;
+			case bridgeMLDv1_DONE:
+				xMulticastStats.ulLeaves++;
+				prvUpdateGroup( &xGroupMAC, xPort, 1U );
+				break;
+			case bridgeMLDv2_REPORT:
+				xMulticastStats.ulReports++;
+				ucRouterPortAge[ xPort ] = ipconfigMAX_MULTICAST_GROUP_AGE;
+				break;
+			case bridgeMLD_QUERY:
+				xMulticastStats.ulQueries++;
+				ucRouterPortAge[ xPort ] = ipconfigMAX_MULTICAST_GROUP_AGE;
+				break;
+			default:
+				break;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Decrement the ages of group members and queriers. Call with the table
+locked. */
+static void prvAgeMulticastGroups( UBaseType_t uxPeriods )
+{
+BaseType_t x, xPort, xExpired, xRemaining;
+uint8_t *pucAge;
+
+	/* Row -1 are the querier ages. */
+	for( x = -1; x < ipconfigMULTICAST_GROUP_ENTRIES; x++ )
+	{
+		pucAge = ( x < 0 ) ? ucRouterPortAge : xMulticastGroups[ x ].ucAge;
+		xExpired = pdFALSE;
+		xRemaining = pdFALSE;
+
+		for( xPort = 0; xPort < ipconfigMULTICAST_GROUP_PORTS; xPort++ )
+		{
+			if( pucAge[ xPort ] > uxPeriods )
+			{
+				pucAge[ xPort ] -= ( uint8_t ) uxPeriods;
+				xRemaining = pdTRUE;
+			}
+			else if( pucAge[ xPort ] != 0U )
+			{
+				pucAge[ xPort ] = 0U;
+				xExpired = pdTRUE;
+			}
+		}
+
+		/* The last member of the group timed out. */
+		if( ( x >= 0 ) && ( xExpired != pdFALSE ) && ( xRemaining == pdFALSE ) )
+		{
+			xMulticastStats.uxGroups--;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Decide whether a multicast frame is forwarded to pxInterface. */
+static BaseType_t prvForwardMulticast( NetworkInterface_t *pxInterface, const MACAddress_t *pxGroupMAC, BaseType_t *pxDropped )
+{
+MulticastGroupRow_t *pxGroup;
+BaseType_t xPort, x;
+BaseType_t xReturn = pdTRUE;
+
+	#ifdef ipconfigMULTICAST_DROP_LIST
+	{
+		if( pxInterface->bits.bMulticastDropList != 0 )
+		{
+			for( x = 0; x < ( BaseType_t ) ( sizeof( xMulticastDropList ) / sizeof( xMulticastDropList[ 0 ] ) ); x++ )
+			{
+				if( memcmp( xMulticastDropList[ x ].ucBytes, pxGroupMAC->ucBytes, ipMAC_ADDRESS_LENGTH_BYTES ) == 0 )
+				{
+					*pxDropped = pdTRUE;
+					return pdFALSE;
+				}
+			}
+		}
+	}
+	#else
+	{
+		( void ) pxDropped;
+	}
+	#endif
+
+	xPort = prvPortIndex( pxInterface );
+	if( ( xPort >= 0 ) && ( prvIsSnoopedGroup( pxGroupMAC ) != pdFALSE ) )
+	{
+		taskENTER_CRITICAL();
+		{
+			if( ucRouterPortAge[ xPort ] == 0U )
+			{
+				pxGroup = prvFindGroup( pxGroupMAC );
+				if( pxGroup != NULL )
+				{
+					xReturn = ( pxGroup->ucAge[ xPort ] != 0U ) ? pdTRUE : pdFALSE;
+				}
+				else
+				{
+					/* Without a querier the members do not report regularly,
+					unknown groups are flooded then. */
+					for( x = 0; x < ipconfigMULTICAST_GROUP_PORTS; x++ )
+					{
+						if( ucRouterPortAge[ x ] != 0U )
+						{
+							xReturn = pdFALSE;
+						}
+					}
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vGetMulticastSnoopingStats( MulticastSnoopingStats_t *pxStats )
+{
+	taskENTER_CRITICAL();
+	{
+		*pxStats = xMulticastStats;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_MULTICAST_SNOOPING != 0 */
+
 #if( ipconfigUSE_FORWARDING_TABLE != 0 )
 
+/* The forwarding table is an open addressing hash table with linear probing,
+keyed on the MAC address. ipconfigFORWARDING_TABLE_ENTRIES is the number of
+slots, at most three quarters of them are used so a probe always ends at an
+empty slot after a few steps. */
+#if( ( ipconfigFORWARDING_TABLE_ENTRIES < 4 ) || ( ( ipconfigFORWARDING_TABLE_ENTRIES & ( ipconfigFORWARDING_TABLE_ENTRIES - 1 ) ) != 0 ) )
+	#error ipconfigFORWARDING_TABLE_ENTRIES must be a power of 2
+#endif
+
+#define bridgeTABLE_MASK			( ( UBaseType_t ) ipconfigFORWARDING_TABLE_ENTRIES - 1U )
+#define bridgeTABLE_MAX_USE			( ( ( UBaseType_t ) ipconfigFORWARDING_TABLE_ENTRIES * 3U ) / 4U )
+
+/* Number of slots, starting at the home slot of a new MAC, that are searched
+for the oldest entry when the table is full. */
+#define bridgeEVICTION_WINDOW		( 8U )
+
+#ifndef ipFORWARDING_TABLE_TIMER_PERIOD_MS
+	#define ipFORWARDING_TABLE_TIMER_PERIOD_MS	( 10000U )
+#endif
+
 typedef struct xFORWARDING_TABLE_ROW
 {
-	struct xNetworkInterface *pxInterface;		/* The Network Interface of a forwarding table entry. */
+	struct xNetworkInterface *pxInterface;		/* The Network Interface of a forwarding table entry, NULL for a free slot. */
 	MACAddress_t xMACAddress;                   /* The MAC address of a forwarding table entry. */
 	uint8_t ucAge;				                /* A value that is periodically decremented but can also be refreshed by active communication. */
+	uint32_t ulHits;							/* The number of frames that were forwarded using this entry. */
 } ForwardingTableRow_t;
 
-static UBaseType_t uxForwardTableMaxUse = 0;
 static ForwardingTableRow_t xForwardingTable[ipconfigFORWARDING_TABLE_ENTRIES];
+static ForwardingTableStats_t xForwardingTableStats;
+static TickType_t xLastAgeTime;
 
-NetworkInterface_t *pxFindInterfaceOnMAC( const MACAddress_t *pxMACAddress )
+static UBaseType_t prvHashMAC( const MACAddress_t *pxMACAddress )
 {
-BaseType_t x;
-NetworkInterface_t *pxInterface = NULL;
+uint32_t ulHash;
 
-	for( x = 0; x < uxForwardTableMaxUse; x++ )
+	/* The lower bytes are the most specific part of a MAC address. */
+	ulHash = ( ( uint32_t ) pxMACAddress->ucBytes[ 2 ] << 24 ) | ( ( uint32_t ) pxMACAddress->ucBytes[ 3 ] << 16 ) |
+			 ( ( uint32_t ) pxMACAddress->ucBytes[ 4 ] << 8 ) | ( ( uint32_t ) pxMACAddress->ucBytes[ 5 ] );
+	ulHash ^= ( ( uint32_t ) pxMACAddress->ucBytes[ 0 ] << 8 ) | ( ( uint32_t ) pxMACAddress->ucBytes[ 1 ] );
+	ulHash *= 0x9E3779B1UL;
+
+	return ( UBaseType_t ) ( ulHash >> 16 ) & bridgeTABLE_MASK;
+}
+/*-----------------------------------------------------------*/
+
+/* Returns pdTRUE and the slot of the MAC if it is in the table, otherwise
+pdFALSE and the free slot where it would be stored. Call with the table
+locked. */
+static BaseType_t prvFindSlot( const MACAddress_t *pxMACAddress, UBaseType_t *puxSlot )
+{
+UBaseType_t uxSlot = prvHashMAC( pxMACAddress );
+BaseType_t xFound = pdFALSE;
+
+	while( xForwardingTable[ uxSlot ].pxInterface != NULL )
 	{
-		if( ( xForwardingTable->pxInterface != NULL )
-			&& ( memcmp( xForwardingTable[x].xMACAddress.ucBytes, pxMACAddress->ucBytes, ipMAC_ADDRESS_LENGTH_BYTES ) ) == 0 )
+		if( memcmp( xForwardingTable[ uxSlot ].xMACAddress.ucBytes, pxMACAddress->ucBytes, ipMAC_ADDRESS_LENGTH_BYTES ) == 0 )
 		{
-			/* Found. */
-			pxInterface =  xForwardingTable[x].pxInterface;
+			xFound = pdTRUE;
 			break;
 		}
+		uxSlot = ( uxSlot + 1U ) & bridgeTABLE_MASK;
 	}
+	*puxSlot = uxSlot;
 
-	return pxInterface;
+	return xFound;
 }
 /*-----------------------------------------------------------*/
 
-void vRefreshForwardingTableEntry( const MACAddress_t *pxMACAddress, NetworkInterface_t *pxInterface, uint8_t ucAge )
+/* Free a slot and move the following entries of the probe sequence back, so
+no tombstones are needed. Call with the table locked. */
+static void prvDeleteSlot( UBaseType_t uxSlot )
 {
-BaseType_t xUseEntry, xOldestEntry;
-uint8_t ucMinAgeFound = 0;
+UBaseType_t uxNext = uxSlot;
+UBaseType_t uxHome;
+
+	for( ;; )
+	{
+		xForwardingTable[ uxSlot ].pxInterface = NULL;
 
-	/* Start with the maximum possible number. */
-	ucMinAgeFound--;
+		/* Find an entry that may be moved into the free slot. */
+		do
+		{
+			uxNext = ( uxNext + 1U ) & bridgeTABLE_MASK;
+			if( xForwardingTable[ uxNext ].pxInterface == NULL )
+			{
+				xForwardingTableStats.uxEntries--;
+				return;
+			}
+			uxHome = prvHashMAC( &( xForwardingTable[ uxNext ].xMACAddress ) );
+		} while( ( uxSlot <= uxNext ) ? ( ( uxSlot < uxHome ) && ( uxHome <= uxNext ) )
+									  : ( ( uxSlot < uxHome ) || ( uxHome <= uxNext ) ) );
 
-	/* Find the first unused entry or one with the same MAC. */
-	for( xUseEntry = 0; xUseEntry < uxForwardTableMaxUse; xUseEntry++ )
+		xForwardingTable[ uxSlot ] = xForwardingTable[ uxNext ];
+		uxSlot = uxNext;
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Make room for a new entry by removing the oldest one near its home slot.
+Entries with an infinite age are never removed. Call with the table locked. */
+static BaseType_t prvEvictEntry( const MACAddress_t *pxMACAddress )
+{
+UBaseType_t uxSlot = prvHashMAC( pxMACAddress );
+UBaseType_t uxOldest = 0U;
+UBaseType_t x;
+uint8_t ucMinAgeFound = INFINITE_FORWARDING_TABLE_AGE;
+BaseType_t xReturn = pdFALSE;
+
+	for( x = 0U; x < bridgeEVICTION_WINDOW; x++ )
 	{
-		if( xForwardingTable[xUseEntry].pxInterface == NULL )
+		if( ( xForwardingTable[ uxSlot ].pxInterface != NULL ) && ( xForwardingTable[ uxSlot ].ucAge < ucMinAgeFound ) )
 		{
-			/* Unused entry, save MAC here so the table stays compact.
-			A previously used entry of this MAC may be left for time out. */
-			break;
+			ucMinAgeFound = xForwardingTable[ uxSlot ].ucAge;
+			uxOldest = uxSlot;
+			xReturn = pdTRUE;
 		}
-		if( memcmp( xForwardingTable[xUseEntry].xMACAddress.ucBytes, pxMACAddress->ucBytes, ipMAC_ADDRESS_LENGTH_BYTES ) == 0 )
+		uxSlot = ( uxSlot + 1U ) & bridgeTABLE_MASK;
+	}
+
+	if( xReturn != pdFALSE )
+	{
+		prvDeleteSlot( uxOldest );
+		xForwardingTableStats.ulEvictions++;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+/* Decrement the age of all entries by the given number of periods. Call with
+the table locked. */
+static void prvAgeForwardingTable( UBaseType_t uxPeriods )
+{
+UBaseType_t uxSlot = 0U;
+UBaseType_t uxVisited = 0U;
+
+	if( xForwardingTableStats.uxEntries == 0U )
+	{
+		return;
+	}
+
+	/* Start right behind a free slot. Deleting an entry only moves entries
+	of the same probe sequence back into the current slot, which is then
+	checked again. */
+	while( xForwardingTable[ uxSlot ].pxInterface != NULL )
+	{
+		uxSlot++;
+	}
+
+	while( uxVisited < ( UBaseType_t ) ipconfigFORWARDING_TABLE_ENTRIES )
+	{
+		uxSlot = ( uxSlot + 1U ) & bridgeTABLE_MASK;
+
+		while( ( xForwardingTable[ uxSlot ].pxInterface != NULL ) &&
+			   ( xForwardingTable[ uxSlot ].ucAge != INFINITE_FORWARDING_TABLE_AGE ) )
 		{
-			/* Found MAC, no need to copy it. */
-			pxMACAddress = NULL;
-			break;
+			if( xForwardingTable[ uxSlot ].ucAge > uxPeriods )
+			{
+				xForwardingTable[ uxSlot ].ucAge -= ( uint8_t ) uxPeriods;
+				break;
+			}
+
+			/* The entry is no longer valid.  Wipe it out. */
+			prvDeleteSlot( uxSlot );
 		}
+		uxVisited++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Age the table by the number of timer periods that have passed since it was
+aged last. Frames are forwarded by the network drivers, so the table is aged
+lazily from there instead of by a timer. */
+static void prvCheckForwardingTableAge( void )
+{
+TickType_t xNow = xTaskGetTickCount();
+TickType_t xPeriods = ( xNow - xLastAgeTime ) / pdMS_TO_TICKS( ipFORWARDING_TABLE_TIMER_PERIOD_MS );
+
+	if( xPeriods != 0U )
+	{
+		xLastAgeTime += xPeriods * pdMS_TO_TICKS( ipFORWARDING_TABLE_TIMER_PERIOD_MS );
 
-		/* Look for the oldest entry, in case the table is full */
-		if( xForwardingTable[xUseEntry].ucAge < ucMinAgeFound )
+		if( xPeriods > INFINITE_FORWARDING_TABLE_AGE )
 		{
-			ucMinAgeFound = xForwardingTable[xUseEntry].ucAge;
-			xOldestEntry = xUseEntry;
+			xPeriods = INFINITE_FORWARDING_TABLE_AGE;
 		}
+
+		taskENTER_CRITICAL();
+		{
+			prvAgeForwardingTable( ( UBaseType_t ) xPeriods );
+			#if( ipconfigUSE_MULTICAST_SNOOPING != 0 )
+			{
+				prvAgeMulticastGroups( ( UBaseType_t ) xPeriods );
+			}
+			#endif
+		}
+		taskEXIT_CRITICAL();
 	}
+}
+/*-----------------------------------------------------------*/
+
+NetworkInterface_t *pxFindInterfaceOnMAC( const MACAddress_t *pxMACAddress )
+{
+UBaseType_t uxSlot;
+NetworkInterface_t *pxInterface = NULL;
 
-	if( xUseEntry == uxForwardTableMaxUse )
+	taskENTER_CRITICAL();
 	{
-		if( xUseEntry == ( sizeof( xForwardingTable ) / sizeof( xForwardingTable[0] ) ) )
+		if( prvFindSlot( pxMACAddress, &uxSlot ) != pdFALSE )
 		{
-			/* The table is full, replace the oldest entry */
-			xUseEntry = xOldestEntry;
+			/* Found. */
+			pxInterface = xForwardingTable[ uxSlot ].pxInterface;
+			xForwardingTable[ uxSlot ].ulHits++;
+			xForwardingTableStats.ulLookupHits++;
 		}
 		else
 		{
-			/* A new row is used, increase the usage counter. */
-			uxForwardTableMaxUse++;
+			xForwardingTableStats.ulLookupMisses++;
 		}
 	}
+	taskEXIT_CRITICAL();
+
+	return pxInterface;
+}
+/*-----------------------------------------------------------*/
 
-	if( pxMACAddress != NULL )
+void vRefreshForwardingTableEntry( const MACAddress_t *pxMACAddress, NetworkInterface_t *pxInterface, uint8_t ucAge )
+{
+UBaseType_t uxSlot;
+
+	taskENTER_CRITICAL();
 	{
-		memcpy( xForwardingTable[xUseEntry].xMACAddress.ucBytes, pxMACAddress->ucBytes, ipMAC_ADDRESS_LENGTH_BYTES );
+		if( prvFindSlot( pxMACAddress, &uxSlot ) == pdFALSE )
+		{
+			if( ( xForwardingTableStats.uxEntries < bridgeTABLE_MAX_USE ) || ( prvEvictEntry( pxMACAddress ) != pdFALSE ) )
+			{
+				/* Eviction may have moved entries, look for a free slot again. */
+				( void ) prvFindSlot( pxMACAddress, &uxSlot );
+				memcpy( xForwardingTable[ uxSlot ].xMACAddress.ucBytes, pxMACAddress->ucBytes, ipMAC_ADDRESS_LENGTH_BYTES );
+				xForwardingTable[ uxSlot ].ulHits = 0U;
+				xForwardingTableStats.uxEntries++;
+			}
+			else
+			{
+				/* The table is full of permanent entries, the MAC can not be
+				learned. Frames to it will be flooded. */
+				pxInterface = NULL;
+			}
+		}
+
+		if( pxInterface != NULL )
+		{
+			xForwardingTable[ uxSlot ].pxInterface = pxInterface;
+			xForwardingTable[ uxSlot ].ucAge = ucAge;
+		}
 	}
-	xForwardingTable[xUseEntry].pxInterface = pxInterface;
-	xForwardingTable[xUseEntry].ucAge = ucAge;
+	taskEXIT_CRITICAL();
 }
 /*-----------------------------------------------------------*/
 
 void vAgeForwardingTable( void )
 {
-BaseType_t x;
+	taskENTER_CRITICAL();
+	{
+		prvAgeForwardingTable( 1U );
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vGetForwardingTableStats( ForwardingTableStats_t *pxStats )
+{
+	taskENTER_CRITICAL();
+	{
+		*pxStats = xForwardingTableStats;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xGetForwardingTableEntry( UBaseType_t uxIndex, MACAddress_t *pxMACAddress, NetworkInterface_t **ppxInterface, uint8_t *pucAge, uint32_t *pulHits )
+{
+BaseType_t xReturn = pdFALSE;
 
-	/* Loop through each entry in the ARP cache. */
-	for( x = 0; x < uxForwardTableMaxUse; x++ )
+	if( uxIndex < ( UBaseType_t ) ipconfigFORWARDING_TABLE_ENTRIES )
 	{
-		if( xForwardingTable[ x ].ucAge != INFINITE_FORWARDING_TABLE_AGE )
+		taskENTER_CRITICAL();
 		{
-			/* Decrement the age value of the entry in this table row.
-			When the age reaches zero it is no longer considered valid. */
-			xForwardingTable[ x ].ucAge--;
-
-			if( xForwardingTable[ x ].ucAge == 0u )
+			if( xForwardingTable[ uxIndex ].pxInterface != NULL )
 			{
-				/* The entry is no longer valid.  Wipe it out. */
-				xForwardingTable[ x ].pxInterface = NULL;
+				*pxMACAddress = xForwardingTable[ uxIndex ].xMACAddress;
+				*ppxInterface = xForwardingTable[ uxIndex ].pxInterface;
+				*pucAge = xForwardingTable[ uxIndex ].ucAge;
+				*pulHits = xForwardingTable[ uxIndex ].ulHits;
+				xReturn = pdTRUE;
 			}
 		}
+		taskEXIT_CRITICAL();
 	}
+
+	return xReturn;
 }
 /*-----------------------------------------------------------*/
 
@@ -211,7 +798,7 @@ NetworkInterface_t *FreeRTOS_NextNetworkInterfaceInBridge( NetworkInterface_t *p
 	while( pxInterface != NULL )
 	{
 		pxInterface = pxInterface->pxNext;
-		if( pxInterface->bits.bIsBridged != 0 )
+		if( ( pxInterface != NULL ) && ( pxInterface->bits.bIsBridged != 0 ) )
 		{
 			break;
 		}
@@ -221,6 +808,25 @@ NetworkInterface_t *FreeRTOS_NextNetworkInterfaceInBridge( NetworkInterface_t *p
 }
 /*-----------------------------------------------------------*/
 
+static void prvForwardDuplicate( NetworkInterface_t *pxInterface, const NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+NetworkBufferDescriptor_t *pxNetworkBufferDuplicate;
+
+	pxNetworkBufferDuplicate = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
+	if( pxNetworkBufferDuplicate != NULL )
+	{
+		iptraceBRIDGE_FORWARD_PACKET( pxNetworkBuffer, pxInterface );
+		pxInterface->pfOutput( pxInterface, pxNetworkBufferDuplicate, pdTRUE );
+	}
+	else
+	{
+		/* Unable to duplicate network buffer. */
+		ipNETWORK_BUFFER_STARVED( eNetworkBufferOwnerBridge );
+		iptraceSTACK_TX_EVENT_LOST();
+	}
+}
+/*-----------------------------------------------------------*/
+
 BaseType_t xBridge_Process( NetworkBufferDescriptor_t * const pxNetworkBuffer )
 {
 BaseType_t xReturn = pdFAIL;
@@ -229,27 +835,54 @@ BaseType_t xReturn = pdFAIL;
 #endif
 NetworkInterface_t *pxInterface;
 NetworkInterface_t *pxSendToInterface = NULL;
-NetworkBufferDescriptor_t *pxNetworkBufferDuplicate;
+#if( ipconfigUSE_NETWORK_BUFFER_REFCOUNT != 0 )
+	NetworkInterface_t *pxLocalInterface = NULL;
+#endif
 BaseType_t xIsBroadcast = pdFALSE;
+#if( ipconfigUSE_MULTICAST_SNOOPING != 0 )
+	BaseType_t xIsMulticast = pdFALSE;
+	BaseType_t xWithheld = pdFALSE;
+	BaseType_t xDropped = pdFALSE;
+#endif
 
 	/* The receiving interface must be set */
 	configASSERT( pxNetworkBuffer->pxInterface );
 
+	ipNETWORK_BUFFER_SET_OWNER( pxNetworkBuffer, eNetworkBufferOwnerBridge );
+
 	#if( ipconfigUSE_FORWARDING_TABLE != 0)
 	{
 		pxEthernetHeader = ( EthernetHeader_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
 
+		prvCheckForwardingTableAge();
+
 		if( memcmp( ( void * ) xBroadcastMACAddress.ucBytes, ( void * ) pxEthernetHeader->xDestinationAddress.ucBytes, sizeof( MACAddress_t ) ) != 0 )
 		{
-			/* No broadcast, try to find the correct interface in the forwarding table. */
-			pxSendToInterface = pxFindInterfaceOnMAC( &(pxEthernetHeader->xDestinationAddress) );
+		#if( ipconfigUSE_MULTICAST_SNOOPING != 0 )
+			if( ( pxEthernetHeader->xDestinationAddress.ucBytes[ 0 ] & 0x01U ) != 0U )
+			{
+				/* Group addresses are never learned, there is no need to look
+				them up. IGMP and MLD messages are sent to group addresses. */
+				xIsMulticast = pdTRUE;
+				prvSnoopMulticast( pxNetworkBuffer );
+			}
+			else
+		#endif
+			{
+				/* No broadcast, try to find the correct interface in the forwarding table.
+				A frame for a station behind another bridged interface is handed
+				straight to that driver from the task of the receiving driver, it
+				never passes the IP-task. */
+				pxSendToInterface = pxFindInterfaceOnMAC( &(pxEthernetHeader->xDestinationAddress) );
+			}
 		}
 		else
 		{
 			xIsBroadcast = pdTRUE;
 		}
 
-		if( pxNetworkBuffer->pxInterface->bits.bForwardingTableKnown == 0 )
+		if( ( pxNetworkBuffer->pxInterface->bits.bForwardingTableKnown == 0 ) &&
+			( ( pxEthernetHeader->xSourceAddress.ucBytes[ 0 ] & 0x01U ) == 0U ) )
 		{
 			/* Update the forwarding table with the source address of the
 			received frame. */
@@ -258,6 +891,22 @@ BaseType_t xIsBroadcast = pdFALSE;
 	}
 	#endif /* ipconfigUSE_FORWARDING_TABLE != 0 */
 
+	#if( ipconfigMAX_TX_FRAGMENTS != 0 )
+	{
+		/* A frame from the IP-task may refer to data outside the buffer. Only
+		a single driver which can send the fragments itself gets it as it is,
+		flooded copies need the whole frame in the buffer. */
+		if( ( pxNetworkBuffer->uxFragmentCount != 0U ) &&
+			( ( pxSendToInterface == NULL ) || ( pxSendToInterface->bits.bTxFragments == 0 ) ) &&
+			( xNetworkBufferFlattenFragments( pxNetworkBuffer ) == pdFAIL ) )
+		{
+			/* Too long, it can not be sent anywhere. Addressing it to the
+			receiving interface skips the flooding and fails below. */
+			pxSendToInterface = pxNetworkBuffer->pxInterface;
+		}
+	}
+	#endif /* ipconfigMAX_TX_FRAGMENTS != 0 */
+
 	if( pxSendToInterface == NULL )
 	{
 		/* Send frame to all interfaces except the receiving one. */
@@ -274,6 +923,26 @@ BaseType_t xIsBroadcast = pdFALSE;
 				&& ( pxInterface != pxNetworkBuffer->pxInterface )
 				&& ( pxInterface->pfGetPhyLinkStatus( pxInterface ) == pdPASS ) )
 			{
+			#if( ipconfigUSE_MULTICAST_SNOOPING != 0 )
+				if( ( xIsMulticast != pdFALSE ) && ( prvForwardMulticast( pxInterface, &( pxEthernetHeader->xDestinationAddress ), &xDropped ) == pdFALSE ) )
+				{
+					/* No members of the group behind this interface. */
+					xWithheld = pdTRUE;
+					continue;
+				}
+			#endif
+
+			#if( ipconfigUSE_NETWORK_BUFFER_REFCOUNT != 0 )
+				if( pxInterface->bits.bIsBridged == 0 )
+				{
+					/* The bridge interface itself passes the frame to the
+					IP-task, which may modify it. It can not share the buffer
+					with the drivers, so it is served last. */
+					pxLocalInterface = pxInterface;
+					continue;
+				}
+			#endif
+
 				/* Store the interface, so the NetworkBuffer is only
 				duplicated when necessary. */
 				if( pxSendToInterface == NULL )
@@ -282,20 +951,55 @@ BaseType_t xIsBroadcast = pdFALSE;
 				}
 				else
 				{
-					pxNetworkBufferDuplicate = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
-					if( pxNetworkBufferDuplicate != NULL )
-					{
-						iptraceBRIDGE_FORWARD_PACKET( pxNetworkBuffer, pxInterface );
-						pxInterface->pfOutput( pxInterface, pxNetworkBufferDuplicate, pdTRUE );
-					}
-					else
-					{
-						/* Unable to duplicate network buffer. */
-						iptraceSTACK_TX_EVENT_LOST();
-					}
+				#if( ipconfigUSE_NETWORK_BUFFER_REFCOUNT != 0 )
+					/* The drivers only read the frame, so they share the
+					buffer. The reference of the caller is not passed on before
+					the loop ends, so the buffer stays valid until then. */
+					iptraceBRIDGE_FORWARD_PACKET( pxNetworkBuffer, pxInterface );
+					pxInterface->pfOutput( pxInterface, pxNetworkBufferAddReference( pxNetworkBuffer ), pdTRUE );
+				#else
+					prvForwardDuplicate( pxInterface, pxNetworkBuffer );
+				#endif
+				}
+			}
+		}
+
+		#if( ipconfigUSE_NETWORK_BUFFER_REFCOUNT != 0 )
+		{
+			if( pxLocalInterface != NULL )
+			{
+				if( pxSendToInterface == NULL )
+				{
+					/* No driver involved, the IP-task may have the buffer. */
+					pxSendToInterface = pxLocalInterface;
+				}
+				else
+				{
+					prvForwardDuplicate( pxLocalInterface, pxNetworkBuffer );
+				}
+			}
+		}
+		#endif
+
+		#if( ipconfigUSE_MULTICAST_SNOOPING != 0 )
+		{
+			if( xIsMulticast != pdFALSE )
+			{
+				if( xDropped != pdFALSE )
+				{
+					xMulticastStats.ulDropped++;
+				}
+				else if( xWithheld != pdFALSE )
+				{
+					xMulticastStats.ulFiltered++;
+				}
+				else
+				{
+					xMulticastStats.ulFlooded++;
 				}
 			}
 		}
+		#endif
 	}
 
 	if( ( pxSendToInterface != NULL ) && ( pxSendToInterface != pxNetworkBuffer->pxInterface ) )
@@ -309,4 +1013,39 @@ BaseType_t xIsBroadcast = pdFALSE;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigBRIDGE_LATENCY_STATS != 0 )
+
+void vBridgeLatencySample( NetworkInterface_t *pxInterface, const NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulNow )
+{
+BridgeLatency_t *pxLatency = &( pxInterface->xBridgeLatency );
+uint32_t ulMicroSeconds;
+uint32_t ulLimit = 8U;
+BaseType_t xBucket = 0;
+
+	/* Only frames forwarded from another bridged interface are of interest,
+	not the frames sent by the IP-task. */
+	if( ( pxNetworkBuffer->pxInterface != NULL ) &&
+		( pxNetworkBuffer->pxInterface != pxInterface ) &&
+		( pxNetworkBuffer->pxInterface->bits.bIsBridged != 0 ) )
+	{
+		ulMicroSeconds = ( ulNow - pxNetworkBuffer->ulRxTimestamp ) / ( configCPU_CLOCK_HZ / 1000000UL );
+
+		while( ( xBucket < ( ipBRIDGE_LATENCY_BUCKETS - 1 ) ) && ( ulMicroSeconds >= ulLimit ) )
+		{
+			ulLimit <<= 1;
+			xBucket++;
+		}
+
+		pxLatency->ulBuckets[ xBucket ]++;
+		pxLatency->ulFrames++;
+		if( ulMicroSeconds > pxLatency->ulMaxMicroSeconds )
+		{
+			pxLatency->ulMaxMicroSeconds = ulMicroSeconds;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigBRIDGE_LATENCY_STATS != 0 */
+
 #endif /* ipconfigUSE_BRIDGE != 0 */
@@ -297,6 +297,26 @@ static void prvCheckNetworkTimers( void );
  */
 static TickType_t prvCalculateSleepTime( void );
 
+/*
+ * Take the next event for the IP-task, events in the priority queue first.
+ * Blocks for at most xBlockTime when there are no events.
+ */
+static BaseType_t prvReceiveIPEvent( IPStackEvent_t * pxEvent,
+                                     TickType_t xBlockTime );
+
+/*
+ * Returns the number of events waiting for the IP-task.
+ */
+static UBaseType_t prvEventsWaiting( void );
+
+#if ( ipconfigEVENT_PRIORITY_QUEUE_LENGTH > 0 )
+
+/*
+ * Returns the queue in which events of the given type are posted.
+ */
+    static QueueHandle_t prvEventQueue( eIPEvent_t eEventType );
+#endif
+
 /*
  * The network card driver has received a packet.  In the case that it is part
  * of a linked packet chain, walk through it to handle every message.
@@ -332,6 +352,14 @@ static eFrameProcessingResult_t prvAllowIPPacketIPv4( const IPPacket_t * const p
 /** @brief The queue used to pass events into the IP-task for processing. */
 QueueHandle_t xNetworkEventQueue = NULL;
 
+#if ( ipconfigEVENT_PRIORITY_QUEUE_LENGTH > 0 )
+
+/** @brief The queue used for all events other than packets to be received or
+ * sent.  The IP-task is woken up by a task notification, because it waits for
+ * two queues. */
+    static QueueHandle_t xNetworkPriorityEventQueue = NULL;
+#endif
+
 /** @brief The IP packet ID. */
 uint16_t usPacketIdentifier = 0U;
 
@@ -391,6 +419,11 @@ static BaseType_t xIPTaskInitialised = pdFALSE;
     static UBaseType_t uxQueueMinimumSpace = ipconfigEVENT_QUEUE_LENGTH;
 #endif
 
+#if ( ipconfigEVENT_RESIDENCY_STATS != 0 )
+    /** @brief The time events have spent in the queues, per event type. */
+    static IPEventResidency_t xEventResidency[ ipEVENT_TYPE_COUNT ];
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* Coverity wants to make pvParameters const, which would make it incompatible. Leave the
@@ -407,8 +440,9 @@ static BaseType_t xIPTaskInitialised = pdFALSE;
 static void prvIPTask( void * pvParameters )
 {
     IPStackEvent_t xReceivedEvent;
-    TickType_t xNextIPSleep;
+    TickType_t xNextIPSleep = 0U;
     FreeRTOS_Socket_t * pxSocket;
+    UBaseType_t uxBatchCount = 0U;
 
     #if ( ipconfigUSE_IPv6 != 0 )
         struct freertos_sockaddr6 xAddress;
@@ -459,23 +493,46 @@ static void prvIPTask( void * pvParameters )
     /* Loop, processing IP events. */
     for( ; ; )
     {
-        ipconfigWATCHDOG_TIMER();
+        /* While in a batch of events, the timers are left alone and the
+         * next event is taken without blocking. */
+        if( uxBatchCount == 0U )
+        {
+            ipconfigWATCHDOG_TIMER();
 
-        /* Check the ARP, DHCP and TCP timers to see if there is any periodic
-         * or timeout processing to perform. */
-        prvCheckNetworkTimers();
+            /* Check the ARP, DHCP and TCP timers to see if there is any periodic
+             * or timeout processing to perform. */
+            prvCheckNetworkTimers();
 
-        /* Calculate the acceptable maximum sleep time. */
-        xNextIPSleep = prvCalculateSleepTime();
+            /* Calculate the acceptable maximum sleep time. */
+            xNextIPSleep = prvCalculateSleepTime();
+        }
 
         /* Wait until there is something to do. If the following call exits
          * due to a time out rather than a message being received, set a
          * 'NoEvent' value. */
-        if( xQueueReceive( xNetworkEventQueue, ( void * ) &xReceivedEvent, xNextIPSleep ) == pdFALSE )
+        if( prvReceiveIPEvent( &( xReceivedEvent ), xNextIPSleep ) == pdFALSE )
         {
             xReceivedEvent.eEventType = eNoEvent;
         }
 
+        if( xReceivedEvent.eEventType == eNoEvent )
+        {
+            uxBatchCount = 0U;
+        }
+        else
+        {
+            uxBatchCount++;
+
+            if( uxBatchCount >= ( UBaseType_t ) ipconfigEVENT_BATCH_SIZE )
+            {
+                uxBatchCount = 0U;
+            }
+            else
+            {
+                xNextIPSleep = 0U;
+            }
+        }
+
         #if ( ipconfigCHECK_IP_QUEUE_SPACE != 0 )
             {
                 if( xReceivedEvent.eEventType != eNoEvent )
@@ -682,6 +739,145 @@ static void prvIPTask( void * pvParameters )
 }
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Take the next event for the IP-task.  Events in the priority queue,
+ *        if configured, are served before the received and outgoing packets.
+ *
+ * @param[out] pxEvent: The event taken.
+ * @param[in] xBlockTime: The maximum time to wait for an event.
+ *
+ * @return pdTRUE if an event was taken, pdFALSE when the time-out expired.
+ */
+static BaseType_t prvReceiveIPEvent( IPStackEvent_t * pxEvent,
+                                     TickType_t xBlockTime )
+{
+    BaseType_t xReturn;
+
+    #if ( ipconfigEVENT_PRIORITY_QUEUE_LENGTH > 0 )
+        {
+            xReturn = xQueueReceive( xNetworkPriorityEventQueue, ( void * ) pxEvent, 0U );
+
+            if( xReturn == pdFALSE )
+            {
+                xReturn = xQueueReceive( xNetworkEventQueue, ( void * ) pxEvent, 0U );
+            }
+
+            if( ( xReturn == pdFALSE ) && ( xBlockTime > 0U ) )
+            {
+                /* Both queues are empty.  Every sender gives a notification
+                 * after posting an event, so an event posted since the queues
+                 * were checked will not be missed. */
+                ( void ) ulTaskNotifyTake( pdTRUE, xBlockTime );
+
+                xReturn = xQueueReceive( xNetworkPriorityEventQueue, ( void * ) pxEvent, 0U );
+
+                if( xReturn == pdFALSE )
+                {
+                    xReturn = xQueueReceive( xNetworkEventQueue, ( void * ) pxEvent, 0U );
+                }
+            }
+        }
+    #else /* if ( ipconfigEVENT_PRIORITY_QUEUE_LENGTH > 0 ) */
+        {
+            xReturn = xQueueReceive( xNetworkEventQueue, ( void * ) pxEvent, xBlockTime );
+        }
+    #endif /* ipconfigEVENT_PRIORITY_QUEUE_LENGTH */
+
+    #if ( ipconfigEVENT_RESIDENCY_STATS != 0 )
+        {
+            if( ( xReturn != pdFALSE ) && ( pxEvent->eEventType >= 0 ) && ( ( BaseType_t ) pxEvent->eEventType < ipEVENT_TYPE_COUNT ) )
+            {
+                IPEventResidency_t * pxResidency = &( xEventResidency[ pxEvent->eEventType ] );
+                uint32_t ulTime = ( uint32_t ) ipconfigEVENT_TIMESTAMP() - pxEvent->ulQueueTime;
+
+                pxResidency->ulCount++;
+                pxResidency->ulTotal += ulTime;
+
+                if( pxResidency->ulMaximum < ulTime )
+                {
+                    pxResidency->ulMaximum = ulTime;
+                }
+            }
+        }
+    #endif /* ipconfigEVENT_RESIDENCY_STATS */
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The number of events that are waiting for the IP-task.
+ *
+ * @return The number of events in the event queue(s).
+ */
+static UBaseType_t prvEventsWaiting( void )
+{
+    UBaseType_t uxCount = uxQueueMessagesWaiting( xNetworkEventQueue );
+
+    #if ( ipconfigEVENT_PRIORITY_QUEUE_LENGTH > 0 )
+        {
+            uxCount += uxQueueMessagesWaiting( xNetworkPriorityEventQueue );
+        }
+    #endif
+
+    return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+#if ( ipconfigEVENT_PRIORITY_QUEUE_LENGTH > 0 )
+
+/**
+ * @brief Only packets that are received or must be sent go through the
+ *        normal event queue, all other events take the priority queue.
+ *
+ * @param[in] eEventType: The type of the event.
+ *
+ * @return The queue to post the event in.
+ */
+    static QueueHandle_t prvEventQueue( eIPEvent_t eEventType )
+    {
+        QueueHandle_t xQueue;
+
+        switch( eEventType )
+        {
+            case eNetworkRxEvent:
+            case eNetworkTxEvent:
+            case eStackTxEvent:
+                xQueue = xNetworkEventQueue;
+                break;
+
+            default:
+                xQueue = xNetworkPriorityEventQueue;
+                break;
+        }
+
+        return xQueue;
+    }
+#endif /* ipconfigEVENT_PRIORITY_QUEUE_LENGTH */
+/*-----------------------------------------------------------*/
+
+#if ( ipconfigEVENT_RESIDENCY_STATS != 0 )
+
+/**
+ * @brief Get the time that events of a given type have spent in the queue.
+ *
+ * @param[in] xEventType: The event type, an eIPEvent_t.
+ *
+ * @return The statistics, or NULL for an unknown event type.
+ */
+    const IPEventResidency_t * pxGetIPEventResidency( BaseType_t xEventType )
+    {
+        const IPEventResidency_t * pxReturn = NULL;
+
+        if( ( xEventType >= 0 ) && ( xEventType < ipEVENT_TYPE_COUNT ) )
+        {
+            pxReturn = &( xEventResidency[ xEventType ] );
+        }
+
+        return pxReturn;
+    }
+#endif /* ipconfigEVENT_RESIDENCY_STATS */
+/*-----------------------------------------------------------*/
 
 static void prvCallDHCP_RA_Handler( NetworkEndPoint_t * pxEndPoint )
 {
@@ -941,7 +1137,7 @@ static void prvCheckNetworkTimers( void )
 
             /* If the IP task has messages waiting to be processed then
              * it will not sleep in any case. */
-            if( uxQueueMessagesWaiting( xNetworkEventQueue ) == 0U )
+            if( prvEventsWaiting() == 0U )
             {
                 xWillSleep = pdTRUE;
             }
@@ -1129,7 +1325,7 @@ BaseType_t FreeRTOS_NetworkDownFromISR( struct xNetworkInterface * pxNetworkInte
     xNetworkDownEvent.pvData = pxNetworkInterface;
 
     /* Simply send the network task the appropriate event. */
-    if( xQueueSendToBackFromISR( xNetworkEventQueue, &xNetworkDownEvent, &xHigherPriorityTaskWoken ) != pdPASS )
+    if( xSendEventStructToIPTaskFromISR( &xNetworkDownEvent, &xHigherPriorityTaskWoken ) != pdPASS )
     {
         /* Could not send the message, so it is still pending. */
         pxNetworkInterface->bits.bCallDownEvent = pdTRUE;
@@ -1258,18 +1454,107 @@ NetworkBufferDescriptor_t * pxDuplicateNetworkBufferWithDescriptor( const Networ
         pxNewBuffer->usBoundPort = pxNetworkBuffer->usBoundPort;
         pxNewBuffer->pxInterface = pxNetworkBuffer->pxInterface;
         pxNewBuffer->pxEndPoint = pxNetworkBuffer->pxEndPoint;
-        ( void ) memcpy( pxNewBuffer->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
+        ( void ) pvCopyPacketData( pxNewBuffer->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
         #if ( ipconfigUSE_IPv6 != 0 )
             {
                 ( void ) memcpy( pxNewBuffer->xIPv6_Address.ucBytes, pxNetworkBuffer->xIPv6_Address.ucBytes, ipSIZE_OF_IPv6_ADDRESS );
             }
         #endif /* ipconfigUSE_IPv6 != 0 */
+        #if ( ipconfigMAX_TX_FRAGMENTS != 0 )
+            {
+                /* The fragments point to memory that does not change, the
+                 * copy can refer to the same memory. */
+                pxNewBuffer->uxFragmentCount = pxNetworkBuffer->uxFragmentCount;
+                ( void ) memcpy( pxNewBuffer->xFragments, pxNetworkBuffer->xFragments, sizeof( pxNewBuffer->xFragments ) );
+            }
+        #endif /* ipconfigMAX_TX_FRAGMENTS != 0 */
+        #if ( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+            {
+                /* The copy has the same contents. */
+                pxNewBuffer->ucRxChecksum = pxNetworkBuffer->ucRxChecksum;
+            }
+        #endif /* ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 */
     }
 
     return pxNewBuffer;
 }
 /*-----------------------------------------------------------*/
 
+#if ( ipconfigMAX_TX_FRAGMENTS != 0 )
+
+/**
+ * @brief Append a fragment to a frame that is about to be sent.
+ *
+ * @param[in] pxNetworkBuffer: The network buffer holding the start of the frame.
+ * @param[in] pucData: The fragment, it must not change until the frame is sent.
+ * @param[in] xLength: The number of bytes in the fragment.
+ *
+ * @return pdPASS if the fragment was added, pdFAIL when there is no free slot.
+ */
+    BaseType_t xNetworkBufferAddFragment( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                          const uint8_t * pucData,
+                                          size_t xLength )
+    {
+        BaseType_t xReturn = pdFAIL;
+
+        if( pxNetworkBuffer->uxFragmentCount < ( UBaseType_t ) ipconfigMAX_TX_FRAGMENTS )
+        {
+            pxNetworkBuffer->xFragments[ pxNetworkBuffer->uxFragmentCount ].pucData = pucData;
+            pxNetworkBuffer->xFragments[ pxNetworkBuffer->uxFragmentCount ].xLength = xLength;
+            pxNetworkBuffer->uxFragmentCount++;
+            xReturn = pdPASS;
+        }
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Copy the fragments of a frame into the network buffer itself, for an
+ *        interface that can only send contiguous frames.
+ *
+ * @param[in] pxNetworkBuffer: The network buffer holding the start of the frame.
+ *
+ * @return pdPASS if the frame is contiguous now, pdFAIL if it does not fit.
+ */
+    BaseType_t xNetworkBufferFlattenFragments( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+    {
+        BaseType_t xReturn = pdPASS;
+        size_t uxOffset = pxNetworkBuffer->xDataLength;
+        size_t uxLength = uxOffset;
+        UBaseType_t uxIndex;
+
+        for( uxIndex = 0U; uxIndex < pxNetworkBuffer->uxFragmentCount; uxIndex++ )
+        {
+            uxLength += pxNetworkBuffer->xFragments[ uxIndex ].xLength;
+        }
+
+        /* The buffer may belong to a small size class, let it grow first.
+         * The descriptor stays the same, only its storage is exchanged. */
+        if( ( uxLength > ipTOTAL_ETHERNET_FRAME_SIZE ) ||
+            ( pxResizeNetworkBufferWithDescriptor( pxNetworkBuffer, uxLength ) == NULL ) )
+        {
+            xReturn = pdFAIL;
+        }
+        else
+        {
+            for( uxIndex = 0U; uxIndex < pxNetworkBuffer->uxFragmentCount; uxIndex++ )
+            {
+                ( void ) memcpy( &( pxNetworkBuffer->pucEthernetBuffer[ uxOffset ] ),
+                                 pxNetworkBuffer->xFragments[ uxIndex ].pucData,
+                                 pxNetworkBuffer->xFragments[ uxIndex ].xLength );
+                uxOffset += pxNetworkBuffer->xFragments[ uxIndex ].xLength;
+            }
+
+            pxNetworkBuffer->uxFragmentCount = 0U;
+        }
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigMAX_TX_FRAGMENTS != 0 */
+
 /**
  * @brief Get the network buffer descriptor from the packet buffer.
  *
@@ -1489,6 +1774,22 @@ BaseType_t FreeRTOS_IPStart( void )
     xNetworkEventQueue = xQueueCreate( ( UBaseType_t ) ipconfigEVENT_QUEUE_LENGTH, ( UBaseType_t ) sizeof( IPStackEvent_t ) );
     configASSERT( xNetworkEventQueue != NULL );
 
+    #if ( ipconfigEVENT_PRIORITY_QUEUE_LENGTH > 0 )
+        {
+            if( xNetworkEventQueue != NULL )
+            {
+                xNetworkPriorityEventQueue = xQueueCreate( ( UBaseType_t ) ipconfigEVENT_PRIORITY_QUEUE_LENGTH, ( UBaseType_t ) sizeof( IPStackEvent_t ) );
+                configASSERT( xNetworkPriorityEventQueue != NULL );
+
+                if( xNetworkPriorityEventQueue == NULL )
+                {
+                    vQueueDelete( xNetworkEventQueue );
+                    xNetworkEventQueue = NULL;
+                }
+            }
+        }
+    #endif /* ipconfigEVENT_PRIORITY_QUEUE_LENGTH */
+
     if( xNetworkEventQueue != NULL )
     {
         #if ( configQUEUE_REGISTRY_SIZE > 0 )
@@ -1497,6 +1798,11 @@ BaseType_t FreeRTOS_IPStart( void )
                  * debugger.  If one is in use then it will be helpful for the debugger
                  * to show information about the network event queue. */
                 vQueueAddToRegistry( xNetworkEventQueue, "NetEvnt" );
+                #if ( ipconfigEVENT_PRIORITY_QUEUE_LENGTH > 0 )
+                    {
+                        vQueueAddToRegistry( xNetworkPriorityEventQueue, "NetPrio" );
+                    }
+                #endif
             }
         #endif /* configQUEUE_REGISTRY_SIZE */
 
@@ -1520,6 +1826,12 @@ BaseType_t FreeRTOS_IPStart( void )
             /* Clean up. */
             vQueueDelete( xNetworkEventQueue );
             xNetworkEventQueue = NULL;
+            #if ( ipconfigEVENT_PRIORITY_QUEUE_LENGTH > 0 )
+                {
+                    vQueueDelete( xNetworkPriorityEventQueue );
+                    xNetworkPriorityEventQueue = NULL;
+                }
+            #endif
         }
     }
     else
@@ -1770,6 +2082,7 @@ BaseType_t xSendEventStructToIPTask( const IPStackEvent_t * pxEvent,
 {
     BaseType_t xReturn, xSendMessage;
     TickType_t uxUseTimeout = uxTimeout;
+    QueueHandle_t xQueue = xNetworkEventQueue;
 
     if( ( xIPIsNetworkTaskReady() == pdFALSE ) && ( pxEvent->eEventType != eNetworkDownEvent ) )
     {
@@ -1790,7 +2103,7 @@ BaseType_t xSendEventStructToIPTask( const IPStackEvent_t * pxEvent,
                      * IP task is already awake processing other message. */
                     xTCPTimer.bExpired = pdTRUE_UNSIGNED;
 
-                    if( uxQueueMessagesWaiting( xNetworkEventQueue ) != 0U )
+                    if( prvEventsWaiting() != 0U )
                     {
                         /* Not actually going to send the message but this is not a
                          * failure as the message didn't need to be sent. */
@@ -1809,7 +2122,33 @@ BaseType_t xSendEventStructToIPTask( const IPStackEvent_t * pxEvent,
                 uxUseTimeout = ( TickType_t ) 0;
             }
 
-            xReturn = xQueueSendToBack( xNetworkEventQueue, pxEvent, uxUseTimeout );
+            #if ( ipconfigEVENT_PRIORITY_QUEUE_LENGTH > 0 )
+                {
+                    xQueue = prvEventQueue( pxEvent->eEventType );
+                }
+            #endif
+
+            #if ( ipconfigEVENT_RESIDENCY_STATS != 0 )
+                {
+                    IPStackEvent_t xEvent = *pxEvent;
+
+                    xEvent.ulQueueTime = ( uint32_t ) ipconfigEVENT_TIMESTAMP();
+                    xReturn = xQueueSendToBack( xQueue, &( xEvent ), uxUseTimeout );
+                }
+            #else
+                {
+                    xReturn = xQueueSendToBack( xQueue, pxEvent, uxUseTimeout );
+                }
+            #endif
+
+            #if ( ipconfigEVENT_PRIORITY_QUEUE_LENGTH > 0 )
+                {
+                    if( ( xReturn != pdFAIL ) && ( xIPTaskHandle != NULL ) )
+                    {
+                        ( void ) xTaskNotifyGive( xIPTaskHandle );
+                    }
+                }
+            #endif
 
             if( xReturn == pdFAIL )
             {
@@ -1830,6 +2169,53 @@ BaseType_t xSendEventStructToIPTask( const IPStackEvent_t * pxEvent,
 }
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Send an event (in form of struct) to the IP task from an interrupt.
+ *
+ * @param[in] pxEvent: The event to be sent.
+ * @param[in,out] pxHigherPriorityTaskWoken: will be set to non-zero in case a higher-
+ *                priority task has become runnable.
+ *
+ * @return pdPASS if the event was sent. Else, pdFAIL.
+ */
+BaseType_t xSendEventStructToIPTaskFromISR( const IPStackEvent_t * pxEvent,
+                                            BaseType_t * pxHigherPriorityTaskWoken )
+{
+    BaseType_t xReturn;
+    QueueHandle_t xQueue = xNetworkEventQueue;
+
+    #if ( ipconfigEVENT_PRIORITY_QUEUE_LENGTH > 0 )
+        {
+            xQueue = prvEventQueue( pxEvent->eEventType );
+        }
+    #endif
+
+    #if ( ipconfigEVENT_RESIDENCY_STATS != 0 )
+        {
+            IPStackEvent_t xEvent = *pxEvent;
+
+            xEvent.ulQueueTime = ( uint32_t ) ipconfigEVENT_TIMESTAMP();
+            xReturn = xQueueSendToBackFromISR( xQueue, &( xEvent ), pxHigherPriorityTaskWoken );
+        }
+    #else
+        {
+            xReturn = xQueueSendToBackFromISR( xQueue, pxEvent, pxHigherPriorityTaskWoken );
+        }
+    #endif
+
+    #if ( ipconfigEVENT_PRIORITY_QUEUE_LENGTH > 0 )
+        {
+            if( ( xReturn != pdFAIL ) && ( xIPTaskHandle != NULL ) )
+            {
+                vTaskNotifyGiveFromISR( xIPTaskHandle, pxHigherPriorityTaskWoken );
+            }
+        }
+    #endif
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
 #if ( ipconfigUSE_DHCPv6 == 1 ) || ( ipconfigUSE_DHCP == 1 ) || ( ipconfigUSE_RA == 1 )
 
 /**
@@ -2110,6 +2496,8 @@ static void prvProcessEthernetPacket( NetworkBufferDescriptor_t * const pxNetwor
 
     configASSERT( pxNetworkBuffer != NULL );
 
+    ipNETWORK_BUFFER_SET_OWNER( pxNetworkBuffer, eNetworkBufferOwnerIPTask );
+
     iptraceNETWORK_INTERFACE_INPUT( pxNetworkBuffer->xDataLength, pxNetworkBuffer->pucEthernetBuffer );
 
     /* Interpret the Ethernet frame. */
@@ -2483,6 +2871,19 @@ static eFrameProcessingResult_t prvAllowIPPacketIPv4( const IPPacket_t * const p
             {
                 NetworkEndPoint_t * pxEndPoint = FreeRTOS_FindEndPointOnMAC( &( pxIPPacket->xEthernetHeader.xSourceAddress ), NULL );
 
+                #if ( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+                    if( pxNetworkBuffer->ucRxChecksum == ipRX_CHECKSUM_BAD )
+                    {
+                        /* The driver has found a wrong checksum. */
+                        eReturn = eReleaseBuffer;
+                    }
+                    else if( pxNetworkBuffer->ucRxChecksum == ipRX_CHECKSUM_GOOD )
+                    {
+                        /* The driver has checked the packet already. */
+                    }
+                    else
+                #endif /* ipconfigDRIVER_VERIFIES_RX_CHECKSUM */
+
                 /* Do not check the checksum of loop-back messages. */
                 if( pxEndPoint == NULL )
                 {
@@ -2512,6 +2913,20 @@ static eFrameProcessingResult_t prvAllowIPPacketIPv4( const IPPacket_t * const p
             {
                 #warning Please create a xCheckSizeFields() in stead if calling usGenerateProtocolChecksum()
 
+                #if ( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+                    if( pxNetworkBuffer->ucRxChecksum == ipRX_CHECKSUM_BAD )
+                    {
+                        /* The driver has found a wrong checksum. */
+                        eReturn = eReleaseBuffer;
+                    }
+                    else if( pxNetworkBuffer->ucRxChecksum == ipRX_CHECKSUM_GOOD )
+                    {
+                        /* The driver has checked the lengths and the checksums
+                         * while copying the frame, no need to do it again. */
+                    }
+                    else
+                #endif /* ipconfigDRIVER_VERIFIES_RX_CHECKSUM */
+
                 if( usGenerateProtocolChecksum( pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength, pdFALSE ) != ipCORRECT_CRC )
                 {
                     /* Some of the length checks were not successful. */
@@ -3461,6 +3876,20 @@ uint16_t usGenerateChecksum( uint16_t usSum,
         /* Now xSource is word (32-bit) aligned. */
     }
 
+    #if ( ipUSE_CM3_ASM_KERNELS != 0 )
+        /* With less than a word left, xSource might not be aligned. */
+        if( uxDataLengthBytes >= 4U )
+        {
+            size_t uxWords = uxDataLengthBytes / 4U;
+
+            /* Let the Thumb-2 kernel sum all whole words, the loop below
+             * will find nothing left to do. */
+            xSum.u32 = ulChecksumWordsCM3( xSource.u32ptr, uxWords, xSum.u32 );
+            xSource.u32ptr = &( xSource.u32ptr[ uxWords ] );
+            uxDataLengthBytes %= 4U;
+        }
+    #endif /* ipUSE_CM3_ASM_KERNELS != 0 */
+
     /* Word (32-bit) aligned, do the most part. */
     xLastSource.u32ptr = ( xSource.u32ptr + ( uxDataLengthBytes / 4U ) ) - 3U;
 
@@ -3552,6 +3981,349 @@ uint16_t usGenerateChecksum( uint16_t usSum,
 }
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Copy an array of bytes and calculate its 16-bit checksum on the way.
+ *        Drivers use it to get the checksum of a received frame for free
+ *        while they move it into a network buffer.
+ *
+ * @param[in] usSum: The initial sum, obtained from earlier data.
+ * @param[out] pucDestination: Where the data is copied to.
+ * @param[in] pucSource: The data to be copied.
+ * @param[in] uxByteCount: The number of bytes.
+ *
+ * @return The same value as usGenerateChecksum( usSum, pucDestination, uxByteCount )
+ *         would return after the copy.
+ */
+uint16_t usGenerateChecksumCopy( uint16_t usSum,
+                                 uint8_t * pucDestination,
+                                 const uint8_t * pucSource,
+                                 size_t uxByteCount )
+{
+    uint8_t * pucTarget = pucDestination;
+    const uint8_t * pucFrom = pucSource;
+    size_t uxCount = uxByteCount;
+    uint32_t ulSum, ulNext, ulWord;
+    uint32_t ulCarry = 0UL;
+    BaseType_t xOddStart = ( ( ( ( uintptr_t ) pucDestination ) & 1U ) != 0U ) ? pdTRUE : pdFALSE;
+
+    /* The words are summed in the order of the platform (little endian),
+     * aligned to the destination, like usGenerateChecksum() does. */
+    ulSum = ( uint32_t ) FreeRTOS_ntohs( usSum );
+
+    if( xOddStart != pdFALSE )
+    {
+        ulSum = ( ( ulSum & 0xffU ) << 8 ) | ( ( ulSum & 0xff00U ) >> 8 );
+
+        if( uxCount >= 1U )
+        {
+            /* The first byte is the upper half of a 16-bit word. */
+            *pucTarget = *pucFrom;
+            ulSum += ( ( uint32_t ) *pucFrom ) << 8;
+            pucTarget++;
+            pucFrom++;
+            uxCount--;
+        }
+    }
+
+    if( ( ( ( ( uintptr_t ) pucTarget ) & 2U ) != 0U ) && ( uxCount >= 2U ) )
+    {
+        pucTarget[ 0 ] = pucFrom[ 0 ];
+        pucTarget[ 1 ] = pucFrom[ 1 ];
+        ulSum += ( ( uint32_t ) pucFrom[ 1 ] << 8 ) | pucFrom[ 0 ];
+        pucTarget = &( pucTarget[ 2 ] );
+        pucFrom = &( pucFrom[ 2 ] );
+        uxCount -= 2U;
+    }
+
+    /* The destination is now word aligned, unless the data ran out. */
+    #if ( ipUSE_CM3_ASM_KERNELS != 0 )
+        if( ( uxCount >= 4U ) && ( ( ( ( uintptr_t ) pucFrom ) & 3U ) == 0U ) )
+        {
+            size_t uxWords = uxCount / 4U;
+
+            /* Both pointers are word aligned, the Thumb-2 kernel moves and
+             * sums 16 bytes per LDM/STM pair. */
+            ulSum = ulChecksumCopyWordsCM3( ipPOINTER_CAST( uint32_t *, pucTarget ),
+                                            ipPOINTER_CAST( const uint32_t *, pucFrom ),
+                                            uxWords,
+                                            ulSum );
+            pucTarget = &( pucTarget[ uxWords * 4U ] );
+            pucFrom = &( pucFrom[ uxWords * 4U ] );
+            uxCount %= 4U;
+        }
+    #endif /* ipUSE_CM3_ASM_KERNELS != 0 */
+
+    while( uxCount >= 4U )
+    {
+        /* The source may be unaligned, the Cortex-M3 loads it with a single
+         * LDR all the same. */
+        ( void ) memcpy( &( ulWord ), pucFrom, sizeof( ulWord ) );
+        *( ipPOINTER_CAST( uint32_t *, pucTarget ) ) = ulWord;
+        ulNext = ulSum + ulWord;
+
+        if( ulNext < ulSum )
+        {
+            ulCarry++;
+        }
+
+        ulSum = ulNext;
+        pucTarget = &( pucTarget[ 4 ] );
+        pucFrom = &( pucFrom[ 4 ] );
+        uxCount -= 4U;
+    }
+
+    /* Fold the 32-bit sum, so the last bytes can be added without overflow. */
+    ulSum = ( ulSum & 0xffffU ) + ( ulSum >> 16 ) + ulCarry;
+
+    if( uxCount >= 2U )
+    {
+        pucTarget[ 0 ] = pucFrom[ 0 ];
+        pucTarget[ 1 ] = pucFrom[ 1 ];
+        ulSum += ( ( uint32_t ) pucFrom[ 1 ] << 8 ) | pucFrom[ 0 ];
+        pucTarget = &( pucTarget[ 2 ] );
+        pucFrom = &( pucFrom[ 2 ] );
+        uxCount -= 2U;
+    }
+
+    if( uxCount != 0U )
+    {
+        *pucTarget = *pucFrom;
+        ulSum += ( uint32_t ) *pucFrom;
+    }
+
+    ulSum = ( ulSum & 0xffffU ) + ( ulSum >> 16 );
+    ulSum = ( ulSum & 0xffffU ) + ( ulSum >> 16 );
+
+    if( xOddStart != pdFALSE )
+    {
+        ulSum = ( ( ulSum & 0xffU ) << 8 ) | ( ( ulSum & 0xff00U ) >> 8 );
+    }
+
+    return FreeRTOS_htons( ( uint16_t ) ulSum );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Add the checksum of a block of data to the checksum of the data that
+ *        precedes it.  usGenerateChecksum() and usGenerateChecksumCopy() treat
+ *        their first byte as the upper half of a 16-bit word, so a block that
+ *        starts at an odd offset must be byte-swapped first.
+ *
+ * @param[in] usSum: The checksum of the data in front of the block.
+ * @param[in] usPart: The checksum of the block, calculated from zero.
+ * @param[in] uxOffset: The offset of the block in the data.
+ *
+ * @return The checksum of the data up to and including the block.
+ */
+uint16_t usChecksumAddBlock( uint16_t usSum,
+                             uint16_t usPart,
+                             size_t uxOffset )
+{
+    uint32_t ulSum = usPart;
+
+    if( ( uxOffset & 1U ) != 0U )
+    {
+        ulSum = ( ( ulSum & 0xffU ) << 8 ) | ( ( ulSum & 0xff00U ) >> 8 );
+    }
+
+    ulSum += usSum;
+    ulSum = ( ulSum & 0xffffU ) + ( ulSum >> 16 );
+
+    return ( uint16_t ) ulSum;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Copy packet data.  Network buffers all start at the same offset from
+ *        a word boundary, so a copy between two of them can move the bulk a
+ *        word at a time after at most three single bytes.
+ *
+ * @param[out] pvDestination: Where the data is copied to.
+ * @param[in] pvSource: The data to be copied.
+ * @param[in] uxByteCount: The number of bytes.
+ *
+ * @return pvDestination, like memcpy().
+ */
+void * pvCopyPacketData( void * pvDestination,
+                         const void * pvSource,
+                         size_t uxByteCount )
+{
+    #if ( ipUSE_CM3_ASM_KERNELS != 0 )
+        uint8_t * pucTarget = ( uint8_t * ) pvDestination;
+        const uint8_t * pucFrom = ( const uint8_t * ) pvSource;
+        size_t uxCount = uxByteCount;
+        size_t uxWords;
+
+        if( ( ( ( ( uintptr_t ) pucTarget ) ^ ( ( uintptr_t ) pucFrom ) ) & 3U ) == 0U )
+        {
+            while( ( ( ( ( uintptr_t ) pucTarget ) & 3U ) != 0U ) && ( uxCount != 0U ) )
+            {
+                *pucTarget = *pucFrom;
+                pucTarget++;
+                pucFrom++;
+                uxCount--;
+            }
+
+            uxWords = uxCount / 4U;
+
+            if( uxWords != 0U )
+            {
+                vCopyWordsCM3( ipPOINTER_CAST( uint32_t *, pucTarget ),
+                               ipPOINTER_CAST( const uint32_t *, pucFrom ),
+                               uxWords );
+                pucTarget = &( pucTarget[ uxWords * 4U ] );
+                pucFrom = &( pucFrom[ uxWords * 4U ] );
+                uxCount %= 4U;
+            }
+        }
+
+        /* The rest, or all of it when the alignments differ. */
+        ( void ) memcpy( pucTarget, pucFrom, uxCount );
+    #else
+        ( void ) memcpy( pvDestination, pvSource, uxByteCount );
+    #endif /* ipUSE_CM3_ASM_KERNELS != 0 */
+
+    return pvDestination;
+}
+/*-----------------------------------------------------------*/
+
+#if ( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+
+/**
+ * @brief Check the IPv4 header checksum and the TCP, UDP, ICMP or IGMP
+ *        checksum of a received frame, without reading the payload again.
+ *        The checksum of the protocol data is found by subtracting the
+ *        Ethernet header, the IP header and the padding from the checksum
+ *        of the complete frame.  The result is stored in the network buffer
+ *        for prvAllowIPPacketIPv4().  Frames that are not checked here, like
+ *        UDP packets without a checksum, are left to the IP-task.
+ *
+ * @param[in] pxNetworkBuffer: The buffer with the received frame.
+ * @param[in] usFrameSum: usGenerateChecksum( 0U, pucEthernetBuffer, xDataLength ).
+ */
+    void vNetworkBufferSetRxChecksum( NetworkBufferDescriptor_t * pxNetworkBuffer,
+                                      uint16_t usFrameSum )
+    {
+        const IPPacket_t * pxIPPacket = ipCAST_CONST_PTR_TO_CONST_TYPE_PTR( IPPacket_t, pxNetworkBuffer->pucEthernetBuffer );
+        const IPHeader_t * pxIPHeader = &( pxIPPacket->xIPHeader );
+        size_t uxDataLength = pxNetworkBuffer->xDataLength;
+        size_t uxHeaderLength, uxTotalLength, uxProtocolLength, uxMinimumLength;
+        uint32_t ulSum;
+        uint16_t usPart;
+        const uint16_t * pusChecksum;
+
+        pxNetworkBuffer->ucRxChecksum = ipRX_CHECKSUM_UNKNOWN;
+
+        do
+        {
+            if( ( uxDataLength < sizeof( IPPacket_t ) ) ||
+                ( pxIPPacket->xEthernetHeader.usFrameType != ipIPv4_FRAME_TYPE ) ||
+                ( ( pxIPHeader->ucVersionHeaderLength & 0xF0U ) != ( ipIPV4_VERSION_HEADER_LENGTH_MIN & 0xF0U ) ) )
+            {
+                break;
+            }
+
+            uxHeaderLength = 4U * ( ( size_t ) pxIPHeader->ucVersionHeaderLength & 0x0FU );
+            uxTotalLength = ( size_t ) FreeRTOS_ntohs( pxIPHeader->usLength );
+
+            /* Packets with IP options are left to the IP-task. */
+            if( ( uxHeaderLength != ipSIZE_OF_IPv4_HEADER ) ||
+                ( uxTotalLength < uxHeaderLength ) ||
+                ( uxDataLength < ( ipSIZE_OF_ETH_HEADER + uxTotalLength ) ) )
+            {
+                break;
+            }
+
+            /* Does the IP header add up? */
+            if( usGenerateChecksum( 0U, &( pxIPHeader->ucVersionHeaderLength ), uxHeaderLength ) != ipCORRECT_CRC )
+            {
+                pxNetworkBuffer->ucRxChecksum = ipRX_CHECKSUM_BAD;
+                break;
+            }
+
+            uxProtocolLength = uxTotalLength - uxHeaderLength;
+            pusChecksum = ipPOINTER_CAST( const uint16_t *, &( pxNetworkBuffer->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER + uxHeaderLength ] ) );
+
+            switch( pxIPHeader->ucProtocol )
+            {
+                case ipPROTOCOL_TCP:
+                    uxMinimumLength = ipSIZE_OF_TCP_HEADER;
+                    pusChecksum = &( pusChecksum[ 8 ] );
+                    break;
+
+                case ipPROTOCOL_UDP:
+                    uxMinimumLength = ipSIZE_OF_UDP_HEADER;
+                    pusChecksum = &( pusChecksum[ 3 ] );
+                    break;
+
+                case ipPROTOCOL_ICMP:
+                case ipPROTOCOL_IGMP:
+                    uxMinimumLength = ipSIZE_OF_ICMPv4_HEADER;
+                    pusChecksum = &( pusChecksum[ 1 ] );
+                    break;
+
+                default:
+                    uxMinimumLength = 0U;
+                    break;
+            }
+
+            /* Other protocols and lengths that usGenerateProtocolChecksum()
+             * would not accept are left to the IP-task. */
+            if( ( uxMinimumLength == 0U ) ||
+                ( uxProtocolLength < uxMinimumLength ) ||
+                ( uxProtocolLength < ipSIZE_OF_UDP_HEADER ) ||
+                ( uxProtocolLength > ( ipconfigNETWORK_MTU - uxHeaderLength ) ) )
+            {
+                break;
+            }
+
+            if( ( pxIPHeader->ucProtocol == ( uint8_t ) ipPROTOCOL_UDP ) && ( *pusChecksum == 0U ) )
+            {
+                /* The sender did not set a checksum. */
+                break;
+            }
+
+            /* Start with the whole frame and subtract the Ethernet header and
+             * the padding behind the IP packet.  The IP header adds up to
+             * 0xffff, which is zero in one's complement. */
+            ulSum = usFrameSum;
+            ulSum += ( uint16_t ) ~usGenerateChecksum( 0U, pxNetworkBuffer->pucEthernetBuffer, ipSIZE_OF_ETH_HEADER );
+
+            if( uxDataLength > ( ipSIZE_OF_ETH_HEADER + uxTotalLength ) )
+            {
+                usPart = usGenerateChecksum( 0U,
+                                             &( pxNetworkBuffer->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER + uxTotalLength ] ),
+                                             uxDataLength - ( ipSIZE_OF_ETH_HEADER + uxTotalLength ) );
+                ulSum += ( uint16_t ) ~usChecksumAddBlock( 0U, usPart, ipSIZE_OF_ETH_HEADER + uxTotalLength );
+            }
+
+            if( ( pxIPHeader->ucProtocol == ( uint8_t ) ipPROTOCOL_TCP ) ||
+                ( pxIPHeader->ucProtocol == ( uint8_t ) ipPROTOCOL_UDP ) )
+            {
+                /* The pseudo header: addresses, protocol and length. */
+                ulSum += usGenerateChecksum( 0U,
+                                             ipPOINTER_CAST( const uint8_t *, &( pxIPHeader->ulSourceIPAddress ) ),
+                                             2U * ipSIZE_OF_IPv4_ADDRESS );
+                ulSum += ( uint32_t ) pxIPHeader->ucProtocol + ( uint32_t ) uxProtocolLength;
+            }
+
+            ulSum = ( ulSum & 0xffffU ) + ( ulSum >> 16 );
+            ulSum = ( ulSum & 0xffffU ) + ( ulSum >> 16 );
+
+            /* Both 0x0000 and 0xffff stand for zero in one's complement. */
+            if( ( ulSum == 0U ) || ( ulSum == ipCORRECT_CRC ) )
+            {
+                pxNetworkBuffer->ucRxChecksum = ipRX_CHECKSUM_GOOD;
+            }
+            else
+            {
+                pxNetworkBuffer->ucRxChecksum = ipRX_CHECKSUM_BAD;
+            }
+        } while( ipFALSE_BOOL );
+    }
+#endif /* ipconfigDRIVER_VERIFIES_RX_CHECKSUM */
+/*-----------------------------------------------------------*/
+
 /* This function is used in other files, has external linkage e.g. in
  * FreeRTOS_DNS.c. Not to be made static. */
 
@@ -195,6 +195,26 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain,
                                     size_t uxDataLength );
 #endif /* ipconfigUSE_TCP */
 
+#if ( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_WIN == 1 )
+
+/*
+ * Called from FreeRTOS_send(): returns pdTRUE when the socket is corked and
+ * the data waiting in txStream does not fill a segment yet.
+ */
+    static BaseType_t prvTCPSendCorked( const FreeRTOS_Socket_t * pxSocket );
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_WIN == 1 ) */
+
+#if ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_CONST_REGIONS != 0 )
+
+/*
+ * Called from FreeRTOS_send(): reserve space in txStream for constant data
+ * without copying it, see FREERTOS_MSG_CONST.
+ */
+    static size_t prvTCPSendConst( FreeRTOS_Socket_t * pxSocket,
+                                   const uint8_t * pucData,
+                                   size_t uxLength );
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_CONST_REGIONS != 0 ) */
+
 #if ( ipconfigUSE_TCP == 1 )
 
 /*
@@ -3783,6 +3803,117 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t * pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if ( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_WIN == 1 )
+
+/**
+ * @brief Called from FreeRTOS_send(): check if the IP-task can be left alone
+ *        because the socket is corked ( FREERTOS_SO_SET_FULL_SIZE ) and the
+ *        data that it has not seen yet is less than a full segment.
+ *
+ * @param[in] pxSocket: The socket owning the connection.
+ *
+ * @return pdTRUE when no eTCPTimerEvent needs to be sent.
+ */
+    static BaseType_t prvTCPSendCorked( const FreeRTOS_Socket_t * pxSocket )
+    {
+        BaseType_t xReturn = pdFALSE;
+
+        if( ( pxSocket->u.xTCP.xTCPWindow.u.bits.bSendFullSize != pdFALSE_UNSIGNED ) &&
+            ( pxSocket->u.xTCP.bits.bCloseRequested == pdFALSE_UNSIGNED ) &&
+            ( uxStreamBufferMidSpace( pxSocket->u.xTCP.txStream ) < ( size_t ) pxSocket->u.xTCP.usCurMSS ) )
+        {
+            xReturn = pdTRUE;
+        }
+
+        return xReturn;
+    }
+
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_WIN == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_CONST_REGIONS != 0 )
+
+/**
+ * @brief Called from FreeRTOS_send() with FREERTOS_MSG_CONST: advance the head
+ *        of txStream without copying the data, and remember where the data
+ *        is.  The IP-task reads it from there when it builds a segment.
+ *
+ * @param[in] pxSocket: The socket owning the connection.
+ * @param[in] pucData: The constant data.
+ * @param[in] uxLength: The number of bytes, it must fit in txStream.
+ *
+ * @return The number of bytes added to txStream.
+ */
+    static size_t prvTCPSendConst( FreeRTOS_Socket_t * pxSocket,
+                                   const uint8_t * pucData,
+                                   size_t uxLength )
+    {
+        StreamBuffer_t * pxStream = pxSocket->u.xTCP.txStream;
+        TCPConstRegion_t * pxRegion;
+        TCPConstRegion_t * pxFree = NULL;
+        TCPConstRegion_t * pxLast = NULL;
+        UBaseType_t uxIndex;
+        size_t uxEnd;
+        size_t uxCount;
+
+        /* The IP-task shrinks the regions when data gets acknowledged, it may
+         * not run while they are changed here. */
+        vTaskSuspendAll();
+        {
+            for( uxIndex = 0U; uxIndex < ( UBaseType_t ) ipconfigTCP_TX_CONST_REGIONS; uxIndex++ )
+            {
+                pxRegion = &( pxSocket->u.xTCP.xConstRegions[ uxIndex ] );
+
+                if( pxRegion->uxLength == 0U )
+                {
+                    if( pxFree == NULL )
+                    {
+                        pxFree = pxRegion;
+                    }
+                }
+                else
+                {
+                    uxEnd = pxRegion->uxStart + pxRegion->uxLength;
+
+                    if( uxEnd >= pxStream->LENGTH )
+                    {
+                        uxEnd -= pxStream->LENGTH;
+                    }
+
+                    /* A file that is sent in parts continues the same region. */
+                    if( ( uxEnd == pxStream->uxHead ) && ( &( pxRegion->pucData[ pxRegion->uxLength ] ) == pucData ) )
+                    {
+                        pxLast = pxRegion;
+                    }
+                }
+            }
+
+            if( pxLast != NULL )
+            {
+                uxCount = uxStreamBufferAdd( pxStream, 0U, NULL, uxLength );
+                pxLast->uxLength += uxCount;
+            }
+            else if( pxFree != NULL )
+            {
+                pxFree->pucData = pucData;
+                pxFree->uxStart = pxStream->uxHead;
+                uxCount = uxStreamBufferAdd( pxStream, 0U, NULL, uxLength );
+                pxFree->uxLength = uxCount;
+            }
+            else
+            {
+                /* All regions are in use, copy the data. */
+                uxCount = uxStreamBufferAdd( pxStream, 0U, pucData, uxLength );
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        return uxCount;
+    }
+
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_CONST_REGIONS != 0 ) */
+/*-----------------------------------------------------------*/
+
 #if ( ipconfigUSE_TCP == 1 )
 
 /**
@@ -3835,7 +3966,8 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t * pxSocket )
  * @param[in] xSocket: The socket owning the connection.
  * @param[in] pvBuffer: The buffer containing the data.
  * @param[in] uxDataLength: The length of the data to be added.
- * @param[in] xFlags: This parameter is not used. (zero or FREERTOS_MSG_DONTWAIT).
+ * @param[in] xFlags: Zero or FREERTOS_MSG_DONTWAIT, optionally or'ed with
+ *                   FREERTOS_MSG_CONST when pvBuffer is constant, e.g. in flash.
  *
  * @return The number of bytes actually sent. Zero when nothing could be sent
  *         or a negative error code in case an error occurred.
@@ -3852,6 +3984,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t * pxSocket )
         BaseType_t xTimed = pdFALSE;
         TimeOut_t xTimeOut;
         BaseType_t xCloseAfterSend;
+        BaseType_t xWakeUp;
         const uint8_t * pucSource = ipPOINTER_CAST( const uint8_t *, pvBuffer );
 
         /* Prevent compiler warnings about unused parameters.  The parameter
@@ -3910,7 +4043,16 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t * pxSocket )
                         pxSocket->u.xTCP.bits.bCloseRequested = pdTRUE_UNSIGNED;
                     }
 
-                    xByteCount = ( BaseType_t ) uxStreamBufferAdd( pxSocket->u.xTCP.txStream, 0UL, pucSource, ( size_t ) xByteCount );
+                    #if ( ipconfigTCP_TX_CONST_REGIONS != 0 )
+                        if( ( ( uint32_t ) xFlags & ( uint32_t ) FREERTOS_MSG_CONST ) != 0U )
+                        {
+                            xByteCount = ( BaseType_t ) prvTCPSendConst( pxSocket, pucSource, ( size_t ) xByteCount );
+                        }
+                        else
+                    #endif /* ipconfigTCP_TX_CONST_REGIONS */
+                    {
+                        xByteCount = ( BaseType_t ) uxStreamBufferAdd( pxSocket->u.xTCP.txStream, 0UL, pucSource, ( size_t ) xByteCount );
+                    }
 
                     if( xCloseAfterSend != pdFALSE )
                     {
@@ -3924,10 +4066,24 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t * pxSocket )
                     * socket.  Data is sent, let the IP-task work on it. */
                     pxSocket->u.xTCP.usTimeout = 1U;
 
-                    if( xIsCallingFromIPTask() == pdFALSE )
+                    /* Only send a TCP timer event when not called from the
+                     * IP-task. */
+                    xWakeUp = ( xIsCallingFromIPTask() == pdFALSE ) ? pdTRUE : pdFALSE;
+
+                    #if ( ipconfigUSE_TCP_WIN == 1 )
+                        {
+                            if( prvTCPSendCorked( pxSocket ) != pdFALSE )
+                            {
+                                /* The IP-task would not find a full segment to
+                                 * send.  It will be woken up when the cork is
+                                 * removed. */
+                                xWakeUp = pdFALSE;
+                            }
+                        }
+                    #endif /* ipconfigUSE_TCP_WIN */
+
+                    if( xWakeUp != pdFALSE )
                     {
-                        /* Only send a TCP timer event when not called from the
-                         * IP-task. */
                         ( void ) xSendEventToIPTask( eTCPTimerEvent );
                     }
 
@@ -4076,6 +4232,20 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t * pxSocket )
                     vStreamBufferClear( pxSocket->u.xTCP.txStream );
                 }
 
+                #if ( ipconfigTCP_TX_CONST_REGIONS != 0 )
+                    {
+                        ( void ) memset( pxSocket->u.xTCP.xConstRegions, 0, sizeof( pxSocket->u.xTCP.xConstRegions ) );
+                    }
+                #endif
+
+                #if ( ipconfigUSE_TCP_WIN == 1 )
+                    {
+                        /* Return the segments and the window budget of the
+                         * previous connection before the window is cleared. */
+                        vTCPWindowDestroy( &pxSocket->u.xTCP.xTCPWindow );
+                    }
+                #endif
+
                 ( void ) memset( pxSocket->u.xTCP.xPacket.u.ucLastPacket, 0, sizeof( pxSocket->u.xTCP.xPacket.u.ucLastPacket ) );
                 ( void ) memset( &pxSocket->u.xTCP.xTCPWindow, 0, sizeof( pxSocket->u.xTCP.xTCPWindow ) );
                 ( void ) memset( &pxSocket->u.xTCP.bits, 0, sizeof( pxSocket->u.xTCP.bits ) );
@@ -5381,7 +5551,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t * pxSocket )
         xEvent.pvData = pxSocket;
 
         /* The IP-task will call FreeRTOS_SignalSocket for this socket. */
-        xReturn = xQueueSendToBackFromISR( xNetworkEventQueue, &xEvent, pxHigherPriorityTaskWoken );
+        xReturn = xSendEventStructToIPTaskFromISR( &xEvent, pxHigherPriorityTaskWoken );
 
         return xReturn;
     }
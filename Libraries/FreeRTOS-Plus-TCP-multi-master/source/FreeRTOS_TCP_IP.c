@@ -167,6 +167,15 @@
         #define tcpMAXIMUM_TCP_WAKEUP_TIME_MS    20000U
     #endif
 
+/** @brief
+ * Constant data at the end of a segment is sent as a fragment of the network
+ * buffer, see FREERTOS_MSG_CONST.  A shorter piece is cheaper to copy than to
+ * give it a DMA descriptor of its own.
+ */
+    #ifndef tcpCONST_FRAGMENT_MIN_LENGTH
+        #define tcpCONST_FRAGMENT_MIN_LENGTH    64U
+    #endif
+
 /*
  * Returns true if the socket must be checked.  Non-active sockets are waiting
  * for user action, either connect() or close().
@@ -390,6 +399,33 @@
         static uint8_t prvWinScaleFactor( const FreeRTOS_Socket_t * pxSocket );
     #endif
 
+    #if ( ipconfigTCP_TX_CONST_REGIONS != 0 )
+
+/*
+ * Copy a segment from txStream, where parts may refer to constant memory.
+ */
+        static size_t prvTCPConstGet( FreeRTOS_Socket_t * pxSocket,
+                                      NetworkBufferDescriptor_t * pxNetworkBuffer,
+                                      size_t uxOffset,
+                                      uint8_t * pucTarget,
+                                      size_t uxCount );
+
+/*
+ * Let the constant regions of txStream follow the tail when data is acked.
+ */
+        static void prvTCPConstAck( FreeRTOS_Socket_t * pxSocket,
+                                    size_t uxCount );
+    #endif /* ipconfigTCP_TX_CONST_REGIONS */
+
+    #if ( ipconfigTCP_TX_CONST_REGIONS != 0 ) && ( ipconfigMAX_TX_FRAGMENTS != 0 )
+
+/*
+ * Calculate the TCP checksum of a segment that ends in a fragment.
+ */
+        static void prvTCPFragmentChecksum( NetworkBufferDescriptor_t * pxNetworkBuffer,
+                                            uint32_t ulLen );
+    #endif
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -1090,6 +1126,18 @@
                 /* Important: tell NIC driver how many bytes must be sent. */
                 pxNetworkBuffer->xDataLength = ulLen + ipSIZE_OF_ETH_HEADER;
 
+                #if ( ipconfigMAX_TX_FRAGMENTS != 0 )
+                    {
+                        UBaseType_t uxIndex;
+
+                        /* The fragments are sent behind the bytes in the buffer. */
+                        for( uxIndex = 0U; uxIndex < pxNetworkBuffer->uxFragmentCount; uxIndex++ )
+                        {
+                            pxNetworkBuffer->xDataLength -= pxNetworkBuffer->xFragments[ uxIndex ].xLength;
+                        }
+                    }
+                #endif /* ipconfigMAX_TX_FRAGMENTS */
+
                 #if ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
                     {
                         /* calculate the IP header checksum, in case the driver won't do that. */
@@ -1098,7 +1146,16 @@
                         pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
 
                         /* calculate the TCP checksum for an outgoing packet. */
-                        ( void ) usGenerateProtocolChecksum( ( uint8_t * ) pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength, pdTRUE );
+                        #if ( ipconfigTCP_TX_CONST_REGIONS != 0 ) && ( ipconfigMAX_TX_FRAGMENTS != 0 )
+                            if( pxNetworkBuffer->uxFragmentCount != 0U )
+                            {
+                                prvTCPFragmentChecksum( pxNetworkBuffer, ulLen );
+                            }
+                            else
+                        #endif
+                        {
+                            ( void ) usGenerateProtocolChecksum( ( uint8_t * ) pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength, pdTRUE );
+                        }
 
                         /* A calculated checksum of 0 must be inverted as 0 means the checksum
                          * is disabled. */
@@ -1133,9 +1190,49 @@
             pvCopyDest = &( pxEthernetHeader->xSourceAddress );
             ( void ) memcpy( pvCopyDest, pvCopySource, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
 
+            #if ( ipconfigMAX_TX_FRAGMENTS != 0 )
+                {
+                    /* The segment may end in constant data, see prvTCPConstGet().
+                     * Not every interface can send that as it is. */
+                    if( ( pxNetworkBuffer->uxFragmentCount != 0U ) && ( pxInterface->bits.bTxFragments == pdFALSE_UNSIGNED ) )
+                    {
+                        if( xNetworkBufferFlattenFragments( pxNetworkBuffer ) == pdFAIL )
+                        {
+                            /* prvTCPBufferResize() made room for the complete segment. */
+                            FreeRTOS_debug_printf( ( "prvTCPReturnPacket: flatten failed\n" ) );
+                        }
+                    }
+                }
+            #endif /* ipconfigMAX_TX_FRAGMENTS */
+
             #if defined( ipconfigETHERNET_MINIMUM_PACKET_BYTES )
                 {
-                    if( pxNetworkBuffer->xDataLength < ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+                    BaseType_t xPad = ( pxNetworkBuffer->xDataLength < ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES ) ? pdTRUE : pdFALSE;
+
+                    #if ( ipconfigMAX_TX_FRAGMENTS != 0 )
+                        {
+                            /* The frame continues in its fragments, the padding would
+                             * overwrite the place where they belong.  Copy them into the
+                             * buffer first, and only pad when the frame is still short. */
+                            if( ( xPad != pdFALSE ) && ( pxNetworkBuffer->uxFragmentCount != 0U ) )
+                            {
+                                if( xNetworkBufferFlattenFragments( pxNetworkBuffer ) == pdFAIL )
+                                {
+                                    xPad = pdFALSE;
+                                }
+                                else if( pxNetworkBuffer->xDataLength >= ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+                                {
+                                    xPad = pdFALSE;
+                                }
+                                else
+                                {
+                                    /* Still too short. */
+                                }
+                            }
+                        }
+                    #endif /* ipconfigMAX_TX_FRAGMENTS */
+
+                    if( xPad != pdFALSE )
                     {
                         BaseType_t xIndex;
 
@@ -1194,6 +1291,17 @@
  */
     static void prvTCPCreateWindow( FreeRTOS_Socket_t * pxSocket )
     {
+        #if ( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_WIN_BUDGET != 0 )
+            {
+                /* The windows may become smaller than the socket asked for
+                 * when the pool of segment descriptors is running low.  The
+                 * new size is also used for the window scaling option. */
+                vTCPWindowBudget( &( pxSocket->u.xTCP.xTCPWindow ),
+                                  &( pxSocket->u.xTCP.uxRxWinSize ),
+                                  &( pxSocket->u.xTCP.uxTxWinSize ) );
+            }
+        #endif
+
         if( xTCPWindowLoggingLevel != 0 )
         {
             FreeRTOS_debug_printf( ( "Limits (using): TCP Win size %u Water %u <= %u <= %u\n",
@@ -1785,6 +1893,12 @@
              */
             if( ( pxSocket->u.xTCP.txStream != NULL ) && ( ulCount > 0U ) )
             {
+                #if ( ipconfigTCP_TX_CONST_REGIONS != 0 )
+                    {
+                        prvTCPConstAck( pxSocket, ( size_t ) ulCount );
+                    }
+                #endif
+
                 /* Just advancing the tail index, 'ulCount' bytes have been confirmed. */
                 ( void ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, 0, NULL, ( size_t ) ulCount, pdFALSE );
                 pxSocket->xEventBits |= ( EventBits_t ) eSOCKET_SEND;
@@ -2210,7 +2324,7 @@
                 if( pxNetworkBuffer != NULL )
                 {
                     /* Either from the previous buffer... */
-                    ( void ) memcpy( pxReturn->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
+                    ( void ) pvCopyPacketData( pxReturn->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
 
                     /* ...and release it. */
                     vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
@@ -2235,6 +2349,221 @@
     }
 /*-----------------------------------------------------------*/
 
+    #if ( ipconfigTCP_TX_CONST_REGIONS != 0 )
+
+/**
+ * @brief Copy the data of a segment from txStream in 'peek' mode.  Bytes
+ *        that were sent with FREERTOS_MSG_CONST are read from their constant
+ *        memory.  When such bytes end the segment, the network buffer refers
+ *        to them as a fragment and they are not copied at all.
+ *
+ * @param[in] pxSocket: The socket owning the connection.
+ * @param[in] pxNetworkBuffer: The network buffer that will carry the segment.
+ * @param[in] uxOffset: The position of the data, as an offset from the tail of txStream.
+ * @param[in] pucTarget: Where the TCP payload starts in the network buffer.
+ * @param[in] uxCount: The number of bytes in the segment.
+ *
+ * @return The number of bytes in the segment, as uxStreamBufferGet() would.
+ */
+        static size_t prvTCPConstGet( FreeRTOS_Socket_t * pxSocket,
+                                      NetworkBufferDescriptor_t * pxNetworkBuffer,
+                                      size_t uxOffset,
+                                      uint8_t * pucTarget,
+                                      size_t uxCount )
+        {
+            StreamBuffer_t * pxStream = pxSocket->u.xTCP.txStream;
+            const TCPConstRegion_t * pxRegion;
+            const uint8_t * pucSource;
+            UBaseType_t uxIndex;
+            size_t uxDone = 0U;
+            size_t uxPosition, uxStart, uxPiece, uxGot;
+
+            #if ( ipconfigMAX_TX_FRAGMENTS != 0 )
+                BaseType_t xFragment = pdFALSE;
+
+                /* The buffer may have carried an earlier segment. */
+                pxNetworkBuffer->uxFragmentCount = 0U;
+
+                /* prvTCPFragmentChecksum() only knows IPv4. */
+                #if ( ipconfigUSE_IPv6 != 0 )
+                    if( pxSocket->bits.bIsIPv6 == pdFALSE_UNSIGNED )
+                #endif
+                {
+                    xFragment = pdTRUE;
+                }
+            #else
+                {
+                    ( void ) pxNetworkBuffer;
+                }
+            #endif /* ipconfigMAX_TX_FRAGMENTS */
+
+            while( uxDone < uxCount )
+            {
+                uxPosition = uxOffset + uxDone;
+                uxPiece = uxCount - uxDone;
+                pucSource = NULL;
+
+                /* All regions in use lie between the tail and the head of
+                 * txStream.  Find the one holding uxPosition, or else the first
+                 * one that starts behind it. */
+                for( uxIndex = 0U; uxIndex < ( UBaseType_t ) ipconfigTCP_TX_CONST_REGIONS; uxIndex++ )
+                {
+                    pxRegion = &( pxSocket->u.xTCP.xConstRegions[ uxIndex ] );
+
+                    if( pxRegion->uxLength != 0U )
+                    {
+                        uxStart = uxStreamBufferDistance( pxStream, pxStream->uxTail, pxRegion->uxStart );
+
+                        if( uxPosition < uxStart )
+                        {
+                            uxPiece = FreeRTOS_min_uint32( uxPiece, uxStart - uxPosition );
+                        }
+                        else if( uxPosition < ( uxStart + pxRegion->uxLength ) )
+                        {
+                            pucSource = &( pxRegion->pucData[ uxPosition - uxStart ] );
+                            uxPiece = FreeRTOS_min_uint32( uxPiece, ( uxStart + pxRegion->uxLength ) - uxPosition );
+                        }
+                        else
+                        {
+                            /* The region ends before uxPosition. */
+                        }
+                    }
+                }
+
+                if( pucSource == NULL )
+                {
+                    uxGot = uxStreamBufferGet( pxStream, uxPosition, &( pucTarget[ uxDone ] ), uxPiece, pdTRUE );
+                    uxDone += uxGot;
+
+                    if( uxGot != uxPiece )
+                    {
+                        break;
+                    }
+                }
+                else
+                {
+                    #if ( ipconfigMAX_TX_FRAGMENTS != 0 )
+                        if( ( xFragment != pdFALSE ) && ( ( uxDone + uxPiece ) == uxCount ) && ( uxPiece >= tcpCONST_FRAGMENT_MIN_LENGTH ) )
+                        {
+                            /* The checksum is summed in 16-bit words: the bytes in
+                             * the buffer must have an even length. */
+                            if( ( uxDone & 1U ) != 0U )
+                            {
+                                pucTarget[ uxDone ] = pucSource[ 0 ];
+                                pucSource = &( pucSource[ 1 ] );
+                                uxDone++;
+                                uxPiece--;
+                            }
+
+                            if( xNetworkBufferAddFragment( pxNetworkBuffer, pucSource, uxPiece ) == pdPASS )
+                            {
+                                uxDone += uxPiece;
+                                uxPiece = 0U;
+                            }
+                        }
+                    #endif /* ipconfigMAX_TX_FRAGMENTS */
+
+                    ( void ) memcpy( &( pucTarget[ uxDone ] ), pucSource, uxPiece );
+                    uxDone += uxPiece;
+                }
+            }
+
+            return uxDone;
+        }
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The peer has acknowledged 'uxCount' bytes and the tail of txStream
+ *        is about to advance.  Shrink the constant regions accordingly, a
+ *        region that has been acknowledged completely becomes free.
+ *
+ * @param[in] pxSocket: The socket owning the connection.
+ * @param[in] uxCount: The number of bytes acknowledged.
+ */
+        static void prvTCPConstAck( FreeRTOS_Socket_t * pxSocket,
+                                    size_t uxCount )
+        {
+            const StreamBuffer_t * pxStream = pxSocket->u.xTCP.txStream;
+            TCPConstRegion_t * pxRegion;
+            UBaseType_t uxIndex;
+            size_t uxStart, uxAcked;
+
+            /* FreeRTOS_send() changes the regions with the scheduler suspended, do
+             * the same here in case it runs at a higher priority. */
+            vTaskSuspendAll();
+            {
+                for( uxIndex = 0U; uxIndex < ( UBaseType_t ) ipconfigTCP_TX_CONST_REGIONS; uxIndex++ )
+                {
+                    pxRegion = &( pxSocket->u.xTCP.xConstRegions[ uxIndex ] );
+
+                    if( pxRegion->uxLength != 0U )
+                    {
+                        uxStart = uxStreamBufferDistance( pxStream, pxStream->uxTail, pxRegion->uxStart );
+
+                        if( uxStart < uxCount )
+                        {
+                            uxAcked = FreeRTOS_min_uint32( uxCount - uxStart, pxRegion->uxLength );
+                            pxRegion->pucData = &( pxRegion->pucData[ uxAcked ] );
+                            pxRegion->uxStart += uxAcked;
+
+                            if( pxRegion->uxStart >= pxStream->LENGTH )
+                            {
+                                pxRegion->uxStart -= pxStream->LENGTH;
+                            }
+
+                            pxRegion->uxLength -= uxAcked;
+                        }
+                    }
+                }
+            }
+            ( void ) xTaskResumeAll();
+        }
+/*-----------------------------------------------------------*/
+
+    #endif /* ipconfigTCP_TX_CONST_REGIONS */
+
+    #if ( ipconfigTCP_TX_CONST_REGIONS != 0 ) && ( ipconfigMAX_TX_FRAGMENTS != 0 )
+
+/**
+ * @brief Calculate the TCP checksum of an IPv4 segment of which the last part
+ *        is a fragment.  usGenerateProtocolChecksum() only sees the bytes in
+ *        the network buffer.  prvTCPConstGet() made sure that those have an
+ *        even length, so the sum simply continues over the fragment.
+ *
+ * @param[in] pxNetworkBuffer: The network buffer carrying the segment.
+ * @param[in] ulLen: The length of the IP packet, including the fragment.
+ */
+        static void prvTCPFragmentChecksum( NetworkBufferDescriptor_t * pxNetworkBuffer,
+                                            uint32_t ulLen )
+        {
+            IPHeader_t * pxIPHeader = ipCAST_PTR_TO_TYPE_PTR( IPHeader_t, &( pxNetworkBuffer->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER ] ) );
+            ProtocolHeaders_t * pxProtocolHeaders = ipCAST_PTR_TO_TYPE_PTR( ProtocolHeaders_t, &( pxNetworkBuffer->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER ] ) );
+            size_t uxBufferedLength = pxNetworkBuffer->xDataLength - ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER );
+            uint16_t usChecksum;
+            UBaseType_t uxIndex;
+
+            pxProtocolHeaders->xTCPHeader.usChecksum = 0U;
+
+            /* The pseudo header: protocol and TCP length, then the IP addresses,
+             * which are followed by the TCP header and the data in the buffer. */
+            usChecksum = ( uint16_t ) ( ( ulLen - ipSIZE_OF_IPv4_HEADER ) + ( uint32_t ) ipPROTOCOL_TCP );
+            usChecksum = usGenerateChecksum( usChecksum,
+                                             ipPOINTER_CAST( const uint8_t *, &( pxIPHeader->ulSourceIPAddress ) ),
+                                             ( 2U * ipSIZE_OF_IPv4_ADDRESS ) + uxBufferedLength );
+
+            for( uxIndex = 0U; uxIndex < pxNetworkBuffer->uxFragmentCount; uxIndex++ )
+            {
+                usChecksum = usGenerateChecksum( usChecksum,
+                                                 pxNetworkBuffer->xFragments[ uxIndex ].pucData,
+                                                 pxNetworkBuffer->xFragments[ uxIndex ].xLength );
+            }
+
+            pxProtocolHeaders->xTCPHeader.usChecksum = FreeRTOS_htons( ( uint16_t ) ~usChecksum );
+        }
+/*-----------------------------------------------------------*/
+
+    #endif /* ( ipconfigTCP_TX_CONST_REGIONS != 0 ) && ( ipconfigMAX_TX_FRAGMENTS != 0 ) */
+
 /**
  * @brief Prepare an outgoing message, in case anything has to be sent.
  *
@@ -2311,7 +2640,15 @@
 
                     /* Here data is copied from the txStream in 'peek' mode.  Only
                      * when the packets are acked, the tail marker will be updated. */
-                    ulDataGot = ( uint32_t ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, uxOffset, pucSendData, ( size_t ) lDataLen, pdTRUE );
+                    #if ( ipconfigTCP_TX_CONST_REGIONS != 0 )
+                        {
+                            ulDataGot = ( uint32_t ) prvTCPConstGet( pxSocket, pxNewBuffer, uxOffset, pucSendData, ( size_t ) lDataLen );
+                        }
+                    #else
+                        {
+                            ulDataGot = ( uint32_t ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, uxOffset, pucSendData, ( size_t ) lDataLen, pdTRUE );
+                        }
+                    #endif
 
                     #if ( ipconfigHAS_DEBUG_PRINTF != 0 )
                         {
@@ -3094,6 +3431,10 @@
         uint16_t usWindow;
         UBaseType_t uxIntermediateResult = 0;
 
+        #if ( ipconfigUSE_TCP_WIN == 1 )
+            uint32_t ulPreviousWindowSize = pxSocket->u.xTCP.ulWindowSize;
+        #endif
+
         /* Remember the window size the peer is advertising. */
         usWindow = FreeRTOS_ntohs( pxTCPHeader->usWindow );
         pxSocket->u.xTCP.ulWindowSize = ( uint32_t ) usWindow;
@@ -3106,6 +3447,19 @@
 
         if( ( ucTCPFlags & ( uint8_t ) tcpTCP_FLAG_ACK ) != 0U )
         {
+            #if ( ipconfigUSE_TCP_WIN == 1 )
+                {
+                    /* Only a pure ACK that doesn't update the window counts as
+                     * a duplicate ACK ( RFC 5681 ). */
+                    if( ( ulReceiveLength == 0U ) &&
+                        ( ( ucTCPFlags & ( uint8_t ) ( tcpTCP_FLAG_SYN | tcpTCP_FLAG_FIN ) ) == 0U ) &&
+                        ( pxSocket->u.xTCP.ulWindowSize == ulPreviousWindowSize ) )
+                    {
+                        vTCPWindowTxDuplicateAck( pxTCPWindow, FreeRTOS_ntohl( pxTCPHeader->ulAckNr ) );
+                    }
+                }
+            #endif /* ipconfigUSE_TCP_WIN == 1 */
+
             ulCount = ulTCPWindowTxAck( pxTCPWindow, FreeRTOS_ntohl( pxTCPHeader->ulAckNr ) );
 
             /* ulTCPWindowTxAck() returns the number of bytes which have been acked,
@@ -3117,6 +3471,12 @@
                  * confirmed, and because there is new space in the txStream, the
                  * user/owner should be woken up. */
                 /* _HT_ : only in case the socket's waiting? */
+                #if ( ipconfigTCP_TX_CONST_REGIONS != 0 )
+                    {
+                        prvTCPConstAck( pxSocket, ( size_t ) ulCount );
+                    }
+                #endif
+
                 if( uxStreamBufferGet( pxSocket->u.xTCP.txStream, 0U, NULL, ( size_t ) ulCount, pdFALSE ) != 0U )
                 {
                     pxSocket->xEventBits |= ( EventBits_t ) eSOCKET_SEND;
@@ -213,6 +213,23 @@
                                                     uint32_t ulFirst );
     #endif /* ipconfigUSE_TCP_WIN == 1 */
 
+/*
+ * Duplicate ACKs or a partial ACK were received.  Requeue the oldest segment
+ * that has not been acknowledged for an immediate retransmission.
+ */
+    #if ( ipconfigUSE_TCP_WIN == 1 )
+        static BaseType_t prvTCPWindowTxRetransmit( TCPWindow_t * pxWindow );
+    #endif /* ipconfigUSE_TCP_WIN == 1 */
+
+/*
+ * Find the first sequence number of the contiguous block of received
+ * segments that ends at 'ulSequenceNumber'.
+ */
+    #if ( ipconfigUSE_TCP_WIN == 1 )
+        static uint32_t ulTCPWindowRxBlockStart( const TCPWindow_t * pxWindow,
+                                                 uint32_t ulSequenceNumber );
+    #endif /* ipconfigUSE_TCP_WIN == 1 */
+
 /*-----------------------------------------------------------*/
 
 /**< TCP segment pool. */
@@ -225,6 +242,11 @@
         _static List_t xSegmentList;
     #endif
 
+/**< The number of segment descriptors reserved by all windows. */
+    #if ( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_WIN_BUDGET != 0 )
+        static UBaseType_t uxTCPWindowReserved = 0U;
+    #endif
+
 /** @brief Logging verbosity level. */
     BaseType_t xTCPWindowLoggingLevel = 0;
 
@@ -523,6 +545,55 @@
 
     #if ( ipconfigUSE_TCP_WIN == 1 )
 
+/**
+ * @brief Find the start of the contiguous block of received segments that ends
+ *        at a given sequence number.
+ *
+ * @param[in] pxWindow: The descriptor of the TCP sliding windows.
+ * @param[in] ulSequenceNumber: The sequence number just after the block.
+ *
+ * @return The first sequence number of the block, or 'ulSequenceNumber' when
+ *         no stored segment ends there.
+ */
+        static uint32_t ulTCPWindowRxBlockStart( const TCPWindow_t * pxWindow,
+                                                 uint32_t ulSequenceNumber )
+        {
+            const ListItem_t * pxIterator;
+            const ListItem_t * pxEnd = listGET_END_MARKER( &pxWindow->xRxSegments );
+            const TCPSegment_t * pxSegment;
+            uint32_t ulFirst = ulSequenceNumber;
+            BaseType_t xFound;
+
+            /* xRxSegments is not sorted, so search again for every segment that
+             * extends the block to the left.  There are only a few segments. */
+            do
+            {
+                xFound = pdFALSE;
+
+                for( pxIterator = listGET_NEXT( pxEnd );
+                     pxIterator != pxEnd;
+                     pxIterator = listGET_NEXT( pxIterator ) )
+                {
+                    pxSegment = ipCAST_PTR_TO_TYPE_PTR( TCPSegment_t, listGET_LIST_ITEM_OWNER( pxIterator ) );
+
+                    if( ( pxSegment->lDataLength > 0 ) &&
+                        ( ( pxSegment->ulSequenceNumber + ( uint32_t ) pxSegment->lDataLength ) == ulFirst ) )
+                    {
+                        ulFirst = pxSegment->ulSequenceNumber;
+                        xFound = pdTRUE;
+                        break;
+                    }
+                }
+            } while( xFound != pdFALSE );
+
+            return ulFirst;
+        }
+
+    #endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
+    #if ( ipconfigUSE_TCP_WIN == 1 )
+
 /**
  * @brief Allocate a new segment object, either for transmission or reception.
  *
@@ -752,7 +823,7 @@
  *
  * @param[in] pxWindow: The descriptor of the TCP sliding windows.
  */
-        void vTCPWindowDestroy( TCPWindow_t const * pxWindow )
+        void vTCPWindowDestroy( TCPWindow_t * pxWindow )
         {
             const List_t * pxSegments;
             BaseType_t xRound;
@@ -782,12 +853,97 @@
                     }
                 }
             }
+
+            #if ( ipconfigTCP_WIN_BUDGET != 0 )
+                {
+                    /* Give the reserved descriptors back to the budget. */
+                    uxTCPWindowReserved -= pxWindow->uxBudget;
+                    pxWindow->uxBudget = 0U;
+                }
+            #endif
         }
 
 
     #endif /* ipconfigUSE_TCP_WIN == 1 */
 /*-----------------------------------------------------------*/
 
+    #if ( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_WIN_BUDGET != 0 )
+
+/**
+ * @brief Fit the window sizes of a new connection in the pool of segment
+ *        descriptors.  A window of N times MSS needs N descriptors, so each
+ *        connection reserves the sum of its reception and transmission
+ *        windows.  When less is free than asked for, the free descriptors are
+ *        divided in the same proportion, with at least one MSS each way.
+ *
+ * @param[in] pxWindow: The window of the connection.
+ * @param[in,out] puxRxWinSize: The reception window in units of MSS.
+ * @param[in,out] puxTxWinSize: The transmission window in units of MSS.
+ */
+        void vTCPWindowBudget( TCPWindow_t * pxWindow,
+                               size_t * puxRxWinSize,
+                               size_t * puxTxWinSize )
+        {
+            size_t uxWanted = *puxRxWinSize + *puxTxWinSize;
+            size_t uxFree = 0U;
+            size_t uxTxWinSize;
+
+            /* A window that is created a second time first gives back what
+             * it had reserved. */
+            uxTCPWindowReserved -= pxWindow->uxBudget;
+            pxWindow->uxBudget = 0U;
+
+            if( uxTCPWindowReserved < ( UBaseType_t ) ipconfigTCP_WIN_SEG_COUNT )
+            {
+                uxFree = ( size_t ) ipconfigTCP_WIN_SEG_COUNT - uxTCPWindowReserved;
+            }
+
+            if( uxWanted > uxFree )
+            {
+                uxTxWinSize = ( uxFree * *puxTxWinSize ) / uxWanted;
+
+                if( uxTxWinSize == 0U )
+                {
+                    uxTxWinSize = 1U;
+                }
+
+                if( uxFree > ( uxTxWinSize + 1U ) )
+                {
+                    *puxRxWinSize = uxFree - uxTxWinSize;
+                }
+                else
+                {
+                    *puxRxWinSize = 1U;
+                }
+
+                *puxTxWinSize = uxTxWinSize;
+
+                FreeRTOS_debug_printf( ( "vTCPWindowBudget: %u of %u free, Rx/Tx %u/%u MSS\n",
+                                         ( unsigned ) uxFree,
+                                         ( unsigned ) uxWanted,
+                                         ( unsigned ) *puxRxWinSize,
+                                         ( unsigned ) *puxTxWinSize ) );
+            }
+
+            pxWindow->uxBudget = ( UBaseType_t ) ( *puxRxWinSize + *puxTxWinSize );
+            uxTCPWindowReserved += pxWindow->uxBudget;
+        }
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get the number of segment descriptors reserved by all windows.
+ *
+ * @return The number of reserved descriptors, which may exceed
+ *         ipconfigTCP_WIN_SEG_COUNT when many connections are open.
+ */
+        UBaseType_t uxTCPWindowBudgetReserved( void )
+        {
+            return uxTCPWindowReserved;
+        }
+
+    #endif /* ( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_WIN_BUDGET != 0 ) */
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Create a window for TCP.
  *
@@ -898,6 +1054,14 @@
         /* The right-hand side of the transmit window. */
         pxWindow->tx.ulHighestSequenceNumber = ulSequenceNumber;
         pxWindow->ulOurSequenceNumber = ulSequenceNumber;
+
+        #if ( ipconfigUSE_TCP_WIN == 1 )
+            {
+                /* Not in fast recovery, see vTCPWindowTxDuplicateAck(). */
+                pxWindow->ulRecoverSequenceNumber = ulSequenceNumber;
+                pxWindow->ucDupAckCount = 0U;
+            }
+        #endif /* ipconfigUSE_TCP_WIN == 1 */
     }
 /*-----------------------------------------------------------*/
 
@@ -1188,8 +1352,10 @@
                      * Code OPTION_CODE_SINGLE_SACK already in network byte order. */
                     pxWindow->ulOptionsData[ 0 ] = OPTION_CODE_SINGLE_SACK;
 
-                    /* First sequence number that we received. */
-                    pxWindow->ulOptionsData[ 1 ] = FreeRTOS_htonl( ulSequenceNumber );
+                    /* First sequence number of the block that holds this
+                     * packet, the first SACK block must report it as a whole
+                     * ( RFC 2018 ). */
+                    pxWindow->ulOptionsData[ 1 ] = FreeRTOS_htonl( ulTCPWindowRxBlockStart( pxWindow, ulSequenceNumber ) );
 
                     /* Last + 1 */
                     pxWindow->ulOptionsData[ 2 ] = FreeRTOS_htonl( ulLast );
@@ -2037,6 +2203,118 @@
 
     #if ( ipconfigUSE_TCP_WIN == 1 )
 
+/**
+ * @brief Queue the oldest unacknowledged segment for an immediate retransmission.
+ *
+ * @param[in] pxWindow: The descriptor of the TCP sliding windows.
+ *
+ * @return pdTRUE if the segment was moved to the priority queue.
+ */
+        static BaseType_t prvTCPWindowTxRetransmit( TCPWindow_t * pxWindow )
+        {
+            const ListItem_t * pxIterator;
+            const ListItem_t * pxEnd = listGET_END_MARKER( &( pxWindow->xTxSegments ) );
+            TCPSegment_t * pxSegment;
+            BaseType_t xReturn = pdFALSE;
+
+            /* xTxSegments is sorted on sequence number, segments that were
+             * selectively acknowledged have 'bAcked' set. */
+            for( pxIterator = listGET_NEXT( pxEnd );
+                 pxIterator != pxEnd;
+                 pxIterator = listGET_NEXT( pxIterator ) )
+            {
+                pxSegment = ipCAST_PTR_TO_TYPE_PTR( TCPSegment_t, listGET_LIST_ITEM_OWNER( pxIterator ) );
+
+                if( pxSegment->u.bits.bAcked == pdFALSE_UNSIGNED )
+                {
+                    /* Only a segment that is waiting for its ACK, and which has
+                     * not been fast-retransmitted yet, either here or by
+                     * prvTCPWindowFastRetransmit(). */
+                    if( ( listLIST_ITEM_CONTAINER( &( pxSegment->xQueueItem ) ) == &( pxWindow->xWaitQueue ) ) &&
+                        ( pxSegment->u.bits.ucDupAckCount < DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT ) )
+                    {
+                        pxSegment->u.bits.ucDupAckCount = ( uint8_t ) DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT;
+
+                        if( ( xTCPWindowLoggingLevel >= 0 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) ) )
+                        {
+                            FreeRTOS_debug_printf( ( "prvTCPWindowTxRetransmit[%u,%u]: Requeue sequence number %lu (dup %u)\n",
+                                                     pxWindow->usPeerPortNumber,
+                                                     pxWindow->usOurPortNumber,
+                                                     pxSegment->ulSequenceNumber - pxWindow->tx.ulFirstSequenceNumber,
+                                                     ( unsigned ) pxWindow->ucDupAckCount ) );
+                            FreeRTOS_flush_logging();
+                        }
+
+                        ( void ) uxListRemove( &pxSegment->xQueueItem );
+                        vListInsertFifo( &( pxWindow->xPriorityQueue ), &( pxSegment->xQueueItem ) );
+                        xReturn = pdTRUE;
+                    }
+
+                    break;
+                }
+            }
+
+            return xReturn;
+        }
+
+    #endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
+    #if ( ipconfigUSE_TCP_WIN == 1 )
+
+/**
+ * @brief Receive a duplicate ACK: the ACK number equals tx.ulCurrentSequenceNumber,
+ *        the packet carries no data and doesn't change the window.  The caller
+ *        checks the last two conditions.
+ *
+ * @param[in] pxWindow: The descriptor of the TCP sliding windows.
+ * @param[in] ulSequenceNumber: The ACK number of the packet.
+ */
+        void vTCPWindowTxDuplicateAck( TCPWindow_t * pxWindow,
+                                       uint32_t ulSequenceNumber )
+        {
+            uint32_t ulOutstanding, ulThreshold = DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT;
+
+            /* NewReno fast retransmit (RFC 6582).  It works without SACK.  When
+             * the peer does send SACK's, prvTCPWindowFastRetransmit() will often
+             * have requeued the same segment already. */
+            if( ( ulSequenceNumber == pxWindow->tx.ulCurrentSequenceNumber ) &&
+                ( pxWindow->tx.ulHighestSequenceNumber != pxWindow->tx.ulCurrentSequenceNumber ) )
+            {
+                if( pxWindow->ucDupAckCount < ( uint8_t ) 0xffU )
+                {
+                    pxWindow->ucDupAckCount++;
+                }
+
+                /* Early retransmit (RFC 5827): a window of 2 or 3 segments can
+                 * never produce 3 duplicate ACKs.  When no new data can be sent
+                 * to cause more of them, use one less than the number of
+                 * outstanding segments. */
+                ulOutstanding = ( ( pxWindow->tx.ulHighestSequenceNumber - pxWindow->tx.ulCurrentSequenceNumber ) + pxWindow->usMSS - 1U ) / pxWindow->usMSS;
+
+                if( ( ulOutstanding >= 2U ) && ( ulOutstanding <= DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT ) &&
+                    ( ( listLIST_IS_EMPTY( &( pxWindow->xTxQueue ) ) != pdFALSE ) ||
+                      ( ( pxWindow->tx.ulHighestSequenceNumber - pxWindow->tx.ulCurrentSequenceNumber ) + pxWindow->usMSS > pxWindow->xSize.ulTxWindowLength ) ) )
+                {
+                    ulThreshold = ulOutstanding - 1U;
+                }
+
+                if( ( pxWindow->u.bits.bFastRecovery == pdFALSE_UNSIGNED ) && ( pxWindow->ucDupAckCount >= ulThreshold ) )
+                {
+                    /* Enter fast recovery.  It ends when all data sent until
+                     * now has been acknowledged. */
+                    pxWindow->u.bits.bFastRecovery = pdTRUE_UNSIGNED;
+                    pxWindow->ulRecoverSequenceNumber = pxWindow->tx.ulHighestSequenceNumber;
+                    ( void ) prvTCPWindowTxRetransmit( pxWindow );
+                }
+            }
+        }
+
+    #endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
+    #if ( ipconfigUSE_TCP_WIN == 1 )
+
 /**
  * @brief Receive a normal ACK.
  *
@@ -2061,6 +2339,26 @@
             else
             {
                 ulReturn = prvTCPWindowTxCheckAck( pxWindow, ulFirstSequence, ulSequenceNumber );
+
+                /* New data was acknowledged, start counting duplicates again. */
+                pxWindow->ucDupAckCount = 0U;
+
+                if( pxWindow->u.bits.bFastRecovery != pdFALSE_UNSIGNED )
+                {
+                    if( xSequenceLessThan( ulSequenceNumber, pxWindow->ulRecoverSequenceNumber ) != pdFALSE )
+                    {
+                        /* A partial ACK: the retransmission arrived but there
+                         * is another hole in the data that was outstanding when
+                         * fast recovery started.  Resend it without waiting for
+                         * more duplicate ACKs or for the RTO. */
+                        ( void ) prvTCPWindowTxRetransmit( pxWindow );
+                    }
+                    else
+                    {
+                        /* All data that was outstanding has been acknowledged. */
+                        pxWindow->u.bits.bFastRecovery = pdFALSE_UNSIGNED;
+                    }
+                }
             }
 
             return ulReturn;
@@ -2496,7 +2794,7 @@
  *
  * @return Always returns a NULL.
  */
-        void vTCPWindowDestroy( const TCPWindow_t * pxWindow )
+        void vTCPWindowDestroy( TCPWindow_t * pxWindow )
         {
             /* As in tiny TCP there are no shared segments descriptors, there is
              * nothing to release. */
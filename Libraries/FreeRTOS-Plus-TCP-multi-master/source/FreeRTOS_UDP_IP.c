@@ -532,6 +532,8 @@ BaseType_t xProcessReceivedUDPPacket( NetworkBufferDescriptor_t * pxNetworkBuffe
             /* xReturn is still pdPASS. */
         #endif
         {
+            ipNETWORK_BUFFER_SET_OWNER( pxNetworkBuffer, eNetworkBufferOwnerSocket );
+
             vTaskSuspendAll();
             {
                 taskENTER_CRITICAL();
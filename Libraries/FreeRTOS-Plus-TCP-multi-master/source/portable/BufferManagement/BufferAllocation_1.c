@@ -33,6 +33,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 /* Standard includes. */
 #include <stdint.h>
+#include <string.h>
 
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
@@ -50,26 +51,75 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 be at least this number of buffers available. */
 #define baINTERRUPT_BUFFER_GET_THRESHOLD	( 3 )
 
-/* A list of free (available) NetworkBufferDescriptor_t structures. */
-static List_t xFreeBuffersList;
+#if( ipNETWORK_BUFFER_FULL_COUNT <= 0 )
+	#error ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS must leave full sized network buffers
+#endif
+
+/* The obtained network buffer must be large enough to hold a packet that might
+replace the packet that was requested to be sent. */
+#if ipconfigUSE_TCP == 1
+	#define baMINIMAL_BUFFER_SIZE		sizeof( TCPPacket_t )
+#else
+	#define baMINIMAL_BUFFER_SIZE		sizeof( ARPPacket_t )
+#endif /* ipconfigUSE_TCP == 1 */
+
+/* The network buffers are divided in size classes, see
+ipconfigNETWORK_BUFFER_SMALL_COUNT.  The last class holds full sized buffers
+and is always present. */
+#define baNUM_BUFFER_CLASSES		( 3 )
+#define baFULL_BUFFER_CLASS			( baNUM_BUFFER_CLASSES - 1 )
+
+typedef struct xBUFFER_CLASS
+{
+	List_t xFreeBuffersList;		/* The free (available) NetworkBufferDescriptor_t structures of this class. */
+	SemaphoreHandle_t xSemaphore;	/* Counts the free buffers, NULL when the class has no buffers. */
+	size_t uxSize;					/* The number of bytes each buffer can hold. */
+	UBaseType_t uxCount;			/* The number of buffers in the class. */
+} BufferClass_t;
+
+static BufferClass_t xBufferClasses[ baNUM_BUFFER_CLASSES ];
+
+#if( ipconfigNETWORK_BUFFER_STATS != 0 )
+
+	#define baSTATS_VERSION		( 1U )
+
+	typedef struct xBUFFER_STATS
+	{
+		UBaseType_t uxHeld[ eNetworkBufferOwnerCount ];			/* The number of buffers each owner holds. */
+		UBaseType_t uxMaximumHeld[ eNetworkBufferOwnerCount ];	/* The most buffers each owner held at the same time. */
+		uint32_t ulStarved[ eNetworkBufferOwnerCount ];			/* See vNetworkBufferStarved(). */
+		UBaseType_t uxMinimumFree[ baNUM_BUFFER_CLASSES ];		/* The lowest number of free buffers per size class. */
+		uint32_t ulAllocFailures;								/* The number of times no buffer could be obtained. */
+		uint32_t ulBlockedWaits;								/* The number of times a task had to wait for a buffer. */
+		uint32_t ulBlockedTicks;								/* The total time spent waiting. */
+		uint32_t ulMaximumBlockedTicks;							/* The longest wait. */
+	} BufferStats_t;
+
+	static BufferStats_t xBufferStats;
+
+#endif /* ipconfigNETWORK_BUFFER_STATS */
 
 /* Some statistics about the use of buffers. */
 static UBaseType_t uxMinimumFreeNetworkBuffers = 0U;
 
 /* Declares the pool of NetworkBufferDescriptor_t structures that are available
-to the system.  All the network buffers referenced from xFreeBuffersList exist
+to the system.  All the network buffers referenced from the free lists exist
 in this array.  The array is not accessed directly except during initialisation,
-when the xFreeBuffersList is filled (as all the buffers are free when the system
+when the free lists are filled (as all the buffers are free when the system
 is booted). */
 static NetworkBufferDescriptor_t xNetworkBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
 
+/* The size class of the storage that each descriptor in xNetworkBuffers owns
+at the moment.  pxResizeNetworkBufferWithDescriptor() may exchange the
+storage of two descriptors. */
+static uint8_t ucBufferClass[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
+
 /* This constant is defined as true to let FreeRTOS_TCP_IP.c know that the
 network buffers have constant size, large enough to hold the biggest Ethernet
-packet. No resizing will be done. */
-const BaseType_t xBufferAllocFixedSize = pdTRUE;
-
-/* The semaphore used to obtain network buffers. */
-static SemaphoreHandle_t xNetworkBufferSemaphore = NULL;
+packet. No resizing will be done.  With size classes the stack asks for what
+it needs and resizes when necessary. */
+const BaseType_t xBufferAllocFixedSize =
+	( ( ipconfigNETWORK_BUFFER_SMALL_COUNT + ipconfigNETWORK_BUFFER_MEDIUM_COUNT ) == 0 ) ? pdTRUE : pdFALSE;
 
 #if( ipconfigTCP_IP_SANITY != 0 )
 	static char cIsLow = pdFALSE;
@@ -80,6 +130,36 @@ static SemaphoreHandle_t xNetworkBufferSemaphore = NULL;
 
 static void prvShowWarnings( void );
 
+/*
+ * Returns the smallest size class with buffers that can hold the requested
+ * number of bytes.  Requests which are too large get a full sized buffer.
+ */
+static UBaseType_t prvSizeClass( size_t xRequestedSizeBytes );
+
+/*
+ * Returns the size class of the storage of a network buffer.
+ */
+#define baCLASS_OF( pxNetworkBuffer )	( ucBufferClass[ ( pxNetworkBuffer ) - xNetworkBuffers ] )
+
+#if( ipconfigNETWORK_BUFFER_STATS != 0 )
+
+	/*
+	 * Account a buffer that was just taken from the free list of its class.
+	 * Must be called with the buffer allocation lock held.
+	 */
+	static void prvStatsObtained( NetworkBufferDescriptor_t *pxNetworkBuffer, NetworkBufferOwner_t eOwner );
+
+	/*
+	 * Account a buffer that was returned to the free list.  Must be called
+	 * with the buffer allocation lock held.
+	 */
+	static void prvStatsReleased( const NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+	/* Write an unsigned value in little endian byte order. */
+	static uint8_t *prvStatsWrite( uint8_t *pucTarget, uint32_t ulValue, size_t uxBytes );
+
+#endif /* ipconfigNETWORK_BUFFER_STATS */
+
 /* The user can define their own ipconfigBUFFER_ALLOC_LOCK() and
 ipconfigBUFFER_ALLOC_UNLOCK() macros, especially for use form an ISR.  If these
 are not defined then default them to call the normal enter/exit critical
@@ -119,7 +199,7 @@ section macros. */
 	BaseType_t prvIsFreeBuffer( const NetworkBufferDescriptor_t *pxDescr )
 	{
 		return ( bIsValidNetworkDescriptor( pxDescr ) != 0 ) &&
-			( listIS_CONTAINED_WITHIN( &xFreeBuffersList, &( pxDescr->xBufferListItem ) ) != 0 );
+			( listIS_CONTAINED_WITHIN( &( xBufferClasses[ baCLASS_OF( pxDescr ) ].xFreeBuffersList ), &( pxDescr->xBufferListItem ) ) != 0 );
 	}
 	/*-----------------------------------------------------------*/
 
@@ -162,41 +242,77 @@ section macros. */
 BaseType_t xNetworkBuffersInitialise( void )
 {
 BaseType_t xReturn, x;
+UBaseType_t uxClass;
+BufferClass_t *pxClass;
 
 	/* Only initialise the buffers and their associated kernel objects if they
 	have not been initialised before. */
-	if( xNetworkBufferSemaphore == NULL )
+	if( xBufferClasses[ baFULL_BUFFER_CLASS ].xSemaphore == NULL )
 	{
 		/* In case alternative locking is used, the mutexes can be initialised
 		here */
 		ipconfigBUFFER_ALLOC_INIT();
 
-		xNetworkBufferSemaphore = xSemaphoreCreateCounting( ( UBaseType_t ) ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, ( UBaseType_t ) ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS );
-		configASSERT( xNetworkBufferSemaphore != NULL );
+		xBufferClasses[ 0 ].uxSize = ( size_t ) ipconfigNETWORK_BUFFER_SMALL_SIZE;
+		xBufferClasses[ 0 ].uxCount = ( UBaseType_t ) ipconfigNETWORK_BUFFER_SMALL_COUNT;
+		xBufferClasses[ 1 ].uxSize = ( size_t ) ipconfigNETWORK_BUFFER_MEDIUM_SIZE;
+		xBufferClasses[ 1 ].uxCount = ( UBaseType_t ) ipconfigNETWORK_BUFFER_MEDIUM_COUNT;
+		xBufferClasses[ baFULL_BUFFER_CLASS ].uxSize = ( size_t ) ipTOTAL_ETHERNET_FRAME_SIZE;
+		xBufferClasses[ baFULL_BUFFER_CLASS ].uxCount = ( UBaseType_t ) ipNETWORK_BUFFER_FULL_COUNT;
 
-		if( xNetworkBufferSemaphore != NULL )
+		for( uxClass = 0U; uxClass < ( UBaseType_t ) baNUM_BUFFER_CLASSES; uxClass++ )
 		{
-			vListInitialise( &xFreeBuffersList );
+			pxClass = &( xBufferClasses[ uxClass ] );
+			vListInitialise( &( pxClass->xFreeBuffersList ) );
+
+			if( pxClass->uxCount != 0U )
+			{
+				/* Every buffer must be able to hold an ARP or TCP packet
+				that replaces the packet it was obtained for. */
+				configASSERT( pxClass->uxSize >= baMINIMAL_BUFFER_SIZE );
 
+				pxClass->xSemaphore = xSemaphoreCreateCounting( pxClass->uxCount, pxClass->uxCount );
+				configASSERT( pxClass->xSemaphore != NULL );
+			}
+		}
+
+		if( xBufferClasses[ baFULL_BUFFER_CLASS ].xSemaphore != NULL )
+		{
 			/* Initialise all the network buffers.  The buffer storage comes
 			from the network interface, and different hardware has different
-			requirements. */
+			requirements.  The descriptors are ordered by size class. */
 			vNetworkInterfaceAllocateRAMToBuffers( xNetworkBuffers );
+			uxClass = 0U;
 			for( x = 0; x < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; x++ )
 			{
+				while( listCURRENT_LIST_LENGTH( &( xBufferClasses[ uxClass ].xFreeBuffersList ) ) >= xBufferClasses[ uxClass ].uxCount )
+				{
+					uxClass++;
+				}
+				ucBufferClass[ x ] = ( uint8_t ) uxClass;
+
 				/* Initialise and set the owner of the buffer list items. */
 				vListInitialiseItem( &( xNetworkBuffers[ x ].xBufferListItem ) );
 				listSET_LIST_ITEM_OWNER( &( xNetworkBuffers[ x ].xBufferListItem ), ipPOINTER_CAST( void *, &( xNetworkBuffers[ x ] ) ) );
 
 				/* Currently, all buffers are available for use. */
-				vListInsert( &xFreeBuffersList, &( xNetworkBuffers[ x ].xBufferListItem ) );
+				vListInsert( &( xBufferClasses[ uxClass ].xFreeBuffersList ), &( xNetworkBuffers[ x ].xBufferListItem ) );
 			}
 
 			uxMinimumFreeNetworkBuffers = ( UBaseType_t ) ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS;
+
+			#if( ipconfigNETWORK_BUFFER_STATS != 0 )
+			{
+				for( uxClass = 0U; uxClass < ( UBaseType_t ) baNUM_BUFFER_CLASSES; uxClass++ )
+				{
+					xBufferStats.uxMinimumFree[ uxClass ] = xBufferClasses[ uxClass ].uxCount;
+				}
+			}
+			#endif /* ipconfigNETWORK_BUFFER_STATS */
 		}
 	}
 
-	if( xNetworkBufferSemaphore == NULL )
+	if( xBufferClasses[ baFULL_BUFFER_CLASS ].xSemaphore == NULL )
 	{
 		xReturn = pdFAIL;
 	}
@@ -209,32 +325,99 @@ BaseType_t xReturn, x;
 }
 /*-----------------------------------------------------------*/
 
+static UBaseType_t prvSizeClass( size_t xRequestedSizeBytes )
+{
+UBaseType_t uxClass = 0U;
+
+	while( ( uxClass < ( UBaseType_t ) baFULL_BUFFER_CLASS ) &&
+		   ( ( xBufferClasses[ uxClass ].uxCount == 0U ) || ( xBufferClasses[ uxClass ].uxSize < xRequestedSizeBytes ) ) )
+	{
+		uxClass++;
+	}
+
+	return uxClass;
+}
+/*-----------------------------------------------------------*/
+
 NetworkBufferDescriptor_t *pxGetNetworkBufferWithDescriptor( size_t xRequestedSizeBytes, TickType_t xBlockTimeTicks )
 {
 NetworkBufferDescriptor_t *pxReturn = NULL;
 BaseType_t xInvalid = pdFALSE;
+BaseType_t xTaken = pdFALSE;
 UBaseType_t uxCount;
-
-	/* The current implementation only has a single size memory block, so
-	the requested size parameter is not used (yet). */
-	( void ) xRequestedSizeBytes;
-
-	if( xNetworkBufferSemaphore != NULL )
+UBaseType_t uxFirstClass;
+UBaseType_t uxClass;
+List_t *pxFreeList;
+#if( ipconfigNETWORK_BUFFER_STATS != 0 )
+	TickType_t xWaitStart, xWaited;
+	NetworkBufferOwner_t eOwner = ( xIsCallingFromIPTask() != pdFALSE ) ? eNetworkBufferOwnerIPTask : eNetworkBufferOwnerApplication;
+#endif
+
+	if( xBufferClasses[ baFULL_BUFFER_CLASS ].xSemaphore != NULL )
 	{
 		/* If there is a semaphore available, there is a network buffer
-		available. */
-		if( xSemaphoreTake( xNetworkBufferSemaphore, xBlockTimeTicks ) == pdPASS )
+		available.  When the best fitting class is exhausted, a larger
+		buffer is better than waiting. */
+		uxFirstClass = prvSizeClass( xRequestedSizeBytes );
+		for( uxClass = uxFirstClass; uxClass < ( UBaseType_t ) baNUM_BUFFER_CLASSES; uxClass++ )
+		{
+			if( ( xBufferClasses[ uxClass ].xSemaphore != NULL ) &&
+				( xSemaphoreTake( xBufferClasses[ uxClass ].xSemaphore, ( TickType_t ) 0 ) == pdPASS ) )
+			{
+				xTaken = pdTRUE;
+				break;
+			}
+		}
+
+		if( ( xTaken == pdFALSE ) && ( xBlockTimeTicks != ( TickType_t ) 0 ) )
+		{
+			/* Wait for a buffer of the best fitting class. */
+			uxClass = uxFirstClass;
+
+			#if( ipconfigNETWORK_BUFFER_STATS != 0 )
+			{
+				xWaitStart = xTaskGetTickCount();
+				xTaken = xSemaphoreTake( xBufferClasses[ uxClass ].xSemaphore, xBlockTimeTicks );
+				xWaited = xTaskGetTickCount() - xWaitStart;
+
+				ipconfigBUFFER_ALLOC_LOCK();
+				{
+					xBufferStats.ulBlockedWaits++;
+					xBufferStats.ulBlockedTicks += ( uint32_t ) xWaited;
+					if( xBufferStats.ulMaximumBlockedTicks < ( uint32_t ) xWaited )
+					{
+						xBufferStats.ulMaximumBlockedTicks = ( uint32_t ) xWaited;
+					}
+				}
+				ipconfigBUFFER_ALLOC_UNLOCK();
+			}
+			#else
+			{
+				xTaken = xSemaphoreTake( xBufferClasses[ uxClass ].xSemaphore, xBlockTimeTicks );
+			}
+			#endif /* ipconfigNETWORK_BUFFER_STATS */
+		}
+
+		if( xTaken != pdFALSE )
 		{
+			pxFreeList = &( xBufferClasses[ uxClass ].xFreeBuffersList );
+
 			/* Protect the structure as it is accessed from tasks and
 			interrupts. */
 			ipconfigBUFFER_ALLOC_LOCK();
 			{
-				pxReturn = ipPOINTER_CAST( NetworkBufferDescriptor_t *, listGET_OWNER_OF_HEAD_ENTRY( &xFreeBuffersList ) );
+				pxReturn = ipPOINTER_CAST( NetworkBufferDescriptor_t *, listGET_OWNER_OF_HEAD_ENTRY( pxFreeList ) );
 
 				if( ( bIsValidNetworkDescriptor( pxReturn ) != pdFALSE_UNSIGNED ) &&
-					listIS_CONTAINED_WITHIN( &xFreeBuffersList, &( pxReturn->xBufferListItem ) ) )
+					listIS_CONTAINED_WITHIN( pxFreeList, &( pxReturn->xBufferListItem ) ) )
 				{
 					( void ) uxListRemove( &( pxReturn->xBufferListItem ) );
+
+					#if( ipconfigNETWORK_BUFFER_STATS != 0 )
+					{
+						prvStatsObtained( pxReturn, eOwner );
+					}
+					#endif /* ipconfigNETWORK_BUFFER_STATS */
 				}
 				else
 				{
@@ -256,8 +439,7 @@ UBaseType_t uxCount;
 			}
 			else
 			{
-				/* Reading UBaseType_t, no critical section needed. */
-				uxCount = listCURRENT_LIST_LENGTH( &xFreeBuffersList );
+				uxCount = uxGetNumberOfFreeNetworkBuffers();
 
 				/* For stats, latch the lowest number of network buffers since
 				booting. */
@@ -270,6 +452,24 @@ UBaseType_t uxCount;
 				pxReturn->pxEndPoint = NULL;
 				pxReturn->pxInterface = NULL;
 
+				#if( ipconfigUSE_NETWORK_BUFFER_REFCOUNT != 0 )
+				{
+					pxReturn->ucRefCount = 1U;
+				}
+				#endif /* ipconfigUSE_NETWORK_BUFFER_REFCOUNT */
+
+				#if( ipconfigMAX_TX_FRAGMENTS != 0 )
+				{
+					pxReturn->uxFragmentCount = 0U;
+				}
+				#endif /* ipconfigMAX_TX_FRAGMENTS */
+
+				#if( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+				{
+					pxReturn->ucRxChecksum = ipRX_CHECKSUM_UNKNOWN;
+				}
+				#endif /* ipconfigDRIVER_VERIFIES_RX_CHECKSUM */
+
 				#if( ipconfigTCP_IP_SANITY != 0 )
 				{
 					prvShowWarnings();
@@ -292,6 +492,19 @@ UBaseType_t uxCount;
 		}
 	}
 
+	#if( ipconfigNETWORK_BUFFER_STATS != 0 )
+	{
+		if( pxReturn == NULL )
+		{
+			ipconfigBUFFER_ALLOC_LOCK();
+			{
+				xBufferStats.ulAllocFailures++;
+			}
+			ipconfigBUFFER_ALLOC_UNLOCK();
+		}
+	}
+	#endif /* ipconfigNETWORK_BUFFER_STATS */
+
 	return pxReturn;
 }
 /*-----------------------------------------------------------*/
@@ -299,25 +512,57 @@ UBaseType_t uxCount;
 NetworkBufferDescriptor_t *pxNetworkBufferGetFromISR( size_t xRequestedSizeBytes )
 {
 NetworkBufferDescriptor_t *pxReturn = NULL;
-
-	/* The current implementation only has a single size memory block, so
-	the requested size parameter is not used (yet). */
-	( void ) xRequestedSizeBytes;
+UBaseType_t uxClass;
+SemaphoreHandle_t xSemaphore;
 
 	/* If there is a semaphore available then there is a buffer available, but,
 	as this is called from an interrupt, only take a buffer if there are at
 	least baINTERRUPT_BUFFER_GET_THRESHOLD buffers remaining.  This prevents,
 	to a certain degree at least, a rapidly executing interrupt exhausting
 	buffer and in so doing preventing tasks from continuing. */
-	if( uxQueueMessagesWaitingFromISR( ( QueueHandle_t ) xNetworkBufferSemaphore ) > ( UBaseType_t ) baINTERRUPT_BUFFER_GET_THRESHOLD )
+	for( uxClass = prvSizeClass( xRequestedSizeBytes ); uxClass < ( UBaseType_t ) baNUM_BUFFER_CLASSES; uxClass++ )
 	{
-		if( xSemaphoreTakeFromISR( xNetworkBufferSemaphore, NULL ) == pdPASS )
+		xSemaphore = xBufferClasses[ uxClass ].xSemaphore;
+		if( ( xSemaphore != NULL ) &&
+			( uxQueueMessagesWaitingFromISR( ( QueueHandle_t ) xSemaphore ) > ( UBaseType_t ) baINTERRUPT_BUFFER_GET_THRESHOLD ) )
+		{
+			break;
+		}
+	}
+
+	if( uxClass < ( UBaseType_t ) baNUM_BUFFER_CLASSES )
+	{
+		if( xSemaphoreTakeFromISR( xSemaphore, NULL ) == pdPASS )
 		{
 			/* Protect the structure as it is accessed from tasks and interrupts. */
 			ipconfigBUFFER_ALLOC_LOCK_FROM_ISR();
 			{
-				pxReturn = ipPOINTER_CAST( NetworkBufferDescriptor_t *, listGET_OWNER_OF_HEAD_ENTRY( &xFreeBuffersList ) );
+				pxReturn = ipPOINTER_CAST( NetworkBufferDescriptor_t *, listGET_OWNER_OF_HEAD_ENTRY( &( xBufferClasses[ uxClass ].xFreeBuffersList ) ) );
 				( void ) uxListRemove( &( pxReturn->xBufferListItem ) );
+
+				#if( ipconfigNETWORK_BUFFER_STATS != 0 )
+				{
+					prvStatsObtained( pxReturn, eNetworkBufferOwnerApplication );
+				}
+				#endif /* ipconfigNETWORK_BUFFER_STATS */
+
+				#if( ipconfigUSE_NETWORK_BUFFER_REFCOUNT != 0 )
+				{
+					pxReturn->ucRefCount = 1U;
+				}
+				#endif /* ipconfigUSE_NETWORK_BUFFER_REFCOUNT */
+
+				#if( ipconfigMAX_TX_FRAGMENTS != 0 )
+				{
+					pxReturn->uxFragmentCount = 0U;
+				}
+				#endif /* ipconfigMAX_TX_FRAGMENTS */
+
+				#if( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+				{
+					pxReturn->ucRxChecksum = ipRX_CHECKSUM_UNKNOWN;
+				}
+				#endif /* ipconfigDRIVER_VERIFIES_RX_CHECKSUM */
 			}
 			ipconfigBUFFER_ALLOC_UNLOCK_FROM_ISR();
 
@@ -337,17 +582,44 @@ NetworkBufferDescriptor_t *pxReturn = NULL;
 BaseType_t vNetworkBufferReleaseFromISR( NetworkBufferDescriptor_t * const pxNetworkBuffer )
 {
 BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+BaseType_t xStillReferenced = pdFALSE;
+BufferClass_t *pxClass = &( xBufferClasses[ baCLASS_OF( pxNetworkBuffer ) ] );
 
 	/* Ensure the buffer is returned to the list of free buffers before the
 	counting semaphore is 'given' to say a buffer is available. */
 	ipconfigBUFFER_ALLOC_LOCK_FROM_ISR();
 	{
-		vListInsertEnd( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+		#if( ipconfigUSE_NETWORK_BUFFER_REFCOUNT != 0 )
+		if( pxNetworkBuffer->ucRefCount > 1U )
+		{
+			/* Another user still holds a reference. */
+			pxNetworkBuffer->ucRefCount--;
+			xStillReferenced = pdTRUE;
+		}
+		else
+		{
+			pxNetworkBuffer->ucRefCount = 0U;
+		}
+		#endif /* ipconfigUSE_NETWORK_BUFFER_REFCOUNT */
+
+		if( xStillReferenced == pdFALSE )
+		{
+			vListInsertEnd( &( pxClass->xFreeBuffersList ), &( pxNetworkBuffer->xBufferListItem ) );
+
+			#if( ipconfigNETWORK_BUFFER_STATS != 0 )
+			{
+				prvStatsReleased( pxNetworkBuffer );
+			}
+			#endif /* ipconfigNETWORK_BUFFER_STATS */
+		}
 	}
 	ipconfigBUFFER_ALLOC_UNLOCK_FROM_ISR();
 
-	( void ) xSemaphoreGiveFromISR( xNetworkBufferSemaphore, &xHigherPriorityTaskWoken );
-	iptraceNETWORK_BUFFER_RELEASED( pxNetworkBuffer );
+	if( xStillReferenced == pdFALSE )
+	{
+		( void ) xSemaphoreGiveFromISR( pxClass->xSemaphore, &xHigherPriorityTaskWoken );
+		iptraceNETWORK_BUFFER_RELEASED( pxNetworkBuffer );
+	}
 
 	return xHigherPriorityTaskWoken;
 }
@@ -355,7 +627,9 @@ BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
 void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer )
 {
-BaseType_t xListItemAlreadyInFreeList;
+BaseType_t xListItemAlreadyInFreeList = pdFALSE;
+BaseType_t xStillReferenced = pdFALSE;
+BufferClass_t *pxClass;
 
 	if( bIsValidNetworkDescriptor( pxNetworkBuffer ) == pdFALSE_UNSIGNED )
 	{
@@ -363,29 +637,56 @@ BaseType_t xListItemAlreadyInFreeList;
 	}
 	else
 	{
+		pxClass = &( xBufferClasses[ baCLASS_OF( pxNetworkBuffer ) ] );
+
 		/* Ensure the buffer is returned to the list of free buffers before the
 		counting semaphore is 'given' to say a buffer is available. */
 		ipconfigBUFFER_ALLOC_LOCK();
 		{
+			#if( ipconfigUSE_NETWORK_BUFFER_REFCOUNT != 0 )
+			if( pxNetworkBuffer->ucRefCount > 1U )
+			{
+				/* The buffer is shared, e.g. a frame flooded by the bridge.
+				Only the last user returns it to the free list. */
+				pxNetworkBuffer->ucRefCount--;
+				xStillReferenced = pdTRUE;
+			}
+			else
+			#endif /* ipconfigUSE_NETWORK_BUFFER_REFCOUNT */
 			{
-				xListItemAlreadyInFreeList = listIS_CONTAINED_WITHIN( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+				xListItemAlreadyInFreeList = listIS_CONTAINED_WITHIN( &( pxClass->xFreeBuffersList ), &( pxNetworkBuffer->xBufferListItem ) );
 
 				if( xListItemAlreadyInFreeList == pdFALSE )
 				{
-					vListInsertEnd( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+					#if( ipconfigUSE_NETWORK_BUFFER_REFCOUNT != 0 )
+					{
+						pxNetworkBuffer->ucRefCount = 0U;
+					}
+					#endif /* ipconfigUSE_NETWORK_BUFFER_REFCOUNT */
+					vListInsertEnd( &( pxClass->xFreeBuffersList ), &( pxNetworkBuffer->xBufferListItem ) );
+
+					#if( ipconfigNETWORK_BUFFER_STATS != 0 )
+					{
+						prvStatsReleased( pxNetworkBuffer );
+					}
+					#endif /* ipconfigNETWORK_BUFFER_STATS */
 				}
 			}
 		}
 		ipconfigBUFFER_ALLOC_UNLOCK();
 
-		if( xListItemAlreadyInFreeList )
+		if( xStillReferenced != pdFALSE )
+		{
+			/* Nothing to do, the last user will free the buffer. */
+		}
+		else if( xListItemAlreadyInFreeList )
 		{
 			FreeRTOS_debug_printf( ( "vReleaseNetworkBufferAndDescriptor: %p ALREADY RELEASED (now %lu)\n",
 				pxNetworkBuffer, uxGetNumberOfFreeNetworkBuffers( ) ) );
 		}
 		else
 		{
-			( void ) xSemaphoreGive( xNetworkBufferSemaphore );
+			( void ) xSemaphoreGive( pxClass->xSemaphore );
 			prvShowWarnings();
 		}
 		iptraceNETWORK_BUFFER_RELEASED( pxNetworkBuffer );
@@ -393,6 +694,25 @@ BaseType_t xListItemAlreadyInFreeList;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_NETWORK_BUFFER_REFCOUNT != 0 )
+
+NetworkBufferDescriptor_t *pxNetworkBufferAddReference( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+	/* The caller must own a reference already, otherwise the buffer might be
+	returned to the free list in the meantime. */
+	ipconfigBUFFER_ALLOC_LOCK();
+	{
+		configASSERT( ( pxNetworkBuffer->ucRefCount != 0U ) && ( pxNetworkBuffer->ucRefCount != 0xFFU ) );
+		pxNetworkBuffer->ucRefCount++;
+	}
+	ipconfigBUFFER_ALLOC_UNLOCK();
+
+	return pxNetworkBuffer;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_NETWORK_BUFFER_REFCOUNT */
+
 UBaseType_t uxGetMinimumFreeNetworkBuffers( void )
 {
 	return uxMinimumFreeNetworkBuffers;
@@ -401,14 +721,209 @@ UBaseType_t uxGetMinimumFreeNetworkBuffers( void )
 
 UBaseType_t uxGetNumberOfFreeNetworkBuffers( void )
 {
-	return listCURRENT_LIST_LENGTH( &xFreeBuffersList );
+UBaseType_t uxClass;
+UBaseType_t uxCount = 0U;
+
+	/* Reading UBaseType_t, no critical section needed. */
+	for( uxClass = 0U; uxClass < ( UBaseType_t ) baNUM_BUFFER_CLASSES; uxClass++ )
+	{
+		uxCount += listCURRENT_LIST_LENGTH( &( xBufferClasses[ uxClass ].xFreeBuffersList ) );
+	}
+
+	return uxCount;
 }
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxGetNumberOfFreeNetworkBuffersOfSize( size_t xRequestedSizeBytes )
+{
+UBaseType_t uxClass;
+UBaseType_t uxCount = 0U;
+
+	/* Only the classes that can hold the size count, e.g. the small buffers
+	are of no use for a received frame. */
+	for( uxClass = prvSizeClass( xRequestedSizeBytes ); uxClass < ( UBaseType_t ) baNUM_BUFFER_CLASSES; uxClass++ )
+	{
+		uxCount += listCURRENT_LIST_LENGTH( &( xBufferClasses[ uxClass ].xFreeBuffersList ) );
+	}
+
+	return uxCount;
+}
+/*-----------------------------------------------------------*/
 
 NetworkBufferDescriptor_t *pxResizeNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * pxNetworkBuffer, size_t xNewSizeBytes )
 {
-	/* In BufferAllocation_1.c all network buffer are allocated with a
-	maximum size of 'ipTOTAL_ETHERNET_FRAME_SIZE'.No need to resize the
-	network buffer. */
-	pxNetworkBuffer->xDataLength = xNewSizeBytes;
-	return pxNetworkBuffer;
+NetworkBufferDescriptor_t *pxReturn = pxNetworkBuffer;
+NetworkBufferDescriptor_t *pxLargerBuffer;
+uint8_t *pucBuffer;
+uint8_t ucClass;
+
+	/* A full sized buffer never needs to grow.  A smaller one takes over the
+	storage of a larger buffer, the descriptor itself stays the same as the
+	caller may still refer to it. */
+	if( xNewSizeBytes > xBufferClasses[ baCLASS_OF( pxNetworkBuffer ) ].uxSize )
+	{
+		pxLargerBuffer = pxGetNetworkBufferWithDescriptor( xNewSizeBytes, ( TickType_t ) 0 );
+
+		if( pxLargerBuffer == NULL )
+		{
+			/* In case the allocation fails, return NULL. */
+			pxReturn = NULL;
+		}
+		else
+		{
+			( void ) pvCopyPacketData( pxLargerBuffer->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
+
+			/* Exchange the storage, each buffer holds a pointer to its
+			descriptor in front of the data. */
+			pucBuffer = pxNetworkBuffer->pucEthernetBuffer;
+			pxNetworkBuffer->pucEthernetBuffer = pxLargerBuffer->pucEthernetBuffer;
+			pxLargerBuffer->pucEthernetBuffer = pucBuffer;
+			*( ipPOINTER_CAST( NetworkBufferDescriptor_t **, pxNetworkBuffer->pucEthernetBuffer - ipBUFFER_PADDING ) ) = pxNetworkBuffer;
+			*( ipPOINTER_CAST( NetworkBufferDescriptor_t **, pxLargerBuffer->pucEthernetBuffer - ipBUFFER_PADDING ) ) = pxLargerBuffer;
+
+			ucClass = baCLASS_OF( pxNetworkBuffer );
+			baCLASS_OF( pxNetworkBuffer ) = baCLASS_OF( pxLargerBuffer );
+			baCLASS_OF( pxLargerBuffer ) = ucClass;
+
+			/* Return the small storage to its class. */
+			vReleaseNetworkBufferAndDescriptor( pxLargerBuffer );
+		}
+	}
+
+	if( pxReturn != NULL )
+	{
+		pxReturn->xDataLength = xNewSizeBytes;
+	}
+
+	return pxReturn;
 }
+/*-----------------------------------------------------------*/
+
+#if( ipconfigNETWORK_BUFFER_STATS != 0 )
+
+	static void prvStatsObtained( NetworkBufferDescriptor_t *pxNetworkBuffer, NetworkBufferOwner_t eOwner )
+	{
+	UBaseType_t uxClass = baCLASS_OF( pxNetworkBuffer );
+	UBaseType_t uxFree = listCURRENT_LIST_LENGTH( &( xBufferClasses[ uxClass ].xFreeBuffersList ) );
+
+		if( xBufferStats.uxMinimumFree[ uxClass ] > uxFree )
+		{
+			xBufferStats.uxMinimumFree[ uxClass ] = uxFree;
+		}
+
+		pxNetworkBuffer->ucOwner = ( uint8_t ) eOwner;
+		xBufferStats.uxHeld[ eOwner ]++;
+		if( xBufferStats.uxMaximumHeld[ eOwner ] < xBufferStats.uxHeld[ eOwner ] )
+		{
+			xBufferStats.uxMaximumHeld[ eOwner ] = xBufferStats.uxHeld[ eOwner ];
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvStatsReleased( const NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+		xBufferStats.uxHeld[ pxNetworkBuffer->ucOwner ]--;
+	}
+	/*-----------------------------------------------------------*/
+
+	void vNetworkBufferSetOwner( NetworkBufferDescriptor_t * const pxNetworkBuffer, NetworkBufferOwner_t eOwner )
+	{
+		configASSERT( eOwner < eNetworkBufferOwnerCount );
+
+		ipconfigBUFFER_ALLOC_LOCK();
+		{
+			if( pxNetworkBuffer->ucOwner != ( uint8_t ) eOwner )
+			{
+				xBufferStats.uxHeld[ pxNetworkBuffer->ucOwner ]--;
+				pxNetworkBuffer->ucOwner = ( uint8_t ) eOwner;
+				xBufferStats.uxHeld[ eOwner ]++;
+				if( xBufferStats.uxMaximumHeld[ eOwner ] < xBufferStats.uxHeld[ eOwner ] )
+				{
+					xBufferStats.uxMaximumHeld[ eOwner ] = xBufferStats.uxHeld[ eOwner ];
+				}
+			}
+		}
+		ipconfigBUFFER_ALLOC_UNLOCK();
+	}
+	/*-----------------------------------------------------------*/
+
+	void vNetworkBufferStarved( NetworkBufferOwner_t eOwner )
+	{
+		configASSERT( eOwner < eNetworkBufferOwnerCount );
+
+		ipconfigBUFFER_ALLOC_LOCK();
+		{
+			xBufferStats.ulStarved[ eOwner ]++;
+		}
+		ipconfigBUFFER_ALLOC_UNLOCK();
+	}
+	/*-----------------------------------------------------------*/
+
+	static uint8_t *prvStatsWrite( uint8_t *pucTarget, uint32_t ulValue, size_t uxBytes )
+	{
+	size_t uxIndex;
+
+		for( uxIndex = 0U; uxIndex < uxBytes; uxIndex++ )
+		{
+			pucTarget[ uxIndex ] = ( uint8_t ) ( ulValue >> ( 8U * uxIndex ) );
+		}
+
+		return &( pucTarget[ uxBytes ] );
+	}
+	/*-----------------------------------------------------------*/
+
+	size_t uxNetworkBufferStatsSnapshot( uint8_t *pucBuffer, size_t uxBufferLength )
+	{
+	const size_t uxNeeded = 4U + ( baNUM_BUFFER_CLASSES * 8U ) + ( eNetworkBufferOwnerCount * 8U ) + 16U;
+	BufferStats_t xCopy;
+	UBaseType_t uxFree[ baNUM_BUFFER_CLASSES ];
+	UBaseType_t uxIndex;
+	uint8_t *pucTarget = pucBuffer;
+	size_t uxReturn = 0U;
+
+		if( uxBufferLength >= uxNeeded )
+		{
+			/* Take a consistent copy, the record is written without the lock. */
+			ipconfigBUFFER_ALLOC_LOCK();
+			{
+				xCopy = xBufferStats;
+				for( uxIndex = 0U; uxIndex < ( UBaseType_t ) baNUM_BUFFER_CLASSES; uxIndex++ )
+				{
+					uxFree[ uxIndex ] = listCURRENT_LIST_LENGTH( &( xBufferClasses[ uxIndex ].xFreeBuffersList ) );
+				}
+			}
+			ipconfigBUFFER_ALLOC_UNLOCK();
+
+			pucTarget = prvStatsWrite( pucTarget, baSTATS_VERSION, 1U );
+			pucTarget = prvStatsWrite( pucTarget, baNUM_BUFFER_CLASSES, 1U );
+			pucTarget = prvStatsWrite( pucTarget, eNetworkBufferOwnerCount, 1U );
+			pucTarget = prvStatsWrite( pucTarget, 0U, 1U );
+
+			for( uxIndex = 0U; uxIndex < ( UBaseType_t ) baNUM_BUFFER_CLASSES; uxIndex++ )
+			{
+				pucTarget = prvStatsWrite( pucTarget, ( uint32_t ) xBufferClasses[ uxIndex ].uxSize, 2U );
+				pucTarget = prvStatsWrite( pucTarget, ( uint32_t ) xBufferClasses[ uxIndex ].uxCount, 2U );
+				pucTarget = prvStatsWrite( pucTarget, ( uint32_t ) uxFree[ uxIndex ], 2U );
+				pucTarget = prvStatsWrite( pucTarget, ( uint32_t ) xCopy.uxMinimumFree[ uxIndex ], 2U );
+			}
+
+			for( uxIndex = 0U; uxIndex < ( UBaseType_t ) eNetworkBufferOwnerCount; uxIndex++ )
+			{
+				pucTarget = prvStatsWrite( pucTarget, ( uint32_t ) xCopy.uxHeld[ uxIndex ], 2U );
+				pucTarget = prvStatsWrite( pucTarget, ( uint32_t ) xCopy.uxMaximumHeld[ uxIndex ], 2U );
+				pucTarget = prvStatsWrite( pucTarget, xCopy.ulStarved[ uxIndex ], 4U );
+			}
+
+			pucTarget = prvStatsWrite( pucTarget, xCopy.ulAllocFailures, 4U );
+			pucTarget = prvStatsWrite( pucTarget, xCopy.ulBlockedWaits, 4U );
+			pucTarget = prvStatsWrite( pucTarget, xCopy.ulBlockedTicks, 4U );
+			pucTarget = prvStatsWrite( pucTarget, xCopy.ulMaximumBlockedTicks, 4U );
+
+			uxReturn = ( size_t ) ( pucTarget - pucBuffer );
+		}
+
+		return uxReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigNETWORK_BUFFER_STATS */
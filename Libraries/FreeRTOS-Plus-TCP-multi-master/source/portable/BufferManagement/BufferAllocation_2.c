@@ -51,6 +51,18 @@ heap_4 can be used. */
 #include "NetworkInterface.h"
 #include "NetworkBufferManagement.h"
 
+#if( ipconfigUSE_NETWORK_BUFFER_REFCOUNT != 0 )
+	#error ipconfigUSE_NETWORK_BUFFER_REFCOUNT is only supported by BufferAllocation_1.c
+#endif
+
+#if( ipconfigMAX_TX_FRAGMENTS != 0 )
+	#error ipconfigMAX_TX_FRAGMENTS is only supported by BufferAllocation_1.c
+#endif
+
+#if( ipconfigNETWORK_BUFFER_STATS != 0 )
+	#error ipconfigNETWORK_BUFFER_STATS is only supported by BufferAllocation_1.c
+#endif
+
 /* The obtained network buffer must be large enough to hold a packet that might
 replace the packet that was requested to be sent. */
 #if ipconfigUSE_TCP == 1
@@ -285,6 +297,12 @@ size_t xRequestedSizeBytes = xByteCount;	/* To avoid lint complain: function par
 						pxReturn->pxNextBuffer = NULL;
 					}
 					#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+					#if( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+					{
+						pxReturn->ucRxChecksum = ipRX_CHECKSUM_UNKNOWN;
+					}
+					#endif /* ipconfigDRIVER_VERIFIES_RX_CHECKSUM */
 				}
 			}
 			else
@@ -360,6 +378,15 @@ UBaseType_t uxGetNumberOfFreeNetworkBuffers( void )
 }
 /*-----------------------------------------------------------*/
 
+UBaseType_t uxGetNumberOfFreeNetworkBuffersOfSize( size_t xRequestedSizeBytes )
+{
+	/* All buffers are allocated with the size that is asked for. */
+	( void ) xRequestedSizeBytes;
+
+	return uxGetNumberOfFreeNetworkBuffers();
+}
+/*-----------------------------------------------------------*/
+
 UBaseType_t uxGetMinimumFreeNetworkBuffers( void )
 {
 	return uxMinimumFreeNetworkBuffers;
@@ -6,6 +6,10 @@
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
 
+/* FreeRTOS+TCP includes, for pvCopyPacketData(). */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+
 /* httpd-fs includes. */
 #include "ff_stdio.h"
 #include "httpd-fs.h"
@@ -26,6 +30,10 @@ FF_FILE *httpdfs_fopen( const char *pcFile, const char *pcMode)
 			pxStream->pucBuffer = (uint8_t *) pxFileHandle.data;
 			pxStream->ulFileSize = (uint32_t) pxFileHandle.len;
 			pxStream->ulFilePointer = 0;
+			pxStream->pcHeader = pxFileHandle.header;
+			pxStream->uxHeaderLength = (size_t) pxFileHandle.header_len;
+			pxStream->uxHeader304 = (size_t) pxFileHandle.header_304;
+			pxStream->pcETag = pxFileHandle.etag;
 		}
 	}
 
@@ -50,7 +58,37 @@ size_t httpdfs_fread(void *pvBuffer, size_t xSize, size_t xItems, FF_FILE *pxStr
 		count = pxStream->ulFileSize - pxStream->ulFilePointer;
 	}
 
-	memcpy(pvBuffer, pxStream->pucBuffer + pxStream->ulFilePointer, count);
+	/* The web server reads into the TCP stream buffers, copy a word at a
+	time where the alignment allows it. */
+	pvCopyPacketData(pvBuffer, pxStream->pucBuffer + pxStream->ulFilePointer, count);
 	pxStream->ulFilePointer += count;
 	return count;
 }
+
+/* The HTTP server sends this header as it is, instead of formatting one. */
+const char *httpdfs_fheader(FF_FILE *pxStream, size_t *puxLength)
+{
+	*puxLength = pxStream->uxHeaderLength;
+	return pxStream->pcHeader;
+}
+
+/* The end of the header, from the ETag line onwards.  A '304 Not Modified'
+reply consists of a status line followed by these lines. */
+const char *httpdfs_fheader304(FF_FILE *pxStream, size_t *puxLength)
+{
+	*puxLength = pxStream->uxHeaderLength - pxStream->uxHeader304;
+	return pxStream->pcHeader + pxStream->uxHeader304;
+}
+
+const char *httpdfs_fetag(FF_FILE *pxStream)
+{
+	return pxStream->pcETag;
+}
+
+/* The contents of the file, which stay in flash.  The HTTP server lets the
+socket refer to them instead of reading them into a buffer. */
+const uint8_t *httpdfs_fdata(FF_FILE *pxStream, size_t *puxLength)
+{
+	*puxLength = (size_t) pxStream->ulFileSize;
+	return pxStream->pucBuffer;
+}
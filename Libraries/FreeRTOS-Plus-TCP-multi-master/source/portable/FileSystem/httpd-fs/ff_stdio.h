@@ -8,12 +8,20 @@
 #define ff_fopen(file, mode)                  httpdfs_fopen(file, mode)
 #define ff_fclose(stream)                     httpdfs_fclose(stream)
 #define ff_fread(buffer, size, items, stream) httpdfs_fread(buffer, size, items, stream)
+#define ff_fheader(stream, length)            httpdfs_fheader(stream, length)
+#define ff_fheader304(stream, length)         httpdfs_fheader304(stream, length)
+#define ff_fetag(stream)                      httpdfs_fetag(stream)
+#define ff_fdata(stream, length)              httpdfs_fdata(stream, length)
 
 typedef struct _FF_FILE
 {
 	uint8_t *pucBuffer;				/* A buffer for providing fast unaligned access. */
 	uint32_t ulFileSize;			/* File's Size. */
 	uint32_t ulFilePointer;			/* Current Position Pointer. */
+	const char *pcHeader;			/* The HTTP reply header, generated by makefsdata.py */
+	size_t uxHeaderLength;
+	size_t uxHeader304;				/* Offset of the lines that a 304 reply repeats. */
+	const char *pcETag;				/* Strong ETag, with the quotes. */
 } FF_FILE;
 
 #define FF_FindData_t BaseType_t /* Used for FTP. Suppress Error. */
@@ -23,5 +31,9 @@ typedef struct _FF_FILE
 FF_FILE *httpdfs_fopen( const char *pcFile, const char *pcMode);
 int httpdfs_fclose(FF_FILE *pxStream);
 size_t httpdfs_fread(void *pvBuffer, size_t xSize, size_t xItems, FF_FILE *pxStream);
+const char *httpdfs_fheader(FF_FILE *pxStream, size_t *puxLength);
+const char *httpdfs_fheader304(FF_FILE *pxStream, size_t *puxLength);
+const char *httpdfs_fetag(FF_FILE *pxStream);
+const uint8_t *httpdfs_fdata(FF_FILE *pxStream, size_t *puxLength);
 
 #endif /* __FF_STDIO_H__ */
@@ -42,26 +42,28 @@
 #include "httpd-fsdata.h"
 
 /*-----------------------------------------------------------------------------------*/
-static uint8_t
-httpd_fs_strcmp(const char *str1, const char *str2)
+/* FNV-1a hash of a file name, which ends at a NUL, CR or LF.  makefsdata.py
+   uses the same hash to build fs_hash_displace[] and fs_hash_table[]. */
+static uint32_t
+httpd_fs_hash(const char *name)
 {
-  uint8_t i;
-  i = 0;
- loop:
+  uint32_t h = 0x811c9dc5UL;
 
-  if(str2[i] == 0 ||
-     str1[i] == '\r' ||
-     str1[i] == '\n') {
-    return 0;
+  while(*name != 0 && *name != '\r' && *name != '\n') {
+    h = (h ^ (uint8_t)*name++) * 0x01000193UL;
   }
-
-  if(str1[i] != str2[i]) {
-    return 1;
+  return h;
+}
+/*-----------------------------------------------------------------------------------*/
+/* Returns 0 when 'name' is exactly the file name 'fname'. */
+static uint8_t
+httpd_fs_namecmp(const char *name, const char *fname)
+{
+  while(*fname != 0 && *name == *fname) {
+    ++name;
+    ++fname;
   }
-
-
-  ++i;
-  goto loop;
+  return (*fname == 0 && (*name == 0 || *name == '\r' || *name == '\n')) ? 0 : 1;
 }
 /*-----------------------------------------------------------------------------------*/
 int
@@ -69,27 +71,36 @@ httpd_fs_open(const char *name, struct httpd_fs_file *file)
 {
 #if HTTPD_FS_STATISTICS
   uint16_t i = 0;
+  const struct fsdata_file *g;
 #endif /* HTTPD_FS_STATISTICS */
-  struct httpd_fsdata_file_noconst *f;
+  const struct fsdata_file *f;
+  uint32_t h;
 
-  for(f = (struct httpd_fsdata_file_noconst *)fs_root;
-      f != NULL;
-      f = (struct httpd_fsdata_file_noconst *)f->next) {
+  /* The file names form a perfect hash: the bucket of the hash gives a
+     displacement, which selects the only file that can have this name. */
+  h = httpd_fs_hash(name);
+  h ^= fs_hash_displace[h & ((1UL << fs_hash_bits) - 1UL)];
+  f = fs_hash_table[(uint32_t)(h * 0x9e3779b1UL) >> (32 - fs_hash_bits)];
 
-    if(httpd_fs_strcmp(name, f->name) == 0) {
-      file->data = f->data;
-      file->len = f->len;
-#if HTTPD_FS_STATISTICS
-      ++fs_count[i];
-#endif /* HTTPD_FS_STATISTICS */
-      return 1;
-    }
+  if(f == NULL || httpd_fs_namecmp(name, (const char *)f->name) != 0) {
+    return 0;
+  }
+
+  file->data = (char *)f->data;
+  file->len = f->len;
+  file->type = f->type;
+  file->etag = f->etag;
+  file->gzip = f->gzip;
+  file->header = f->header;
+  file->header_len = f->header_len;
+  file->header_304 = f->header_304;
 #if HTTPD_FS_STATISTICS
+  for(g = fs_root; g != f; g = g->next) {
     ++i;
-#endif /* HTTPD_FS_STATISTICS */
-
   }
-  return 0;
+  ++fs_count[i];
+#endif /* HTTPD_FS_STATISTICS */
+  return 1;
 }
 /*-----------------------------------------------------------------------------------*/
 void
@@ -115,7 +126,7 @@ uint16_t httpd_fs_count
       f != NULL;
       f = (struct httpd_fsdata_file_noconst *)f->next) {
 
-    if(httpd_fs_strcmp(name, f->name) == 0) {
+    if(httpd_fs_namecmp(name, f->name) == 0) {
       return fs_count[i];
     }
     ++i;
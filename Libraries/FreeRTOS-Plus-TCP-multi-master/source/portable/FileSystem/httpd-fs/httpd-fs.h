@@ -42,6 +42,12 @@
 struct httpd_fs_file {
   char *data;
   int len;
+  const char *type;
+  const char *etag;
+  int gzip;
+  const char *header;
+  int header_len;
+  int header_304;
 };
 
 /* file must be allocated by caller and will be filled in
@@ -43,6 +43,12 @@ struct fsdata_file {
   const unsigned char *name;
   const unsigned char *data;
   const int len;
+  const char *type;             /* Content-Type */
+  const char *etag;             /* Strong ETag, with the quotes */
+  const int gzip;               /* The data is gzip encoded */
+  const char *header;           /* The complete HTTP reply header */
+  const int header_len;
+  const int header_304;         /* Offset of the lines that a 304 reply repeats */
 #ifdef HTTPD_FS_STATISTICS
 #if HTTPD_FS_STATISTICS == 1
   uint16_t count;
@@ -55,6 +61,12 @@ struct httpd_fsdata_file_noconst {
   char *name;
   char *data;
   int len;
+  char *type;
+  char *etag;
+  int gzip;
+  char *header;
+  int header_len;
+  int header_304;
 #ifdef HTTPD_FS_STATISTICS
 #if HTTPD_FS_STATISTICS == 1
   uint16_t count;
@@ -63,6 +75,12 @@ struct httpd_fsdata_file_noconst {
 };
 
 extern const struct fsdata_file *fs_root;
+extern const uint16_t fs_numfiles;
+
+/* Perfect hash of the file names, generated by makefsdata.py */
+extern const uint8_t fs_hash_bits;
+extern const uint16_t fs_hash_displace[];
+extern const struct fsdata_file * const fs_hash_table[];
 #if HTTPD_FS_STATISTICS
 extern uint16_t *fs_count;
 #endif /* HTTPD_FS_STATISTICS */
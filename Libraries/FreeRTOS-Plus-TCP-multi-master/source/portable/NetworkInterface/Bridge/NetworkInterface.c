@@ -123,21 +123,37 @@ IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
 		/* Frame coming in from Bridge itself, pass it to the
 		TCP/IP task for processing. */
 		pxNetworkBuffer->pxInterface = pxInterface;
-		xRxEvent.pvData = ( void * ) pxNetworkBuffer;
-		xReturn = xSendEventStructToIPTask( &xRxEvent, xDescriptorWaitTime );
-		if( xReturn == pdFAIL )
+
+	#if( ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES == 1 )
+		/* The bridged drivers do not filter, and the bridge floods unknown
+		unicast and multicast frames to this interface as well.  The IP
+		task relies on the driver to drop what is not for this node. */
+		if( eConsiderFrameForProcessing( pxNetworkBuffer->pucEthernetBuffer ) != eProcessBuffer )
 		{
 			if( bReleaseAfterSend == pdTRUE )
 			{
-				/* Could not send the descriptor into the TCP/IP stack,
-				it must be released. */
 				vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
-				iptraceETHERNET_RX_EVENT_LOST();
 			}
 		}
 		else
+	#endif
 		{
-			iptraceNETWORK_INTERFACE_RECEIVE();
+			xRxEvent.pvData = ( void * ) pxNetworkBuffer;
+			xReturn = xSendEventStructToIPTask( &xRxEvent, xDescriptorWaitTime );
+			if( xReturn == pdFAIL )
+			{
+				if( bReleaseAfterSend == pdTRUE )
+				{
+					/* Could not send the descriptor into the TCP/IP stack,
+					it must be released. */
+					vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+					iptraceETHERNET_RX_EVENT_LOST();
+				}
+			}
+			else
+			{
+				iptraceNETWORK_INTERFACE_RECEIVE();
+			}
 		}
 	}
 	else
@@ -192,6 +208,14 @@ is declared static or global, and that it will remain to exist. */
 	added to the forwarding table. */
 	pxInterface->bits.bForwardingTableKnown = 1;
 
+	#if( ipconfigMAX_TX_FRAGMENTS != 0 )
+	{
+		/* xBridge_Process() flattens the frame when a bridged driver needs it. */
+		pxInterface->bits.bTxFragments = 1;
+	}
+	#endif
+
+
 	return pxInterface;
 }
 /*-----------------------------------------------------------*/
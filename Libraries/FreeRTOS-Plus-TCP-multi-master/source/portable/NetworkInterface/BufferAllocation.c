@@ -47,26 +47,71 @@
 #define BUFFER_SIZE ( ipTOTAL_ETHERNET_FRAME_SIZE + ipBUFFER_PADDING )
 #define BUFFER_SIZE_ROUNDED_UP ( ( BUFFER_SIZE + 7 ) & ~0x07UL )
 
+#define SMALL_BUFFER_SIZE_ROUNDED_UP ( ( ipconfigNETWORK_BUFFER_SMALL_SIZE + ipBUFFER_PADDING + 7 ) & ~0x07UL )
+#define MEDIUM_BUFFER_SIZE_ROUNDED_UP ( ( ipconfigNETWORK_BUFFER_MEDIUM_SIZE + ipBUFFER_PADDING + 7 ) & ~0x07UL )
+
+#if( ipNETWORK_BUFFER_FULL_COUNT <= 0 )
+	#error ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS must leave full sized network buffers
+#endif
+
 static __attribute__ ((section(".bss.$RAM2")))
-		uint8_t ucNetworkPackets[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ][ BUFFER_SIZE_ROUNDED_UP ]
+		uint8_t ucNetworkPackets[ ipNETWORK_BUFFER_FULL_COUNT ][ BUFFER_SIZE_ROUNDED_UP ]
 		__attribute__ ( ( aligned( 32 ) ) );
 
+#if( ipconfigNETWORK_BUFFER_SMALL_COUNT != 0 )
+	static __attribute__ ((section(".bss.$RAM2")))
+			uint8_t ucSmallNetworkPackets[ ipconfigNETWORK_BUFFER_SMALL_COUNT ][ SMALL_BUFFER_SIZE_ROUNDED_UP ]
+			__attribute__ ( ( aligned( 32 ) ) );
+#endif
+
+#if( ipconfigNETWORK_BUFFER_MEDIUM_COUNT != 0 )
+	static __attribute__ ((section(".bss.$RAM2")))
+			uint8_t ucMediumNetworkPackets[ ipconfigNETWORK_BUFFER_MEDIUM_COUNT ][ MEDIUM_BUFFER_SIZE_ROUNDED_UP ]
+			__attribute__ ( ( aligned( 32 ) ) );
+#endif
+
+static void prvAssignBuffer( NetworkBufferDescriptor_t *pxNetworkBuffer, uint8_t *pucBuffer )
+{
+    /* pucEthernetBuffer is set to point ipBUFFER_PADDING bytes in from the
+    beginning of the allocated buffer. */
+    pxNetworkBuffer->pucEthernetBuffer = &( pucBuffer[ ipBUFFER_PADDING ] );
+
+    /* The following line is also required, but will not be required in
+    future versions. */
+    *( ( uint32_t * ) &pucBuffer[ 0 ] ) = ( uint32_t ) pxNetworkBuffer;
+}
+
 /* Next provide the vNetworkInterfaceAllocateRAMToBuffers() function, which
-simply fills in the pucEthernetBuffer member of each descriptor. */
+simply fills in the pucEthernetBuffer member of each descriptor.  The small
+buffers go first, then the medium and the full sized ones, the order which
+BufferAllocation_1.c expects. */
 void vNetworkInterfaceAllocateRAMToBuffers(
     NetworkBufferDescriptor_t pxNetworkBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ] )
 {
 BaseType_t x;
+NetworkBufferDescriptor_t *pxNext = pxNetworkBuffers;
+
+    #if( ipconfigNETWORK_BUFFER_SMALL_COUNT != 0 )
+    {
+        for( x = 0; x < ipconfigNETWORK_BUFFER_SMALL_COUNT; x++ )
+        {
+            prvAssignBuffer( pxNext++, ucSmallNetworkPackets[ x ] );
+        }
+    }
+    #endif
 
-    for( x = 0; x < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; x++ )
+    #if( ipconfigNETWORK_BUFFER_MEDIUM_COUNT != 0 )
     {
-        /* pucEthernetBuffer is set to point ipBUFFER_PADDING bytes in from the
-        beginning of the allocated buffer. */
-        pxNetworkBuffers[ x ].pucEthernetBuffer = &( ucNetworkPackets[x][ ipBUFFER_PADDING ] );
+        for( x = 0; x < ipconfigNETWORK_BUFFER_MEDIUM_COUNT; x++ )
+        {
+            prvAssignBuffer( pxNext++, ucMediumNetworkPackets[ x ] );
+        }
+    }
+    #endif
 
-        /* The following line is also required, but will not be required in
-        future versions. */
-        *( ( uint32_t * ) &ucNetworkPackets[x][ 0 ] ) = ( uint32_t ) &( pxNetworkBuffers[ x ] );
+    for( x = 0; x < ipNETWORK_BUFFER_FULL_COUNT; x++ )
+    {
+        prvAssignBuffer( pxNext++, ucNetworkPackets[ x ] );
     }
 }
 /*-----------------------------------------------------------*/
@@ -0,0 +1,163 @@
+/*
+ * FreeRTOS+TCP V2.3.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "NetworkBufferRing.h"
+
+/*-----------------------------------------------------------*/
+
+/* The ring needs a compare-and-swap, an atomic add and a memory barrier on
+32-bit words.  GCC builds them from LDREX/STREX and DMB on the Cortex-M3, so no
+device header is needed, and the same code runs in the host test in tools/.  A
+port for another compiler defines ringCOMPARE_AND_SWAP(), ringATOMIC_ADD() and
+ringMEMORY_BARRIER() in FreeRTOSIPConfig.h. */
+#if !defined( ringCOMPARE_AND_SWAP ) || !defined( ringATOMIC_ADD ) || !defined( ringMEMORY_BARRIER )
+	#if defined( __GNUC__ )
+		/* Store 'ulNew' in '*pulValue' if it still holds 'ulExpected', pdTRUE when it was stored. */
+		static portINLINE BaseType_t prvCompareAndSwap( volatile uint32_t *pulValue, uint32_t ulExpected, uint32_t ulNew )
+		{
+			return __atomic_compare_exchange_n( pulValue, &ulExpected, ulNew, pdFALSE, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED ) ? pdTRUE : pdFALSE;
+		}
+
+		/* Atomically add 'lDelta' to '*pulValue' and return the old value. */
+		static portINLINE uint32_t prvAtomicAdd( volatile uint32_t *pulValue, int32_t lDelta )
+		{
+			return __atomic_fetch_add( pulValue, ( uint32_t ) lDelta, __ATOMIC_SEQ_CST );
+		}
+
+		#define ringCOMPARE_AND_SWAP( pulValue, ulExpected, ulNew )	prvCompareAndSwap( ( pulValue ), ( ulExpected ), ( ulNew ) )
+		#define ringATOMIC_ADD( pulValue, lDelta )					prvAtomicAdd( ( pulValue ), ( lDelta ) )
+		#define ringMEMORY_BARRIER()								__atomic_thread_fence( __ATOMIC_SEQ_CST )
+	#else
+		#error Please define ringCOMPARE_AND_SWAP(), ringATOMIC_ADD() and ringMEMORY_BARRIER() for this compiler
+	#endif
+#endif
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkBufferRingInit( NetworkBufferRing_t *pxRing, NetworkBufferDescriptor_t **ppxStorage, UBaseType_t uxLength )
+{
+UBaseType_t uxIndex;
+
+	/* The indexes are masked, so the length must be a power of 2. */
+	configASSERT( ( uxLength != 0U ) && ( ( uxLength & ( uxLength - 1U ) ) == 0U ) );
+
+	for( uxIndex = 0; uxIndex < uxLength; uxIndex++ )
+	{
+		ppxStorage[ uxIndex ] = NULL;
+	}
+
+	pxRing->ppxItems = ppxStorage;
+	pxRing->ulMask = ( uint32_t ) ( uxLength - 1U );
+	pxRing->ulHead = 0U;
+	pxRing->ulTail = 0U;
+	pxRing->ulCount = 0U;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkBufferRingPush( NetworkBufferRing_t *pxRing, NetworkBufferDescriptor_t *pxDescriptor, BaseType_t *pxWasEmpty )
+{
+uint32_t ulHead;
+
+	configASSERT( pxDescriptor != NULL );
+
+	/* Reserve a slot.  The head only grows, so a value that was seen once
+	will not come back before the counter wraps. */
+	do
+	{
+		ulHead = pxRing->ulHead;
+		if( ( ulHead - pxRing->ulTail ) > pxRing->ulMask )
+		{
+			/* The ring is full. */
+			return pdFAIL;
+		}
+	} while( ringCOMPARE_AND_SWAP( &( pxRing->ulHead ), ulHead, ulHead + 1U ) == pdFALSE );
+
+	/* The slot was emptied by the consumer before it advanced the tail,
+	so it can be filled now. */
+	ringMEMORY_BARRIER();
+	pxRing->ppxItems[ ulHead & pxRing->ulMask ] = pxDescriptor;
+	ringMEMORY_BARRIER();
+
+	/* Only the producer that increments the count from zero has to wake up
+	the consumer. */
+	if( ringATOMIC_ADD( &( pxRing->ulCount ), 1 ) == 0U )
+	{
+		if( pxWasEmpty != NULL )
+		{
+			*pxWasEmpty = pdTRUE;
+		}
+	}
+	else if( pxWasEmpty != NULL )
+	{
+		*pxWasEmpty = pdFALSE;
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxNetworkBufferRingPeek( NetworkBufferRing_t *pxRing )
+{
+NetworkBufferDescriptor_t *pxDescriptor;
+
+	pxDescriptor = pxRing->ppxItems[ pxRing->ulTail & pxRing->ulMask ];
+	ringMEMORY_BARRIER();
+
+	return pxDescriptor;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxNetworkBufferRingPop( NetworkBufferRing_t *pxRing )
+{
+NetworkBufferDescriptor_t *pxDescriptor;
+uint32_t ulSlot = pxRing->ulTail & pxRing->ulMask;
+
+	pxDescriptor = pxRing->ppxItems[ ulSlot ];
+	if( pxDescriptor != NULL )
+	{
+		ringMEMORY_BARRIER();
+		pxRing->ppxItems[ ulSlot ] = NULL;
+		ringMEMORY_BARRIER();
+
+		/* Only now the slot may be reserved again. */
+		pxRing->ulTail++;
+		( void ) ringATOMIC_ADD( &( pxRing->ulCount ), -1 );
+	}
+
+	return pxDescriptor;
+}
+/*-----------------------------------------------------------*/
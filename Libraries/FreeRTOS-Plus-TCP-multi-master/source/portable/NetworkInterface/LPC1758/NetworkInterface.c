@@ -72,8 +72,10 @@
 #include "FreeRTOS_IP_Private.h"
 #include "FreeRTOS_Routing.h"
 #include "FreeRTOS_Bridge.h"
+#include "FreeRTOS_DNS.h"
 #include "NetworkBufferManagement.h"
 #include "NetworkInterface.h"
+#include "NetworkBufferRing.h"
 
 /* LPCOpen includes. */
 #include "chip.h"
@@ -93,6 +95,25 @@
 	#define PHY_LS_LOW_CHECK_TIME_MS	3000
 #endif
 
+#ifndef configEMAC_TX_RING_LENGTH
+	/* Number of frames which can wait for a free TX DMA descriptor,
+	must be a power of 2. */
+	#define configEMAC_TX_RING_LENGTH	8
+#endif
+
+#ifndef configEMAC_RX_BUDGET
+	/* Maximum number of frames taken from the RX ring in one pass.  While
+	the ring is not empty the RX interrupt stays masked and the task polls,
+	one pass per tick. */
+	#define configEMAC_RX_BUDGET	8
+#endif
+
+#ifndef configEMAC_RX_RESERVE
+	/* Number of network buffers kept aside to replace the buffers of received
+	frames, so that the allocator is called once per batch, not per frame. */
+	#define configEMAC_RX_RESERVE	2
+#endif
+
 #ifndef configUSE_RMII
 	#define configUSE_RMII 1
 #endif
@@ -105,6 +126,18 @@
 	#error please define ipconfigNUM_TX_DESCRIPTORS in your FreeRTOSIPConfig.h
 #endif
 
+#if( ipconfigMAX_TX_FRAGMENTS != 0 ) && ( ( ipconfigMAX_TX_FRAGMENTS + 1 ) >= ipconfigNUM_TX_DESCRIPTORS )
+	#error ipconfigNUM_TX_DESCRIPTORS must be larger than the number of descriptors of one frame with fragments
+#endif
+
+#ifndef configEMAC_DMA_READABLE
+	/* The EMAC DMA only reads the AHB SRAM banks, neither the flash nor the
+	local SRAM of the CPU.  Frames with fragments elsewhere, e.g. a file body
+	in flash, are flattened first. */
+	#define configEMAC_DMA_READABLE( pucAddress ) \
+		( ( ( uint32_t ) ( pucAddress ) >= 0x2007C000UL ) && ( ( uint32_t ) ( pucAddress ) < 0x20084000UL ) )
+#endif
+
 #ifndef NETWORK_IRQHandler
 	#error NETWORK_IRQHandler must be defined to the name of the function that is installed in the interrupt vector table to handle Ethernet interrupts.
 #endif
@@ -132,6 +165,10 @@
 /* Transmit group interrupts */
 #define TXINTGROUP (ENET_INT_TXUNDERRUN | ENET_INT_TXERROR | ENET_INT_TXDONE)
 
+/* Notification bit to tell the EMAC task that frames were added to the
+TX ring.  It does not collide with the ENET_INT_* bits. */
+#define EMAC_TX_START_EVENT	0x00010000UL
+
 /*-----------------------------------------------------------*/
 
 
@@ -147,16 +184,33 @@ static void prvDelay( uint32_t ulMilliSeconds );
 static void prvSetupTxDescriptors( void );
 static void prvSetupRxDescriptors( void );
 
+/*
+ * Fills the reserve of network buffers used to replace received buffers.
+ */
+static void prvRefillRxReserve( void );
+
 /*
  * A task that processes received frames.
  */
 static void prvEMACHandlerTask( void *pvParameters );
 
+/*
+ * Moves frames from the TX ring to free TX DMA descriptors.
+ */
+static void prvEMACTransmit( NetworkInterface_t *pxInterface );
+
 /*
  * Sets up the MAC with the results of an auto-negotiation.
  */
 static void prvSetLinkSpeed( void );
 
+/*
+ * Programs the station address and the receive filter.  A bridged interface
+ * receives everything, otherwise only frames for the endpoint, broadcasts and
+ * the multicast groups the stack listens to are accepted by the hardware.
+ */
+static void prvSetRXFilter( NetworkInterface_t *pxInterface );
+
 /*-----------------------------------------------------------*/
 
 /* A copy of PHY status */
@@ -169,11 +223,19 @@ static UBaseType_t ulTxCleanupIndex = 0;
 the task can be notified when new packets arrive. */
 static TaskHandle_t xEMACTaskHandle = NULL;
 
-/* xTXDescriptorSemaphore is a counting semaphore with
-a maximum count of ipconfigNUM_TX_DESCRIPTORS, which is the number of
-DMA TX descriptors. */
-static SemaphoreHandle_t xTXDescriptorSemaphore = NULL;
-static SemaphoreHandle_t xTXMutex = NULL;
+/* Frames to be sent are pushed into xTXRing by any task and handed to the
+DMA by the EMAC task only, so the TX descriptors need no locking. */
+static NetworkBufferRing_t xTXRing;
+static NetworkBufferDescriptor_t *pxTXRingStorage[ configEMAC_TX_RING_LENGTH ];
+
+/* Network buffers waiting to replace the buffer of a received frame, only
+accessed by the EMAC task. */
+static NetworkBufferDescriptor_t *pxRxReserve[ configEMAC_RX_RESERVE ];
+static UBaseType_t uxRxReserveCount = 0;
+
+/* Frames dropped because the reserve was empty or the DMA overran the ring. */
+static uint32_t ulRxNoBufferCount = 0;
+static volatile uint32_t ulRxOverrunCount = 0;
 
 /* The EMAC DMA descriptors are stored in AHB SRAM for faster access */
 static __attribute__ ((section(".bss.$RAM2")))
@@ -185,6 +247,12 @@ static __attribute__ ((section(".bss.$RAM2")))
 static __attribute__ ((section(".bss.$RAM2")))
 		ENET_TXSTAT_T xDMATxStatus[ipconfigNUM_TX_DESCRIPTORS];
 
+#if( ipconfigZERO_COPY_TX_DRIVER != 0 )
+	/* The Network Buffer to release when a TX descriptor is done, NULL for
+	the descriptors that hold the fragments of a frame. */
+	static NetworkBufferDescriptor_t *pxTxDescriptorBuffers[ ipconfigNUM_TX_DESCRIPTORS ];
+#endif
+
 /*-----------------------------------------------------------*/
 
 void vCheckBuffersAndQueue( void )
@@ -194,6 +262,8 @@ static UBaseType_t uxLastBufferCount = 0;
 	static UBaseType_t uxLastMinQueueSpace;
 #endif
 static UBaseType_t uxCurrentCount;
+static uint32_t ulLastRxDropped = 0;
+uint32_t ulRxDropped;
 
 	#if( ipconfigCHECK_IP_QUEUE_SPACE != 0 )
 	{
@@ -216,6 +286,13 @@ static UBaseType_t uxCurrentCount;
 		//FreeRTOS_printf( ( "Network buffers: %lu lowest %lu\n",
 		//	uxCurrentCount, uxGetMinimumFreeNetworkBuffers() ) );
 	}
+	ulRxDropped = ulRxNoBufferCount + ulRxOverrunCount;
+	if( ulLastRxDropped != ulRxDropped )
+	{
+		ulLastRxDropped = ulRxDropped;
+		FreeRTOS_printf( ( "EMAC RX: %lu no buffer, %lu overruns\n",
+			ulRxNoBufferCount, ulRxOverrunCount ) );
+	}
 }
 /*-----------------------------------------------------------*/
 
@@ -315,6 +392,39 @@ BaseType_t x;
 
 	/* Point the DMA to the base of the descriptor list. */
 	Chip_ENET_InitRxDescriptors(LPC_ETHERNET, xDMARxDescriptors, xDMARxStatus, ipconfigNUM_RX_DESCRIPTORS);
+
+	/* Have replacements ready before the first frame arrives. */
+	prvRefillRxReserve();
+}
+/*-----------------------------------------------------------*/
+
+static void prvRefillRxReserve( void )
+{
+const UBaseType_t uxMinimumBuffersRemaining = 2UL;
+UBaseType_t uxFree;
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+
+	if( uxRxReserveCount < configEMAC_RX_RESERVE )
+	{
+		/* The pool is looked at once for the whole batch.  Leave some full
+		sized buffers for the stack, received frames are dropped rather than
+		starving it. */
+		uxFree = uxGetNumberOfFreeNetworkBuffersOfSize( ipTOTAL_ETHERNET_FRAME_SIZE );
+
+		while( ( uxRxReserveCount < configEMAC_RX_RESERVE ) && ( uxFree > uxMinimumBuffersRemaining ) )
+		{
+			pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( ipTOTAL_ETHERNET_FRAME_SIZE, ( TickType_t ) 0 );
+			if( pxNetworkBuffer == NULL )
+			{
+				break;
+			}
+
+			ipNETWORK_BUFFER_SET_OWNER( pxNetworkBuffer, eNetworkBufferOwnerEthernet );
+			pxRxReserve[ uxRxReserveCount ] = pxNetworkBuffer;
+			uxRxReserveCount++;
+			uxFree--;
+		}
+	}
 }
 /*-----------------------------------------------------------*/
 
@@ -394,7 +504,6 @@ BaseType_t xLPC1758_NetworkInterfaceInitialise( NetworkInterface_t *pxInterface
 {
 const TickType_t xAutoNegotiateDelay = pdMS_TO_TICKS( 2000UL );
 BaseType_t xReturn = pdPASS;
-NetworkEndPoint_t *pxEndPoint;
 
 	/* The interrupt will be turned on when a link is established. */
 	NVIC_DisableIRQ( ETHERNET_IRQn );
@@ -416,27 +525,6 @@ NetworkEndPoint_t *pxEndPoint;
 		}
 		#endif
 
-		/* _ML_ TODO: Ethernet driver needs to wait until GreenPHY has read its MAC. */
-//	#if( ipconfigUSE_BRIDGE != 0 )
-//		if( pxInterface->bits.bIsBridged != 0 )
-//		{
-//			/* If interface is bridged run in promiscuous mode and
-//			do not activate RX filters */
-//		}
-//		else
-//	#endif
-		{
-			/* Not bridged. Get MAC address from associated Endpoint. */
-			pxEndPoint = FreeRTOS_FirstEndPoint( NULL /*pxInterface*/ );
-			configASSERT( pxEndPoint != NULL );
-
-			/* Save MAC address. */
-			Chip_ENET_SetADDR( LPC_ETHERNET, pxEndPoint->xMACAddress.ucBytes );
-
-			/* Perfect match and Broadcast enabled */
-//			Chip_ENET_EnableRXFilter(LPC_ETHERNET, ENET_RXFILTERCTRL_APE | ENET_RXFILTERCTRL_ABE);
-		}
-
 		/* Initialize the PHY */
 		#define LPC_PHYDEF_PHYADDR 1
 		Chip_ENET_SetupMII(LPC_ETHERNET, Chip_ENET_FindMIIDiv(LPC_ETHERNET, 2500000), LPC_PHYDEF_PHYADDR);
@@ -458,18 +546,23 @@ NetworkEndPoint_t *pxEndPoint;
 		}
 		#endif
 
+		#if( ipconfigBRIDGE_LATENCY_STATS != 0 )
+		{
+			/* The cycle counter time stamps frames for the bridge statistics. */
+			CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+			DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+		}
+		#endif
+
 		/* Guard the descriptors from being initialised more than once. */
-		if( xTXDescriptorSemaphore == NULL )
+		if( xTXRing.ppxItems == NULL )
 		{
 			/* Initialise the descriptors. */
 			prvSetupTxDescriptors();
 			prvSetupRxDescriptors();
 
-			/* Create a semaphore which counts free TX descriptors. */
-			xTXDescriptorSemaphore = xSemaphoreCreateCounting( ( UBaseType_t ) ipconfigNUM_TX_DESCRIPTORS, ( UBaseType_t ) ipconfigNUM_TX_DESCRIPTORS );
-			configASSERT( xTXDescriptorSemaphore );
-			xTXMutex = xSemaphoreCreateMutex();
-			configASSERT( xTXMutex );
+			/* Create the ring which holds frames waiting for a TX descriptor. */
+			xNetworkBufferRingInit( &xTXRing, pxTXRingStorage, configEMAC_TX_RING_LENGTH );
 		}
 
 		/* Guard against the task being created more than once. */
@@ -496,6 +589,10 @@ NetworkEndPoint_t *pxEndPoint;
 			/* Resume the EMAC Task in case it was suspended after a PHY disconnect. */
 //			vTaskResume( xEMACTaskHandle );
 
+			/* The filter is set up on every initialisation, as the MAC of the
+			endpoint may have been read from the GreenPHY in the meantime. */
+			prvSetRXFilter( pxInterface );
+
 			/* Clear and enable RX/TX interrupts. */
 			Chip_ENET_EnableInt(LPC_ETHERNET, RXINTGROUP | TXINTGROUP);
 
@@ -513,79 +610,185 @@ NetworkEndPoint_t *pxEndPoint;
 }
 /*-----------------------------------------------------------*/
 
-BaseType_t xLPC1758_NetworkInterfaceOutput( NetworkInterface_t *pxInterface, NetworkBufferDescriptor_t * const pxDescriptor, BaseType_t bReleaseAfterSend )
+#if( ipconfigUSE_LLMNR == 1 )
+
+static uint32_t prvHashFilterBit( const uint8_t *pucMACAddress )
 {
-BaseType_t xReturn = pdFAIL;
-const TickType_t xBlockTimeTicks = pdMS_TO_TICKS( 250 );
-UBaseType_t ulTxProduceIndex;
+uint32_t ulCRC = 0xFFFFFFFFUL;
+uint32_t ulByte;
+BaseType_t x, xBit;
 
-	if( xLPC1758_GetPhyLinkStatus( pxInterface ) == pdPASS )
+	/* The EMAC hashes the destination MAC with the Ethernet CRC, bits 28..23
+	of the CRC select one of the 64 bits of the hash filter. */
+	for( x = 0; x < ipMAC_ADDRESS_LENGTH_BYTES; x++ )
 	{
-
-		do
+		ulByte = pucMACAddress[ x ];
+		for( xBit = 0; xBit < 8; xBit++ )
 		{
-			if( ( xTXDescriptorSemaphore == NULL ) || ( xTXMutex == NULL ) )
+			if( ( ( ulCRC >> 31 ) ^ ulByte ) & 0x01UL )
 			{
-				break;
+				ulCRC = ( ulCRC << 1 ) ^ 0x04C11DB7UL;
 			}
-			if( xSemaphoreTake( xTXDescriptorSemaphore, xBlockTimeTicks ) != pdPASS )
+			else
 			{
-				/* Time-out waiting for a free TX descriptor. */
-				break;
+				ulCRC <<= 1;
 			}
+			ulByte >>= 1;
+		}
+	}
 
-			/* The semaphore was taken, so there should be a TX DMA descriptor
-			available */
-			configASSERT( !Chip_ENET_IsTxFull( LPC_ETHERNET ) );
+	return ( ulCRC >> 23 ) & 0x3FUL;
+}
+/*-----------------------------------------------------------*/
 
-			/* Ensure only one task is accessing critical section of
-			xLPC1758_NetworkInterfaceOutput at the same time. */
-			if( xSemaphoreTake( xTXMutex, xBlockTimeTicks ) != pdPASS )
-			{
-				/* Mutex access failed, release semaphore and exit. */
-				xSemaphoreGive( xTXDescriptorSemaphore );
-				break;
-			}
+#endif /* ipconfigUSE_LLMNR == 1 */
 
-			ulTxProduceIndex = Chip_ENET_GetTXProduceIndex( LPC_ETHERNET );
+static void prvSetRXFilter( NetworkInterface_t *pxInterface )
+{
+NetworkEndPoint_t *pxEndPoint;
+uint32_t ulFilter = ENET_RXFILTERCTRL_ABE;
+uint32_t ulHash[ 2 ] = { 0UL, 0UL };
 
-			#if( ipconfigZERO_COPY_TX_DRIVER != 0 )
-			{
-				/* bReleaseAfterSend should always be set when using the zero
-				copy driver. */
-				configASSERT( bReleaseAfterSend != pdFALSE );
+	/* Get MAC address from associated Endpoint. */
+	pxEndPoint = FreeRTOS_FirstEndPoint( NULL /*pxInterface*/ );
+	configASSERT( pxEndPoint != NULL );
 
-				/* The DMA's descriptor to point directly to the data in the
-				network buffer descriptor.  The data is not copied. */
-				xDMATxDescriptors[ ulTxProduceIndex ].Packet = ( uint32_t ) pxDescriptor->pucEthernetBuffer;
+	/* Save MAC address. */
+	Chip_ENET_SetADDR( LPC_ETHERNET, pxEndPoint->xMACAddress.ucBytes );
 
-				/* The DMA descriptor will 'own' this Network Buffer,
-				until it has been sent.  So don't release it now. */
-				bReleaseAfterSend = pdFALSE;
-			}
-			#else
+	#if( ipconfigUSE_BRIDGE != 0 )
+	if( pxInterface->bits.bIsBridged != 0 )
+	{
+		/* If interface is bridged run in promiscuous mode. */
+		ulFilter |= ENET_RXFILTERCTRL_AUE | ENET_RXFILTERCTRL_AME;
+	}
+	else
+	#endif
+	{
+		( void ) pxInterface;
+
+		/* Perfect match of the endpoint MAC. */
+		ulFilter |= ENET_RXFILTERCTRL_APE;
+
+		#if( ipconfigUSE_LLMNR == 1 )
+		{
+		uint32_t ulBit;
+
+			ulBit = prvHashFilterBit( xLLMNR_MacAdress.ucBytes );
+			ulHash[ ulBit >> 5 ] |= 1UL << ( ulBit & 0x1FUL );
+		}
+		#endif
+
+		#if( ipconfigUSE_IPv6 != 0 )
+		{
+			/* IPv6 uses a multicast group per address, accept them all. */
+			ulFilter |= ENET_RXFILTERCTRL_AME;
+		}
+		#endif
+
+		if( ( ulHash[ 0 ] | ulHash[ 1 ] ) != 0UL )
+		{
+			ulFilter |= ENET_RXFILTERCTRL_AMHE;
+		}
+	}
+
+	LPC_ETHERNET->RXFILTER.HashFilterL = ulHash[ 0 ];
+	LPC_ETHERNET->RXFILTER.HashFilterH = ulHash[ 1 ];
+	Chip_ENET_DisableRXFilter( LPC_ETHERNET, ENET_RXFILTERCTRL_AUE | ENET_RXFILTERCTRL_ABE | ENET_RXFILTERCTRL_AME |
+											 ENET_RXFILTERCTRL_AUHE | ENET_RXFILTERCTRL_AMHE | ENET_RXFILTERCTRL_APE );
+	Chip_ENET_EnableRXFilter( LPC_ETHERNET, ulFilter );
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigMAX_TX_FRAGMENTS != 0 ) && ( ipconfigZERO_COPY_TX_DRIVER != 0 )
+
+static BaseType_t prvFragmentsReadable( const NetworkBufferDescriptor_t *pxDescriptor )
+{
+BaseType_t xReturn = pdTRUE;
+UBaseType_t uxFragment;
+
+	for( uxFragment = 0; uxFragment < pxDescriptor->uxFragmentCount; uxFragment++ )
+	{
+		if( !configEMAC_DMA_READABLE( pxDescriptor->xFragments[ uxFragment ].pucData ) )
+		{
+			xReturn = pdFALSE;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* ( ipconfigMAX_TX_FRAGMENTS != 0 ) && ( ipconfigZERO_COPY_TX_DRIVER != 0 ) */
+
+BaseType_t xLPC1758_NetworkInterfaceOutput( NetworkInterface_t *pxInterface, NetworkBufferDescriptor_t * const pxDescriptor, BaseType_t bReleaseAfterSend )
+{
+BaseType_t xReturn = pdFAIL;
+BaseType_t xWasEmpty = pdFALSE;
+NetworkBufferDescriptor_t *pxTXDescriptor = pxDescriptor;
+
+	if( ( xLPC1758_GetPhyLinkStatus( pxInterface ) == pdPASS ) && ( xTXRing.ppxItems != NULL ) )
+	{
+		#if( ipconfigZERO_COPY_TX_DRIVER != 0 )
+		{
+			/* bReleaseAfterSend should always be set when using the zero
+			copy driver. */
+			configASSERT( bReleaseAfterSend != pdFALSE );
+
+			#if( ipconfigMAX_TX_FRAGMENTS != 0 )
 			{
-				/* The data is copied from the network buffer descriptor into
-				the DMA's descriptor. */
-				memcpy( ( void * ) xDMATxDescriptors[ ulTxProduceIndex ].Packet, ( void * ) pxDescriptor->pucEthernetBuffer, pxDescriptor->xDataLength );
+				if( prvFragmentsReadable( pxDescriptor ) == pdFALSE )
+				{
+					/* The DMA can not reach a fragment, send a copy. */
+					if( xNetworkBufferFlattenFragments( pxDescriptor ) == pdFAIL )
+					{
+						pxTXDescriptor = NULL;
+					}
+				}
 			}
 			#endif
+		}
+		#else
+		{
+			/* The frame is copied later by the EMAC task, so it needs a
+			buffer of its own if the caller keeps this one. */
+			if( bReleaseAfterSend == pdFALSE )
+			{
+				pxTXDescriptor = pxDuplicateNetworkBufferWithDescriptor( pxDescriptor, pxDescriptor->xDataLength );
+			}
+		}
+		#endif
 
-			/* Set DMA descriptor data length, enable TxDone Interrupt and
-			indicate it's the frame's last (and only) descriptor */
-			xDMATxDescriptors[ ulTxProduceIndex ].Control = ( uint32_t ) ENET_TCTRL_SIZE( pxDescriptor->xDataLength ) | ENET_TCTRL_INT | ENET_TCTRL_LAST;
-
-			/* Increase the current Tx Produce Descriptor Index to start transmission*/
-			Chip_ENET_IncTXProduceIndex(LPC_ETHERNET);
+		if( pxTXDescriptor != NULL )
+		{
+			/* Before the push, the EMAC task may send and release it at once. */
+			ipNETWORK_BUFFER_SET_OWNER( pxTXDescriptor, eNetworkBufferOwnerEthernet );
+		}
 
-			xSemaphoreGive( xTXMutex );
+		if( ( pxTXDescriptor != NULL ) && ( xNetworkBufferRingPush( &xTXRing, pxTXDescriptor, &xWasEmpty ) == pdPASS ) )
+		{
+			/* The ring will 'own' this Network Buffer, until it has been
+			sent.  So don't release it now. */
+			if( pxTXDescriptor == pxDescriptor )
+			{
+				bReleaseAfterSend = pdFALSE;
+			}
 
-			iptraceNETWORK_INTERFACE_TRANSMIT();
+			if( xWasEmpty != pdFALSE )
+			{
+				/* The EMAC task drains the ring until it is empty, so it
+				only needs to be woken for the first frame. */
+				xTaskNotify( xEMACTaskHandle, EMAC_TX_START_EVENT, eSetBits );
+			}
 
 			/* The Tx has been initiated. */
 			xReturn = pdPASS;
-
-		} while( 0 );
+		}
+		else if( ( pxTXDescriptor != NULL ) && ( pxTXDescriptor != pxDescriptor ) )
+		{
+			/* The ring is full, drop the copy. */
+			vReleaseNetworkBufferAndDescriptor( pxTXDescriptor );
+		}
 	}
 
 	/* The buffer has been sent so can be released. */
@@ -598,22 +801,136 @@ UBaseType_t ulTxProduceIndex;
 }
 /*-----------------------------------------------------------*/
 
-static void prvEMACHandlerTask( void *pvParameters )
+static void prvEMACTransmit( NetworkInterface_t *pxInterface )
 {
-const TickType_t xDescriptorWaitTime = pdMS_TO_TICKS( 250 );
-const UBaseType_t uxMinimumBuffersRemaining = 2UL;
+NetworkBufferDescriptor_t *pxDescriptor;
+UBaseType_t ulTxProduceIndex;
+UBaseType_t uxFree;
+UBaseType_t uxNeeded;
+#if( ipconfigMAX_TX_FRAGMENTS != 0 )
+	UBaseType_t uxFragment;
+	#if( ipconfigZERO_COPY_TX_DRIVER == 0 )
+		size_t uxOffset;
+	#endif
+#endif
+
+	for( ;; )
+	{
+		pxDescriptor = pxNetworkBufferRingPeek( &xTXRing );
+		if( pxDescriptor == NULL )
+		{
+			break;
+		}
+
+		/* One slot is always left empty, a full ring looks like an empty one
+		otherwise. */
+		ulTxProduceIndex = Chip_ENET_GetTXProduceIndex( LPC_ETHERNET );
+		uxFree = ( ( ipconfigNUM_TX_DESCRIPTORS - 1 ) + Chip_ENET_GetTXConsumeIndex( LPC_ETHERNET ) - ulTxProduceIndex ) % ipconfigNUM_TX_DESCRIPTORS;
+		uxNeeded = 1;
+		#if( ipconfigMAX_TX_FRAGMENTS != 0 ) && ( ipconfigZERO_COPY_TX_DRIVER != 0 )
+		{
+			/* Every fragment gets a descriptor of its own. */
+			uxNeeded += pxDescriptor->uxFragmentCount;
+		}
+		#endif
+		if( uxFree < uxNeeded )
+		{
+			break;
+		}
+
+		( void ) pxNetworkBufferRingPop( &xTXRing );
+
+		#if( ipconfigZERO_COPY_TX_DRIVER != 0 )
+		{
+			/* The DMA's descriptor to point directly to the data in the
+			network buffer descriptor.  The data is not copied.  The DMA
+			descriptor will 'own' this Network Buffer, until it has been
+			sent. */
+			xDMATxDescriptors[ ulTxProduceIndex ].Packet = ( uint32_t ) pxDescriptor->pucEthernetBuffer;
+			xDMATxDescriptors[ ulTxProduceIndex ].Control = ( uint32_t ) ENET_TCTRL_SIZE( pxDescriptor->xDataLength );
+
+			#if( ipconfigMAX_TX_FRAGMENTS != 0 )
+			{
+				/* The fragments follow on the next descriptors, the EMAC
+				gathers them into one frame. */
+				for( uxFragment = 0; uxFragment < pxDescriptor->uxFragmentCount; uxFragment++ )
+				{
+					pxTxDescriptorBuffers[ ulTxProduceIndex ] = NULL;
+					ulTxProduceIndex = ( ulTxProduceIndex + 1 ) % ipconfigNUM_TX_DESCRIPTORS;
+					xDMATxDescriptors[ ulTxProduceIndex ].Packet = ( uint32_t ) pxDescriptor->xFragments[ uxFragment ].pucData;
+					xDMATxDescriptors[ ulTxProduceIndex ].Control = ( uint32_t ) ENET_TCTRL_SIZE( pxDescriptor->xFragments[ uxFragment ].xLength );
+				}
+			}
+			#endif
+
+			/* The last descriptor of the frame releases the Network Buffer. */
+			pxTxDescriptorBuffers[ ulTxProduceIndex ] = pxDescriptor;
+		}
+		#else
+		{
+			/* The data is copied from the network buffer descriptor into
+			the DMA's descriptor. */
+			memcpy( ( void * ) xDMATxDescriptors[ ulTxProduceIndex ].Packet, ( void * ) pxDescriptor->pucEthernetBuffer, pxDescriptor->xDataLength );
+			xDMATxDescriptors[ ulTxProduceIndex ].Control = ( uint32_t ) ENET_TCTRL_SIZE( pxDescriptor->xDataLength );
+
+			#if( ipconfigMAX_TX_FRAGMENTS != 0 )
+			{
+				uxOffset = pxDescriptor->xDataLength;
+				for( uxFragment = 0; uxFragment < pxDescriptor->uxFragmentCount; uxFragment++ )
+				{
+					memcpy( ( void * ) ( xDMATxDescriptors[ ulTxProduceIndex ].Packet + uxOffset ), ( const void * ) pxDescriptor->xFragments[ uxFragment ].pucData, pxDescriptor->xFragments[ uxFragment ].xLength );
+					uxOffset += pxDescriptor->xFragments[ uxFragment ].xLength;
+				}
+				xDMATxDescriptors[ ulTxProduceIndex ].Control = ( uint32_t ) ENET_TCTRL_SIZE( uxOffset );
+			}
+			#endif
+		}
+		#endif
+
+		/* Enable TxDone Interrupt and indicate it's the frame's last
+		descriptor */
+		xDMATxDescriptors[ ulTxProduceIndex ].Control |= ENET_TCTRL_INT | ENET_TCTRL_LAST;
+
+		/* Hand all descriptors of the frame to the DMA at once to start
+		transmission, so it can not run out of data in the middle. */
+		LPC_ETHERNET->CONTROL.TX.PRODUCEINDEX = ( ulTxProduceIndex + 1 ) % ipconfigNUM_TX_DESCRIPTORS;
+
+		#if( ipconfigUSE_BRIDGE != 0 ) && ( ipconfigBRIDGE_LATENCY_STATS != 0 )
+		{
+			vBridgeLatencySample( pxInterface, pxDescriptor, DWT->CYCCNT );
+		}
+		#else
+		{
+			( void ) pxInterface;
+		}
+		#endif
+
+		#if( ipconfigZERO_COPY_TX_DRIVER == 0 )
+		{
+			vReleaseNetworkBufferAndDescriptor( pxDescriptor );
+		}
+		#endif
+
+		iptraceNETWORK_INTERFACE_TRANSMIT();
+	}
+}
+/*-----------------------------------------------------------*/
 
+static void prvEMACHandlerTask( void *pvParameters )
+{
 TickType_t xPhyPollTime = pdMS_TO_TICKS( PHY_LS_HIGH_CHECK_TIME_MS );
 NetworkInterface_t *pxInterface = ( NetworkInterface_t *) pvParameters;
 uint32_t ulNotificationValue;
 eFrameProcessingResult_t eResult;
 UBaseType_t ulConsumeIndex;
 NetworkBufferDescriptor_t *pxDescriptor;
-#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
-	NetworkBufferDescriptor_t *pxNewDescriptor;
-#endif /* ipconfigZERO_COPY_RX_DRIVER */
+NetworkBufferDescriptor_t *pxNewDescriptor;
 size_t xDataLength;
 IPStackEvent_t xIPStackEvent;
+BaseType_t xTxRetry = pdFALSE;
+BaseType_t xRxPolling = pdFALSE;
+TickType_t xLastRxPass = 0;
+UBaseType_t uxBudget;
 
 	for( ;; )
 	{
@@ -623,10 +940,32 @@ IPStackEvent_t xIPStackEvent;
 		 * 0 timeout
 		 * ENET_INT_RXDONE receive
 		 * ENET_INT_TXDONE TX cleanup
+		 * EMAC_TX_START_EVENT frames in the TX ring
 		 * */
-		ulNotificationValue = ulTaskNotifyTake( pdTRUE, xPhyPollTime );
+		if( xRxPolling != pdFALSE )
+		{
+			/* The RX ring still holds frames.  This task runs above the
+			IP-task, so it waits for the next tick before the next pass:
+			otherwise a flood of frames would leave no time to the IP-task
+			and the PLC task.  TX events are still handled in between. */
+			ulNotificationValue = ulTaskNotifyTake( pdTRUE, 1 );
+			if( xTaskGetTickCount() != xLastRxPass )
+			{
+				ulNotificationValue |= ENET_INT_RXDONE;
+			}
+		}
+		else
+		{
+			/* Wait until a packet has been received or PHY link status times out */
+			ulNotificationValue = ulTaskNotifyTake( pdTRUE, ( xTxRetry != pdFALSE ) ? 1 : xPhyPollTime );
+		}
 
-		/* Wait until a packet has been received or PHY link status times out */
+		if( xTxRetry != pdFALSE )
+		{
+			/* A producer has reserved a slot in the TX ring but had not
+			filled it yet, look again. */
+			ulNotificationValue |= EMAC_TX_START_EVENT;
+		}
 
 		if( ulNotificationValue == 0 )
 		{
@@ -653,12 +992,29 @@ IPStackEvent_t xIPStackEvent;
 			/* Task got notified */
 			if ( ( ulNotificationValue & ENET_INT_RXDONE ) != 0x00 )
 			{
-				/* Check if a packet has been received. */
-				while( !Chip_ENET_IsRxEmpty(LPC_ETHERNET) )
+				/* Check if a packet has been received.  No more than
+				configEMAC_RX_BUDGET frames are taken in one pass, so TX
+				cleanup is not held off by a long burst. */
+				uxBudget = configEMAC_RX_BUDGET;
+				xLastRxPass = xTaskGetTickCount();
+				while( ( uxBudget > 0 ) && ( !Chip_ENET_IsRxEmpty(LPC_ETHERNET) ) )
 				{
+					uxBudget--;
 					ulConsumeIndex = Chip_ENET_GetRXConsumeIndex( LPC_ETHERNET );
 
-					eResult = ipCONSIDER_FRAME_FOR_PROCESSING( ( const uint8_t * const ) ( xDMARxDescriptors[ ulConsumeIndex ].Packet ) );
+				#if( ipconfigUSE_BRIDGE != 0 )
+					if( pxInterface->bits.bIsBridged != 0 )
+					{
+						/* The bridge decides where the frame goes. */
+						eResult = eProcessBuffer;
+					}
+					else
+				#endif
+					{
+						/* Drop frames that are not for this node before a
+						network buffer is spent on them. */
+						eResult = ipCONSIDER_FRAME_FOR_PROCESSING( ( const uint8_t * const ) ( xDMARxDescriptors[ ulConsumeIndex ].Packet ) );
+					}
 					if( eResult == eProcessBuffer )
 					{
 						/* A packet was received, set PHY status to connected. */
@@ -669,21 +1025,15 @@ IPStackEvent_t xIPStackEvent;
 							xPhyPollTime = pdMS_TO_TICKS( PHY_LS_HIGH_CHECK_TIME_MS );
 						}
 
-					#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
-						if( uxGetNumberOfFreeNetworkBuffers() > uxMinimumBuffersRemaining )
-						{
-							pxNewDescriptor = pxGetNetworkBufferWithDescriptor( ipTOTAL_ETHERNET_FRAME_SIZE, xDescriptorWaitTime );
-						}
-						else
+						if( uxRxReserveCount == 0 )
 						{
-							/* Too risky to allocate a new Network Buffer. */
-							pxNewDescriptor = NULL;
+							/* The reserve ran dry in the middle of a burst. */
+							prvRefillRxReserve();
 						}
-						if( pxNewDescriptor != NULL )
-					#else
-						if( uxGetNumberOfFreeNetworkBuffers() > uxMinimumBuffersRemaining )
-					#endif /* ipconfigZERO_COPY_RX_DRIVER */
+
+						if( uxRxReserveCount != 0 )
 						{
+							pxNewDescriptor = pxRxReserve[ --uxRxReserveCount ];
 
 							/* Get the actual length. */
 							xDataLength = ( size_t ) ENET_RINFO_SIZE( xDMARxStatus[ ulConsumeIndex ].StatusInfo ) - 4; /* Remove FCS */
@@ -704,63 +1054,78 @@ IPStackEvent_t xIPStackEvent;
 							}
 							#else
 							{
-								/* Create a buffer of exactly the required length. */
-								pxDescriptor = pxGetNetworkBufferWithDescriptor( xDataLength, xDescriptorWaitTime );
+								/* Copy the data into the buffer from the reserve. */
+								pxDescriptor = pxNewDescriptor;
+								#if( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+								{
+									/* Check the checksums while the frame is copied,
+									so the IP task does not read it once more. */
+									pxDescriptor->xDataLength = xDataLength;
+									vNetworkBufferSetRxChecksum( pxDescriptor,
+										usGenerateChecksumCopy( 0U, pxDescriptor->pucEthernetBuffer, ( const uint8_t * ) xDMARxDescriptors[ ulConsumeIndex ].Packet, xDataLength ) );
+								}
+								#else
+								{
+									memcpy( ( void * ) pxDescriptor->pucEthernetBuffer, ( void * ) xDMARxDescriptors[ ulConsumeIndex ].Packet, xDataLength );
+								}
+								#endif /* ipconfigDRIVER_VERIFIES_RX_CHECKSUM */
 							}
 							#endif /* ipconfigZERO_COPY_RX_DRIVER */
 
-							if( pxDescriptor != NULL )
+							/* Update the the length of the network buffer descriptor
+							with the number of received bytes */
+							pxDescriptor->xDataLength = xDataLength;
+
+							/* Set the receiving interface in the network buffer descriptor */
+							pxDescriptor->pxInterface = pxInterface;
+
+							#if( ipconfigBRIDGE_LATENCY_STATS != 0 )
 							{
+								pxDescriptor->ulRxTimestamp = DWT->CYCCNT;
+							}
+							#endif
 
-								/* Update the the length of the network buffer descriptor
-								with the number of received bytes */
-								pxDescriptor->xDataLength = xDataLength;
-								#if( ipconfigZERO_COPY_RX_DRIVER == 0 )
+						#if( ipconfigUSE_BRIDGE != 0 )
+							if( pxInterface->bits.bIsBridged )
+							{
+								if( xBridge_Process( pxDescriptor ) == pdFAIL )
 								{
-									/* Copy the data into the allocated buffer. */
-									memcpy( ( void * ) pxDescriptor->pucEthernetBuffer, ( void * ) xDMARxDescriptors[ ulConsumeIndex ].Packet, usLength );
+									/* The Bridge could not process the descriptor,
+									it must be released. */
+									vReleaseNetworkBufferAndDescriptor( pxDescriptor );
+									iptraceETHERNET_RX_EVENT_LOST();
 								}
-								#endif /* ipconfigZERO_COPY_RX_DRIVER */
-
-								/* Set the receiving interface in the network buffer descriptor */
-								pxDescriptor->pxInterface = pxInterface;
-
-							#if( ipconfigUSE_BRIDGE != 0 )
-								if( pxInterface->bits.bIsBridged )
+							}
+							else
+						#endif
+							{
+								/* Pass the data to the TCP/IP task for processing.
+								Do not block: while this task waits, the DMA keeps
+								filling the ring and would overrun it. */
+								xIPStackEvent.eEventType = eNetworkRxEvent;
+								xIPStackEvent.pvData = ( void * ) pxDescriptor;
+								if( xSendEventStructToIPTask( &xIPStackEvent, ( TickType_t ) 0 ) == pdFAIL )
 								{
-									if( xBridge_Process( pxDescriptor ) == pdFAIL )
-									{
-										/* The Bridge could not process the descriptor,
-										it must be released. */
-										vReleaseNetworkBufferAndDescriptor( pxDescriptor );
-										iptraceETHERNET_RX_EVENT_LOST();
-									}
+									/* Could not send the descriptor into the TCP/IP
+									stack, it must be released. */
+									vReleaseNetworkBufferAndDescriptor( pxDescriptor );
+									iptraceETHERNET_RX_EVENT_LOST();
 								}
 								else
-							#endif
 								{
-									/* Pass the data to the TCP/IP task for processing. */
-									xIPStackEvent.eEventType = eNetworkRxEvent;
-									xIPStackEvent.pvData = ( void * ) pxDescriptor;
-									if( xSendEventStructToIPTask( &xIPStackEvent, xDescriptorWaitTime ) == pdFAIL )
-									{
-										/* Could not send the descriptor into the TCP/IP
-										stack, it must be released. */
-										vReleaseNetworkBufferAndDescriptor( pxDescriptor );
-										iptraceETHERNET_RX_EVENT_LOST();
-									}
-									else
-									{
-										iptraceNETWORK_INTERFACE_RECEIVE();
-
-										/* The data that was available at the top of this
-										loop has been sent, so is no longer available. */
-									}
+									iptraceNETWORK_INTERFACE_RECEIVE();
+
+									/* The data that was available at the top of this
+									loop has been sent, so is no longer available. */
 								}
 							}
 						}
 						else
 						{
+							/* No network buffer to replace the one in the
+							descriptor, the frame is dropped. */
+							ulRxNoBufferCount++;
+							ipNETWORK_BUFFER_STARVED( eNetworkBufferOwnerEthernet );
 							iptraceETHERNET_RX_EVENT_LOST();
 						}
 					}
@@ -768,6 +1133,29 @@ IPStackEvent_t xIPStackEvent;
 					/* Release the DMA descriptor. */
 					Chip_ENET_IncRXConsumeIndex( LPC_ETHERNET );
 				}
+
+				/* Top up the reserve for the next burst. */
+				prvRefillRxReserve();
+
+				if( Chip_ENET_IsRxEmpty(LPC_ETHERNET) )
+				{
+					/* The ring is drained, re-arm the RX interrupt which was
+					masked by the ISR.  A frame that completed just before is
+					caught by looking at the ring once more. */
+					taskENTER_CRITICAL();
+					{
+						Chip_ENET_ClearIntStatus( LPC_ETHERNET, ENET_INT_RXDONE );
+						Chip_ENET_EnableInt( LPC_ETHERNET, ENET_INT_RXDONE );
+					}
+					taskEXIT_CRITICAL();
+					xRxPolling = ( Chip_ENET_IsRxEmpty(LPC_ETHERNET) ) ? pdFALSE : pdTRUE;
+				}
+				else
+				{
+					/* The ring is hot, keep polling with the RX interrupt
+					masked. */
+					xRxPolling = pdTRUE;
+				}
 			} /* ENET_INT_RXDONE */
 			if ( ( ulNotificationValue & ENET_INT_TXDONE ) != 0x00 )
 			{
@@ -777,22 +1165,18 @@ IPStackEvent_t xIPStackEvent;
 				{
 					#if( ipconfigZERO_COPY_TX_DRIVER != 0 )
 					{
-						/* Obtain the associated network buffer to release it. */
-						pxDescriptor = pxPacketBuffer_to_NetworkBuffer( ( uint8_t * ) xDMATxDescriptors[ ulTxCleanupIndex ].Packet );
-						/* This zero-copy driver makes sure that every 'xDMARxDescriptors' contains
-						a reference to a Network Buffer at any time.
-						In case it runs out of Network Buffers, a DMA buffer won't be replaced,
-						and the received messages is dropped. */
-						configASSERT( pxDescriptor != NULL );
-
-						vReleaseNetworkBufferAndDescriptor( pxDescriptor ) ;
+						/* Only the last descriptor of a frame refers to the
+						Network Buffer, the others point to its fragments. */
+						pxDescriptor = pxTxDescriptorBuffers[ ulTxCleanupIndex ];
+						if( pxDescriptor != NULL )
+						{
+							vReleaseNetworkBufferAndDescriptor( pxDescriptor ) ;
+							pxTxDescriptorBuffers[ ulTxCleanupIndex ] = NULL;
+						}
 						xDMATxDescriptors[ ulTxCleanupIndex ].Packet = ( uint32_t )0u;
 					}
 					#endif /* ipconfigZERO_COPY_TX_DRIVER */
 
-					/* Tell the counting semaphore that one more TX descriptor is available. */
-					xSemaphoreGive( xTXDescriptorSemaphore );
-
 					/* Advance to the next descriptor, wrapping if necessary */
 					++ulTxCleanupIndex;
 					if( ulTxCleanupIndex >= ipconfigNUM_TX_DESCRIPTORS )
@@ -801,6 +1185,20 @@ IPStackEvent_t xIPStackEvent;
 					}
 				}
 			}
+			if ( ( ulNotificationValue & ( ENET_INT_TXDONE | EMAC_TX_START_EVENT ) ) != 0x00 )
+			{
+				/* Hand waiting frames to the free TX descriptors. */
+				prvEMACTransmit( pxInterface );
+
+				xTxRetry = pdFALSE;
+				if( ( uxNetworkBufferRingCount( &xTXRing ) != 0 ) &&
+					( pxNetworkBufferRingPeek( &xTXRing ) == NULL ) )
+				{
+					/* Frames were counted but their slots are not filled
+					yet, the producer will not notify again. */
+					xTxRetry = pdTRUE;
+				}
+			}
 		}
 
 	}
@@ -820,15 +1218,23 @@ uint32_t ulInterrupts;
 	/* RX done interrupt. */
 	if( ( ulInterrupts & ENET_INT_RXDONE ) != 0x00 )
 	{
+		/* The task polls the ring until it is empty and then enables the
+		interrupt again, so there is one interrupt per burst. */
+		Chip_ENET_DisableInt( LPC_ETHERNET, ENET_INT_RXDONE );
 		xTaskNotifyFromISR( xEMACTaskHandle, ENET_INT_RXDONE, eSetBits, &xHigherPriorityTaskWoken );
 	}
+	/* RX overrun, the DMA found no free descriptor. */
+	if( ( ulInterrupts & ENET_INT_RXOVERRUN ) != 0x00 )
+	{
+		ulRxOverrunCount++;
+	}
 	/* TX done interrupt. */
 	if( ( ulInterrupts & ENET_INT_TXDONE ) != 0x00 )
 	{
 		xTaskNotifyFromISR( xEMACTaskHandle, ENET_INT_TXDONE, eSetBits, &xHigherPriorityTaskWoken );
 	}
 
-	// TODO: Handle Error interrupts like ENET_INT_RXOVERRUN and ENET_INT_RXERROR
+	// TODO: Handle Error interrupts like ENET_INT_RXERROR
 
 	/* Clear pending interrupts. */
 	Chip_ENET_ClearIntStatus(LPC_ETHERNET, ulInterrupts);
@@ -855,5 +1261,12 @@ is declared static or global, and that it will remain to exist. */
 	pxInterface->pfOutput			= xLPC1758_NetworkInterfaceOutput;
 	pxInterface->pfGetPhyLinkStatus = xLPC1758_GetPhyLinkStatus;
 
+	#if( ipconfigMAX_TX_FRAGMENTS != 0 )
+	{
+		/* Fragments are mapped onto consecutive TX DMA descriptors. */
+		pxInterface->bits.bTxFragments = 1;
+	}
+	#endif
+
 	return pxInterface;
 }
@@ -107,12 +107,23 @@ the task can be notified when new packets arrive. */
 static TaskHandle_t xGreenPHYTaskHandle = NULL;
 SemaphoreHandle_t xGreenPHY_DMASemaphore;
 
+#ifndef GREENPHY_TX_MAX_PENDING
+	/* Frames waiting for the QCA7k write buffer which are accepted before
+	pfOutput reports failure, so PLC upload cannot occupy all network
+	buffers.  Control traffic is not limited. */
+	#define GREENPHY_TX_MAX_PENDING	( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS / 2 )
+#endif
+
+/* Storage of the TX descriptor rings. */
+static NetworkBufferDescriptor_t *pxTxQueueStorage[ QCAGP_NO_OF_QUEUES ][ QCAGP_TX_QUEUE_LEN ];
+
 /*-----------------------------------------------------------*/
 
 extern void qcaspi_spi_thread(void *data);
 BaseType_t xQCA7000_NetworkInterfaceInitialise( NetworkInterface_t *pxInterface )
 {
 BaseType_t xReturn = pdPASS;
+BaseType_t xQueue;
 #if( ipconfigREAD_MAC_FROM_GREENPHY != 0 )
 	NetworkEndPoint_t *pxEndPoint;
 	NetworkBufferDescriptor_t *pxDescriptor;
@@ -126,9 +137,18 @@ BaseType_t xReturn = pdPASS;
 		Chip_GPDMA_Init(LPC_GPDMA);
 		Board_SSP_Init(LPC_SSP0, true);
 
+	#if( ipconfigBRIDGE_LATENCY_STATS != 0 )
+		/* The cycle counter time stamps frames for the bridge statistics. */
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	#endif
+
 		qca.SSPx = LPC_SSP0;
 		qca.sync = QCASPI_SYNC_UNKNOWN;
-		qca.txQueue = xQueueCreate( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, sizeof( NetworkBufferDescriptor_t *) );
+		for( xQueue = 0; xQueue < QCAGP_NO_OF_QUEUES; xQueue++ )
+		{
+			xNetworkBufferRingInit( &qca.txQueues[ xQueue ], pxTxQueueStorage[ xQueue ], QCAGP_TX_QUEUE_LEN );
+		}
 		qca.rx_desc = NULL;
 
 		qca.pxInterface = pxInterface;
@@ -196,10 +216,70 @@ BaseType_t xReturn = pdPASS;
 
 BaseType_t xQCA7000_NetworkInterfaceOutput( NetworkInterface_t *pxInterface, NetworkBufferDescriptor_t * const pxDescriptor, BaseType_t bReleaseAfterSend )
 {
+BaseType_t xReturn = pdFAIL;
+BaseType_t xWasEmpty = pdFALSE;
+uint8_t ucQueue;
+
+	/* Control traffic must not wait behind bulk transfers. */
+	ucQueue = qcaspi_classify_frame( pxDescriptor );
+
+	if( qca.sync != QCASPI_SYNC_READY )
+	{
+		/* The QCA7k is not synchronised, frames would only be flushed. */
+		xReturn = pdFAIL;
+	}
+	else if( ( ucQueue != QCAGP_CONTROL_QUEUE ) && ( qcaspi_txq_pending( &qca ) >= GREENPHY_TX_MAX_PENDING ) )
+	{
+		/* The write buffer does not keep up, push back. */
+		xReturn = pdFAIL;
+	}
+	else
+	{
+		/* Before the push, the SPI task may send and release it at once. */
+		ipNETWORK_BUFFER_SET_OWNER( pxDescriptor, eNetworkBufferOwnerPLC );
+		xReturn = xNetworkBufferRingPush( &qca.txQueues[ ucQueue ], pxDescriptor, &xWasEmpty );
+	}
+
+	if( xReturn == pdPASS )
+	{
+		if( xWasEmpty != pdFALSE )
+		{
+			/* The SPI task drains the queue until it is empty, so it only
+			needs to be woken for the first frame. */
+			xTaskNotify( xGreenPHYTaskHandle, QCAGP_TX_FLAG, eSetBits );
+		}
+	}
+	else
+	{
+		/* The frame could not be queued, drop it. */
+		qca.tx_queue_dropped[ ucQueue ]++;
+		qca.stats.tx_dropped++;
+		if( bReleaseAfterSend != pdFALSE )
+		{
+			vReleaseNetworkBufferAndDescriptor( pxDescriptor );
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQCA7000_GetTxQueueStats( UBaseType_t uxQueue, UBaseType_t *puxDepth, uint32_t *pulDropped )
+{
 BaseType_t xReturn = pdFAIL;
 
-	xReturn = xQueueSend(qca.txQueue, ( void * ) &pxDescriptor, 0);
-	xTaskNotify( xGreenPHYTaskHandle, QCAGP_TX_FLAG, eSetBits );
+	if( ( uxQueue < QCAGP_NO_OF_QUEUES ) && ( qca.txQueues[ uxQueue ].ppxItems != NULL ) )
+	{
+		if( puxDepth != NULL )
+		{
+			*puxDepth = uxNetworkBufferRingCount( &qca.txQueues[ uxQueue ] );
+		}
+		if( pulDropped != NULL )
+		{
+			*pulDropped = qca.tx_queue_dropped[ uxQueue ];
+		}
+		xReturn = pdPASS;
+	}
 
 	return xReturn;
 }
@@ -37,7 +37,7 @@ NetworkBufferDescriptor_t *qcaspi_create_get_sw_version_mme( NetworkInterface_t
 	unsigned char my_mac_address[] = { 0x00, 0xB0, 0x52, 0xA0, 0xB0, 0xC0 };
 
 
-	pxDescriptor = pxGetNetworkBufferWithDescriptor( ipTOTAL_ETHERNET_FRAME_SIZE, xDescriptorWaitTime );
+	pxDescriptor = pxGetNetworkBufferWithDescriptor( usSize, xDescriptorWaitTime );
 	if( pxDescriptor != NULL )
 	{
 		pxDescriptor->xDataLength = usSize;
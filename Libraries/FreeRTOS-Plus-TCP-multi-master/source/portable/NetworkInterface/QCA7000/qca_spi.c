@@ -34,6 +34,7 @@
  *--------------------------------------------------------------------*/
 /* Standard includes. */
 #include <stdint.h>
+#include <string.h>
 
 /* LPCOpen includes */
 #include "board.h"
@@ -60,13 +61,82 @@
 #include "qca_framing.h"
 #include "qca_7k.h"
 
+#include "qca_vs_mme.h"
+
 #if( ipconfigREAD_MAC_FROM_GREENPHY != 0 )
 	#include "mme_handler.h"
 #endif
 
 /**********************************************************************/
+#ifndef GREENPHY_RX_BURST_MODE
+	/* Read all bytes the QCA7k has available with a single SPI transfer
+	and decode the frames from a staging buffer, instead of reading each
+	header, frame and footer with a transfer of its own. */
+	#define GREENPHY_RX_BURST_MODE	1
+#endif
+
+#ifndef GREENPHY_RX_BURST_LEN
+	/* Size of the RX staging buffer. The rest of a frame which does
+	not fit in is read directly into the network buffer, together with
+	the bytes behind it, so every frame costs one transfer at most. */
+	#define GREENPHY_RX_BURST_LEN	512
+#endif
+
+#ifndef GREENPHY_TX_BATCH_FRAMES
+	/* Maximum number of frames written to the QCA7k with a single
+	SPI write command. */
+	#define GREENPHY_TX_BATCH_FRAMES	8
+#endif
+
+#ifndef GREENPHY_SIMPLE_QOS
+	/* TX frames are always sorted into one queue per channel access
+	priority, which the driver serves in strict priority order.  This
+	option also tags them with the host queue ID, so the QCA7k sends
+	them with the matching CAP.  Only enable it when the firmware of the
+	QCA7k runs in QoS mode (set in its PIB): otherwise it does not expect
+	the QID in front of the frame, and the driver can not find out at
+	run time. */
+	#define GREENPHY_SIMPLE_QOS	0
+#endif
+
+#if( GREENPHY_SIMPLE_QOS != 0 )
+	#define QCASPI_TX_HEADER_LEN	( QCAFRM_HEADER_LEN + QCAFRM_QID_LEN )
+#else
+	#define QCASPI_TX_HEADER_LEN	QCAFRM_HEADER_LEN
+#endif
+
+/* QCA7k buffer space used by one frame besides its payload */
+#define QCASPI_TX_OVERHEAD	( QCASPI_TX_HEADER_LEN + QCAFRM_FOOTER_LEN )
+
+#ifndef GREENPHY_TX_WATERMARK
+	/* The write buffer watermark interrupt fires as soon as the used space
+	drops below this level, i.e. when a frame of maximum size fits again. */
+	#define GREENPHY_TX_WATERMARK	( QCASPI_HW_BUF_LEN - ( QCAFRM_ETHMAXLEN + QCASPI_TX_OVERHEAD ) )
+#endif
+
 static uint16_t available = 0;
 
+/* Framing and DMA linked list items of a TX batch are read by the
+GPDMA, so they have to be in AHB SRAM. */
+static __attribute__ ((section(".bss.$RAM2")))
+		uint8_t tx_header[GREENPHY_TX_BATCH_FRAMES][QCASPI_TX_HEADER_LEN] __attribute__ ( ( aligned( 4 ) ) );
+static __attribute__ ((section(".bss.$RAM2")))
+		uint8_t tx_footer[QCAFRM_FOOTER_LEN] __attribute__ ( ( aligned( 4 ) ) );
+static __attribute__ ((section(".bss.$RAM2")))
+		DMA_TransferDescriptor_t tx_lli[GREENPHY_TX_BATCH_FRAMES * 3];
+
+#if( GREENPHY_RX_BURST_MODE != 0 )
+	/* The staging buffer is filled by DMA, so it has to be in AHB SRAM. */
+	static __attribute__ ((section(".bss.$RAM2")))
+			uint8_t rx_burst_buffer[GREENPHY_RX_BURST_LEN];
+	/* Linked list items of a read into a network buffer and the staging
+	buffer, for the RX channel and the TX channel that drives the clock. */
+	static __attribute__ ((section(".bss.$RAM2")))
+			DMA_TransferDescriptor_t rx_lli[2];
+	static __attribute__ ((section(".bss.$RAM2")))
+			DMA_TransferDescriptor_t rx_clk_lli[2];
+#endif
+
 /*====================================================================*
  *
  * Disables all SPI interrupts and returns the old value of the
@@ -246,40 +316,268 @@ qcaspi_read_burst(struct qcaspi *qca, uint8_t *dst, uint16_t len)
 	return len;
 }
 
+#if( GREENPHY_RX_BURST_MODE != 0 )
+
+/*====================================================================*
+ *
+ * Sends a read command and then receives len bytes into the buffer
+ * at dst, and the tail_len bytes that follow into the staging buffer,
+ * with a single scatter-gather DMA transfer.
+ *
+ * Returns the number of received bytes.
+ *
+ *--------------------------------------------------------------------*/
+
+uint16_t
+qcaspi_read_burst_split(struct qcaspi *qca, uint8_t *dst, uint16_t len, uint16_t tail_len)
+{
+	DMA_TransferDescriptor_t xFirstTX, xFirstRX;
+	uint16_t total = len + tail_len;
+
+	/* SSP --> dst, then SSP --> staging buffer */
+	Chip_GPDMA_PrepareDescriptor(LPC_GPDMA, &rx_lli[0], GPDMA_CONN_SSP0_Rx, (uint32_t) dst,
+								 len, GPDMA_TRANSFERTYPE_P2M_CONTROLLER_DMA, ( tail_len > 0 ) ? &rx_lli[1] : NULL);
+	Chip_GPDMA_PrepareDescriptor(LPC_GPDMA, &rx_lli[1], GPDMA_CONN_SSP0_Rx, (uint32_t) rx_burst_buffer,
+								 tail_len, GPDMA_TRANSFERTYPE_P2M_CONTROLLER_DMA, NULL);
+
+	/* The dummy data is taken from the same two buffers, so the TX
+	 * channel never reads beyond the end of a buffer */
+	Chip_GPDMA_PrepareDescriptor(LPC_GPDMA, &rx_clk_lli[0], (uint32_t) dst, GPDMA_CONN_SSP0_Tx,
+								 len, GPDMA_TRANSFERTYPE_M2P_CONTROLLER_DMA, ( tail_len > 0 ) ? &rx_clk_lli[1] : NULL);
+	Chip_GPDMA_PrepareDescriptor(LPC_GPDMA, &rx_clk_lli[1], (uint32_t) rx_burst_buffer, GPDMA_CONN_SSP0_Tx,
+								 tail_len, GPDMA_TRANSFERTYPE_M2P_CONTROLLER_DMA, NULL);
+
+	qcaspi_write_register(qca, SPI_REG_BFR_SIZE, total);
+
+	int status = Board_SSP_AssertSSEL(qca->SSPx);
+
+	qcaspi_tx_cmd(qca, (QCA7K_SPI_READ | QCA7K_SPI_EXTERNAL));
+
+	uint8_t channelTX = Chip_GPDMA_GetFreeChannel(LPC_GPDMA, GPDMA_CONN_SSP0_Tx);
+	uint8_t channelRX = Chip_GPDMA_GetFreeChannel(LPC_GPDMA, GPDMA_CONN_SSP0_Rx);
+	registerInterruptHandlerDMA(channelTX, GreenPHY_DMA_IRQHandler);
+	registerInterruptHandlerDMA(channelRX, GreenPHY_DMA_IRQHandler);
+
+	/* Chip_GPDMA_SGTransfer() expects the connection ID in the first
+	 * descriptor, the linked items carry the real SSP address. */
+	xFirstTX = rx_clk_lli[0];
+	xFirstTX.dst = GPDMA_CONN_SSP0_Tx;
+	xFirstRX = rx_lli[0];
+	xFirstRX.src = GPDMA_CONN_SSP0_Rx;
+
+	Chip_GPDMA_SGTransfer(LPC_GPDMA, channelTX, &xFirstTX, GPDMA_TRANSFERTYPE_M2P_CONTROLLER_DMA);
+	Chip_GPDMA_SGTransfer(LPC_GPDMA, channelRX, &xFirstRX, GPDMA_TRANSFERTYPE_P2M_CONTROLLER_DMA);
+
+	Chip_SSP_DMA_Enable(qca->SSPx);
+	/* wait for DMA to complete, only the last item of each channel
+	 * raises an interrupt */
+	xSemaphoreTake( xGreenPHY_DMASemaphore, portMAX_DELAY );
+	xSemaphoreTake( xGreenPHY_DMASemaphore, portMAX_DELAY );
+	Chip_SSP_DMA_Disable(qca->SSPx);
+
+	/* stop DMA transfer and free the channels */
+	Chip_GPDMA_Stop(LPC_GPDMA, channelTX);
+	Chip_GPDMA_Stop(LPC_GPDMA, channelRX);
+
+	if (status) Board_SSP_DeassertSSEL(qca->SSPx);
+
+	available -= total;
+
+	return total;
+}
+
+#endif /* GREENPHY_RX_BURST_MODE */
+
 /*====================================================================*
  *
- * Transmits an buffer in burst mode.
+ * Transmits a batch of frames in burst mode. All frames, each with
+ * its own QCA header and footer, are sent behind a single write
+ * command using one scatter-gather DMA transfer.
  *
- * Returns number of transmitted bytes, 0 on failure.
+ * Returns number of transmitted bytes including framing, 0 on failure.
  *
  *--------------------------------------------------------------------*/
 
 uint16_t
-qcaspi_tx_frame(struct qcaspi *qca, NetworkBufferDescriptor_t * txBuffer)
+qcaspi_tx_batch(struct qcaspi *qca, NetworkBufferDescriptor_t **txBuffers, uint8_t *qids, uint16_t count)
 {
-	uint16_t writtenBytes = 0;
-
-	uint8_t* pucData = txBuffer->pucEthernetBuffer;
-	uint16_t len = txBuffer->xDataLength;
-	uint16_t pad_len;
-	if (len < QCAFRM_ETHMINLEN) {
-		pad_len = QCAFRM_ETHMINLEN - len;
-		memset(pucData+len, 0, pad_len);
-		len += pad_len;
+	DMA_TransferDescriptor_t xFirst;
+	DMA_TransferDescriptor_t *pxLLI = tx_lli;
+	uint16_t total = 0;
+	uint16_t i;
+
+	QcaFrmCreateFooter(tx_footer);
+
+	for (i = 0; i < count; i++)
+	{
+		uint8_t* pucData = txBuffers[i]->pucEthernetBuffer;
+		uint16_t len = txBuffers[i]->xDataLength;
+		uint16_t pad_len;
+		if (len < QCAFRM_ETHMINLEN) {
+			pad_len = QCAFRM_ETHMINLEN - len;
+			/* only the bytes behind the frame are touched, the descriptor
+			 * may be shared with another interface */
+			memset(pucData+len, 0, pad_len);
+			len += pad_len;
+		}
+
+	#if( GREENPHY_SIMPLE_QOS != 0 )
+		/* the QID is part of the frame as seen by the QCA7k */
+		QcaFrmCreateHeader(tx_header[i], len + QCAFRM_QID_LEN, QCAGP_QOS_PROTOCOL_VERSION);
+		QcaFrmAddQID(&tx_header[i][QCAFRM_HEADER_LEN], qids[i]);
+	#else
+		( void ) qids;
+		QcaFrmCreateHeader(tx_header[i], len, 0);
+	#endif
+
+		/* header, payload and footer are three linked list items */
+		Chip_GPDMA_PrepareDescriptor(LPC_GPDMA, &pxLLI[0], (uint32_t) tx_header[i], GPDMA_CONN_SSP0_Tx,
+									 QCASPI_TX_HEADER_LEN, GPDMA_TRANSFERTYPE_M2P_CONTROLLER_DMA, &pxLLI[1]);
+		Chip_GPDMA_PrepareDescriptor(LPC_GPDMA, &pxLLI[1], (uint32_t) pucData, GPDMA_CONN_SSP0_Tx,
+									 len, GPDMA_TRANSFERTYPE_M2P_CONTROLLER_DMA, &pxLLI[2]);
+		Chip_GPDMA_PrepareDescriptor(LPC_GPDMA, &pxLLI[2], (uint32_t) tx_footer, GPDMA_CONN_SSP0_Tx,
+									 QCAFRM_FOOTER_LEN, GPDMA_TRANSFERTYPE_M2P_CONTROLLER_DMA,
+									 ( i + 1 < count ) ? &pxLLI[3] : NULL);
+		pxLLI += 3;
+		total += len + QCASPI_TX_OVERHEAD;
 	}
 
 	int status = Board_SSP_AssertSSEL(qca->SSPx);
-	qcaspi_write_register(qca, SPI_REG_BFR_SIZE, len + QCAFRM_FRAME_OVERHEAD);
+	qcaspi_write_register(qca, SPI_REG_BFR_SIZE, total);
 	if (status) Board_SSP_DeassertSSEL(qca->SSPx);
 
 	status = Board_SSP_AssertSSEL(qca->SSPx);
 
-	/* send ethernet packet via DMA to SPI */
-	writtenBytes = qcaspi_write_burst(qca, pucData, len);
+	qcaspi_tx_cmd(qca, QCA7K_SPI_WRITE | QCA7K_SPI_EXTERNAL);
+
+	/* Get a free DMA channel and register the interrupt handler */
+	uint8_t channel = Chip_GPDMA_GetFreeChannel(LPC_GPDMA, GPDMA_CONN_SSP0_Tx);
+	registerInterruptHandlerDMA(channel, GreenPHY_DMA_IRQHandler);
+
+	/* Chip_GPDMA_SGTransfer() expects the connection ID in the first
+	 * descriptor, the linked items carry the real SSP address. */
+	xFirst = tx_lli[0];
+	xFirst.dst = GPDMA_CONN_SSP0_Tx;
+
+	/* Headers, payloads and footers --> SSP */
+	Chip_GPDMA_SGTransfer(LPC_GPDMA, channel, &xFirst, GPDMA_TRANSFERTYPE_M2P_CONTROLLER_DMA);
+
+	Chip_SSP_DMA_Enable(qca->SSPx);
+	/* wait for DMA to complete */
+	xSemaphoreTake( xGreenPHY_DMASemaphore, portMAX_DELAY );
+	Chip_SSP_DMA_Disable(qca->SSPx);
+
+	/* stop DMA transfer and free the channel */
+	Chip_GPDMA_Stop(LPC_GPDMA, channel);
 
 	if (status) Board_SSP_DeassertSSEL(qca->SSPx);
 
-	return writtenBytes;
+	return total;
+}
+
+/*====================================================================*
+ *
+ * Returns the host queue ID for a frame. Control traffic (ARP, MMEs
+ * and pure TCP ACKs) uses the highest queue, everything else is
+ * mapped from the VLAN PCP or the IP DSCP to a CAP.
+ *
+ *--------------------------------------------------------------------*/
+
+uint8_t
+qcaspi_classify_frame(NetworkBufferDescriptor_t *txBuffer)
+{
+	/* HomePlug AV mapping of 802.1p user priorities to CAPs */
+	static const uint8_t pcp_to_cap[8] = { 1, 0, 0, 1, 2, 2, 3, 3 };
+	const uint8_t *pucData = txBuffer->pucEthernetBuffer;
+	size_t len = txBuffer->xDataLength;
+	size_t offset = ETH_HLEN;
+	size_t ip_len;
+	size_t tcp_len;
+	uint16_t frame_type;
+	int pcp = -1;
+
+	if (len < ETH_HLEN) {
+		return QCAGP_DEFAULT_QUEUE;
+	}
+
+	frame_type = (pucData[12] << 8) | pucData[13];
+	if ((frame_type == 0x8100) && (len >= VLAN_ETH_HLEN)) {
+		pcp = pucData[14] >> 5;
+		frame_type = (pucData[16] << 8) | pucData[17];
+		offset = VLAN_ETH_HLEN;
+	}
+
+	if ((frame_type == 0x0806) || (frame_type == eEtherTypeMME)) {
+		return QCAGP_CONTROL_QUEUE;
+	}
+
+	if ((frame_type == 0x0800) && (len >= offset + 20)) {
+		ip_len = (pucData[offset] & 0x0F) * 4;
+		if ((pucData[offset + 9] == ipPROTOCOL_TCP) && (len >= offset + ip_len + 20)) {
+			/* pure ACK: only the ACK flag is set and there is no payload */
+			tcp_len = (pucData[offset + ip_len + 12] >> 4) * 4;
+			if (((pucData[offset + ip_len + 13] & 0x3F) == 0x10) &&
+				(((pucData[offset + 2] << 8) | pucData[offset + 3]) == ip_len + tcp_len)) {
+				return QCAGP_CONTROL_QUEUE;
+			}
+		}
+		if (pcp < 0) {
+			/* class selector of the DSCP */
+			pcp = pucData[offset + 1] >> 5;
+		}
+	} else if ((frame_type == 0x86DD) && (len >= offset + 2) && (pcp < 0)) {
+		/* class selector of the traffic class */
+		pcp = (pucData[offset] & 0x0F) >> 1;
+	}
+
+	if (pcp < 0) {
+		return QCAGP_BEST_EFFORT_QUEUE;
+	}
+	return pcp_to_cap[pcp];
+}
+
+/*====================================================================*
+ *
+ * Peeks at the next frame to send, serving the queues in strict
+ * priority order.
+ *
+ * Returns the queue ID or -1 if all queues are empty.
+ *
+ *--------------------------------------------------------------------*/
+
+static int
+qcaspi_peek_txq(struct qcaspi *qca, NetworkBufferDescriptor_t **txBuffer)
+{
+	int qid;
+
+	for (qid = QCAGP_NO_OF_QUEUES - 1; qid >= 0; qid--)
+	{
+		*txBuffer = pxNetworkBufferRingPeek(&qca->txQueues[qid]);
+		if( *txBuffer != NULL )
+		{
+			return qid;
+		}
+	}
+	return -1;
+}
+
+/*====================================================================*
+ *
+ * Returns the number of frames waiting in all TX queues.
+ *
+ *--------------------------------------------------------------------*/
+
+UBaseType_t
+qcaspi_txq_pending(struct qcaspi *qca)
+{
+	UBaseType_t pending = 0;
+	int qid;
+
+	for (qid = 0; qid < QCAGP_NO_OF_QUEUES; qid++)
+	{
+		pending += uxNetworkBufferRingCount(&qca->txQueues[qid]);
+	}
+	return pending;
 }
 
 /*====================================================================*
@@ -287,42 +585,211 @@ qcaspi_tx_frame(struct qcaspi *qca, NetworkBufferDescriptor_t * txBuffer)
  * Transmits as many sk_buff's that will fit in
  * the SPI slave write buffer.
  *
+ * The free space of the write buffer is tracked locally. It is only
+ * read back from the QCA7k when the watermark interrupt fired or once
+ * when the local credit is used up, after arming that interrupt.
+ *
  * Returns -1 on failure, 0 on success.
  *
  *--------------------------------------------------------------------*/
 int
 qcaspi_transmit(struct qcaspi *qca)
 {
-	uint16_t available;
+	BaseType_t resynced = pdFALSE;
+	uint16_t required;
+	uint16_t count;
+	uint16_t i;
+	int qid;
 	NetworkBufferDescriptor_t *txBuffer;
+	NetworkBufferDescriptor_t *txBuffers[GREENPHY_TX_BATCH_FRAMES];
+	uint8_t qids[GREENPHY_TX_BATCH_FRAMES];
 
-	/* read the available space in bytes from QCA7k */
-	available = qcaspi_read_register(qca, SPI_REG_WRBUF_SPC_AVA);
-
-	while( xQueuePeek(qca->txQueue, &txBuffer, 0) )
+	while( qcaspi_peek_txq(qca, &txBuffer) >= 0 )
 	{
-		/* check whether there is enough space in the QCA7k buffer to hold
-		 * the next packet */
-		if ( available < (txBuffer->xDataLength + QCAFRM_FRAME_OVERHEAD) )
+		/* collect as many packets as fit in the QCA7k buffer */
+		count = 0;
+		while( ( count < GREENPHY_TX_BATCH_FRAMES ) && ( ( qid = qcaspi_peek_txq(qca, &txBuffer) ) >= 0 ) )
 		{
-			return -1;
+			required = txBuffer->xDataLength;
+			if (required < QCAFRM_ETHMINLEN) {
+				required = QCAFRM_ETHMINLEN;
+			}
+			required += QCASPI_TX_OVERHEAD;
+
+			/* check whether there is enough space in the QCA7k buffer to hold
+			 * the next packet */
+			if ( qca->tx_credit < required )
+			{
+				break;
+			}
+
+			txBuffers[count] = pxNetworkBufferRingPop(&qca->txQueues[qid]);
+			qids[count] = (uint8_t) qid;
+			qca->tx_credit -= required;
+			count++;
 		}
 
-		/* receive and process the next packet */
-		xQueueReceive(qca->txQueue, &txBuffer, 0);
+		if( count == 0 )
+		{
+			if( resynced )
+			{
+				/* QCA7k write buffer is full, wait for the watermark interrupt */
+				return -1;
+			}
+
+			/* Arm the watermark interrupt first, so no drain is missed, then
+			 * look once whether space got free in the meantime. */
+			uint32_t old_intr_enable = qcaspi_read_register(qca, SPI_REG_INTR_ENABLE);
+			qcaspi_write_register(qca, SPI_REG_INTR_ENABLE, old_intr_enable | SPI_INT_WRBUF_BELOW_WM);
 
-		uint16_t writtenBytes = qcaspi_tx_frame(qca, txBuffer);
+			qca->tx_credit = qcaspi_read_register(qca, SPI_REG_WRBUF_SPC_AVA);
+			qca->stats.tx_credit_resyncs++;
+			resynced = pdTRUE;
+			continue;
+		}
 
-		vReleaseNetworkBufferAndDescriptor(txBuffer);
+		qcaspi_tx_batch(qca, txBuffers, qids, count);
+		qca->stats.tx_spi_writes++;
 
-		available -= (writtenBytes + QCAFRM_FRAME_OVERHEAD);
-		qca->stats.tx_packets++;
-		qca->stats.tx_bytes += writtenBytes;
+		for( i = 0; i < count; i++ )
+		{
+			qca->stats.tx_packets++;
+			qca->stats.tx_bytes += txBuffers[i]->xDataLength;
+		#if( ipconfigUSE_BRIDGE != 0 ) && ( ipconfigBRIDGE_LATENCY_STATS != 0 )
+			vBridgeLatencySample( qca->pxInterface, txBuffers[i], DWT->CYCCNT );
+		#endif
+			vReleaseNetworkBufferAndDescriptor(txBuffers[i]);
+		}
 	}
 
 	return 0;
 }
 
+/*====================================================================*
+ *
+ * Allocates the descriptor for the next received frame. A few
+ * buffers are left for the stack, meanwhile the frames wait in
+ * the QCA7k.
+ *
+ *--------------------------------------------------------------------*/
+
+static void
+qcaspi_get_rx_desc(struct qcaspi *qca)
+{
+const TickType_t xDescriptorWaitTime = pdMS_TO_TICKS( 250 );
+const UBaseType_t uxMinimumBuffersRemaining = 2UL;
+
+	/* Only the full sized buffers can take a frame, the small ones do not
+	count. */
+	if( uxGetNumberOfFreeNetworkBuffersOfSize( ipTOTAL_ETHERNET_FRAME_SIZE ) > uxMinimumBuffersRemaining )
+	{
+		qca->rx_desc = pxGetNetworkBufferWithDescriptor(ipTOTAL_ETHERNET_FRAME_SIZE, xDescriptorWaitTime);
+	}
+
+	if( qca->rx_desc != NULL )
+	{
+		ipNETWORK_BUFFER_SET_OWNER( qca->rx_desc, eNetworkBufferOwnerPLC );
+	}
+	else
+	{
+		ipNETWORK_BUFFER_STARVED( eNetworkBufferOwnerPLC );
+	}
+}
+
+/*====================================================================*
+ *
+ * Hands a completely received frame over to the bridge or the
+ * IP task and allocates a new descriptor for the next frame.
+ *
+ *--------------------------------------------------------------------*/
+
+static void
+qcaspi_rx_frame_complete(struct qcaspi *qca)
+{
+IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+
+	qca->stats.rx_packets++;
+	qca->stats.rx_bytes += qca->rx_desc->xDataLength;
+
+	/* Data was received and stored.  Send a message to the IP
+	task to let it know. */
+
+#if( ipconfigREAD_MAC_FROM_GREENPHY != 0 )
+	/* Check if frame is an MME which is handled elsewhere. */
+	if( !filter_rx_mme( qca->rx_desc ) )
+#endif
+	{
+		/* Set the receiving interface */
+		qca->rx_desc->pxInterface = qca->pxInterface;
+	#if( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+	#if( GREENPHY_RX_BURST_MODE == 0 )
+		/* The frame was read by DMA, sum it here so the IP task does not
+		have to. */
+		qca->rx_csum = usGenerateChecksum( 0U, qca->rx_desc->pucEthernetBuffer, qca->rx_desc->xDataLength );
+	#endif
+		vNetworkBufferSetRxChecksum( qca->rx_desc, qca->rx_csum );
+	#endif
+	#if( ipconfigBRIDGE_LATENCY_STATS != 0 )
+		qca->rx_desc->ulRxTimestamp = DWT->CYCCNT;
+	#endif
+	#if( ipconfigUSE_BRIDGE != 0 )
+		if( qca->pxInterface->bits.bIsBridged )
+		{
+			if( xBridge_Process( qca->rx_desc ) == pdPASS )
+			{
+				/* The bridge passed the descriptor to another NetworkInterface. */
+				qca->rx_desc = NULL;
+			}
+			else
+			{
+				/* The bridge could not process the buffer, but there is no need
+				to free it, as the buffer will be reused for the next packet. */
+				qca->stats.rx_dropped++;
+				iptraceETHERNET_RX_EVENT_LOST();
+			}
+		}
+		else
+	#endif
+	#if( ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES == 1 )
+		if( eConsiderFrameForProcessing( qca->rx_desc->pucEthernetBuffer ) != eProcessBuffer )
+		{
+			/* The frame is not for this node, the buffer will be reused
+			for the next packet. */
+			qca->stats.rx_dropped++;
+		}
+		else
+	#endif
+		{
+			/* Pass data up to the IP Task */
+			xRxEvent.pvData = ( void * ) qca->rx_desc;
+			if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 ) == pdPASS )
+			{
+				/* The descriptor was sent into the TCP/IP stack. */
+				qca->rx_desc = NULL;
+			}
+			else
+			{
+				/* Could not send the descriptor into the TCP/IP stack,
+				but there is no need to free it, as the buffer will be
+				reused for the next packet. */
+				qca->stats.rx_dropped++;
+				iptraceETHERNET_RX_EVENT_LOST();
+			}
+		}
+	}
+
+	iptraceNETWORK_INTERFACE_RECEIVE();
+
+	/* Reset the frame handle, so a new header will be read */
+	qca->lFrmHdl.state = QCAFRM_WAIT_AA1;
+
+	if( qca->rx_desc == NULL )
+	{
+		/* Wait for a new buffer */
+		qcaspi_get_rx_desc( qca );
+	}
+}
+
 /*====================================================================*
  *
  * Read the number of bytes available in the SPI slave and
@@ -332,6 +799,148 @@ qcaspi_transmit(struct qcaspi *qca)
  *
  *--------------------------------------------------------------------*/
 
+#if( GREENPHY_RX_BURST_MODE != 0 )
+
+/*====================================================================*
+ *
+ * Walks the staging buffer and decodes as many frames as possible.
+ * Payload bytes are copied in one go, only the framing bytes are
+ * passed through the state machine.
+ *
+ *--------------------------------------------------------------------*/
+
+void
+qcaspi_process_rx_buffer(struct qcaspi *qca)
+{
+int32_t ret;
+uint16_t chunk;
+
+	while( qca->rx_desc && ( qca->rx_buffer_pos < qca->rx_buffer_len ) )
+	{
+		if( QcaFrmGetAction( &qca->lFrmHdl ) == QCAFRM_COPY_FRAME )
+		{
+			chunk = QcaFrmBytesRequired( &qca->lFrmHdl );
+			if( chunk > ( qca->rx_buffer_len - qca->rx_buffer_pos ) )
+			{
+				chunk = qca->rx_buffer_len - qca->rx_buffer_pos;
+			}
+#if( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+			/* The payload passes the CPU anyway, so the checksum is
+			calculated on the way. */
+			qca->rx_csum = usChecksumAddBlock( ( qca->lFrmHdl.offset == 0 ) ? 0U : qca->rx_csum,
+					usGenerateChecksumCopy( 0U, qca->rx_desc->pucEthernetBuffer + qca->lFrmHdl.offset, &rx_burst_buffer[qca->rx_buffer_pos], chunk ),
+					qca->lFrmHdl.offset );
+#else
+			memcpy( qca->rx_desc->pucEthernetBuffer + qca->lFrmHdl.offset, &rx_burst_buffer[qca->rx_buffer_pos], chunk );
+#endif
+			qca->lFrmHdl.offset += chunk;
+			qca->lFrmHdl.state -= chunk;
+			qca->rx_buffer_pos += chunk;
+			continue;
+		}
+
+		ret = QcaFrmFsmDecode( &qca->lFrmHdl, rx_burst_buffer[qca->rx_buffer_pos], qca->rx_desc->pucEthernetBuffer );
+		qca->rx_buffer_pos++;
+		switch( ret )
+		{
+		case QCAFRM_GATHER:
+		case QCAFRM_NOHEAD:
+			break;
+		case QCAFRM_NOTAIL:
+			qca->stats.rx_errors++;
+			qca->stats.rx_dropped++;
+			break;
+		case QCAFRM_INVLEN:
+			qca->stats.rx_errors++;
+			qca->stats.rx_dropped++;
+			break;
+		default:
+			qca->rx_desc->xDataLength = ret;
+			qcaspi_rx_frame_complete( qca );
+			break;
+		}
+	}
+}
+
+int
+qcaspi_receive(struct qcaspi *qca)
+{
+uint16_t len, tail_len;
+
+	/* Allocate rx buffer if we don't have one available. */
+	if (qca->rx_desc == NULL)
+	{
+		qcaspi_get_rx_desc( qca );
+	}
+
+	/* First finish the bytes left over from the previous run. */
+	qcaspi_process_rx_buffer( qca );
+
+	available = qcaspi_read_register(qca, SPI_REG_RDBUF_BYTE_AVA);
+
+	while( qca->rx_desc && ( qca->rx_buffer_pos >= qca->rx_buffer_len ) && ( available > 0 ) )
+	{
+		len = QcaFrmBytesRequired( &qca->lFrmHdl );
+		if( ( QcaFrmGetAction( &qca->lFrmHdl ) == QCAFRM_COPY_FRAME ) &&
+			( len >= GREENPHY_RX_BURST_LEN ) && ( available >= len ) )
+		{
+			/* The rest of a large frame does not fit into the staging
+			buffer, so DMA it directly into the ethernet buffer.  The
+			footer and the frames behind it go into the staging buffer
+			with the same transfer. */
+			tail_len = ( ( available - len ) > GREENPHY_RX_BURST_LEN ) ? GREENPHY_RX_BURST_LEN : ( available - len );
+			qcaspi_read_burst_split( qca, qca->rx_desc->pucEthernetBuffer + qca->lFrmHdl.offset, len, tail_len );
+			qca->lFrmHdl.state -= len;
+#if( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+			qca->rx_csum = usChecksumAddBlock( ( qca->lFrmHdl.offset == 0 ) ? 0U : qca->rx_csum,
+					usGenerateChecksum( 0U, qca->rx_desc->pucEthernetBuffer + qca->lFrmHdl.offset, len ),
+					qca->lFrmHdl.offset );
+#endif
+			qca->lFrmHdl.offset += len;
+			qca->rx_buffer_len = tail_len;
+			qca->rx_buffer_pos = 0;
+			qca->stats.rx_spi_reads++;
+			qca->stats.rx_spi_bytes += len + tail_len;
+
+			qcaspi_process_rx_buffer( qca );
+			continue;
+		}
+
+		if( ( QcaFrmBytesRequired( &qca->lFrmHdl ) == QCAFRM_TOTAL_HEADER_LEN ) && ( available > GREENPHY_RX_BURST_LEN ) )
+		{
+			/* Not everything fits into the staging buffer.  Read the
+			header of the next frame on its own, so that a large frame
+			is read with the single transfer above. */
+			qca->rx_buffer_len = qcaspi_read_blocking( qca, rx_burst_buffer, QCAFRM_TOTAL_HEADER_LEN );
+			qca->rx_buffer_pos = 0;
+			qca->stats.rx_spi_reads++;
+			qca->stats.rx_spi_bytes += QCAFRM_TOTAL_HEADER_LEN;
+
+			qcaspi_process_rx_buffer( qca );
+			continue;
+		}
+
+		/* Read everything the QCA7k has, as far as the staging buffer
+		allows, in a single transfer and decode all frames in it. */
+		len = ( available > GREENPHY_RX_BURST_LEN ) ? GREENPHY_RX_BURST_LEN : available;
+		qca->rx_buffer_len = qcaspi_read_burst( qca, rx_burst_buffer, len );
+		qca->rx_buffer_pos = 0;
+		qca->stats.rx_spi_reads++;
+		qca->stats.rx_spi_bytes += len;
+
+		qcaspi_process_rx_buffer( qca );
+	}
+
+	if( ( available > 0 ) || ( qca->rx_buffer_pos < qca->rx_buffer_len ) )
+	{
+		/* Could not receive all frames. */
+		return -1;
+	}
+	return 0;
+}
+
+#else /* GREENPHY_RX_BURST_MODE */
+
 void
 qcaspi_process_rx_buffer(struct qcaspi *qca)
 {
@@ -364,17 +973,11 @@ int32_t ret;
 int
 qcaspi_receive(struct qcaspi *qca)
 {
-const TickType_t xDescriptorWaitTime = pdMS_TO_TICKS( 250 );
-const UBaseType_t uxMinimumBuffersRemaining = 2UL;
-IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
 
 	/* Allocate rx buffer if we don't have one available. */
 	if (qca->rx_desc == NULL)
 	{
-		if( uxGetNumberOfFreeNetworkBuffers() > uxMinimumBuffersRemaining )
-		{
-			qca->rx_desc = pxGetNetworkBufferWithDescriptor(ipTOTAL_ETHERNET_FRAME_SIZE, xDescriptorWaitTime);
-		}
+		qcaspi_get_rx_desc( qca );
 	}
 
 	available = qcaspi_read_register(qca, SPI_REG_RDBUF_BYTE_AVA);
@@ -387,85 +990,28 @@ IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
 		case QCAFRM_FIND_HEADER:
 			/* Read data of the size of one header. */
 			qca->rx_buffer_len = qcaspi_read_blocking( qca, qca->rx_buffer, QcaFrmBytesRequired( &qca->lFrmHdl ) );
+			qca->stats.rx_spi_reads++;
+			qca->stats.rx_spi_bytes += qca->rx_buffer_len;
 			qcaspi_process_rx_buffer( qca );
 			break;
 
 		case QCAFRM_COPY_FRAME:
 			/* Start DMA read to copy the frame into the ethernet buffer. */
 			qca->lFrmHdl.state -= qcaspi_read_burst(qca, qca->rx_desc->pucEthernetBuffer + qca->lFrmHdl.offset, ( qca->lFrmHdl.len - qca->lFrmHdl.offset ) );
+			qca->stats.rx_spi_reads++;
+			qca->stats.rx_spi_bytes += ( qca->lFrmHdl.len - qca->lFrmHdl.offset );
 			break;
 
 		case QCAFRM_CHECK_FOOTER:
 			/* Read footer. */
 			qca->rx_buffer_len = qcaspi_read_blocking( qca, qca->rx_buffer, QcaFrmBytesRequired( &qca->lFrmHdl ) );
+			qca->stats.rx_spi_reads++;
+			qca->stats.rx_spi_bytes += qca->rx_buffer_len;
 			qcaspi_process_rx_buffer( qca );
 			break;
 
 		case QCAFRM_FRAME_COMPLETE:
-			qca->stats.rx_packets++;
-			qca->stats.rx_bytes += qca->rx_desc->xDataLength;
-
-			/* Data was received and stored.  Send a message to the IP
-			task to let it know. */
-
-		#if( ipconfigREAD_MAC_FROM_GREENPHY != 0 )
-			/* Check if frame is an MME which is handled elsewhere. */
-			if( !filter_rx_mme( qca->rx_desc ) )
-		#endif
-			{
-				/* Set the receiving interface */
-				qca->rx_desc->pxInterface = qca->pxInterface;
-			#if( ipconfigUSE_BRIDGE != 0 )
-				if( qca->pxInterface->bits.bIsBridged )
-				{
-					if( xBridge_Process( qca->rx_desc ) == pdPASS )
-					{
-						/* The bridge passed the descriptor to another NetworkInterface. */
-						qca->rx_desc = NULL;
-					}
-					else
-					{
-						/* The bridge could not process the buffer, but there is no need
-						to free it, as the buffer will be reused for the next packet. */
-						qca->stats.rx_dropped++;
-						iptraceETHERNET_RX_EVENT_LOST();
-					}
-				}
-				else
-			#endif
-				{
-					/* Pass data up to the IP Task */
-					xRxEvent.pvData = ( void * ) qca->rx_desc;
-					if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 ) == pdPASS )
-					{
-						/* The descriptor was sent into the TCP/IP stack. */
-						qca->rx_desc = NULL;
-					}
-					else
-					{
-						/* Could not send the descriptor into the TCP/IP stack,
-						but there is no need to free it, as the buffer will be
-						reused for the next packet. */
-						qca->stats.rx_dropped++;
-						iptraceETHERNET_RX_EVENT_LOST();
-					}
-				}
-			}
-
-			iptraceNETWORK_INTERFACE_RECEIVE();
-
-			/* Reset the frame handle, so a new header will be read */
-			qca->lFrmHdl.state = QCAFRM_WAIT_AA1;
-
-			if( qca->rx_desc == NULL )
-			{
-				/* Wait for a new buffer */
-				if( uxGetNumberOfFreeNetworkBuffers() > uxMinimumBuffersRemaining )
-				{
-					qca->rx_desc = pxGetNetworkBufferWithDescriptor(ipTOTAL_ETHERNET_FRAME_SIZE, xDescriptorWaitTime);
-				}
-			}
-
+			qcaspi_rx_frame_complete( qca );
 			break;
 		}
 	}
@@ -478,6 +1024,8 @@ IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
 	return 0;
 }
 
+#endif /* GREENPHY_RX_BURST_MODE */
+
 /*====================================================================*
  *
  * Flush the tx queue. This function is only safe to
@@ -489,10 +1037,14 @@ void
 qcaspi_flush_txq(struct qcaspi *qca)
 {
 NetworkBufferDescriptor_t * txBuffer = NULL;
+int qid;
 
-	while(xQueueReceive(qca->txQueue,&txBuffer,0))
+	for (qid = 0; qid < QCAGP_NO_OF_QUEUES; qid++)
 	{
-		vReleaseNetworkBufferAndDescriptor(txBuffer);
+		while( ( txBuffer = pxNetworkBufferRingPop(&qca->txQueues[qid]) ) != NULL )
+		{
+			vReleaseNetworkBufferAndDescriptor(txBuffer);
+		}
 	}
 }
 
@@ -526,6 +1078,9 @@ qcaspi_qca7k_sync(struct qcaspi *qca, int event)
 				if (wrbuf_space != QCASPI_HW_BUF_LEN) {
 					qca->sync = QCASPI_SYNC_SOFT_RESET;
 				} else {
+					/* the write buffer is empty, start with full credit */
+					qca->tx_credit = wrbuf_space;
+					qcaspi_write_register(qca, SPI_REG_WRBUF_WATERMARK, GREENPHY_TX_WATERMARK);
 					qca->sync = QCASPI_SYNC_READY;
 					return;
 				}
@@ -551,6 +1106,10 @@ qcaspi_qca7k_sync(struct qcaspi *qca, int event)
 			spi_config = qcaspi_read_register(qca, SPI_REG_SPI_CONFIG);
 			qcaspi_write_register(qca, SPI_REG_SPI_CONFIG, spi_config | QCASPI_SLAVE_RESET_BIT);
 
+			/* drop partially received data */
+			qca->rx_buffer_pos = qca->rx_buffer_len = 0;
+			qca->lFrmHdl.state = QCAFRM_WAIT_AA1;
+
 			qca->sync = QCASPI_SYNC_WAIT_RESET;
 			reset_count = 0;
 			return;
@@ -563,6 +1122,10 @@ qcaspi_qca7k_sync(struct qcaspi *qca, int event)
 			/* ... and release QCA7k from reset */
 			Chip_GPIO_SetPinOutHigh(LPC_GPIO, GREENPHY_RESET_GPIO_PORT, GREENPHY_RESET_GPIO_PIN);
 
+			/* drop partially received data */
+			qca->rx_buffer_pos = qca->rx_buffer_len = 0;
+			qca->lFrmHdl.state = QCAFRM_WAIT_AA1;
+
 			qca->sync = QCASPI_SYNC_WAIT_RESET;
 			reset_count = 0;
 			return;
@@ -625,6 +1188,7 @@ uint32_t intr_enable;
 uint32_t ulNotificationValue;
 TickType_t xSyncRemTime = pdMS_TO_TICKS( GREENPHY_SYNC_LOW_CHECK_TIME_MS );
 BaseType_t available = pdFALSE;
+BaseType_t tx_retry = pdFALSE;
 
 	for ( ;; )
 	{
@@ -647,8 +1211,14 @@ BaseType_t available = pdFALSE;
 			xSyncRemTime = pdMS_TO_TICKS( GREENPHY_SYNC_LOW_CHECK_TIME_MS );
 		}
 
+		if( tx_retry == pdTRUE )
+		{
+			/* A producer has reserved a TX slot but not filled it yet. */
+			xSyncRemTime = 1;
+		}
+
 		ulNotificationValue = ulTaskNotifyTake( pdTRUE, xSyncRemTime );
-		if ( !ulNotificationValue && ( available == pdFALSE ) )
+		if ( !ulNotificationValue && ( available == pdFALSE ) && ( tx_retry == pdFALSE ) )
 		{
 			/* We got a timeout, check if we need to restart sync. */
 			qcaspi_qca7k_sync(qca, QCASPI_SYNC_UPDATE);
@@ -698,6 +1268,9 @@ BaseType_t available = pdFALSE;
 				/* transmit is handled later */
 				/* disable write watermark interrupt */
 				intr_enable &= ~SPI_INT_WRBUF_BELOW_WM;
+				/* resync the TX credit */
+				qca->tx_credit = qcaspi_read_register(qca, SPI_REG_WRBUF_SPC_AVA);
+				qca->stats.tx_credit_resyncs++;
 			}
 
 			qcaspi_write_register(qca, SPI_REG_INTR_CAUSE, ulInterruptCause);
@@ -715,14 +1288,19 @@ BaseType_t available = pdFALSE;
 				}
 			}
 
-			if( uxQueueMessagesWaiting(qca->txQueue) )
+			tx_retry = pdFALSE;
+			if( qcaspi_txq_pending(qca) )
 			{
 				if( qcaspi_transmit(qca) != 0 )
 				{
-					/* QCA7k write buffer is full, but we need to send more packets
-					 * so set watermark interrupt */
-					uint32_t old_intr_enable = qcaspi_read_register(qca, SPI_REG_INTR_ENABLE);
-					qcaspi_write_register(qca, SPI_REG_INTR_ENABLE, old_intr_enable | SPI_INT_WRBUF_BELOW_WM);
+					/* QCA7k write buffer is full, the watermark interrupt
+					 * was set by qcaspi_transmit() */
+				}
+				else if( qcaspi_txq_pending(qca) )
+				{
+					/* Frames were counted but their slots are not filled yet,
+					 * the producer will not notify again. */
+					tx_retry = pdTRUE;
 				}
 			}
 		}
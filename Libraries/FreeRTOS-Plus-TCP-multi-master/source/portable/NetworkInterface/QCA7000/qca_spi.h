@@ -50,6 +50,7 @@
 #include "NetworkBufferManagement.h"
 #include "FreeRTOS_Routing.h"
 #include "FreeRTOS_Bridge.h"
+#include "NetworkBufferRing.h"
 
 
 /*====================================================================*
@@ -81,14 +82,28 @@
 /* Number of TX queues, equals number of CAPs */
 #define QCAGP_NO_OF_QUEUES  4
 
-/* default queue to use, e.g. if SimpleQoS is disabled */
+/* lowest queue, CAP0 */
 #define QCAGP_DEFAULT_QUEUE  0
 
+/* queue for best effort traffic, CAP1 */
+#define QCAGP_BEST_EFFORT_QUEUE  1
+
+/* queue for control traffic like ARP, MMEs and TCP ACKs, CAP3 */
+#define QCAGP_CONTROL_QUEUE  3
+
+/* header protocol version announcing the QID after the header */
+#define QCAGP_QOS_PROTOCOL_VERSION  1
+
 /* Task notification constants */
 #define QCAGP_INT_FLAG (1<<0)
 #define QCAGP_RX_FLAG  (1<<1) /* RX is passed as interrupt, too */
 #define QCAGP_TX_FLAG  (1<<2)
 
+/* Number of frames each TX queue can hold, must be a power of 2 */
+#ifndef QCAGP_TX_QUEUE_LEN
+	#define QCAGP_TX_QUEUE_LEN  16
+#endif
+
 /* Max amount of bytes read in one run */
 #define QCASPI_BURST_LEN ( QCASPI_HW_BUF_LEN + 4 )
 
@@ -106,27 +121,45 @@ struct stats {
 	uint32_t tx_dropped;
 	uint32_t tx_packets;
 	uint32_t tx_bytes;
+	uint32_t rx_spi_reads;
+	uint32_t rx_spi_bytes;
+	uint32_t tx_spi_writes;
+	uint32_t tx_credit_resyncs;
 };
 
 struct qcaspi {
 	LPC_SSP_T* SSPx;
 	uint8_t sync;
 
-	/* the TX queue, simply a FreeRTOS queue */
-	QueueHandle_t txQueue;
+	/* the TX queues, one descriptor ring per CAP, highest QID first */
+	NetworkBufferRing_t txQueues[QCAGP_NO_OF_QUEUES];
+	uint32_t tx_queue_dropped[QCAGP_NO_OF_QUEUES];
+
+	/* free space in the QCA7k write buffer as far as we know */
+	uint16_t tx_credit;
 	NetworkBufferDescriptor_t *rx_desc;
 
+	/* in RX burst mode the positions refer to the staging buffer */
 	uint8_t rx_buffer[QCAFRM_TOTAL_HEADER_LEN];
 	uint16_t rx_buffer_size;
 	uint16_t rx_buffer_pos;
 	uint16_t rx_buffer_len;
 	QcaFrmHdl lFrmHdl;
+#if( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+	/* checksum of the frame bytes received so far */
+	uint16_t rx_csum;
+#endif
 
 	struct stats stats;
 	NetworkInterface_t *pxInterface;
 };
 
 void qcaspi_spi_thread(void *data);
+uint8_t qcaspi_classify_frame(NetworkBufferDescriptor_t *txBuffer);
+UBaseType_t qcaspi_txq_pending(struct qcaspi *qca);
+
+/* Per queue depth and drop counter of the PLC interface. */
+BaseType_t xQCA7000_GetTxQueueStats( UBaseType_t uxQueue, UBaseType_t *puxDepth, uint32_t *pulDropped );
 
 /*====================================================================*
  *
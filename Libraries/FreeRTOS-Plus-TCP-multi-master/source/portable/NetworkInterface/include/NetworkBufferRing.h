@@ -0,0 +1,75 @@
+/*
+ * FreeRTOS+TCP V2.3.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#ifndef NETWORK_BUFFER_RING_H
+
+#define NETWORK_BUFFER_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A ring of Network Buffer pointers which is used to hand descriptors from
+the IP-task (or the bridge) to a driver task without a queue.  Any number
+of tasks may push, exactly one task may peek and pop.  Push and pop are
+lock-free, they use atomic operations ( LDREX/STREX on the Cortex-M3 )
+instead of a critical section.
+
+A slot is reserved first and filled afterwards, so for a short moment the
+consumer may see 'uxNetworkBufferRingCount() != 0' while the slot at the
+tail is still empty.  In that case it should try again a tick later. */
+
+typedef struct xNETWORK_BUFFER_RING
+{
+	NetworkBufferDescriptor_t * volatile *ppxItems;	/* The slots, NULL when free. */
+	uint32_t ulMask;								/* Number of slots minus one. */
+	volatile uint32_t ulHead;						/* Next slot to be reserved by a producer. */
+	volatile uint32_t ulTail;						/* Next slot to be read by the consumer. */
+	volatile uint32_t ulCount;						/* Number of filled slots. */
+} NetworkBufferRing_t;
+
+/* Initialise a ring with 'uxLength' slots in 'ppxStorage'.  'uxLength' must
+be a power of 2. */
+BaseType_t xNetworkBufferRingInit( NetworkBufferRing_t *pxRing, NetworkBufferDescriptor_t **ppxStorage, UBaseType_t uxLength );
+
+/* Add a descriptor to the ring.  Returns pdFAIL if the ring is full.  When
+'pxWasEmpty' is given it will be set to pdTRUE if this descriptor made the
+ring non-empty, which is the only moment the consumer needs to be woken. */
+BaseType_t xNetworkBufferRingPush( NetworkBufferRing_t *pxRing, NetworkBufferDescriptor_t *pxDescriptor, BaseType_t *pxWasEmpty );
+
+/* Return the oldest descriptor without removing it, or NULL. */
+NetworkBufferDescriptor_t *pxNetworkBufferRingPeek( NetworkBufferRing_t *pxRing );
+
+/* Remove and return the oldest descriptor, or NULL. */
+NetworkBufferDescriptor_t *pxNetworkBufferRingPop( NetworkBufferRing_t *pxRing );
+
+/* The number of descriptors in the ring. */
+#define uxNetworkBufferRingCount( pxRing )	( ( UBaseType_t ) ( pxRing )->ulCount )
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
@@ -50,6 +50,26 @@ static void prvReceiveNewClient( TCPServer_t *pxServer, BaseType_t xIndex, Socke
 static char *strnew( const char *pcString );
 /* Remove slashes at the end of a path. */
 static void prvRemoveSlash( char *pcDir );
+/* Get the space for a new client, and release it again. */
+static TCPClient_t *prvClientAlloc( BaseType_t xSize );
+static void prvClientFree( TCPClient_t *pxClient );
+
+#if( ipconfigTCP_SERVER_CLIENTS > 0 )
+	/* The clients are taken from a fixed pool, so that a busy server can not
+	exhaust or fragment the heap.  A slot is free while its fWorkFunction is NULL. */
+	typedef union xTCP_CLIENT_SLOT
+	{
+		TCPClient_t xTCP;
+	#if( ipconfigUSE_HTTP != 0 )
+		HTTPClient_t xHTTP;
+	#endif
+	#if( ipconfigUSE_FTP != 0 )
+		FTPClient_t xFTP;
+	#endif
+	} TCPClientSlot_t;
+
+	static TCPClientSlot_t xClientPool[ ipconfigTCP_SERVER_CLIENTS ];
+#endif
 
 TCPServer_t *FreeRTOS_CreateTCPServer( const struct xSERVER_CONFIG *pxConfigs, BaseType_t xCount )
 {
@@ -178,10 +198,10 @@ const char *pcType = "Unknown";
 	}
 	#endif /* ipconfigUSE_FTP != 0 */
 
-	/* Malloc enough space for a new HTTP-client */
+	/* Get enough space for a new HTTP-client */
 	if( xSize )
 	{
-		pxClient = ( TCPClient_t* ) pvPortMallocLarge( xSize );
+		pxClient = prvClientAlloc( xSize );
 	}
 
 	if( pxClient != NULL )
@@ -259,7 +279,7 @@ BaseType_t xRc;
 			/* Close handles, resources */
 			pxThis->fDeleteFunction( pxThis );
 			/* Free the space */
-			vPortFreeLarge( pxThis );
+			prvClientFree( pxThis );
 		}
 		else
 		{
@@ -269,6 +289,50 @@ BaseType_t xRc;
 }
 /*-----------------------------------------------------------*/
 
+static TCPClient_t *prvClientAlloc( BaseType_t xSize )
+{
+TCPClient_t *pxClient = NULL;
+
+	#if( ipconfigTCP_SERVER_CLIENTS > 0 )
+	{
+	BaseType_t xIndex;
+
+		configASSERT( xSize <= ( BaseType_t ) sizeof( xClientPool[ 0 ] ) );
+
+		for( xIndex = 0; xIndex < ARRAY_SIZE( xClientPool ); xIndex++ )
+		{
+			if( xClientPool[ xIndex ].xTCP.fWorkFunction == NULL )
+			{
+				pxClient = &( xClientPool[ xIndex ].xTCP );
+				break;
+			}
+		}
+	}
+	#else
+	{
+		pxClient = ( TCPClient_t* ) pvPortMallocLarge( xSize );
+	}
+	#endif /* ipconfigTCP_SERVER_CLIENTS */
+
+	return pxClient;
+}
+/*-----------------------------------------------------------*/
+
+static void prvClientFree( TCPClient_t *pxClient )
+{
+	#if( ipconfigTCP_SERVER_CLIENTS > 0 )
+	{
+		/* The slot is free again. */
+		pxClient->fWorkFunction = NULL;
+	}
+	#else
+	{
+		vPortFreeLarge( pxClient );
+	}
+	#endif /* ipconfigTCP_SERVER_CLIENTS */
+}
+/*-----------------------------------------------------------*/
+
 static char *strnew( const char *pcString )
 {
 BaseType_t xLength;
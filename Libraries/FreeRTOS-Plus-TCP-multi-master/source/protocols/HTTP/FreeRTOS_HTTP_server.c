@@ -56,10 +56,14 @@
 #endif
 
 /* Some defines to make the code more readbale */
-#define pcCOMMAND_BUFFER	pxClient->pxParent->pcCommandBuffer
 #define pcNEW_DIR			pxClient->pxParent->pcNewDir
 #define pcFILE_BUFFER		pxClient->pxParent->pcFileBuffer
 
+/* Replies other than files are sent at once: a header and at most one
+pcFileBuffer.  A next request is only handled when the socket has this much
+space. */
+#define httpREPLY_TX_SPACE	( ipconfigTCP_FILE_BUFFER_SIZE + 256 )
+
 #ifndef ipconfigHTTP_REQUEST_CHARACTER
 	#define ipconfigHTTP_REQUEST_CHARACTER		'?'
 #endif
@@ -71,6 +75,13 @@ static const char *pcGetContentsType( const char *apFname );
 static BaseType_t prvOpenURL( HTTPClient_t *pxClient );
 static BaseType_t prvSendFile( HTTPClient_t *pxClient );
 static BaseType_t prvSendReply( HTTPClient_t *pxClient, BaseType_t xCode );
+static void prvSetCork( HTTPClient_t *pxClient, BaseType_t xCork );
+static size_t prvHeaderLength( const char *pcBuffer, size_t uxLength );
+static BaseType_t prvProcessRequest( HTTPClient_t *pxClient, char *pcBuffer, BaseType_t xRc );
+#ifdef ff_fetag
+	static BaseType_t prvNotModified( HTTPClient_t *pxClient );
+	static BaseType_t prvSendNotModified( HTTPClient_t *pxClient );
+#endif
 
 static const char pcEmptyString[1] = { '\0' };
 
@@ -125,6 +136,15 @@ static void prvFileClose( HTTPClient_t *pxClient )
 }
 /*-----------------------------------------------------------*/
 
+/* While a reply is being composed of several FreeRTOS_send() calls, the socket
+is corked: only full segments go out.  Uncorking sends the rest at once, so that
+a short reply travels in a single segment. */
+static void prvSetCork( HTTPClient_t *pxClient, BaseType_t xCork )
+{
+	FreeRTOS_setsockopt( pxClient->xSocket, 0, FREERTOS_SO_SET_FULL_SIZE, ( void * ) &xCork, sizeof( xCork ) );
+}
+/*-----------------------------------------------------------*/
+
 static BaseType_t prvSendReply( HTTPClient_t *pxClient, BaseType_t xCode )
 {
 struct xTCP_SERVER *pxParent = pxClient->pxParent;
@@ -161,21 +181,49 @@ static BaseType_t prvSendFile( HTTPClient_t *pxClient )
 size_t uxSpace;
 size_t uxCount;
 BaseType_t xRc = 0;
+#ifdef ff_fdata
+	const uint8_t *pucData;
+	size_t uxFileSize;
+#endif
+
+	prvSetCork( pxClient, pdTRUE );
 
 	if( pxClient->bits.bReplySent == pdFALSE_UNSIGNED )
 	{
+	#ifdef ff_fheader
+		const char *pcHeader;
+		size_t uxLength;
+	#endif
+
 		pxClient->bits.bReplySent = pdTRUE_UNSIGNED;
 
-		strcpy( pxClient->pxParent->pcContentsType, pcGetContentsType( pxClient->pcCurrentFilename ) );
-		/* _TM_ Content is zipped; added Encoding */
-		snprintf( pxClient->pxParent->pcExtraContents, sizeof( pxClient->pxParent->pcExtraContents ),
-				"Content-Encoding: gzip\r\n"
-				"Content-Length: %d\r\n", ( int ) pxClient->uxBytesLeft );
+	#ifdef ff_fheader
+		/* The file system may have the complete header ready in flash. */
+		pcHeader = ff_fheader( pxClient->pxFileHandle, &uxLength );
+		if( pcHeader != NULL )
+		{
+			xRc = FreeRTOS_send( pxClient->xSocket, ( const void * ) pcHeader, uxLength, FREERTOS_MSG_CONST );
+		}
+		else
+	#endif /* ff_fheader */
+		{
+			strcpy( pxClient->pxParent->pcContentsType, pcGetContentsType( pxClient->pcCurrentFilename ) );
+			/* _TM_ Content is zipped; added Encoding */
+			snprintf( pxClient->pxParent->pcExtraContents, sizeof( pxClient->pxParent->pcExtraContents ),
+					"Content-Encoding: gzip\r\n"
+					"Content-Length: %d\r\n", ( int ) pxClient->uxBytesLeft );
 
-		/* "Requested file action OK". */
-		xRc = prvSendReply( pxClient, WEB_REPLY_OK );
+			/* "Requested file action OK". */
+			xRc = prvSendReply( pxClient, WEB_REPLY_OK );
+		}
 	}
 
+#ifdef ff_fdata
+	/* The file system may keep the file in flash, where the socket can refer
+	to it.  pcFileBuffer is not needed then. */
+	pucData = ff_fdata( pxClient->pxFileHandle, &uxFileSize );
+#endif
+
 	if( xRc >= 0 ) do
 	{
 		uxSpace = FreeRTOS_tx_space( pxClient->xSocket );
@@ -191,14 +239,24 @@ BaseType_t xRc = 0;
 
 		if( uxCount > 0u )
 		{
-			if( uxCount > sizeof( pxClient->pxParent->pcFileBuffer ) )
+		#ifdef ff_fdata
+			if( pucData != NULL )
 			{
-				uxCount = sizeof( pxClient->pxParent->pcFileBuffer );
+				xRc = FreeRTOS_send( pxClient->xSocket, pucData + ( uxFileSize - pxClient->uxBytesLeft ), uxCount, FREERTOS_MSG_CONST );
+				pxClient->uxBytesLeft -= uxCount;
 			}
-			ff_fread( pxClient->pxParent->pcFileBuffer, 1, uxCount, pxClient->pxFileHandle );
-			pxClient->uxBytesLeft -= uxCount;
+			else
+		#endif /* ff_fdata */
+			{
+				if( uxCount > sizeof( pxClient->pxParent->pcFileBuffer ) )
+				{
+					uxCount = sizeof( pxClient->pxParent->pcFileBuffer );
+				}
+				ff_fread( pxClient->pxParent->pcFileBuffer, 1, uxCount, pxClient->pxFileHandle );
+				pxClient->uxBytesLeft -= uxCount;
 
-			xRc = FreeRTOS_send( pxClient->xSocket, pxClient->pxParent->pcFileBuffer, uxCount, 0 );
+				xRc = FreeRTOS_send( pxClient->xSocket, pxClient->pxParent->pcFileBuffer, uxCount, 0 );
+			}
 			if( xRc < 0 )
 			{
 				break;
@@ -208,20 +266,107 @@ BaseType_t xRc = 0;
 
 	if( pxClient->uxBytesLeft == 0u )
 	{
-		/* Writing is ready, no need for further 'eSELECT_WRITE' events. */
+		/* Writing is ready, no need for further 'eSELECT_WRITE' events.
+		A next request may be read now. */
 		FreeRTOS_FD_CLR( pxClient->xSocket, pxClient->pxParent->xSocketSet, eSELECT_WRITE );
+		FreeRTOS_FD_SET( pxClient->xSocket, pxClient->pxParent->xSocketSet, eSELECT_READ );
 		prvFileClose( pxClient );
+		pxClient->eState = eHTTP_RECV;
 	}
 	else
 	{
-		/* Wake up the TCP task as soon as this socket may be written to. */
+		/* Wake up the TCP task as soon as this socket may be written to.  A
+		next request stays in the socket until the file has been sent, it
+		should not wake up the task in the meantime. */
 		FreeRTOS_FD_SET( pxClient->xSocket, pxClient->pxParent->xSocketSet, eSELECT_WRITE );
+		FreeRTOS_FD_CLR( pxClient->xSocket, pxClient->pxParent->xSocketSet, eSELECT_READ );
+		pxClient->eState = eHTTP_SEND;
+	}
+
+	prvSetCork( pxClient, pdFALSE );
+
+	return xRc;
+}
+/*-----------------------------------------------------------*/
+
+#ifdef ff_fetag
+
+/* See if the request has an If-None-Match header that names the ETag of the
+file that was just opened, or '*'. */
+static BaseType_t prvNotModified( HTTPClient_t *pxClient )
+{
+static const char pcIfNoneMatch[] = "If-None-Match:";
+const char *pcETag = ff_fetag( pxClient->pxFileHandle );
+const char *pcLine = pxClient->pcRestData;
+const char *pcEnd;
+size_t uxLength;
+BaseType_t xResult = pdFALSE;
+
+	/* pcRestData points to "HTTP/1.1", followed by the header lines. */
+	while( ( pcETag != NULL ) && ( pcLine != NULL ) )
+	{
+		pcLine = strchr( pcLine, '\n' );
+		if( pcLine == NULL )
+		{
+			break;
+		}
+		pcLine++;
+		if( strncasecmp( pcLine, pcIfNoneMatch, sizeof( pcIfNoneMatch ) - 1 ) != 0 )
+		{
+			continue;
+		}
+
+		pcLine += sizeof( pcIfNoneMatch ) - 1;
+		for( pcEnd = pcLine; ( *pcEnd != '\0' ) && ( *pcEnd != '\r' ) && ( *pcEnd != '\n' ); pcEnd++ )
+		{
+		}
+
+		/* A list of ETags, maybe weak ones: W/"...".  A weak comparison is
+		good enough for If-None-Match. */
+		uxLength = strlen( pcETag );
+		for( ; ( pcLine < pcEnd ) && ( xResult == pdFALSE ); pcLine++ )
+		{
+			if( ( *pcLine == '*' ) ||
+				( ( ( size_t ) ( pcEnd - pcLine ) >= uxLength ) && ( memcmp( pcLine, pcETag, uxLength ) == 0 ) ) )
+			{
+				xResult = pdTRUE;
+			}
+		}
+		break;
+	}
+
+	return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/* The browser has the file already: repeat the validators and the caching
+lines of the reply header, without a body. */
+static BaseType_t prvSendNotModified( HTTPClient_t *pxClient )
+{
+static const char pcStatus[] = "HTTP/1.1 304 Not Modified\r\n";
+const char *pcHeader;
+size_t uxLength;
+BaseType_t xRc;
+
+	pcHeader = ff_fheader304( pxClient->pxFileHandle, &uxLength );
+
+	prvSetCork( pxClient, pdTRUE );
+	xRc = FreeRTOS_send( pxClient->xSocket, pcStatus, sizeof( pcStatus ) - 1, 0 );
+	if( xRc >= 0 )
+	{
+		xRc = FreeRTOS_send( pxClient->xSocket, pcHeader, uxLength, 0 );
 	}
+	prvSetCork( pxClient, pdFALSE );
+
+	pxClient->bits.bReplySent = pdTRUE_UNSIGNED;
+	prvFileClose( pxClient );
 
 	return xRc;
 }
 /*-----------------------------------------------------------*/
 
+#endif /* ff_fetag */
+
 static BaseType_t prvOpenURL( HTTPClient_t *pxClient )
 {
 BaseType_t xRc;
@@ -243,6 +388,7 @@ char pcSlash[ 2 ];
 					"Transfer-Encoding: chunked\r\n"
 					"Content-Length: %d\r\n", ( int ) pxClient->uxBytesLeft );
 
+			prvSetCork( pxClient, pdTRUE );
 			xRc = prvSendReply( pxClient, WEB_REPLY_OK );	/* "Requested file action OK" */
 
 			/* Use a loop to be able to break out on error. */
@@ -265,6 +411,8 @@ char pcSlash[ 2 ];
 
 				break;
 			}
+			prvSetCork( pxClient, pdFALSE );
+
 			/* Although against the coding standard of FreeRTOS, a return is
 			done here  to simplify this conditional code. */
 			return xRc;
@@ -308,7 +456,17 @@ char pcSlash[ 2 ];
 	else
 	{
 		pxClient->uxBytesLeft = ( size_t ) pxClient->pxFileHandle->ulFileSize;
-		xRc = prvSendFile( pxClient );
+	#ifdef ff_fetag
+		if( prvNotModified( pxClient ) != pdFALSE )
+		{
+			/* "304 Not Modified". */
+			xRc = prvSendNotModified( pxClient );
+		}
+		else
+	#endif /* ff_fetag */
+		{
+			xRc = prvSendFile( pxClient );
+		}
 	}
 
 	return xRc;
@@ -346,74 +504,193 @@ BaseType_t xResult = 0;
 }
 /*-----------------------------------------------------------*/
 
-BaseType_t xHTTPClientWork( TCPClient_t *pxTCPClient )
+/* The header of a request ends with an empty line: "\r\n\r\n", or "\n\n" from
+a simple client.  Returns the length of the header including that line, or 0
+when the header is not complete yet. */
+static size_t prvHeaderLength( const char *pcBuffer, size_t uxLength )
 {
-BaseType_t xRc;
-HTTPClient_t *pxClient = ( HTTPClient_t * ) pxTCPClient;
+size_t uxIndex;
+size_t uxResult = 0u;
 
-	if( pxClient->pxFileHandle != NULL )
+	for( uxIndex = 0u; ( uxIndex + 1u < uxLength ) && ( uxResult == 0u ); uxIndex++ )
 	{
-		prvSendFile( pxClient );
+		if( pcBuffer[ uxIndex ] == '\n' )
+		{
+			if( pcBuffer[ uxIndex + 1u ] == '\n' )
+			{
+				uxResult = uxIndex + 2u;
+			}
+			else if( ( uxIndex + 2u < uxLength ) && ( pcBuffer[ uxIndex + 1u ] == '\r' ) && ( pcBuffer[ uxIndex + 2u ] == '\n' ) )
+			{
+				uxResult = uxIndex + 3u;
+			}
+		}
 	}
 
-	xRc = FreeRTOS_recv( pxClient->xSocket, ( void * )pcCOMMAND_BUFFER, sizeof( pcCOMMAND_BUFFER ), 0 );
+	return uxResult;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvProcessRequest( HTTPClient_t *pxClient, char *pcBuffer, BaseType_t xRc )
+{
+BaseType_t xIndex;
+const char *pcEndOfCmd;
+const struct xWEB_COMMAND *curCmd;
 
-	if( xRc > 0 )
+	pcBuffer[ xRc ] = '\0';
+	while( xRc && ( pcBuffer[ xRc - 1 ] == 13 || pcBuffer[ xRc - 1 ] == 10 ) )
 	{
-	BaseType_t xIndex;
-	const char *pcEndOfCmd;
-	const struct xWEB_COMMAND *curCmd;
-	char *pcBuffer = pcCOMMAND_BUFFER;
+		pcBuffer[ --xRc ] = '\0';
+	}
+	pcEndOfCmd = pcBuffer + xRc;
 
-		if( xRc < ( BaseType_t ) sizeof( pcCOMMAND_BUFFER ) )
-		{
-			pcBuffer[ xRc ] = '\0';
-		}
-		while( xRc && ( pcBuffer[ xRc - 1 ] == 13 || pcBuffer[ xRc - 1 ] == 10 ) )
-		{
-			pcBuffer[ --xRc ] = '\0';
-		}
-		pcEndOfCmd = pcBuffer + xRc;
+	curCmd = xWebCommands;
 
-		curCmd = xWebCommands;
+	/* Pointing to "/index.html HTTP/1.1". */
+	pxClient->pcUrlData = pcBuffer;
 
-		/* Pointing to "/index.html HTTP/1.1". */
-		pxClient->pcUrlData = pcBuffer;
+	/* Pointing to "HTTP/1.1". */
+	pxClient->pcRestData = pcEmptyString;
 
-		/* Pointing to "HTTP/1.1". */
-		pxClient->pcRestData = pcEmptyString;
+	/* Last entry is "ECMD_UNK". */
+	for( xIndex = 0; xIndex < WEB_CMD_COUNT - 1; xIndex++, curCmd++ )
+	{
+	BaseType_t xLength;
 
-		/* Last entry is "ECMD_UNK". */
-		for( xIndex = 0; xIndex < WEB_CMD_COUNT - 1; xIndex++, curCmd++ )
+		xLength = curCmd->xCommandLength;
+		if( ( xRc >= xLength ) && ( memcmp( curCmd->pcCommandName, pcBuffer, xLength ) == 0 ) )
 		{
-		BaseType_t xLength;
+		char *pcLastPtr;
 
-			xLength = curCmd->xCommandLength;
-			if( ( xRc >= xLength ) && ( memcmp( curCmd->pcCommandName, pcBuffer, xLength ) == 0 ) )
+			pxClient->pcUrlData += xLength + 1;
+			for( pcLastPtr = (char *)pxClient->pcUrlData; pcLastPtr < pcEndOfCmd; pcLastPtr++ )
 			{
-			char *pcLastPtr;
-
-				pxClient->pcUrlData += xLength + 1;
-				for( pcLastPtr = (char *)pxClient->pcUrlData; pcLastPtr < pcEndOfCmd; pcLastPtr++ )
+				char ch = *pcLastPtr;
+				if( ( ch == '\0' ) || ( strchr( "\n\r \t", ch ) != NULL ) )
 				{
-					char ch = *pcLastPtr;
-					if( ( ch == '\0' ) || ( strchr( "\n\r \t", ch ) != NULL ) )
-					{
-						*pcLastPtr = '\0';
-						pxClient->pcRestData = pcLastPtr + 1;
-						break;
-					}
+					*pcLastPtr = '\0';
+					pxClient->pcRestData = pcLastPtr + 1;
+					break;
 				}
+			}
+			break;
+		}
+	}
+
+	xRc = 0;
+	if( xIndex < WEB_CMD_COUNT - 1 )
+	{
+		xRc = prvProcessCmd( pxClient, xIndex );
+	}
+
+	return xRc;
+}
+/*-----------------------------------------------------------*/
+
+/* Each client is a small state machine, driven by the select() of the server
+task.  In eHTTP_RECV it collects the header of a request in pcRequest, which
+may arrive in pieces, and answers it once it is complete.  When the answer is
+a file that does not fit in the socket at once, it goes to eHTTP_SEND and
+continues sending as soon as there is space.  No call waits, so one task serves
+all clients in turn. */
+BaseType_t xHTTPClientWork( TCPClient_t *pxTCPClient )
+{
+BaseType_t xRc = 0;
+HTTPClient_t *pxClient = ( HTTPClient_t * ) pxTCPClient;
+size_t uxLength;
+size_t uxSpace;
+
+	uxSpace = sizeof( pxClient->pcRequest ) - 1u - pxClient->uxRequestLength;
+
+	/* FreeRTOS_recv() reports a broken connection, but it is not called while
+	sending a file or when pcRequest is full. */
+	if( ( ( pxClient->eState == eHTTP_SEND ) || ( uxSpace == 0u ) ) &&
+		( FreeRTOS_issocketconnected( pxClient->xSocket ) == pdFALSE ) )
+	{
+		xRc = -pdFREERTOS_ERRNO_ENOTCONN;
+	}
+	else if( pxClient->eState == eHTTP_SEND )
+	{
+		xRc = prvSendFile( pxClient );
+	}
+
+	if( ( xRc >= 0 ) && ( pxClient->eState == eHTTP_RECV ) && ( uxSpace > 0u ) )
+	{
+		xRc = FreeRTOS_recv( pxClient->xSocket, ( void * ) ( pxClient->pcRequest + pxClient->uxRequestLength ), uxSpace, 0 );
+		if( xRc > 0 )
+		{
+			pxClient->uxRequestLength += ( size_t ) xRc;
+		}
+	}
+
+	/* A client may send its next request before the answer to the previous
+	one is complete, handle all requests that are present. */
+	while( ( xRc >= 0 ) && ( pxClient->eState == eHTTP_RECV ) && ( pxClient->uxRequestLength > 0u ) )
+	{
+	size_t uxKeep = 0u;
+	char pcTail[ 2 ];
+	char cNext;
+
+		uxLength = prvHeaderLength( pxClient->pcRequest, pxClient->uxRequestLength );
+		if( uxLength == 0u )
+		{
+			if( uxSpace > 0u )
+			{
+				/* Wait for the rest of the header. */
 				break;
 			}
+
+			/* pcRequest is full, but the header did not end.  Use the start of
+			it, the request line, and drop the rest.  Keep the last bytes, they
+			may be the start of the empty line. */
+			uxLength = pxClient->uxRequestLength;
+			uxKeep = sizeof( pcTail );
+			memcpy( pcTail, pxClient->pcRequest + uxLength - uxKeep, uxKeep );
+		}
+
+		if( pxClient->bits.bSkipHeader != pdFALSE_UNSIGNED )
+		{
+			if( uxKeep == 0u )
+			{
+				pxClient->bits.bSkipHeader = pdFALSE_UNSIGNED;
+			}
+		}
+		else if( FreeRTOS_tx_space( pxClient->xSocket ) < httpREPLY_TX_SPACE )
+		{
+			/* The previous replies are still in the socket.  Continue when it
+			has room, until then more requests may wait in the socket. */
+			FreeRTOS_FD_SET( pxClient->xSocket, pxClient->pxParent->xSocketSet, eSELECT_WRITE );
+			FreeRTOS_FD_CLR( pxClient->xSocket, pxClient->pxParent->xSocketSet, eSELECT_READ );
+			break;
+		}
+		else
+		{
+			FreeRTOS_FD_CLR( pxClient->xSocket, pxClient->pxParent->xSocketSet, eSELECT_WRITE );
+			FreeRTOS_FD_SET( pxClient->xSocket, pxClient->pxParent->xSocketSet, eSELECT_READ );
+
+			/* The header gets a terminating zero, which may overwrite the first
+			byte of a next request. */
+			cNext = pxClient->pcRequest[ uxLength ];
+			xRc = prvProcessRequest( pxClient, pxClient->pcRequest, ( BaseType_t ) uxLength );
+			pxClient->pcRequest[ uxLength ] = cNext;
+			if( uxKeep != 0u )
+			{
+				pxClient->bits.bSkipHeader = pdTRUE_UNSIGNED;
+			}
 		}
 
-		if( xIndex < WEB_CMD_COUNT - 1 )
+		/* Remove the header, a next request may follow it. */
+		uxLength -= uxKeep;
+		pxClient->uxRequestLength -= uxLength;
+		memmove( pxClient->pcRequest, pxClient->pcRequest + uxLength, pxClient->uxRequestLength );
+		if( uxKeep != 0u )
 		{
-			xRc = prvProcessCmd( pxClient, xIndex );
+			memcpy( pxClient->pcRequest, pcTail, uxKeep );
 		}
+		uxSpace = sizeof( pxClient->pcRequest ) - 1u - pxClient->uxRequestLength;
 	}
-	else if( xRc < 0 )
+
+	if( xRc < 0 )
 	{
 		/* The connection will be closed and the client will be deleted. */
 		FreeRTOS_printf( ( "xHTTPClientWork: rc = %ld\n", xRc ) );
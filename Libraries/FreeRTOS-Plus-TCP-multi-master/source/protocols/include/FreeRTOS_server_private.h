@@ -45,7 +45,8 @@
  * ipconfigTCP_FILE_BUFFER_SIZE sets the size of:
  *     pcFileBuffer'   : a buffer to access the file system: read or write data.
  *
- * The buffers are both used for FTP as well as HTTP.
+ * The file buffer is used for FTP as well as HTTP, the command buffer only
+ * for FTP.
  */
 
 #ifndef ipconfigTCP_COMMAND_BUFFER_SIZE
@@ -56,6 +57,25 @@
 	#define ipconfigTCP_FILE_BUFFER_SIZE	( 2048 )
 #endif
 
+/*
+ * ipconfigTCP_SERVER_CLIENTS sets the number of clients that the servers can
+ * serve at the same time.  The clients are taken from a static pool of that
+ * size, the backlog of a server should not be larger.  When it is 0, every
+ * client is allocated with pvPortMallocLarge().
+ *
+ * ipconfigHTTP_REQUEST_BUFFER_SIZE sets the size of:
+ *     pcRequest'      : a buffer in each HTTP client to collect the header of
+ *                       a request until it is complete.
+ */
+
+#ifndef ipconfigTCP_SERVER_CLIENTS
+	#define ipconfigTCP_SERVER_CLIENTS	( 0 )
+#endif
+
+#ifndef ipconfigHTTP_REQUEST_BUFFER_SIZE
+	#define ipconfigHTTP_REQUEST_BUFFER_SIZE	ipconfigTCP_COMMAND_BUFFER_SIZE
+#endif
+
 struct xTCP_CLIENT;
 
 typedef BaseType_t ( * FTCPWorkFunction ) ( struct xTCP_CLIENT * /* pxClient */ );
@@ -78,6 +98,13 @@ typedef struct xTCP_CLIENT
 
 } TCPClient_t;
 
+/* The states of an HTTP client, see xHTTPClientWork(). */
+typedef enum
+{
+	eHTTP_RECV = 0,	/* Collecting the header of the next request. */
+	eHTTP_SEND		/* Sending the body of a file, the next request waits. */
+} eHTTPState_t;
+
 struct xHTTP_CLIENT
 {
 	/* This define contains fields which must come first within each of the client structs */
@@ -89,10 +116,14 @@ struct xHTTP_CLIENT
 	char pcCurrentFilename[ ffconfigMAX_FILENAME ];
 	size_t uxBytesLeft;
 	FF_FILE *pxFileHandle;
+	eHTTPState_t eState;
+	size_t uxRequestLength;
+	char pcRequest[ ipconfigHTTP_REQUEST_BUFFER_SIZE ];
 	union {
 		struct {
 			uint32_t
-				bReplySent : 1;
+				bReplySent : 1,
+				bSkipHeader : 1;	/* The header did not fit in pcRequest, drop the rest of it. */
 		};
 		uint32_t ulFlags;
 	} bits;
@@ -163,8 +194,11 @@ BaseType_t xMakeRelative( FTPClient_t *pxClient, char *pcBuffer, BaseType_t xBuf
 struct xTCP_SERVER
 {
 	SocketSet_t xSocketSet;
-	/* A buffer to receive and send TCP commands, either HTTP of FTP. */
-	char pcCommandBuffer[ ipconfigTCP_COMMAND_BUFFER_SIZE ];
+	#if( ipconfigUSE_FTP != 0 )
+		/* A buffer to receive and send FTP commands.  HTTP clients collect
+		their requests in their own pcRequest. */
+		char pcCommandBuffer[ ipconfigTCP_COMMAND_BUFFER_SIZE ];
+	#endif
 	/* A buffer to access the file system: read or write data. */
 	char pcFileBuffer[ ipconfigTCP_FILE_BUFFER_SIZE ];
 
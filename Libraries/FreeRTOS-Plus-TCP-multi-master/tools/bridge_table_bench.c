@@ -0,0 +1,609 @@
+/*
+ * FreeRTOS+TCP V2.3.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+/*
+ * bridge_table_bench.c
+ * Checks the forwarding table of FreeRTOS_Bridge.c against a plain list, and
+ * times its lookup and learning on the host, next to the linear table that the
+ * bridge used before.  See tools/bridge_table_bench.md for further description.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_Routing.h"
+#include "FreeRTOS_Bridge.h"
+
+/* The table has a size of its own, so that the benchmark shows how it scales
+with hundreds of stations.  Build with -DbenchTABLE_ENTRIES=64 to check it with
+the size of the firmware. */
+#ifndef benchTABLE_ENTRIES
+	#define benchTABLE_ENTRIES		1024
+#endif
+
+#undef ipconfigFORWARDING_TABLE_ENTRIES
+#define ipconfigFORWARDING_TABLE_ENTRIES	benchTABLE_ENTRIES
+
+/* The table code is compiled as part of this module, so its static functions
+can be used to check the table. */
+#include "../source/FreeRTOS_Bridge.c"
+
+#if( ipconfigUSE_FORWARDING_TABLE == 0 )
+	#error bridge_table_bench needs ipconfigUSE_FORWARDING_TABLE
+#endif
+
+#define benchMAX_ENTRIES		bridgeTABLE_MAX_USE
+#define benchINTERFACES			3
+
+/* An entry of the reference list. */
+typedef struct xBENCH_ENTRY
+{
+	MACAddress_t xMACAddress;
+	NetworkInterface_t *pxInterface;
+	uint8_t ucAge;
+} BenchEntry_t;
+
+static NetworkInterface_t xInterfaces[ benchINTERFACES ];
+static BenchEntry_t xReference[ ipconfigFORWARDING_TABLE_ENTRIES ];
+static UBaseType_t uxReferenceCount;
+
+/* The linear table, as the bridge had it before the hash table, for the
+comparison of the timing. */
+static BenchEntry_t xLinearTable[ ipconfigFORWARDING_TABLE_ENTRIES ];
+static UBaseType_t uxLinearMaxUse;
+
+static uint32_t ulRandomState = 1U;
+static uint32_t ulErrors;
+
+/* Keeps the compiler from removing the timed lookups. */
+static volatile uintptr_t uxSink;
+
+/* The time that two calls of ullNow() take, in ns. */
+static double dClockCost;
+/*-----------------------------------------------------------*/
+
+void vAssertCalled( const char *pcFile, int lLine )
+{
+	fprintf( stderr, "Assert %s:%d\n", pcFile, lLine );
+	exit( 1 );
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t ulRandom( void )
+{
+	/* xorshift32 */
+	ulRandomState ^= ulRandomState << 13;
+	ulRandomState ^= ulRandomState >> 17;
+	ulRandomState ^= ulRandomState << 5;
+
+	return ulRandomState;
+}
+/*-----------------------------------------------------------*/
+
+/* Station 'ulIndex' of a network: either consecutive addresses of one vendor,
+as a batch of devices would have, or random unicast addresses. */
+static void vMakeMAC( MACAddress_t *pxMAC, uint32_t ulIndex, BaseType_t xRandom )
+{
+	if( xRandom != pdFALSE )
+	{
+	uint32_t ulState = ulRandomState;
+
+		/* The same index always gives the same address. */
+		ulRandomState = ( ulIndex * 0x9E3779B9UL ) ^ 0x5A5A5A5AUL;
+		if( ulRandomState == 0U )
+		{
+			ulRandomState = 1U;
+		}
+		pxMAC->ucBytes[ 0 ] = ( uint8_t ) ( ulRandom() & 0xFEU );
+		pxMAC->ucBytes[ 1 ] = ( uint8_t ) ulRandom();
+		pxMAC->ucBytes[ 2 ] = ( uint8_t ) ulRandom();
+		pxMAC->ucBytes[ 3 ] = ( uint8_t ) ulRandom();
+		pxMAC->ucBytes[ 4 ] = ( uint8_t ) ulRandom();
+		pxMAC->ucBytes[ 5 ] = ( uint8_t ) ulRandom();
+		ulRandomState = ulState;
+	}
+	else
+	{
+		pxMAC->ucBytes[ 0 ] = 0x00U;
+		pxMAC->ucBytes[ 1 ] = 0x0BU;
+		pxMAC->ucBytes[ 2 ] = 0x3BU;
+		pxMAC->ucBytes[ 3 ] = ( uint8_t ) ( ulIndex >> 16 );
+		pxMAC->ucBytes[ 4 ] = ( uint8_t ) ( ulIndex >> 8 );
+		pxMAC->ucBytes[ 5 ] = ( uint8_t ) ulIndex;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void vClearTables( void )
+{
+	memset( xForwardingTable, 0, sizeof( xForwardingTable ) );
+	memset( &xForwardingTableStats, 0, sizeof( xForwardingTableStats ) );
+	memset( xReference, 0, sizeof( xReference ) );
+	uxReferenceCount = 0U;
+	memset( xLinearTable, 0, sizeof( xLinearTable ) );
+	uxLinearMaxUse = 0U;
+}
+/*-----------------------------------------------------------*/
+
+static NetworkInterface_t *pxLinearFind( const MACAddress_t *pxMACAddress )
+{
+UBaseType_t x;
+NetworkInterface_t *pxInterface = NULL;
+
+	for( x = 0U; x < uxLinearMaxUse; x++ )
+	{
+		if( ( xLinearTable[ x ].pxInterface != NULL ) &&
+			( memcmp( xLinearTable[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, ipMAC_ADDRESS_LENGTH_BYTES ) == 0 ) )
+		{
+			pxInterface = xLinearTable[ x ].pxInterface;
+			break;
+		}
+	}
+
+	return pxInterface;
+}
+/*-----------------------------------------------------------*/
+
+static void vLinearRefresh( const MACAddress_t *pxMACAddress, NetworkInterface_t *pxInterface, uint8_t ucAge )
+{
+UBaseType_t xUseEntry, xOldestEntry = 0U;
+uint8_t ucMinAgeFound = 0xFFU;
+
+	for( xUseEntry = 0U; xUseEntry < uxLinearMaxUse; xUseEntry++ )
+	{
+		if( xLinearTable[ xUseEntry ].pxInterface == NULL )
+		{
+			break;
+		}
+		if( memcmp( xLinearTable[ xUseEntry ].xMACAddress.ucBytes, pxMACAddress->ucBytes, ipMAC_ADDRESS_LENGTH_BYTES ) == 0 )
+		{
+			pxMACAddress = NULL;
+			break;
+		}
+		if( xLinearTable[ xUseEntry ].ucAge < ucMinAgeFound )
+		{
+			ucMinAgeFound = xLinearTable[ xUseEntry ].ucAge;
+			xOldestEntry = xUseEntry;
+		}
+	}
+
+	if( xUseEntry == uxLinearMaxUse )
+	{
+		if( xUseEntry == ( UBaseType_t ) ipconfigFORWARDING_TABLE_ENTRIES )
+		{
+			xUseEntry = xOldestEntry;
+		}
+		else
+		{
+			uxLinearMaxUse++;
+		}
+	}
+
+	if( pxMACAddress != NULL )
+	{
+		memcpy( xLinearTable[ xUseEntry ].xMACAddress.ucBytes, pxMACAddress->ucBytes, ipMAC_ADDRESS_LENGTH_BYTES );
+	}
+	xLinearTable[ xUseEntry ].pxInterface = pxInterface;
+	xLinearTable[ xUseEntry ].ucAge = ucAge;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t xReferenceFind( const MACAddress_t *pxMACAddress, UBaseType_t *puxIndex )
+{
+UBaseType_t x;
+
+	for( x = 0U; x < uxReferenceCount; x++ )
+	{
+		if( memcmp( xReference[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, ipMAC_ADDRESS_LENGTH_BYTES ) == 0 )
+		{
+			*puxIndex = x;
+			return pdTRUE;
+		}
+	}
+
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static void vReferenceRemove( UBaseType_t uxIndex )
+{
+	uxReferenceCount--;
+	xReference[ uxIndex ] = xReference[ uxReferenceCount ];
+}
+/*-----------------------------------------------------------*/
+
+/* Every entry of the reference list must be in the table with the same
+interface and age, the table must not hold more, and every entry of the table
+must be reachable from its home slot. */
+static void vCheckTable( const char *pcWhere, uint32_t ulStep )
+{
+UBaseType_t x, uxSlot, uxUsed = 0U;
+
+	for( x = 0U; x < uxReferenceCount; x++ )
+	{
+		if( ( prvFindSlot( &( xReference[ x ].xMACAddress ), &uxSlot ) == pdFALSE ) ||
+			( xForwardingTable[ uxSlot ].pxInterface != xReference[ x ].pxInterface ) ||
+			( xForwardingTable[ uxSlot ].ucAge != xReference[ x ].ucAge ) )
+		{
+			fprintf( stderr, "%s, step %u: entry %u is wrong or missing\n", pcWhere, ( unsigned ) ulStep, ( unsigned ) x );
+			ulErrors++;
+		}
+	}
+
+	for( x = 0U; x < ( UBaseType_t ) ipconfigFORWARDING_TABLE_ENTRIES; x++ )
+	{
+		if( xForwardingTable[ x ].pxInterface != NULL )
+		{
+			uxUsed++;
+			if( ( prvFindSlot( &( xForwardingTable[ x ].xMACAddress ), &uxSlot ) == pdFALSE ) || ( uxSlot != x ) )
+			{
+				fprintf( stderr, "%s, step %u: slot %u can not be reached\n", pcWhere, ( unsigned ) ulStep, ( unsigned ) x );
+				ulErrors++;
+			}
+		}
+	}
+
+	if( ( uxUsed != uxReferenceCount ) || ( uxUsed != xForwardingTableStats.uxEntries ) || ( uxUsed > benchMAX_ENTRIES ) )
+	{
+		fprintf( stderr, "%s, step %u: %u slots used, %u expected, %u counted\n", pcWhere, ( unsigned ) ulStep,
+			( unsigned ) uxUsed, ( unsigned ) uxReferenceCount, ( unsigned ) xForwardingTableStats.uxEntries );
+		ulErrors++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Learns, looks up and ages random stations, and compares the table with
+the reference list after every step.  An eviction must remove exactly one
+entry, and one that is not permanent. */
+static void vFuzz( uint32_t ulSteps, uint32_t ulStations, BaseType_t xRandom )
+{
+uint32_t ulStep, ulEvictions;
+UBaseType_t uxIndex, x, uxRemoved, uxPeriods;
+MACAddress_t xMAC;
+NetworkInterface_t *pxInterface;
+uint8_t ucAge;
+
+	vClearTables();
+
+	for( ulStep = 0U; ( ulStep < ulSteps ) && ( ulErrors == 0U ); ulStep++ )
+	{
+		vMakeMAC( &xMAC, ulRandom() % ulStations, xRandom );
+
+		switch( ulRandom() % 16U )
+		{
+			case 0:
+				/* Age the table. */
+				uxPeriods = 1U + ( ulRandom() % 3U );
+				prvAgeForwardingTable( uxPeriods );
+				for( x = 0U; x < uxReferenceCount; )
+				{
+					if( xReference[ x ].ucAge == INFINITE_FORWARDING_TABLE_AGE )
+					{
+						x++;
+					}
+					else if( xReference[ x ].ucAge <= uxPeriods )
+					{
+						vReferenceRemove( x );
+					}
+					else
+					{
+						xReference[ x ].ucAge -= ( uint8_t ) uxPeriods;
+						x++;
+					}
+				}
+				break;
+
+			case 1:
+			case 2:
+			case 3:
+			case 4:
+			case 5:
+				pxInterface = pxFindInterfaceOnMAC( &xMAC );
+				if( pxInterface != ( xReferenceFind( &xMAC, &uxIndex ) ? xReference[ uxIndex ].pxInterface : NULL ) )
+				{
+					fprintf( stderr, "fuzz, step %u: lookup gives the wrong interface\n", ( unsigned ) ulStep );
+					ulErrors++;
+				}
+				break;
+
+			default:
+				/* Learn, one in 64 entries is permanent. */
+				pxInterface = &( xInterfaces[ ulRandom() % benchINTERFACES ] );
+				ucAge = ( ( ulRandom() % 64U ) == 0U ) ? INFINITE_FORWARDING_TABLE_AGE : ( uint8_t ) ( 1U + ( ulRandom() % 6U ) );
+				ulEvictions = xForwardingTableStats.ulEvictions;
+				vRefreshForwardingTableEntry( &xMAC, pxInterface, ucAge );
+
+				if( xForwardingTableStats.ulEvictions != ulEvictions )
+				{
+					/* Find the entry that was evicted. */
+					uxRemoved = 0U;
+					for( x = 0U; x < uxReferenceCount; )
+					{
+						if( prvFindSlot( &( xReference[ x ].xMACAddress ), &uxIndex ) == pdFALSE )
+						{
+							if( xReference[ x ].ucAge == INFINITE_FORWARDING_TABLE_AGE )
+							{
+								fprintf( stderr, "fuzz, step %u: a permanent entry was evicted\n", ( unsigned ) ulStep );
+								ulErrors++;
+							}
+							vReferenceRemove( x );
+							uxRemoved++;
+						}
+						else
+						{
+							x++;
+						}
+					}
+					if( uxRemoved != 1U )
+					{
+						fprintf( stderr, "fuzz, step %u: eviction removed %u entries\n", ( unsigned ) ulStep, ( unsigned ) uxRemoved );
+						ulErrors++;
+					}
+				}
+
+				if( xReferenceFind( &xMAC, &uxIndex ) != pdFALSE )
+				{
+					xReference[ uxIndex ].pxInterface = pxInterface;
+					xReference[ uxIndex ].ucAge = ucAge;
+				}
+				else if( prvFindSlot( &xMAC, &x ) != pdFALSE )
+				{
+					xReference[ uxReferenceCount ].xMACAddress = xMAC;
+					xReference[ uxReferenceCount ].pxInterface = pxInterface;
+					xReference[ uxReferenceCount ].ucAge = ucAge;
+					uxReferenceCount++;
+				}
+				else if( uxReferenceCount < benchMAX_ENTRIES )
+				{
+					fprintf( stderr, "fuzz, step %u: a station was not learned\n", ( unsigned ) ulStep );
+					ulErrors++;
+				}
+				break;
+		}
+
+		vCheckTable( "fuzz", ulStep );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t ullNow( void )
+{
+struct timespec xTime;
+
+	clock_gettime( CLOCK_MONOTONIC, &xTime );
+
+	return ( ( uint64_t ) xTime.tv_sec * 1000000000U ) + ( uint64_t ) xTime.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static void vCalibrateClock( void )
+{
+uint64_t ullStart, ullTotal = 0U;
+uint32_t ulRound;
+
+	for( ulRound = 0U; ulRound < 10000U; ulRound++ )
+	{
+		ullStart = ullNow();
+		ullTotal += ullNow() - ullStart;
+	}
+	dClockCost = ( double ) ullTotal / 10000.0;
+}
+/*-----------------------------------------------------------*/
+
+/* Times 'ulRounds' rounds over the stations, in ns per operation:
+	hit    : pxFindInterfaceOnMAC() of a known station
+	miss   : pxFindInterfaceOnMAC() of an unknown station
+	insert : learning of a new station, the table holds the stations before
+	         it, from an empty table up to 'uxStations' entries
+	frame  : a bridged frame, lookup of the destination and learning of the
+	         source, which is known already */
+static void vTime( UBaseType_t uxStations, uint32_t ulRounds, BaseType_t xRandom, BaseType_t xLinear, double *pdResults )
+{
+static MACAddress_t xKnown[ ipconfigFORWARDING_TABLE_ENTRIES ];
+static MACAddress_t xUnknown[ ipconfigFORWARDING_TABLE_ENTRIES ];
+UBaseType_t x;
+uint32_t ulRound;
+uint64_t ullStart;
+double dInsert = 0.0;
+double dCount = ( double ) ulRounds * ( double ) uxStations;
+
+	for( x = 0U; x < uxStations; x++ )
+	{
+		vMakeMAC( &( xKnown[ x ] ), x, xRandom );
+		vMakeMAC( &( xUnknown[ x ] ), 0x10000U + x, xRandom );
+	}
+
+	/* The table is cleared before each round, which is not timed.  The last
+	round leaves it filled for the measurements below. */
+	for( ulRound = 0U; ulRound < ulRounds; ulRound++ )
+	{
+		vClearTables();
+
+		ullStart = ullNow();
+		for( x = 0U; x < uxStations; x++ )
+		{
+			if( xLinear != pdFALSE )
+			{
+				vLinearRefresh( &( xKnown[ x ] ), &( xInterfaces[ x % benchINTERFACES ] ), ipconfigMAX_FORWARDING_TABLE_AGE );
+			}
+			else
+			{
+				vRefreshForwardingTableEntry( &( xKnown[ x ] ), &( xInterfaces[ x % benchINTERFACES ] ), ipconfigMAX_FORWARDING_TABLE_AGE );
+			}
+		}
+		dInsert += ( double ) ( ullNow() - ullStart ) - dClockCost;
+	}
+	pdResults[ 3 ] = dInsert / dCount;
+
+	ullStart = ullNow();
+	for( ulRound = 0U; ulRound < ulRounds; ulRound++ )
+	{
+		for( x = 0U; x < uxStations; x++ )
+		{
+			uxSink += ( uintptr_t ) ( ( xLinear != pdFALSE ) ? pxLinearFind( &( xKnown[ x ] ) ) : pxFindInterfaceOnMAC( &( xKnown[ x ] ) ) );
+		}
+	}
+	pdResults[ 0 ] = ( double ) ( ullNow() - ullStart ) / dCount;
+
+	ullStart = ullNow();
+	for( ulRound = 0U; ulRound < ulRounds; ulRound++ )
+	{
+		for( x = 0U; x < uxStations; x++ )
+		{
+			uxSink += ( uintptr_t ) ( ( xLinear != pdFALSE ) ? pxLinearFind( &( xUnknown[ x ] ) ) : pxFindInterfaceOnMAC( &( xUnknown[ x ] ) ) );
+		}
+	}
+	pdResults[ 1 ] = ( double ) ( ullNow() - ullStart ) / dCount;
+
+	ullStart = ullNow();
+	for( ulRound = 0U; ulRound < ulRounds; ulRound++ )
+	{
+		for( x = 0U; x < uxStations; x++ )
+		{
+		UBaseType_t uxSource = ( x + 1U ) % uxStations;
+
+			if( xLinear != pdFALSE )
+			{
+				uxSink += ( uintptr_t ) pxLinearFind( &( xKnown[ x ] ) );
+				vLinearRefresh( &( xKnown[ uxSource ] ), &( xInterfaces[ uxSource % benchINTERFACES ] ), ipconfigMAX_FORWARDING_TABLE_AGE );
+			}
+			else
+			{
+				uxSink += ( uintptr_t ) pxFindInterfaceOnMAC( &( xKnown[ x ] ) );
+				vRefreshForwardingTableEntry( &( xKnown[ uxSource ] ), &( xInterfaces[ uxSource % benchINTERFACES ] ), ipconfigMAX_FORWARDING_TABLE_AGE );
+			}
+		}
+	}
+	pdResults[ 2 ] = ( double ) ( ullNow() - ullStart ) / dCount;
+
+	if( xLinear == pdFALSE )
+	{
+	UBaseType_t uxProbes = 0U;
+
+		/* Average number of slots that a hit looks at. */
+		for( x = 0U; x < ( UBaseType_t ) ipconfigFORWARDING_TABLE_ENTRIES; x++ )
+		{
+			if( xForwardingTable[ x ].pxInterface != NULL )
+			{
+				uxProbes += ( ( x - prvHashMAC( &( xForwardingTable[ x ].xMACAddress ) ) ) & bridgeTABLE_MASK ) + 1U;
+			}
+		}
+		pdResults[ 4 ] = ( double ) uxProbes / ( double ) uxStations;
+	}
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+uint32_t ulSteps = 200000U;
+uint32_t ulRounds = 200000U;
+uint32_t ulStationRounds;
+double dHash[ 5 ], dLinear[ 4 ];
+BaseType_t xRandom;
+UBaseType_t uxStations;
+int iIndex;
+
+	for( iIndex = 1; iIndex + 1 < argc; iIndex += 2 )
+	{
+		uint32_t ulValue = ( uint32_t ) strtoul( argv[ iIndex + 1 ], NULL, 0 );
+
+		switch( argv[ iIndex ][ 1 ] )
+		{
+			case 'f': ulSteps = ulValue; break;
+			case 'n': ulRounds = ulValue; break;
+			case 's': ulRandomState = ( ulValue != 0U ) ? ulValue : 1U; break;
+			default:
+				fprintf( stderr, "Unknown option %s\n", argv[ iIndex ] );
+				return 2;
+		}
+	}
+
+	printf( "%d slots, at most %u entries, eviction window %u\n",
+		ipconfigFORWARDING_TABLE_ENTRIES, ( unsigned ) benchMAX_ENTRIES, ( unsigned ) bridgeEVICTION_WINDOW );
+
+	/* Few stations keep the table sparse, many make it evict all the time. */
+	vFuzz( ulSteps, benchMAX_ENTRIES / 2U, pdFALSE );
+	vFuzz( ulSteps, benchMAX_ENTRIES * 2U, pdFALSE );
+	vFuzz( ulSteps, benchMAX_ENTRIES * 2U, pdTRUE );
+	printf( "fuzz: %u steps, 3 runs, %u errors\n\n", ( unsigned ) ulSteps, ( unsigned ) ulErrors );
+
+	vCalibrateClock();
+
+	for( xRandom = pdFALSE; xRandom <= pdTRUE; xRandom++ )
+	{
+		printf( "%s addresses, ns per operation\n", ( xRandom != pdFALSE ) ? "random" : "consecutive" );
+		printf( "entries  probes   hash: hit   miss insert  frame   linear: hit   miss insert  frame\n" );
+
+		/* 4, 8, 16 ... stations, and last a full table. */
+		for( uxStations = 4U; ; uxStations *= 2U )
+		{
+			if( uxStations > benchMAX_ENTRIES )
+			{
+				uxStations = benchMAX_ENTRIES;
+			}
+			ulStationRounds = ( ulRounds / uxStations > 0U ) ? ( ulRounds / uxStations ) : 1U;
+
+			vTime( uxStations, ulStationRounds, xRandom, pdFALSE, dHash );
+			vTime( uxStations, ulStationRounds, xRandom, pdTRUE, dLinear );
+			printf( "%7u  %6.2f  %10.1f %6.1f %6.1f %6.1f  %12.1f %6.1f %6.1f %6.1f\n", ( unsigned ) uxStations, dHash[ 4 ],
+				dHash[ 0 ], dHash[ 1 ], dHash[ 3 ], dHash[ 2 ], dLinear[ 0 ], dLinear[ 1 ], dLinear[ 3 ], dLinear[ 2 ] );
+
+			if( uxStations == benchMAX_ENTRIES )
+			{
+				break;
+			}
+		}
+		printf( "\n" );
+	}
+
+	if( ulErrors != 0U )
+	{
+		printf( "FAILED\n" );
+		return 1;
+	}
+
+	printf( "OK\n" );
+	return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,313 @@
+/*
+ * FreeRTOS+TCP V2.3.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+/*
+ * net_ring_stress.c
+ * Pushes descriptors from several threads into one NetworkBufferRing_t and
+ * takes them out in a single consumer thread, on the host, to check that none
+ * is lost, doubled or reordered.  See tools/net_ring_stress.md for further
+ * description.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "NetworkBufferRing.h"
+
+/* The ring is compiled as part of this module, with the GCC atomics of the
+host. */
+#include "../source/portable/NetworkInterface/Common/NetworkBufferRing.c"
+
+/* The highest number of producer threads. */
+#define STRESS_MAX_PRODUCERS	16u
+
+/* The longest ring that can be tested. */
+#define STRESS_MAX_RING_LENGTH	64u
+
+/* Descriptors per producer, they are used again once the consumer has
+taken them. */
+#define STRESS_POOL_SIZE		( 2u * STRESS_MAX_RING_LENGTH )
+
+/* The consumer reports a missed wake-up after waiting this long. */
+#define STRESS_WAKE_TIMEOUT_S	2
+
+typedef struct xSTRESS_PRODUCER
+{
+	pthread_t xThread;
+	UBaseType_t uxIndex;
+	NetworkBufferDescriptor_t xPool[ STRESS_POOL_SIZE ];
+	volatile uint32_t ulInUse[ STRESS_POOL_SIZE ];	/* Set by the producer, cleared by the consumer. */
+	uint32_t ulExpected;							/* The next sequence number the consumer expects. */
+	uint32_t ulFull;								/* Pushes that found the ring full. */
+	uint32_t ulWakes;								/* Pushes that made the ring non-empty. */
+} StressProducer_t;
+
+static NetworkBufferRing_t xRing;
+static NetworkBufferDescriptor_t *pxRingStorage[ STRESS_MAX_RING_LENGTH ];
+static StressProducer_t xProducers[ STRESS_MAX_PRODUCERS ];
+
+/* Posted by a producer when its push made the ring non-empty, as a driver
+would notify its task. */
+static sem_t xWakeSemaphore;
+
+/* Test properties, can be changed from the command line. */
+static UBaseType_t uxProducerCount = 4u;
+static UBaseType_t uxRingLength = 8u;
+static uint32_t ulFramesPerProducer = 250000u;
+/*-----------------------------------------------------------*/
+
+void vAssertCalled( const char *pcFile, int lLine )
+{
+	fprintf( stderr, "Assert %s:%d\n", pcFile, lLine );
+	exit( 1 );
+}
+/*-----------------------------------------------------------*/
+
+static void *pvStressProducer( void *pvParameter )
+{
+StressProducer_t *pxProducer = ( StressProducer_t * ) pvParameter;
+NetworkBufferDescriptor_t *pxDescriptor;
+BaseType_t xWasEmpty;
+uint32_t ulSequence, ulSlot;
+
+	for( ulSequence = 0u; ulSequence < ulFramesPerProducer; ulSequence++ )
+	{
+		ulSlot = ulSequence % STRESS_POOL_SIZE;
+
+		/* Wait until the consumer is done with this descriptor. */
+		while( __atomic_load_n( &( pxProducer->ulInUse[ ulSlot ] ), __ATOMIC_ACQUIRE ) != 0u )
+		{
+			sched_yield();
+		}
+
+		pxDescriptor = &( pxProducer->xPool[ ulSlot ] );
+		pxDescriptor->usPort = ( uint16_t ) pxProducer->uxIndex;
+		pxDescriptor->xDataLength = ( size_t ) ulSequence;
+		pxProducer->ulInUse[ ulSlot ] = 1u;
+
+		while( xNetworkBufferRingPush( &xRing, pxDescriptor, &xWasEmpty ) == pdFAIL )
+		{
+			pxProducer->ulFull++;
+			sched_yield();
+		}
+
+		if( xWasEmpty != pdFALSE )
+		{
+			pxProducer->ulWakes++;
+			sem_post( &xWakeSemaphore );
+		}
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+/* Takes all frames out of the ring and checks them, returns the number of
+errors found. */
+static uint32_t ulStressConsume( uint32_t *pulEmptySlots )
+{
+uint64_t ullRemaining = ( uint64_t ) uxProducerCount * ulFramesPerProducer;
+NetworkBufferDescriptor_t *pxPeeked, *pxDescriptor;
+StressProducer_t *pxProducer;
+struct timespec xTimeout;
+uint32_t ulErrors = 0u;
+uint32_t ulSequence;
+
+	while( ullRemaining > 0u )
+	{
+		if( uxNetworkBufferRingCount( &xRing ) == 0u )
+		{
+			clock_gettime( CLOCK_REALTIME, &xTimeout );
+			xTimeout.tv_sec += STRESS_WAKE_TIMEOUT_S;
+
+			if( ( sem_timedwait( &xWakeSemaphore, &xTimeout ) != 0 ) && ( errno == ETIMEDOUT ) )
+			{
+				if( uxNetworkBufferRingCount( &xRing ) == 0u )
+				{
+					fprintf( stderr, "No wake-up while %llu frames are missing\n", ( unsigned long long ) ullRemaining );
+					ulErrors++;
+					break;
+				}
+
+				fprintf( stderr, "Missed a wake-up, %lu frames waiting\n", ( unsigned long ) uxNetworkBufferRingCount( &xRing ) );
+				ulErrors++;
+			}
+
+			continue;
+		}
+
+		if( uxNetworkBufferRingCount( &xRing ) > uxRingLength )
+		{
+			fprintf( stderr, "Count %lu larger than the ring\n", ( unsigned long ) uxNetworkBufferRingCount( &xRing ) );
+			ulErrors++;
+		}
+
+		pxPeeked = pxNetworkBufferRingPeek( &xRing );
+
+		if( pxPeeked == NULL )
+		{
+			/* A producer reserved the slot but did not fill it yet. */
+			( *pulEmptySlots )++;
+			sched_yield();
+			continue;
+		}
+
+		pxDescriptor = pxNetworkBufferRingPop( &xRing );
+
+		if( pxDescriptor != pxPeeked )
+		{
+			fprintf( stderr, "Pop returned another descriptor than peek\n" );
+			ulErrors++;
+		}
+
+		if( ( pxDescriptor == NULL ) || ( pxDescriptor->usPort >= uxProducerCount ) )
+		{
+			fprintf( stderr, "Unknown descriptor %p\n", ( void * ) pxDescriptor );
+			ulErrors++;
+			break;
+		}
+
+		/* Each producer must arrive in its own order, without gaps. */
+		pxProducer = &( xProducers[ pxDescriptor->usPort ] );
+		ulSequence = ( uint32_t ) pxDescriptor->xDataLength;
+
+		if( ulSequence != pxProducer->ulExpected )
+		{
+			fprintf( stderr, "Producer %u: got frame %lu, expected %lu\n",
+				( unsigned ) pxDescriptor->usPort, ( unsigned long ) ulSequence, ( unsigned long ) pxProducer->ulExpected );
+			ulErrors++;
+		}
+
+		pxProducer->ulExpected = ulSequence + 1u;
+		ullRemaining--;
+
+		__atomic_store_n( &( pxProducer->ulInUse[ ulSequence % STRESS_POOL_SIZE ] ), 0u, __ATOMIC_RELEASE );
+
+		if( ulErrors > 10u )
+		{
+			break;
+		}
+	}
+
+	if( ( ulErrors == 0u ) && ( ( uxNetworkBufferRingCount( &xRing ) != 0u ) || ( pxNetworkBufferRingPeek( &xRing ) != NULL ) ) )
+	{
+		fprintf( stderr, "The ring is not empty at the end\n" );
+		ulErrors++;
+	}
+
+	return ulErrors;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+struct timespec xStart, xEnd;
+uint32_t ulErrors, ulEmptySlots = 0u, ulFull = 0u, ulWakes = 0u;
+double dSeconds, dFrames;
+UBaseType_t uxIndex;
+int iIndex;
+
+	for( iIndex = 1; iIndex + 1 < argc; iIndex += 2 )
+	{
+		uint32_t ulValue = ( uint32_t ) strtoul( argv[ iIndex + 1 ], NULL, 0 );
+
+		switch( argv[ iIndex ][ 1 ] )
+		{
+			case 'p': uxProducerCount = ulValue; break;
+			case 'l': uxRingLength = ulValue; break;
+			case 'n': ulFramesPerProducer = ulValue; break;
+			default:
+				fprintf( stderr, "Unknown option %s\n", argv[ iIndex ] );
+				return 2;
+		}
+	}
+
+	if( ( uxProducerCount == 0u ) || ( uxProducerCount > STRESS_MAX_PRODUCERS ) ||
+		( uxRingLength == 0u ) || ( uxRingLength > STRESS_MAX_RING_LENGTH ) ||
+		( ( uxRingLength & ( uxRingLength - 1u ) ) != 0u ) )
+	{
+		fprintf( stderr, "Use 1 to %u producers and a ring length of a power of 2 up to %u\n",
+			STRESS_MAX_PRODUCERS, STRESS_MAX_RING_LENGTH );
+		return 2;
+	}
+
+	xNetworkBufferRingInit( &xRing, pxRingStorage, uxRingLength );
+
+	/* Start close to the wrap of the 32-bit indexes, so that it is tested as
+	well. */
+	xRing.ulHead = 0u - ( 256u * uxRingLength );
+	xRing.ulTail = xRing.ulHead;
+
+	sem_init( &xWakeSemaphore, 0, 0 );
+	clock_gettime( CLOCK_MONOTONIC, &xStart );
+
+	for( uxIndex = 0u; uxIndex < uxProducerCount; uxIndex++ )
+	{
+		xProducers[ uxIndex ].uxIndex = uxIndex;
+		pthread_create( &( xProducers[ uxIndex ].xThread ), NULL, pvStressProducer, &( xProducers[ uxIndex ] ) );
+	}
+
+	ulErrors = ulStressConsume( &ulEmptySlots );
+
+	if( ulErrors != 0u )
+	{
+		/* The producers may be stuck on descriptors that never came back. */
+		printf( "FAILED: %lu errors\n", ( unsigned long ) ulErrors );
+		return 1;
+	}
+
+	for( uxIndex = 0u; uxIndex < uxProducerCount; uxIndex++ )
+	{
+		pthread_join( xProducers[ uxIndex ].xThread, NULL );
+		ulFull += xProducers[ uxIndex ].ulFull;
+		ulWakes += xProducers[ uxIndex ].ulWakes;
+	}
+
+	clock_gettime( CLOCK_MONOTONIC, &xEnd );
+	dSeconds = ( double ) ( xEnd.tv_sec - xStart.tv_sec ) + ( ( double ) ( xEnd.tv_nsec - xStart.tv_nsec ) / 1e9 );
+	dFrames = ( double ) uxProducerCount * ( double ) ulFramesPerProducer;
+
+	printf( "%lu producers, ring of %lu, %lu frames each\n",
+		( unsigned long ) uxProducerCount, ( unsigned long ) uxRingLength, ( unsigned long ) ulFramesPerProducer );
+	printf( "%.0f frames in %.2f s, %.2f M frames/s\n", dFrames, dSeconds, ( dFrames / dSeconds ) / 1e6 );
+	printf( "ring full %lu times, slot not yet filled %lu times, wake-ups %lu\n",
+		( unsigned long ) ulFull, ( unsigned long ) ulEmptySlots, ( unsigned long ) ulWakes );
+	printf( "OK\n" );
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
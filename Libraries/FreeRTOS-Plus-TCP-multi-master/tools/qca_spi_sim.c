@@ -0,0 +1,836 @@
+/*
+ * FreeRTOS+TCP V2.3.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+/*
+ * qca_spi_sim.c
+ * Runs the receive path of the QCA7000 driver ( qca_spi.c ) on the host,
+ * against a model of the SPI registers and the read buffer of the QCA7000, to
+ * count the SPI transactions and bytes per received frame, with and without
+ * GREENPHY_RX_BURST_MODE.  See tools/qca_spi_sim.md for further description.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The driver hands frames to these two, the simulator checks them instead.
+The versions in FreeRTOS_IP.c, which is linked for the checksum routines, are
+not used. */
+#define xSendEventStructToIPTask		xSimSendEventStructToIPTask
+#define eConsiderFrameForProcessing		eSimConsiderFrameForProcessing
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include "task.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_Routing.h"
+#include "NetworkBufferManagement.h"
+
+/* LPCOpen includes. */
+#include "board.h"
+
+/* The driver time-stamps received frames with the cycle counter. */
+static DWT_Type xSimDWT;
+#undef DWT
+#define DWT		( &xSimDWT )
+
+/* The driver is compiled as part of this module, so that it talks to the
+model below instead of the SSP and the GPDMA. */
+#include "../source/portable/NetworkInterface/QCA7000/qca_spi.c"
+#include "../source/portable/NetworkInterface/QCA7000/qca_7k.c"
+#include "../source/portable/NetworkInterface/QCA7000/qca_framing.c"
+#include "../source/portable/NetworkInterface/Common/NetworkBufferRing.c"
+
+/* SPI clock of the GreenPHY module, see Board_SSP_Init(). */
+#define SIM_SPI_CLOCK_HZ		12000000u
+
+/* Read buffer of the QCA7000. */
+#define SIM_READ_BUFFER_LEN		QCASPI_HW_BUF_LEN
+
+/* Bytes in the read buffer per frame besides the frame itself: the length
+in front of it, the header and the footer. */
+#define SIM_FRAME_OVERHEAD		( QCAFRM_TOTAL_HEADER_LEN + QCAFRM_FOOTER_LEN )
+
+/* Network buffers of the simulated stack. */
+#define SIM_BUFFER_COUNT		8u
+
+typedef struct xSIM_COUNTERS
+{
+	uint32_t ulFrames;			/* Frames handed to the IP-task. */
+	uint32_t ulFrameBytes;		/* Their total length. */
+	uint32_t ulTransactions;	/* SSEL assertions. */
+	uint32_t ulWireBytes;		/* Bytes clocked over the SPI bus. */
+	uint32_t ulDMATransfers;	/* GPDMA transfers that read data. */
+	uint32_t ulInterrupts;		/* Interrupts handled. */
+	uint32_t ulReceiveCalls;	/* Calls of qcaspi_receive(). */
+	uint32_t ulErrors;			/* Wrong, lost or badly summed frames, protocol errors. */
+} SimCounters_t;
+
+/* The state of the QCA7000 SPI slave. */
+static uint8_t ucReadBuffer[ SIM_READ_BUFFER_LEN ];
+static uint32_t ulReadHead, ulReadCount;
+static uint16_t usBufferSize;			/* SPI_REG_BFR_SIZE */
+static uint16_t usIntrEnable;			/* SPI_REG_INTR_ENABLE */
+static BaseType_t xSelected;			/* SSEL is low. */
+static uint8_t ucCommand[ 2 ];			/* The command of the current transaction. */
+static uint32_t ulTransactionBytes;		/* Bytes clocked since SSEL went low. */
+static uint16_t usRegisterValue;
+
+/* Frames that were put into the read buffer and are expected by the stack. */
+static uint32_t ulNextSequence, ulExpectedSequence;
+static uint16_t usExpectedLengths[ 256 ];
+
+static SimCounters_t xCounters;
+
+/* The simulated network buffers. */
+static NetworkBufferDescriptor_t xDescriptors[ SIM_BUFFER_COUNT ];
+static uint8_t ucBuffers[ SIM_BUFFER_COUNT ][ ipBUFFER_PADDING + ipTOTAL_ETHERNET_FRAME_SIZE ] __attribute__ ( ( aligned( 4 ) ) );
+static BaseType_t xInUse[ SIM_BUFFER_COUNT ];
+
+static NetworkInterface_t xSimInterface;
+static LPC_SSP_T xSimSSP;
+static struct qcaspi xSimQCA;
+
+SemaphoreHandle_t xGreenPHY_DMASemaphore;
+
+/* Timing model, can be changed from the command line. */
+static uint32_t ulTransactionNs = 2000u;
+static uint32_t ulDMANs = 15000u;
+static uint32_t ulBurstFrames = 4u;
+static uint32_t ulFramesPerRun = 20000u;
+/*-----------------------------------------------------------*/
+
+void vAssertCalled( const char *pcFile, int lLine )
+{
+	fprintf( stderr, "Assert %s:%d\n", pcFile, lLine );
+	exit( 1 );
+}
+/*-----------------------------------------------------------*/
+
+/* The model of the QCA7000 SPI slave.  Every transaction starts with a 16-bit
+command.  Internal commands access a register with the next 16 bits, external
+reads return up to SPI_REG_BFR_SIZE bytes from the read buffer. */
+static void vSimSlaveClock( const uint8_t *pucMOSI, uint8_t *pucMISO, uint32_t ulLength )
+{
+uint32_t ulIndex;
+uint8_t ucOut;
+uint16_t usCommand;
+
+	if( xSelected == pdFALSE )
+	{
+		fprintf( stderr, "Clocked %lu bytes without SSEL\n", ( unsigned long ) ulLength );
+		xCounters.ulErrors++;
+		return;
+	}
+
+	for( ulIndex = 0u; ulIndex < ulLength; ulIndex++ )
+	{
+		ucOut = 0u;
+		usCommand = ( uint16_t ) ( ( ucCommand[ 0 ] << 8 ) | ucCommand[ 1 ] );
+
+		if( ulTransactionBytes < 2u )
+		{
+			ucCommand[ ulTransactionBytes ] = ( pucMOSI != NULL ) ? pucMOSI[ ulIndex ] : 0u;
+		}
+		else if( ( usCommand & QCA7K_SPI_INTERNAL ) != 0u )
+		{
+			uint16_t usRegister = usCommand & 0x3FFFu;
+
+			if( ulTransactionBytes == 2u )
+			{
+				switch( usRegister )
+				{
+					case SPI_REG_RDBUF_BYTE_AVA: usRegisterValue = ( uint16_t ) ulReadCount; break;
+					case SPI_REG_WRBUF_SPC_AVA: usRegisterValue = QCASPI_HW_BUF_LEN; break;
+					case SPI_REG_BFR_SIZE: usRegisterValue = usBufferSize; break;
+					case SPI_REG_INTR_ENABLE: usRegisterValue = usIntrEnable; break;
+					case SPI_REG_INTR_CAUSE: usRegisterValue = ( ulReadCount != 0u ) ? SPI_INT_PKT_AVLBL : 0u; break;
+					case SPI_REG_SIGNATURE: usRegisterValue = QCASPI_GOOD_SIGNATURE; break;
+					default: usRegisterValue = 0u; break;
+				}
+			}
+
+			if( ( usCommand & QCA7K_SPI_READ ) != 0u )
+			{
+				ucOut = ( ulTransactionBytes == 2u ) ? ( uint8_t ) ( usRegisterValue >> 8 ) : ( uint8_t ) usRegisterValue;
+			}
+			else
+			{
+				if( ulTransactionBytes == 2u )
+				{
+					usRegisterValue = ( uint16_t ) ( ( pucMOSI != NULL ) ? ( ( uint32_t ) pucMOSI[ ulIndex ] << 8 ) : 0u );
+				}
+				else
+				{
+					usRegisterValue |= ( pucMOSI != NULL ) ? pucMOSI[ ulIndex ] : 0u;
+
+					if( usRegister == SPI_REG_BFR_SIZE )
+					{
+						usBufferSize = usRegisterValue;
+					}
+					else if( usRegister == SPI_REG_INTR_ENABLE )
+					{
+						usIntrEnable = usRegisterValue;
+					}
+				}
+			}
+		}
+		else if( ( usCommand & QCA7K_SPI_READ ) != 0u )
+		{
+			if( ( ulTransactionBytes - 2u ) >= usBufferSize )
+			{
+				fprintf( stderr, "Read beyond SPI_REG_BFR_SIZE ( %u )\n", ( unsigned ) usBufferSize );
+				xCounters.ulErrors++;
+			}
+			else if( ulReadCount == 0u )
+			{
+				fprintf( stderr, "Read from an empty read buffer\n" );
+				xCounters.ulErrors++;
+			}
+			else
+			{
+				ucOut = ucReadBuffer[ ulReadHead ];
+				ulReadHead = ( ulReadHead + 1u ) % SIM_READ_BUFFER_LEN;
+				ulReadCount--;
+			}
+		}
+
+		if( pucMISO != NULL )
+		{
+			pucMISO[ ulIndex ] = ucOut;
+		}
+
+		ulTransactionBytes++;
+	}
+
+	xCounters.ulWireBytes += ulLength;
+}
+/*-----------------------------------------------------------*/
+
+bool Board_SSP_AssertSSEL( LPC_SSP_T *pSSP )
+{
+	bool xWasHigh = ( xSelected == pdFALSE );
+
+	if( xWasHigh )
+	{
+		xSelected = pdTRUE;
+		ulTransactionBytes = 0u;
+		xCounters.ulTransactions++;
+	}
+
+	return xWasHigh;
+}
+/*-----------------------------------------------------------*/
+
+bool Board_SSP_DeassertSSEL( LPC_SSP_T *pSSP )
+{
+	xSelected = pdFALSE;
+	return true;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t Chip_SSP_RWFrames_Blocking( LPC_SSP_T *pSSP, Chip_SSP_DATA_SETUP_T *xf_setup )
+{
+	vSimSlaveClock( ( const uint8_t * ) xf_setup->tx_data, ( uint8_t * ) xf_setup->rx_data, xf_setup->length );
+	return xf_setup->length;
+}
+/*-----------------------------------------------------------*/
+
+uint8_t Chip_GPDMA_GetFreeChannel( LPC_GPDMA_T *pGPDMA, uint32_t PeripheralConnection_ID )
+{
+	return ( PeripheralConnection_ID == GPDMA_CONN_SSP0_Rx ) ? 1u : 0u;
+}
+/*-----------------------------------------------------------*/
+
+/* The GPDMA takes 32-bit addresses, a host pointer may be longer.  Find the
+buffer that the driver meant: the staging buffer or a network buffer. */
+static uint8_t *pucSimAddress( uint32_t ulAddress, uint32_t ulSize )
+{
+uint8_t *pucAddress = NULL;
+UBaseType_t uxIndex;
+
+	#if( GREENPHY_RX_BURST_MODE != 0 )
+		if( ( ulAddress - ( uint32_t ) ( uintptr_t ) rx_burst_buffer ) + ulSize <= sizeof( rx_burst_buffer ) )
+		{
+			pucAddress = &( rx_burst_buffer[ ulAddress - ( uint32_t ) ( uintptr_t ) rx_burst_buffer ] );
+		}
+	#endif
+
+	for( uxIndex = 0u; ( pucAddress == NULL ) && ( uxIndex < SIM_BUFFER_COUNT ); uxIndex++ )
+	{
+		if( ( ulAddress - ( uint32_t ) ( uintptr_t ) ucBuffers[ uxIndex ] ) + ulSize <= sizeof( ucBuffers[ uxIndex ] ) )
+		{
+			pucAddress = &( ucBuffers[ uxIndex ][ ulAddress - ( uint32_t ) ( uintptr_t ) ucBuffers[ uxIndex ] ] );
+		}
+	}
+
+	if( pucAddress == NULL )
+	{
+		fprintf( stderr, "DMA to unknown address %08lx\n", ( unsigned long ) ulAddress );
+		exit( 1 );
+	}
+
+	return pucAddress;
+}
+/*-----------------------------------------------------------*/
+
+/* The transfer is done at once.  In a read the TX channel only drives the
+clock, the bytes are counted with the RX channel. */
+Status Chip_GPDMA_Transfer( LPC_GPDMA_T *pGPDMA, uint8_t ChannelNum, uint32_t src, uint32_t dst, GPDMA_FLOW_CONTROL_T TransferType, uint32_t Size )
+{
+	if( src == GPDMA_CONN_SSP0_Rx )
+	{
+		vSimSlaveClock( NULL, pucSimAddress( dst, Size ), Size );
+		xCounters.ulDMATransfers++;
+	}
+	else if( ( ucCommand[ 0 ] & ( QCA7K_SPI_READ >> 8 ) ) == 0u )
+	{
+		vSimSlaveClock( pucSimAddress( src, Size ), NULL, Size );
+		xCounters.ulDMATransfers++;
+	}
+
+	return SUCCESS;
+}
+/*-----------------------------------------------------------*/
+
+/* The same for the linked list items of a read, which are also passed as
+32-bit addresses. */
+static const DMA_TransferDescriptor_t *pxSimDescriptor( uint32_t ulAddress )
+{
+const DMA_TransferDescriptor_t *pxDescriptor = NULL;
+
+	#if( GREENPHY_RX_BURST_MODE != 0 )
+		if( ulAddress == ( uint32_t ) ( uintptr_t ) &( rx_lli[ 1 ] ) )
+		{
+			pxDescriptor = &( rx_lli[ 1 ] );
+		}
+	#endif
+
+	if( ( pxDescriptor == NULL ) && ( ulAddress != 0u ) )
+	{
+		fprintf( stderr, "DMA descriptor at unknown address %08lx\n", ( unsigned long ) ulAddress );
+		exit( 1 );
+	}
+
+	return pxDescriptor;
+}
+/*-----------------------------------------------------------*/
+
+/* Only reads are modelled, as one transfer for the whole chain.  The TX
+channel of a read only drives the clock. */
+Status Chip_GPDMA_SGTransfer( LPC_GPDMA_T *pGPDMA, uint8_t ChannelNum, const DMA_TransferDescriptor_t *DMADescriptor, GPDMA_FLOW_CONTROL_T TransferType )
+{
+const DMA_TransferDescriptor_t *pxDescriptor;
+
+	if( DMADescriptor->src != GPDMA_CONN_SSP0_Rx )
+	{
+		return ( ( ucCommand[ 0 ] & ( QCA7K_SPI_READ >> 8 ) ) != 0u ) ? SUCCESS : ERROR;
+	}
+
+	for( pxDescriptor = DMADescriptor; pxDescriptor != NULL; pxDescriptor = pxSimDescriptor( pxDescriptor->lli ) )
+	{
+		vSimSlaveClock( NULL, pucSimAddress( pxDescriptor->dst, pxDescriptor->ctrl ), pxDescriptor->ctrl );
+	}
+	xCounters.ulDMATransfers++;
+
+	return SUCCESS;
+}
+/*-----------------------------------------------------------*/
+
+/* The control word of the model holds the size of the item. */
+Status Chip_GPDMA_PrepareDescriptor( LPC_GPDMA_T *pGPDMA, DMA_TransferDescriptor_t *DMADescriptor, uint32_t src, uint32_t dst, uint32_t Size, GPDMA_FLOW_CONTROL_T TransferType, const DMA_TransferDescriptor_t *NextDescriptor )
+{
+	DMADescriptor->src = src;
+	DMADescriptor->dst = dst;
+	DMADescriptor->lli = ( uint32_t ) ( uintptr_t ) NextDescriptor;
+	DMADescriptor->ctrl = Size;
+
+	return SUCCESS;
+}
+/*-----------------------------------------------------------*/
+
+void Chip_GPDMA_Stop( LPC_GPDMA_T *pGPDMA, uint8_t ChannelNum )
+{
+}
+/*-----------------------------------------------------------*/
+
+Status registerInterruptHandlerDMA( uint8_t ChannelNum, interruptHandlerFunc func )
+{
+	return SUCCESS;
+}
+/*-----------------------------------------------------------*/
+
+Status registerInterruptHandlerGPIO( int port, int pin, interruptHandlerFunc func )
+{
+	return SUCCESS;
+}
+/*-----------------------------------------------------------*/
+
+void GreenPHY_DMA_IRQHandler( portBASE_TYPE *xHigherPriorityTaskWoken )
+{
+}
+/*-----------------------------------------------------------*/
+
+void GreenPHY_GPIO_IRQHandler( portBASE_TYPE *xHigherPriorityTaskWoken )
+{
+}
+/*-----------------------------------------------------------*/
+
+/* The DMA is done by the time the driver waits for it. */
+BaseType_t xQueueSemaphoreTake( QueueHandle_t xQueue, TickType_t xTicksToWait )
+{
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTaskGenericNotifyTake( UBaseType_t uxIndexToWaitOn, BaseType_t xClearCountOnExit, TickType_t xTicksToWait )
+{
+	return 0u;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelay( const TickType_t xTicksToDelay )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vCheckBuffersAndQueue( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t filter_rx_mme( NetworkBufferDescriptor_t *pxDescriptor )
+{
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xBridge_Process( NetworkBufferDescriptor_t *pxDescriptor )
+{
+	return pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+void vBridgeLatencySample( NetworkInterface_t *pxInterface, const NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulNow )
+{
+}
+/*-----------------------------------------------------------*/
+
+eFrameProcessingResult_t eSimConsiderFrameForProcessing( const uint8_t * const pucEthernetBuffer )
+{
+	return eProcessBuffer;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxGetNetworkBufferWithDescriptor( size_t xRequestedSizeBytes, TickType_t xBlockTimeTicks )
+{
+UBaseType_t uxIndex;
+
+	for( uxIndex = 0u; uxIndex < SIM_BUFFER_COUNT; uxIndex++ )
+	{
+		if( xInUse[ uxIndex ] == pdFALSE )
+		{
+			xInUse[ uxIndex ] = pdTRUE;
+			memset( &( xDescriptors[ uxIndex ] ), 0, sizeof( xDescriptors[ uxIndex ] ) );
+			xDescriptors[ uxIndex ].pucEthernetBuffer = &( ucBuffers[ uxIndex ][ ipBUFFER_PADDING ] );
+			xDescriptors[ uxIndex ].xDataLength = xRequestedSizeBytes;
+			return &( xDescriptors[ uxIndex ] );
+		}
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+	xInUse[ pxNetworkBuffer - xDescriptors ] = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxGetNumberOfFreeNetworkBuffers( void )
+{
+UBaseType_t uxIndex, uxFree = 0u;
+
+	for( uxIndex = 0u; uxIndex < SIM_BUFFER_COUNT; uxIndex++ )
+	{
+		uxFree += ( xInUse[ uxIndex ] == pdFALSE ) ? 1u : 0u;
+	}
+
+	return uxFree;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxGetNumberOfFreeNetworkBuffersOfSize( size_t xRequestedSizeBytes )
+{
+	( void ) xRequestedSizeBytes;
+
+	return uxGetNumberOfFreeNetworkBuffers();
+}
+/*-----------------------------------------------------------*/
+
+void vNetworkBufferSetOwner( NetworkBufferDescriptor_t *pxNetworkBuffer, NetworkBufferOwner_t eOwner )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vNetworkBufferStarved( NetworkBufferOwner_t eOwner )
+{
+}
+/*-----------------------------------------------------------*/
+
+static uint16_t usSimChecksum( uint32_t ulSum, const uint8_t *pucData, size_t uxLength )
+{
+size_t uxIndex;
+
+	for( uxIndex = 0u; uxIndex + 1u < uxLength; uxIndex += 2u )
+	{
+		ulSum += ( uint32_t ) ( ( pucData[ uxIndex ] << 8 ) | pucData[ uxIndex + 1u ] );
+	}
+
+	if( ( uxLength & 1u ) != 0u )
+	{
+		ulSum += ( uint32_t ) pucData[ uxLength - 1u ] << 8;
+	}
+
+	while( ( ulSum >> 16 ) != 0u )
+	{
+		ulSum = ( ulSum & 0xFFFFu ) + ( ulSum >> 16 );
+	}
+
+	return ( uint16_t ) ulSum;
+}
+/*-----------------------------------------------------------*/
+
+/* Builds frame 'ulSequence' of 'usLength' bytes: a UDP packet with correct
+checksums, the payload depends on the sequence number. */
+static void vSimMakeFrame( uint8_t *pucFrame, uint16_t usLength, uint32_t ulSequence )
+{
+static const uint8_t ucHeader[ 34 ] =
+{
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x0b, 0x3b, 0x01, 0x02, 0x03, 0x08, 0x00,
+	0x45, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x40, 0x11, 0x00, 0x00,
+	192, 168, 0, 2, 192, 168, 0, 10
+};
+uint16_t usIPLength = ( uint16_t ) ( usLength - ipSIZE_OF_ETH_HEADER );
+uint16_t usUDPLength = ( uint16_t ) ( usIPLength - ipSIZE_OF_IPv4_HEADER );
+uint16_t usSum;
+uint16_t usIndex;
+
+	memcpy( pucFrame, ucHeader, sizeof( ucHeader ) );
+	pucFrame[ 16 ] = ( uint8_t ) ( usIPLength >> 8 );
+	pucFrame[ 17 ] = ( uint8_t ) usIPLength;
+	pucFrame[ 18 ] = ( uint8_t ) ( ulSequence >> 8 );
+	pucFrame[ 19 ] = ( uint8_t ) ulSequence;
+	usSum = ( uint16_t ) ~usSimChecksum( 0u, &( pucFrame[ 14 ] ), ipSIZE_OF_IPv4_HEADER );
+	pucFrame[ 24 ] = ( uint8_t ) ( usSum >> 8 );
+	pucFrame[ 25 ] = ( uint8_t ) usSum;
+
+	/* UDP header and payload. */
+	pucFrame[ 34 ] = 0x27;
+	pucFrame[ 35 ] = 0x10;
+	pucFrame[ 36 ] = 0x27;
+	pucFrame[ 37 ] = 0x11;
+	pucFrame[ 38 ] = ( uint8_t ) ( usUDPLength >> 8 );
+	pucFrame[ 39 ] = ( uint8_t ) usUDPLength;
+	pucFrame[ 40 ] = 0u;
+	pucFrame[ 41 ] = 0u;
+
+	for( usIndex = 42u; usIndex < usLength; usIndex++ )
+	{
+		pucFrame[ usIndex ] = ( uint8_t ) ( ( ulSequence * 7u ) + usIndex );
+	}
+
+	/* Pseudo header: addresses, protocol and UDP length. */
+	usSum = usSimChecksum( ( uint32_t ) ipPROTOCOL_UDP + usUDPLength, &( pucFrame[ 26 ] ), 8u );
+	usSum = ( uint16_t ) ~usSimChecksum( usSum, &( pucFrame[ 34 ] ), usUDPLength );
+	if( usSum == 0u )
+	{
+		usSum = 0xFFFFu;
+	}
+	pucFrame[ 40 ] = ( uint8_t ) ( usSum >> 8 );
+	pucFrame[ 41 ] = ( uint8_t ) usSum;
+}
+/*-----------------------------------------------------------*/
+
+static void vSimPutByte( uint8_t ucByte )
+{
+	ucReadBuffer[ ( ulReadHead + ulReadCount ) % SIM_READ_BUFFER_LEN ] = ucByte;
+	ulReadCount++;
+}
+/*-----------------------------------------------------------*/
+
+/* The QCA7000 received a frame from the powerline: put it into the read
+buffer as it would, with its length, the header and the footer. */
+static BaseType_t xSimReceiveFrame( uint16_t usLength )
+{
+uint8_t ucFrame[ ipTOTAL_ETHERNET_FRAME_SIZE ];
+uint32_t ulHardwareLength = ( uint32_t ) usLength + QCAFRM_FRAME_OVERHEAD;
+uint16_t usIndex;
+
+	if( ( ulReadCount + usLength + SIM_FRAME_OVERHEAD ) > SIM_READ_BUFFER_LEN )
+	{
+		return pdFAIL;
+	}
+
+	vSimMakeFrame( ucFrame, usLength, ulNextSequence );
+	usExpectedLengths[ ulNextSequence & 0xFFu ] = usLength;
+	ulNextSequence++;
+
+	/* The length of the frame, little endian. */
+	vSimPutByte( ( uint8_t ) ulHardwareLength );
+	vSimPutByte( ( uint8_t ) ( ulHardwareLength >> 8 ) );
+	vSimPutByte( 0u );
+	vSimPutByte( 0u );
+
+	for( usIndex = 0u; usIndex < 4u; usIndex++ )
+	{
+		vSimPutByte( 0xAAu );
+	}
+
+	vSimPutByte( ( uint8_t ) usLength );
+	vSimPutByte( ( uint8_t ) ( usLength >> 8 ) );
+	vSimPutByte( 0u );
+	vSimPutByte( 0u );
+
+	for( usIndex = 0u; usIndex < usLength; usIndex++ )
+	{
+		vSimPutByte( ucFrame[ usIndex ] );
+	}
+
+	vSimPutByte( 0x55u );
+	vSimPutByte( 0x55u );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+/* The IP-task: check that the frames arrive complete, in order and with a
+good checksum. */
+BaseType_t xSimSendEventStructToIPTask( const IPStackEvent_t *pxEvent, TickType_t uxTimeout )
+{
+NetworkBufferDescriptor_t *pxDescriptor = ( NetworkBufferDescriptor_t * ) pxEvent->pvData;
+uint8_t ucFrame[ ipTOTAL_ETHERNET_FRAME_SIZE ];
+uint16_t usLength = usExpectedLengths[ ulExpectedSequence & 0xFFu ];
+
+	if( ( pxDescriptor->xDataLength != usLength ) ||
+		( vSimMakeFrame( ucFrame, usLength, ulExpectedSequence ), memcmp( ucFrame, pxDescriptor->pucEthernetBuffer, usLength ) != 0 ) )
+	{
+		fprintf( stderr, "Frame %lu is wrong\n", ( unsigned long ) ulExpectedSequence );
+		xCounters.ulErrors++;
+	}
+
+	#if( ipconfigDRIVER_VERIFIES_RX_CHECKSUM != 0 )
+		if( pxDescriptor->ucRxChecksum != ipRX_CHECKSUM_GOOD )
+		{
+			fprintf( stderr, "Frame %lu: checksum not found good\n", ( unsigned long ) ulExpectedSequence );
+			xCounters.ulErrors++;
+		}
+	#endif
+
+	ulExpectedSequence++;
+	xCounters.ulFrames++;
+	xCounters.ulFrameBytes += usLength;
+	vReleaseNetworkBufferAndDescriptor( pxDescriptor );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+/* Handles one interrupt of the QCA7000 as qcaspi_spi_thread() does. */
+static void vSimInterrupt( void )
+{
+uint32_t ulCause, ulEnable;
+UBaseType_t uxCalls = 0u;
+
+	xCounters.ulInterrupts++;
+
+	ulEnable = disable_spi_interrupts( &xSimQCA );
+	ulCause = qcaspi_read_register( &xSimQCA, SPI_REG_INTR_CAUSE );
+	qcaspi_write_register( &xSimQCA, SPI_REG_INTR_CAUSE, ( uint16_t ) ulCause );
+	enable_spi_interrupts( &xSimQCA, ulEnable );
+
+	if( ( ulCause & SPI_INT_PKT_AVLBL ) != 0u )
+	{
+		while( qcaspi_receive( &xSimQCA ) != 0 )
+		{
+			xCounters.ulReceiveCalls++;
+
+			if( ++uxCalls > 100u )
+			{
+				fprintf( stderr, "qcaspi_receive() does not finish\n" );
+				xCounters.ulErrors++;
+				break;
+			}
+		}
+
+		xCounters.ulReceiveCalls++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Receives 'ulFramesPerRun' frames, 'ulBurstFrames' of them arrive between
+two interrupts.  The lengths are taken from 'pusLengths' in turn. */
+static void vSimRun( const uint16_t *pusLengths, size_t uxLengthCount )
+{
+uint32_t ulSent = 0u;
+uint32_t ulBurst;
+
+	memset( &xCounters, 0, sizeof( xCounters ) );
+	memset( &xSimQCA, 0, sizeof( xSimQCA ) );
+	memset( xInUse, 0, sizeof( xInUse ) );
+	ulReadHead = 0u;
+	ulReadCount = 0u;
+	ulNextSequence = 0u;
+	ulExpectedSequence = 0u;
+
+	xSimQCA.SSPx = &xSimSSP;
+	xSimQCA.sync = QCASPI_SYNC_READY;
+	xSimQCA.pxInterface = &xSimInterface;
+	QcaFrmFsmInit( &( xSimQCA.lFrmHdl ) );
+
+	while( ( ulSent < ulFramesPerRun ) && ( xCounters.ulErrors == 0u ) )
+	{
+		for( ulBurst = 0u; ( ulBurst < ulBurstFrames ) && ( ulSent < ulFramesPerRun ); ulBurst++ )
+		{
+			if( xSimReceiveFrame( pusLengths[ ulSent % uxLengthCount ] ) == pdFAIL )
+			{
+				/* The read buffer is full. */
+				break;
+			}
+
+			ulSent++;
+		}
+
+		vSimInterrupt();
+	}
+
+	if( ( xCounters.ulErrors == 0u ) && ( xCounters.ulFrames != ulFramesPerRun ) )
+	{
+		fprintf( stderr, "%lu frames received out of %lu\n", ( unsigned long ) xCounters.ulFrames, ( unsigned long ) ulFramesPerRun );
+		xCounters.ulErrors++;
+	}
+
+	if( xSimQCA.rx_desc != NULL )
+	{
+		vReleaseNetworkBufferAndDescriptor( xSimQCA.rx_desc );
+	}
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+static const uint16_t usSize60[] = { 60 };
+static const uint16_t usSize128[] = { 128 };
+static const uint16_t usSize256[] = { 256 };
+static const uint16_t usSize590[] = { 590 };
+static const uint16_t usSize1024[] = { 1024 };
+static const uint16_t usSize1514[] = { 1514 };
+static const uint16_t usSizeIMIX[] = { 60, 590, 60, 60, 590, 60, 1514, 60, 590, 60, 590, 60 };
+static const struct
+{
+	const char *pcName;
+	const uint16_t *pusLengths;
+	size_t uxCount;
+} xMixes[] =
+{
+	{ "60", usSize60, 1u },
+	{ "128", usSize128, 1u },
+	{ "256", usSize256, 1u },
+	{ "590", usSize590, 1u },
+	{ "1024", usSize1024, 1u },
+	{ "1514", usSize1514, 1u },
+	{ "imix", usSizeIMIX, sizeof( usSizeIMIX ) / sizeof( usSizeIMIX[ 0 ] ) }
+};
+uint64_t ullBusNs;
+double dFrames;
+size_t uxIndex;
+int iIndex;
+int iResult = 0;
+
+	for( iIndex = 1; iIndex + 1 < argc; iIndex += 2 )
+	{
+		uint32_t ulValue = ( uint32_t ) strtoul( argv[ iIndex + 1 ], NULL, 0 );
+
+		switch( argv[ iIndex ][ 1 ] )
+		{
+			case 'b': ulBurstFrames = ulValue; break;
+			case 'n': ulFramesPerRun = ulValue; break;
+			case 't': ulTransactionNs = ulValue; break;
+			case 'd': ulDMANs = ulValue; break;
+			default:
+				fprintf( stderr, "Unknown option %s\n", argv[ iIndex ] );
+				return 2;
+		}
+	}
+
+	if( ulBurstFrames == 0u )
+	{
+		ulBurstFrames = 1u;
+	}
+
+	printf( "GREENPHY_RX_BURST_MODE %d", GREENPHY_RX_BURST_MODE );
+	#if( GREENPHY_RX_BURST_MODE != 0 )
+		printf( ", staging buffer %d bytes", GREENPHY_RX_BURST_LEN );
+	#endif
+	printf( ", up to %lu frames per interrupt\n", ( unsigned long ) ulBurstFrames );
+	printf( "SPI %lu MHz, %lu ns per transaction, %lu ns per DMA transfer\n\n",
+		( unsigned long ) ( SIM_SPI_CLOCK_HZ / 1000000u ), ( unsigned long ) ulTransactionNs, ( unsigned long ) ulDMANs );
+	printf( "frame  trans/frame  dma/frame  spi bytes/frame  overhead  frames/s  Mbit/s\n" );
+
+	for( uxIndex = 0u; uxIndex < sizeof( xMixes ) / sizeof( xMixes[ 0 ] ); uxIndex++ )
+	{
+		vSimRun( xMixes[ uxIndex ].pusLengths, xMixes[ uxIndex ].uxCount );
+
+		if( xCounters.ulErrors != 0u )
+		{
+			printf( "%-6s FAILED: %lu errors\n", xMixes[ uxIndex ].pcName, ( unsigned long ) xCounters.ulErrors );
+			iResult = 1;
+			continue;
+		}
+
+		/* The time the SPI bus is busy for these frames. */
+		ullBusNs = ( ( uint64_t ) xCounters.ulWireBytes * 8u * 1000000000u ) / SIM_SPI_CLOCK_HZ;
+		ullBusNs += ( uint64_t ) xCounters.ulTransactions * ulTransactionNs;
+		ullBusNs += ( uint64_t ) xCounters.ulDMATransfers * ulDMANs;
+		dFrames = ( double ) xCounters.ulFrames;
+
+		printf( "%-6s %11.2f %10.2f %16.1f %8.1f%% %9.0f %7.2f\n",
+			xMixes[ uxIndex ].pcName,
+			( double ) xCounters.ulTransactions / dFrames,
+			( double ) xCounters.ulDMATransfers / dFrames,
+			( double ) xCounters.ulWireBytes / dFrames,
+			( 100.0 * ( double ) ( xCounters.ulWireBytes - xCounters.ulFrameBytes ) ) / ( double ) xCounters.ulWireBytes,
+			( dFrames * 1e9 ) / ( double ) ullBusNs,
+			( ( double ) xCounters.ulFrameBytes * 8.0 * 1e3 ) / ( double ) ullBusNs );
+	}
+
+	return iResult;
+}
+/*-----------------------------------------------------------*/
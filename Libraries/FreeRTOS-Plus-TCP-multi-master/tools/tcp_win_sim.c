@@ -0,0 +1,643 @@
+/*
+ * FreeRTOS+TCP V2.3.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+/*
+ * tcp_win_sim.c
+ * Runs the sliding window code of FreeRTOS_TCP_WIN.c over a simulated link, on
+ * the host, to see what window size a link with a given rate, round trip time
+ * and loss needs.  See tools/tcp_win_sim.md for further description.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_TCP_WIN.h"
+
+static void vSimLog( const char *pcFormat, ... );
+
+/* The window code logs through FreeRTOS_debug_printf(), which would mix with
+the results.  Only show it when '-v' is given. */
+#undef FreeRTOS_debug_printf
+#define FreeRTOS_debug_printf( MSG )	vSimLog MSG
+
+/* The window code is compiled as part of this module, so the simulated clock
+and the logging above are used. */
+#include "../source/FreeRTOS_TCP_WIN.c"
+
+#if( ipconfigUSE_TCP_WIN != 1 )
+	#error tcp_win_sim needs ipconfigUSE_TCP_WIN
+#endif
+
+/* The simulation advances in steps of this many microseconds. */
+#define SIM_STEP_US				100u
+
+/* Headers on the wire per segment: Ethernet, IPv4 and TCP with timestamps. */
+#define SIM_OVERHEAD_BYTES		( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + 12u )
+
+/* The highest window that is tried, in units of MSS. */
+#define SIM_MAX_WINDOW			8u
+
+/* Packets that are underway on the link, in either direction. */
+#define SIM_MAX_PACKETS			64u
+
+/* A transfer is given up after this time, the 32-bit clock would wrap. */
+#define SIM_MAX_TIME_US			( 600u * 1000000u )
+
+/* The sequence number of the first byte that is sent. */
+#define SIM_FIRST_SEQUENCE		1000uL
+
+typedef struct xSIM_PACKET
+{
+	uint32_t ulArrival;			/* Time of arrival in us. */
+	uint32_t ulSequence;		/* Data: first byte.  ACK: the ACK number. */
+	uint32_t ulLength;			/* Data: length.  ACK: zero. */
+	uint32_t ulSackFirst;		/* ACK: a SACK block, when ulSackLast is not zero. */
+	uint32_t ulSackLast;
+} SimPacket_t;
+
+typedef struct xSIM_LINK
+{
+	SimPacket_t xPackets[ SIM_MAX_PACKETS ];
+	UBaseType_t uxCount;
+} SimLink_t;
+
+typedef struct xSIM_RESULT
+{
+	uint32_t ulTime;			/* Time until the last byte was acknowledged, in us. */
+	uint32_t ulAcked;			/* Bytes acknowledged, less than the transfer if it took too long. */
+	uint32_t ulSent;			/* Number of segments sent. */
+	uint32_t ulResent;			/* Number of segments sent more than once. */
+	uint32_t ulResentBytes;		/* Number of bytes sent more than once. */
+	uint32_t ulLost;			/* Number of segments dropped by the link. */
+} SimResult_t;
+
+/* Link and receiver properties, can be changed from the command line. */
+static uint32_t ulRoundTripUs = 8000u;
+static uint32_t ulLossPermille = 0u;
+static uint32_t ulLossBurst = 1u;
+static uint32_t ulRateKbps = 8000u;
+static uint32_t ulDelayedAckUs = 40000u;
+static uint32_t ulTransferBytes = 256u * 1024u;
+static uint32_t ulMSS = ipconfigTCP_MSS;
+static BaseType_t xVerbose = pdFALSE;
+static BaseType_t xRequests = pdFALSE;
+
+/* The simulated time in microseconds, it also drives xTaskGetTickCount(). */
+static uint32_t ulNow;
+
+/* A deterministic random generator, so each run drops the same segments. */
+static uint32_t ulRandomSeed;
+
+/* Bursty loss: while 'xLossBurst' is true, all segments are dropped. */
+static BaseType_t xLossBurst;
+static uint32_t ulLossSlot;
+/*-----------------------------------------------------------*/
+
+static void vSimLog( const char *pcFormat, ... )
+{
+	va_list xArgs;
+
+	if( xVerbose != pdFALSE )
+	{
+		va_start( xArgs, pcFormat );
+		vfprintf( stderr, pcFormat, xArgs );
+		va_end( xArgs );
+	}
+}
+/*-----------------------------------------------------------*/
+
+TickType_t xTaskGetTickCount( void )
+{
+	return ( TickType_t ) ( ulNow / 1000u );
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xSize )
+{
+	return malloc( xSize );
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+	free( pv );
+}
+/*-----------------------------------------------------------*/
+
+void vAssertCalled( const char *pcFile, int lLine )
+{
+	fprintf( stderr, "Assert %s:%d\n", pcFile, lLine );
+	exit( 1 );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t ulSimRandom( void )
+{
+	ulRandomSeed = ( ulRandomSeed * 1103515245uL ) + 12345uL;
+	return ( ulRandomSeed >> 16 ) & 0x7FFFu;
+}
+/*-----------------------------------------------------------*/
+
+/* Decide if the link drops a segment.  With a burst length of 1 segments
+are lost independently.  Otherwise the link has a good and a bad state
+( Gilbert-Elliott ) that changes per time slot of one full-size segment: in
+the bad state every segment is lost.  A burst lasts 'ulLossBurst' slots on
+average, and the average loss stays the same.  Noise on the mains lasts a
+time, not a number of segments. */
+static BaseType_t xSimLost( uint32_t ulSlotUs )
+{
+uint32_t ulEnter;
+
+	if( ulLossBurst <= 1u )
+	{
+		xLossBurst = ( ( ulSimRandom() % 1000u ) < ulLossPermille ) ? pdTRUE : pdFALSE;
+	}
+	else
+	{
+		/* The chance per million to enter the bad state. */
+		ulEnter = ( ulLossPermille * 1000000u ) / ( ulLossBurst * ( 1000u - ulLossPermille ) );
+
+		while( ( ulNow - ulLossSlot ) >= ulSlotUs )
+		{
+			ulLossSlot += ulSlotUs;
+
+			if( xLossBurst != pdFALSE )
+			{
+				if( ( ulSimRandom() % ulLossBurst ) == 0u )
+				{
+					xLossBurst = pdFALSE;
+				}
+			}
+			else if( ( ( ( ulSimRandom() << 15 ) | ulSimRandom() ) % 1000000u ) < ulEnter )
+			{
+				xLossBurst = pdTRUE;
+			}
+		}
+	}
+
+	return xLossBurst;
+}
+/*-----------------------------------------------------------*/
+
+static void vSimSend( SimLink_t *pxLink, const SimPacket_t *pxPacket )
+{
+	configASSERT( pxLink->uxCount < SIM_MAX_PACKETS );
+	pxLink->xPackets[ pxLink->uxCount ] = *pxPacket;
+	pxLink->uxCount++;
+}
+/*-----------------------------------------------------------*/
+
+/* Take the packet that arrives first, if it has arrived by now. */
+static BaseType_t xSimReceive( SimLink_t *pxLink, SimPacket_t *pxPacket )
+{
+UBaseType_t uxIndex, uxFirst = 0u;
+BaseType_t xReturn = pdFALSE;
+
+	for( uxIndex = 1u; uxIndex < pxLink->uxCount; uxIndex++ )
+	{
+		if( pxLink->xPackets[ uxIndex ].ulArrival < pxLink->xPackets[ uxFirst ].ulArrival )
+		{
+			uxFirst = uxIndex;
+		}
+	}
+
+	if( ( pxLink->uxCount != 0u ) && ( pxLink->xPackets[ uxFirst ].ulArrival <= ulNow ) )
+	{
+		*pxPacket = pxLink->xPackets[ uxFirst ];
+		pxLink->uxCount--;
+		pxLink->xPackets[ uxFirst ] = pxLink->xPackets[ pxLink->uxCount ];
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+/* Send a window of 'uxWindow' times MSS over the link.  The sender uses the
+FreeRTOS_TCP_WIN code with a TX stream of the same size as its window.  The
+receiver is a host with plenty of buffer space: it ACKs every second segment
+or after the delayed-ACK time, and ACKs out-of-order data at once, with a SACK
+block when 'xSack' is true.  When 'xDupAcks' is false, duplicate ACKs are not
+passed to vTCPWindowTxDuplicateAck(), as before NewReno was added. */
+static void vSimRun( UBaseType_t uxWindow, BaseType_t xSack, BaseType_t xDupAcks, SimResult_t *pxResult )
+{
+static TCPWindow_t xWindow;
+SimLink_t xData, xAcks;
+SimPacket_t xPacket;
+size_t uxRxWinSize = 1u, uxTxWinSize = uxWindow;
+uint32_t ulSegments = ( ulTransferBytes + ulMSS - 1u ) / ulMSS;
+uint8_t *pucReceived = calloc( ulSegments, 1u );
+int32_t lStreamSize, lStreamHead = 0, lPosition;
+uint32_t ulQueued = 0u, ulAcked = 0u, ulLength, ulHighest = SIM_FIRST_SEQUENCE;
+uint32_t ulLinkFree = 0u, ulSerialise, ulNext = 0u, ulUnacked = 0u, ulAckTimer = 0u;
+uint32_t ulSegment, ulFirst, ulLast;
+
+	configASSERT( pucReceived != NULL );
+	memset( pxResult, 0, sizeof( *pxResult ) );
+	memset( &xData, 0, sizeof( xData ) );
+	memset( &xAcks, 0, sizeof( xAcks ) );
+	ulNow = 0u;
+	ulRandomSeed = 0x5EED1234uL;
+	xLossBurst = pdFALSE;
+	ulLossSlot = 0u;
+
+	/* Reserve descriptors just like prvTCPCreateWindow() does. */
+	#if( ipconfigTCP_WIN_BUDGET != 0 )
+	{
+		vTCPWindowBudget( &xWindow, &uxRxWinSize, &uxTxWinSize );
+	}
+	#endif
+
+	lStreamSize = ( int32_t ) ( uxTxWinSize * ulMSS );
+	vTCPWindowCreate( &xWindow, ( uint32_t ) uxRxWinSize * ulMSS, ( uint32_t ) uxTxWinSize * ulMSS,
+		1uL, SIM_FIRST_SEQUENCE, ulMSS );
+
+	ulSerialise = ( ( ulMSS + SIM_OVERHEAD_BYTES ) * 8000u ) / ulRateKbps;
+
+	while( ( ulAcked < ulTransferBytes ) && ( ulNow < SIM_MAX_TIME_US ) )
+	{
+		/* Handle the ACKs that came back, the SACK option before the ACK
+		number as prvCheckOptions() does. */
+		while( xSimReceive( &xAcks, &xPacket ) != pdFALSE )
+		{
+			if( xPacket.ulSackLast != 0u )
+			{
+				ulAcked += ulTCPWindowTxSack( &xWindow, xPacket.ulSackFirst, xPacket.ulSackLast );
+			}
+
+			/* The simulated ACKs never carry data or change the window. */
+			if( xDupAcks != pdFALSE )
+			{
+				vTCPWindowTxDuplicateAck( &xWindow, xPacket.ulSequence );
+			}
+
+			ulAcked += ulTCPWindowTxAck( &xWindow, xPacket.ulSequence );
+		}
+
+		/* The application fills the TX stream as far as there is space. */
+		while( ( ulQueued < ulTransferBytes ) && ( ( ulQueued - ulAcked ) < ( uint32_t ) lStreamSize ) )
+		{
+			ulLength = FreeRTOS_min_uint32( ulMSS, ulTransferBytes - ulQueued );
+			ulLength = FreeRTOS_min_uint32( ulLength, ( uint32_t ) lStreamSize - ( ulQueued - ulAcked ) );
+			ulLength = ( uint32_t ) lTCPWindowTxAdd( &xWindow, ulLength, lStreamHead, lStreamSize );
+
+			if( ulLength == 0u )
+			{
+				break;
+			}
+
+			lStreamHead = ( lStreamHead + ( int32_t ) ulLength ) % lStreamSize;
+			ulQueued += ulLength;
+		}
+
+		/* Put the next segment on the wire when the link is idle. */
+		if( ulNow >= ulLinkFree )
+		{
+			ulLength = ulTCPWindowTxGet( &xWindow, 0x10000u, &lPosition );
+
+			if( ulLength != 0u )
+			{
+				memset( &xPacket, 0, sizeof( xPacket ) );
+				xPacket.ulSequence = xWindow.ulOurSequenceNumber;
+				xPacket.ulLength = ulLength;
+				ulLinkFree = ulNow + ulSerialise;
+				xPacket.ulArrival = ulLinkFree + ( ulRoundTripUs / 2u );
+				pxResult->ulSent++;
+
+				if( xSequenceLessThan( xPacket.ulSequence, ulHighest ) != pdFALSE )
+				{
+					pxResult->ulResent++;
+					pxResult->ulResentBytes += ulLength;
+				}
+				else
+				{
+					ulHighest = xPacket.ulSequence + ulLength;
+				}
+
+				if( xSimLost( ulSerialise ) != pdFALSE )
+				{
+					pxResult->ulLost++;
+				}
+				else
+				{
+					vSimSend( &xData, &xPacket );
+				}
+			}
+		}
+
+		/* The receiver. */
+		while( xSimReceive( &xData, &xPacket ) != pdFALSE )
+		{
+			ulSegment = ( xPacket.ulSequence - SIM_FIRST_SEQUENCE ) / ulMSS;
+			pucReceived[ ulSegment ] = 1u;
+			memset( &xPacket, 0, sizeof( xPacket ) );
+
+			if( ulSegment == ulNext )
+			{
+				while( ( ulNext < ulSegments ) && ( pucReceived[ ulNext ] != 0u ) )
+				{
+					ulNext++;
+				}
+
+				ulUnacked++;
+
+				if( ulUnacked == 1u )
+				{
+					ulAckTimer = ulNow + ulDelayedAckUs;
+				}
+			}
+			else if( ulSegment > ulNext )
+			{
+				/* Out of order: ACK at once and SACK the block that holds it. */
+				for( ulFirst = ulSegment; ( ulFirst > ulNext ) && ( pucReceived[ ulFirst - 1u ] != 0u ); ulFirst-- )
+				{
+				}
+
+				for( ulLast = ulSegment + 1u; ( ulLast < ulSegments ) && ( pucReceived[ ulLast ] != 0u ); ulLast++ )
+				{
+				}
+
+				if( xSack != pdFALSE )
+				{
+					xPacket.ulSackFirst = SIM_FIRST_SEQUENCE + ( ulFirst * ulMSS );
+					xPacket.ulSackLast = SIM_FIRST_SEQUENCE + FreeRTOS_min_uint32( ulLast * ulMSS, ulTransferBytes );
+				}
+
+				ulUnacked = 2u;
+			}
+			else
+			{
+				/* A duplicate, ACK it at once. */
+				ulUnacked = 2u;
+			}
+
+			if( ( ulUnacked >= 2u ) || ( ulNext == ulSegments ) )
+			{
+				xPacket.ulSequence = SIM_FIRST_SEQUENCE + FreeRTOS_min_uint32( ulNext * ulMSS, ulTransferBytes );
+				xPacket.ulArrival = ulNow + ( ulRoundTripUs / 2u );
+				vSimSend( &xAcks, &xPacket );
+				ulUnacked = 0u;
+			}
+		}
+
+		if( ( ulUnacked != 0u ) && ( ulNow >= ulAckTimer ) )
+		{
+			memset( &xPacket, 0, sizeof( xPacket ) );
+			xPacket.ulSequence = SIM_FIRST_SEQUENCE + FreeRTOS_min_uint32( ulNext * ulMSS, ulTransferBytes );
+			xPacket.ulArrival = ulNow + ( ulRoundTripUs / 2u );
+			vSimSend( &xAcks, &xPacket );
+			ulUnacked = 0u;
+		}
+
+		ulNow += SIM_STEP_US;
+	}
+
+	pxResult->ulTime = ulNow;
+	pxResult->ulAcked = ulAcked;
+	vTCPWindowDestroy( &xWindow );
+	free( pucReceived );
+}
+/*-----------------------------------------------------------*/
+
+/* Let the IP-task send what the window offers, and let the peer ACK it at once.
+Returns the number of segments. */
+static uint32_t ulSimFlush( TCPWindow_t *pxWindow )
+{
+uint32_t ulCount = 0u, ulLength;
+int32_t lPosition;
+
+	for( ;; )
+	{
+		ulLength = ulTCPWindowTxGet( pxWindow, 0x10000u, &lPosition );
+
+		if( ulLength == 0u )
+		{
+			break;
+		}
+
+		ulCount++;
+		( void ) ulTCPWindowTxAck( pxWindow, pxWindow->ulOurSequenceNumber + ulLength );
+	}
+
+	return ulCount;
+}
+/*-----------------------------------------------------------*/
+
+/* Send one JSON reply the way prvOpenURL() in FreeRTOS_HTTP_server.c does: the
+header, the chunk size, the body and the closing chunk, each with its own
+FreeRTOS_send().  The IP-task has a higher priority than the HTTP task, so it
+gets to work after each call.  When 'xCork' is true, FREERTOS_SO_SET_FULL_SIZE
+is set around the reply.  Returns the number of segments that were sent. */
+static uint32_t ulSimRequest( uint32_t ulBodyLength, BaseType_t xCork )
+{
+static TCPWindow_t xWindow;
+uint32_t pulWrites[ 4 ];
+uint32_t ulSegments = 0u, ulLength, ulWrite;
+int32_t lStreamSize = ( int32_t ) ( 2u * ulMSS ), lStreamHead = 0;
+char pcText[ 160 ];
+size_t uxRxWinSize = 1u, uxTxWinSize = 2u;
+
+	/* The HTTP server gets a TX window of two segments. */
+	#if( ipconfigTCP_WIN_BUDGET != 0 )
+	{
+		vTCPWindowBudget( &xWindow, &uxRxWinSize, &uxTxWinSize );
+	}
+	#endif
+	vTCPWindowCreate( &xWindow, ( uint32_t ) uxRxWinSize * ulMSS, ( uint32_t ) uxTxWinSize * ulMSS,
+		1uL, SIM_FIRST_SEQUENCE, ulMSS );
+	xWindow.u.bits.bSendFullSize = ( xCork != pdFALSE ) ? pdTRUE_UNSIGNED : pdFALSE_UNSIGNED;
+
+	pulWrites[ 0 ] = ( uint32_t ) snprintf( pcText, sizeof( pcText ),
+		"HTTP/1.1 200 OK\r\n"
+		"Content-Type: application/json\r\n"
+		"Connection: keep-alive\r\n"
+		"Transfer-Encoding: chunked\r\n"
+		"Content-Length: %lu\r\n"
+		"\r\n", ( unsigned long ) ulBodyLength );
+	pulWrites[ 1 ] = ( uint32_t ) snprintf( pcText, sizeof( pcText ), "%lx\r\n", ( unsigned long ) ulBodyLength );
+	pulWrites[ 2 ] = ulBodyLength;
+	pulWrites[ 3 ] = sizeof( "\r\n0\r\n\r\n" ) - 1u;
+
+	for( ulWrite = 0u; ulWrite < 4u; ulWrite++ )
+	{
+		while( pulWrites[ ulWrite ] != 0u )
+		{
+			/* The TX stream is never fuller than one segment: the rest was ACK'd. */
+			ulLength = FreeRTOS_min_uint32( pulWrites[ ulWrite ], ( uint32_t ) lStreamSize - ulMSS );
+			ulLength = ( uint32_t ) lTCPWindowTxAdd( &xWindow, ulLength, lStreamHead, lStreamSize );
+			configASSERT( ulLength != 0u );
+			lStreamHead = ( lStreamHead + ( int32_t ) ulLength ) % lStreamSize;
+			pulWrites[ ulWrite ] -= ulLength;
+			ulSegments += ulSimFlush( &xWindow );
+		}
+	}
+
+	/* Uncork. */
+	xWindow.u.bits.bSendFullSize = pdFALSE_UNSIGNED;
+	ulSegments += ulSimFlush( &xWindow );
+
+	vTCPWindowDestroy( &xWindow );
+
+	return ulSegments;
+}
+/*-----------------------------------------------------------*/
+
+static void vSimRequests( void )
+{
+static const uint32_t pulBodies[] = { 16u, 64u, 256u, 1024u, 1200u, 1400u, 2048u, 4096u };
+uint32_t ulIndex;
+
+	printf( "segments per JSON reply, MSS %lu\n\n", ( unsigned long ) ulMSS );
+	printf( "  body  uncorked  corked\n" );
+
+	for( ulIndex = 0u; ulIndex < sizeof( pulBodies ) / sizeof( pulBodies[ 0 ] ); ulIndex++ )
+	{
+		printf( "%6lu %9lu %7lu\n",
+			( unsigned long ) pulBodies[ ulIndex ],
+			( unsigned long ) ulSimRequest( pulBodies[ ulIndex ], pdFALSE ),
+			( unsigned long ) ulSimRequest( pulBodies[ ulIndex ], pdTRUE ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void vUsage( const char *pcName )
+{
+	fprintf( stderr, "Usage: %s [-r rtt_ms] [-l loss_permille] [-u burst] [-b rate_kbps] [-d delack_ms] [-s kbytes] [-m mss] [-q] [-v]\n", pcName );
+	exit( 2 );
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+SimResult_t xResult;
+UBaseType_t uxWindow;
+BaseType_t xMode;
+uint32_t ulRate, ulBDP;
+int iIndex;
+
+	for( iIndex = 1; iIndex < argc; iIndex++ )
+	{
+		if( strcmp( argv[ iIndex ], "-v" ) == 0 )
+		{
+			xVerbose = pdTRUE;
+		}
+		else if( strcmp( argv[ iIndex ], "-q" ) == 0 )
+		{
+			xRequests = pdTRUE;
+		}
+		else if( ( iIndex + 1 < argc ) && ( argv[ iIndex ][ 0 ] == '-' ) )
+		{
+			uint32_t ulValue = ( uint32_t ) strtoul( argv[ iIndex + 1 ], NULL, 0 );
+
+			switch( argv[ iIndex ][ 1 ] )
+			{
+				case 'r': ulRoundTripUs = ulValue * 1000u; break;
+				case 'l': ulLossPermille = ulValue; break;
+				case 'u': ulLossBurst = ulValue; break;
+				case 'b': ulRateKbps = ulValue; break;
+				case 'd': ulDelayedAckUs = ulValue * 1000u; break;
+				case 's': ulTransferBytes = ulValue * 1024u; break;
+				case 'm': ulMSS = ulValue; break;
+				default: vUsage( argv[ 0 ] ); break;
+			}
+
+			iIndex++;
+		}
+		else
+		{
+			vUsage( argv[ 0 ] );
+		}
+	}
+
+	if( ( ulRateKbps == 0u ) || ( ulMSS == 0u ) || ( ulTransferBytes == 0u ) || ( ulLossPermille >= 1000u ) )
+	{
+		vUsage( argv[ 0 ] );
+	}
+
+	if( xRequests != pdFALSE )
+	{
+		vSimRequests();
+		return 0;
+	}
+
+	/* The bandwidth-delay product, in bytes. */
+	ulBDP = ( ulRateKbps * ( ulRoundTripUs / 100u ) ) / 80u;
+
+	printf( "rate %lu kbit/s, rtt %lu ms, loss %lu/1000 in bursts of %lu, delayed ACK %lu ms, MSS %lu, %lu KB\n",
+		( unsigned long ) ulRateKbps, ( unsigned long ) ( ulRoundTripUs / 1000u ), ( unsigned long ) ulLossPermille, ( unsigned long ) ulLossBurst,
+		( unsigned long ) ( ulDelayedAckUs / 1000u ), ( unsigned long ) ulMSS, ( unsigned long ) ( ulTransferBytes / 1024u ) );
+	printf( "bandwidth-delay product %lu bytes = %lu.%02lu MSS\n\n",
+		( unsigned long ) ulBDP, ( unsigned long ) ( ulBDP / ulMSS ), ( unsigned long ) ( ( ( ulBDP % ulMSS ) * 100u ) / ulMSS ) );
+	printf( "win  bytes   kbit/s  link%%    sent  resent  lost\n" );
+
+	for( uxWindow = 1u; uxWindow <= SIM_MAX_WINDOW; uxWindow++ )
+	{
+		vSimRun( uxWindow, pdTRUE, pdTRUE, &xResult );
+		ulRate = ( uint32_t ) ( ( ( uint64_t ) xResult.ulAcked * 8000u ) / xResult.ulTime );
+
+		printf( "%3u %6lu %8lu %5lu %7lu %7lu %5lu\n",
+			( unsigned ) uxWindow,
+			( unsigned long ) ( uxWindow * ulMSS ),
+			( unsigned long ) ulRate,
+			( unsigned long ) ( ( ulRate * 100u ) / ulRateKbps ),
+			( unsigned long ) xResult.ulSent,
+			( unsigned long ) xResult.ulResent,
+			( unsigned long ) xResult.ulLost );
+	}
+
+	if( ulLossPermille != 0u )
+	{
+		/* Compare the recovery from loss, with and without the duplicate ACK
+		processing of vTCPWindowTxDuplicateAck(), for a peer that does or does
+		not send SACK's.  Goodput in kbit/s and retransmitted bytes. */
+		printf( "\n     ------ peer without SACK ------  ------- peer with SACK -------\n" );
+		printf( "win     RTO only       dup ACKs         SACK only   SACK + dup ACKs\n" );
+
+		for( uxWindow = 1u; uxWindow <= SIM_MAX_WINDOW; uxWindow++ )
+		{
+			printf( "%3u", ( unsigned ) uxWindow );
+
+			for( xMode = 0; xMode < 4; xMode++ )
+			{
+				vSimRun( uxWindow, ( xMode >= 2 ) ? pdTRUE : pdFALSE, ( ( xMode & 1 ) != 0 ) ? pdTRUE : pdFALSE, &xResult );
+				ulRate = ( uint32_t ) ( ( ( uint64_t ) xResult.ulAcked * 8000u ) / xResult.ulTime );
+				printf( " %6lu %7lu", ( unsigned long ) ulRate, ( unsigned long ) xResult.ulResentBytes );
+			}
+
+			printf( "\n" );
+		}
+	}
+
+	return 0;
+}